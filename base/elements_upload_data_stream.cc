@@ -62,6 +62,33 @@ void ElementsUploadDataStream::ResetInternal() {
   element_index_ = 0;
 }
 
+bool ElementsUploadDataStream::GetNextFileRangeInternal(
+    base::PlatformFile* file,
+    uint64_t* offset,
+    uint64_t* length) {
+  if (read_error_ != OK)
+    return false;
+
+  // Skip exhausted elements, as ReadElements() would.
+  while (element_index_ < element_readers_.size() &&
+         element_readers_[element_index_]->BytesRemaining() == 0) {
+    ++element_index_;
+  }
+  if (element_index_ == element_readers_.size())
+    return false;
+
+  UploadElementReader* reader = element_readers_[element_index_].get();
+  if (!reader->GetRemainingFileRange(file, offset))
+    return false;
+  *length = reader->BytesRemaining();
+  return true;
+}
+
+void ElementsUploadDataStream::DidSendFileRangeInternal(uint64_t bytes) {
+  DCHECK_LT(element_index_, element_readers_.size());
+  element_readers_[element_index_]->DidSendFileRange(bytes);
+}
+
 int ElementsUploadDataStream::InitElements(size_t start_index) {
   // Call Init() for all elements.
   for (size_t i = start_index; i < element_readers_.size(); ++i) {
@@ -46,6 +46,10 @@ class NET_EXPORT ElementsUploadDataStream : public UploadDataStream {
   int InitInternal(const NetLogWithSource& net_log) override;
   int ReadInternal(IOBuffer* buf, int buf_len) override;
   void ResetInternal() override;
+  bool GetNextFileRangeInternal(base::PlatformFile* file,
+                                uint64_t* offset,
+                                uint64_t* length) override;
+  void DidSendFileRangeInternal(uint64_t bytes) override;
 
   // Runs Init() for all element readers.
   // This method is used to implement InitInternal().
@@ -388,6 +388,60 @@ TEST_F(ElementsUploadDataStreamTest, FileAndBytes) {
   ASSERT_TRUE(stream->IsEOF());
 }
 
+// Sends the file element directly with GetNextFileRange() and
+// DidSendFileRange(), and reads the bytes element that follows it.
+TEST_F(ElementsUploadDataStreamTest, FileRange) {
+  base::FilePath temp_file_path;
+  ASSERT_TRUE(
+      base::CreateTemporaryFileInDir(temp_dir_.GetPath(), &temp_file_path));
+  ASSERT_EQ(static_cast<int>(kTestDataSize),
+            base::WriteFile(temp_file_path, kTestData, kTestDataSize));
+
+  const uint64_t kFileRangeOffset = 1;
+  const uint64_t kFileRangeLength = 4;
+  element_readers_.push_back(std::make_unique<UploadFileElementReader>(
+      base::ThreadTaskRunnerHandle::Get().get(), temp_file_path,
+      kFileRangeOffset, kFileRangeLength, base::Time()));
+
+  element_readers_.push_back(
+      std::make_unique<UploadBytesElementReader>(kTestData, kTestDataSize));
+
+  const uint64_t kStreamSize = kTestDataSize + kFileRangeLength;
+  TestCompletionCallback init_callback;
+  std::unique_ptr<UploadDataStream> stream(
+      new ElementsUploadDataStream(std::move(element_readers_), 0));
+  ASSERT_THAT(stream->Init(init_callback.callback(), NetLogWithSource()),
+              IsError(ERR_IO_PENDING));
+  ASSERT_THAT(init_callback.WaitForResult(), IsOk());
+
+  base::PlatformFile file = base::kInvalidPlatformFile;
+  uint64_t offset = 0;
+  uint64_t length = 0;
+  ASSERT_TRUE(stream->GetNextFileRange(&file, &offset, &length));
+  EXPECT_NE(base::kInvalidPlatformFile, file);
+  EXPECT_EQ(kFileRangeOffset, offset);
+  EXPECT_EQ(kFileRangeLength, length);
+
+  stream->DidSendFileRange(3);
+  EXPECT_EQ(3u, stream->position());
+  ASSERT_TRUE(stream->GetNextFileRange(&file, &offset, &length));
+  EXPECT_EQ(kFileRangeOffset + 3, offset);
+  EXPECT_EQ(1u, length);
+
+  stream->DidSendFileRange(1);
+  EXPECT_EQ(kFileRangeLength, stream->position());
+  EXPECT_FALSE(stream->IsEOF());
+  // The rest of the stream is in memory.
+  EXPECT_FALSE(stream->GetNextFileRange(&file, &offset, &length));
+
+  scoped_refptr<IOBuffer> buf = base::MakeRefCounted<IOBuffer>(kTestBufferSize);
+  EXPECT_EQ(static_cast<int>(kTestDataSize),
+            stream->Read(buf.get(), kTestBufferSize, CompletionOnceCallback()));
+  EXPECT_EQ(kStreamSize, stream->position());
+  EXPECT_TRUE(stream->IsEOF());
+  EXPECT_FALSE(stream->GetNextFileRange(&file, &offset, &length));
+}
+
 // Init() with on-memory and not-on-memory readers.
 TEST_F(ElementsUploadDataStreamTest, InitAsync) {
   // Create UploadDataStream with mock readers.
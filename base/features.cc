@@ -195,5 +195,68 @@ extern const base::FeatureParam<base::TimeDelta> kTimeoutTcpConnectAttemptMax(
     "TimeoutTcpConnectAttemptMax",
     base::TimeDelta::FromSeconds(30));
 
+const base::Feature kDnsHedgedQueries{"DnsHedgedQueries",
+                                     base::FEATURE_DISABLED_BY_DEFAULT};
+
+extern const base::FeatureParam<int> kDnsHedgedQueriesRttPercentile(
+    &kDnsHedgedQueries,
+    "DnsHedgedQueriesRttPercentile",
+    95);
+
+extern const base::FeatureParam<base::TimeDelta> kDnsHedgedQueriesMinDelay(
+    &kDnsHedgedQueries,
+    "DnsHedgedQueriesMinDelay",
+    base::TimeDelta::FromMilliseconds(10));
+
+extern const base::FeatureParam<double> kDnsHedgedQueriesMaxRatio(
+    &kDnsHedgedQueries,
+    "DnsHedgedQueriesMaxRatio",
+    0.05);
+
+const base::Feature kDnsNxdomainCut{"DnsNxdomainCut",
+                                    base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kUploadSendFile{"UploadSendFile",
+                                    base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kHttp2WriteCoalescing{"Http2WriteCoalescing",
+                                          base::FEATURE_DISABLED_BY_DEFAULT};
+
+extern const base::FeatureParam<int> kHttp2WriteCoalescingMaxBytes(
+    &kHttp2WriteCoalescing,
+    "Http2WriteCoalescingMaxBytes",
+    16 * 1024);
+
+const base::Feature kHttp2ReceiveWindowAutoTuning{
+    "Http2ReceiveWindowAutoTuning", base::FEATURE_DISABLED_BY_DEFAULT};
+
+extern const base::FeatureParam<int>
+    kHttp2ReceiveWindowAutoTuningMaxWindowSize(
+        &kHttp2ReceiveWindowAutoTuning,
+        "Http2ReceiveWindowAutoTuningMaxWindowSize",
+        16 * 1024 * 1024);
+
+const base::Feature kHttp2PeriodicPing{"Http2PeriodicPing",
+                                       base::FEATURE_DISABLED_BY_DEFAULT};
+
+extern const base::FeatureParam<base::TimeDelta> kHttp2PeriodicPingInterval(
+    &kHttp2PeriodicPing,
+    "Http2PeriodicPingInterval",
+    base::TimeDelta::FromSeconds(30));
+
+extern const base::FeatureParam<bool> kHttp2PeriodicPingIdleSessions(
+    &kHttp2PeriodicPing,
+    "Http2PeriodicPingIdleSessions",
+    false);
+
+const base::Feature kPriorityHeader{"PriorityHeader",
+                                    base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kHttp2SelectiveHeaderIndexing{
+    "Http2SelectiveHeaderIndexing", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kHttp2ProxyTunnelRelay{"Http2ProxyTunnelRelay",
+                                           base::FEATURE_DISABLED_BY_DEFAULT};
+
 }  // namespace features
 }  // namespace net
@@ -288,6 +288,83 @@ NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
 NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
     kTimeoutTcpConnectAttemptMax;
 
+// Enables hedging of classic (non-DoH) DNS queries: when a query to one
+// nameserver has not completed after a delay derived from that server's RTT
+// history, a duplicate query is sent to the next nameserver without waiting
+// for the fallback period, and the first valid answer wins.
+NET_EXPORT extern const base::Feature kDnsHedgedQueries;
+
+// FeatureParams associated with kDnsHedgedQueries.
+
+// Percentile of the server's observed RTTs after which a query is hedged.
+NET_EXPORT extern const base::FeatureParam<int> kDnsHedgedQueriesRttPercentile;
+// Lower bound on the hedging delay, in case the server is a local DNS proxy.
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kDnsHedgedQueriesMinDelay;
+// Maximum number of hedged queries per classic DNS query, averaged over time.
+// Caps the extra query volume hedging may generate.
+NET_EXPORT extern const base::FeatureParam<double> kDnsHedgedQueriesMaxRatio;
+
+// When enabled, a cached NXDOMAIN answer for a name is also used to answer
+// lookups for any name below it, per RFC 8020 ("NXDOMAIN: There Really Is
+// Nothing Underneath"), instead of sending a query for each descendant.
+NET_EXPORT extern const base::Feature kDnsNxdomainCut;
+
+// Enables sending file-backed request bodies straight from the file to
+// plaintext HTTP/1.x sockets with sendfile(2), instead of reading them into
+// memory first. sendfile(2) may block on disk reads, so this is only suitable
+// for embedders whose network thread is allowed to block.
+NET_EXPORT extern const base::Feature kUploadSendFile;
+
+// Enables coalescing frames queued on an HTTP/2 session into a single socket
+// write, and so over TLS into a single record, instead of writing each frame
+// on its own.
+NET_EXPORT extern const base::Feature kHttp2WriteCoalescing;
+
+// Once this many bytes have been gathered into a write, no further frames are
+// added to it. The last frame added may take the write past this size.
+NET_EXPORT extern const base::FeatureParam<int> kHttp2WriteCoalescingMaxBytes;
+
+// Enables growing the receive windows of HTTP/2 sessions and streams when
+// they limit throughput, as measured against the round trip time of PINGs,
+// instead of keeping them at their configured sizes.
+NET_EXPORT extern const base::Feature kHttp2ReceiveWindowAutoTuning;
+
+// The size that auto-tuned receive windows may grow to.
+NET_EXPORT extern const base::FeatureParam<int>
+    kHttp2ReceiveWindowAutoTuningMaxWindowSize;
+
+// Enables sending a PING on HTTP/2 sessions with streams at a regular
+// interval, so that their round trip time is sampled and a connection that has
+// died, e.g. after a network change, is noticed and not handed out to new
+// requests.
+NET_EXPORT extern const base::Feature kHttp2PeriodicPing;
+
+// The interval between periodic PINGs.
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kHttp2PeriodicPingInterval;
+
+// Whether periodic PINGs are also sent on sessions without streams.
+NET_EXPORT extern const base::FeatureParam<bool>
+    kHttp2PeriodicPingIdleSessions;
+
+// Enables RFC 9218 extensible priorities: requests sent over HTTP/2 and
+// HTTP/3 carry a Priority header with an urgency mapped from their
+// RequestPriority, HTTP/2 reprioritization is signalled with PRIORITY_UPDATE
+// frames, and the frames we send on an HTTP/2 session are scheduled by
+// urgency and incrementalness.
+NET_EXPORT extern const base::Feature kPriorityHeader;
+
+// Enables adding header fields sent on HTTP/2 sessions to the HPACK dynamic
+// table only once they repeat, so that one-off values don't evict the ones
+// that would be reused.
+NET_EXPORT extern const base::Feature kHttp2SelectiveHeaderIndexing;
+
+// Enables relaying tunnel data through HTTP/2 proxies without intermediate
+// copies: received DATA payloads are handed to the tunneled TLS connection as
+// is, and sent DATA frames are sized to hold a whole TLS record.
+NET_EXPORT extern const base::Feature kHttp2ProxyTunnelRelay;
+
 }  // namespace features
 }  // namespace net
 
@@ -44,6 +44,10 @@ bool FileStream::IsOpen() const {
   return context_->IsOpen();
 }
 
+base::PlatformFile FileStream::GetPlatformFile() const {
+  return context_->GetPlatformFile();
+}
+
 int FileStream::Seek(int64_t offset, Int64CompletionOnceCallback callback) {
   if (!IsOpen())
     return ERR_UNEXPECTED;
@@ -69,6 +69,12 @@ class NET_EXPORT FileStream {
   // Returns true if Open succeeded and Close has not been called.
   virtual bool IsOpen() const;
 
+  // Returns the underlying platform file, or base::kInvalidPlatformFile if the
+  // stream is not open. The stream retains ownership of the file. Must not be
+  // called while there is an in-flight asynchronous operation, and the file
+  // must not be used once another one is started.
+  virtual base::PlatformFile GetPlatformFile() const;
+
   // Adjust the position from the start of the file where data is read
   // asynchronously. Upon success, ERR_IO_PENDING is returned and |callback|
   // will be run on the thread where Seek() was called with the the stream
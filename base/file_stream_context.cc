@@ -157,6 +157,11 @@ bool FileStream::Context::IsOpen() const {
   return file_.IsValid();
 }
 
+base::PlatformFile FileStream::Context::GetPlatformFile() const {
+  DCHECK(!async_in_progress_);
+  return file_.GetPlatformFile();
+}
+
 FileStream::Context::OpenResult FileStream::Context::OpenFileImpl(
     const base::FilePath& path, int open_flags) {
 #if defined(OS_POSIX)
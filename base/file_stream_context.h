@@ -102,6 +102,8 @@ class FileStream::Context {
 
   bool IsOpen() const;
 
+  base::PlatformFile GetPlatformFile() const;
+
  private:
   struct IOResult {
     IOResult();
@@ -5,6 +5,7 @@
 #include "net/base/upload_data_stream.h"
 
 #include "base/check_op.h"
+#include "base/notreached.h"
 #include "base/values.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
@@ -89,6 +90,28 @@ int UploadDataStream::Read(IOBuffer* buf,
   return result;
 }
 
+bool UploadDataStream::GetNextFileRange(base::PlatformFile* file,
+                                        uint64_t* offset,
+                                        uint64_t* length) {
+  DCHECK(initialized_successfully_);
+  DCHECK(callback_.is_null());
+  if (is_chunked_ || is_eof_)
+    return false;
+  return GetNextFileRangeInternal(file, offset, length);
+}
+
+void UploadDataStream::DidSendFileRange(uint64_t bytes) {
+  DCHECK(initialized_successfully_);
+  DCHECK(!is_chunked_);
+  DCHECK_GT(bytes, 0u);
+
+  DidSendFileRangeInternal(bytes);
+  current_position_ += bytes;
+  DCHECK_LE(current_position_, total_size_);
+  if (current_position_ == total_size_)
+    is_eof_ = true;
+}
+
 bool UploadDataStream::IsEOF() const {
   DCHECK(initialized_successfully_);
   DCHECK(is_chunked_ || is_eof_ == (current_position_ == total_size_));
@@ -194,4 +217,14 @@ bool UploadDataStream::AllowHTTP1() const {
   return true;
 }
 
+bool UploadDataStream::GetNextFileRangeInternal(base::PlatformFile* file,
+                                                uint64_t* offset,
+                                                uint64_t* length) {
+  return false;
+}
+
+void UploadDataStream::DidSendFileRangeInternal(uint64_t bytes) {
+  NOTREACHED();
+}
+
 }  // namespace net
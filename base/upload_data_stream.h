@@ -10,6 +10,7 @@
 #include <memory>
 #include <vector>
 
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_export.h"
@@ -60,6 +61,18 @@ class NET_EXPORT UploadDataStream {
   // TODO(mmenke):  Investigate letting reads fail.
   int Read(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
 
+  // For non-chunked streams, if the next bytes of the stream can be sent
+  // straight from a file, returns true and sets |file|, |offset| and |length|
+  // to where they are in it. The caller may then send them with
+  // StreamSocket::SendFile() rather than Read() them, reporting the number of
+  // bytes sent with DidSendFileRange(). Once it has done so, it must keep
+  // sending the range that way until it is exhausted. The file remains owned
+  // by the stream.
+  bool GetNextFileRange(base::PlatformFile* file,
+                        uint64_t* offset,
+                        uint64_t* length);
+  void DidSendFileRange(uint64_t bytes);
+
   // Returns the total size of the data stream and the current position.
   // When the data is chunked, always returns zero. Must always return the same
   // value after each call to Initialize().
@@ -131,6 +144,13 @@ class NET_EXPORT UploadDataStream {
   // at least once before every call to InitInternal.
   virtual void ResetInternal() = 0;
 
+  // See GetNextFileRange() and DidSendFileRange(). The default implementation
+  // of GetNextFileRangeInternal() returns false.
+  virtual bool GetNextFileRangeInternal(base::PlatformFile* file,
+                                        uint64_t* offset,
+                                        uint64_t* length);
+  virtual void DidSendFileRangeInternal(uint64_t bytes);
+
   uint64_t total_size_;
   uint64_t current_position_;
 
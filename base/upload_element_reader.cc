@@ -4,6 +4,8 @@
 
 #include "net/base/upload_element_reader.h"
 
+#include "base/notreached.h"
+
 namespace net {
 
 const UploadBytesElementReader* UploadElementReader::AsBytesReader() const {
@@ -18,4 +20,13 @@ bool UploadElementReader::IsInMemory() const {
   return false;
 }
 
+bool UploadElementReader::GetRemainingFileRange(base::PlatformFile* file,
+                                                uint64_t* offset) {
+  return false;
+}
+
+void UploadElementReader::DidSendFileRange(uint64_t bytes) {
+  NOTREACHED();
+}
+
 }  // namespace net
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_export.h"
@@ -61,6 +62,18 @@ class NET_EXPORT UploadElementReader {
                    int buf_length,
                    CompletionOnceCallback callback) = 0;
 
+  // If the remaining bytes of the element can be sent straight from a file,
+  // returns true and sets |file| and |offset| to where they start in it. The
+  // file remains owned by the reader. Must not be called while an Init() or
+  // Read() is pending. The default implementation returns false.
+  virtual bool GetRemainingFileRange(base::PlatformFile* file,
+                                     uint64_t* offset);
+
+  // Records that |bytes| bytes from the range returned by
+  // GetRemainingFileRange() were sent directly, rather than Read(). Once this
+  // has been called, the rest of the element must be sent the same way.
+  virtual void DidSendFileRange(uint64_t bytes);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(UploadElementReader);
 };
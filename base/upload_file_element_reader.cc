@@ -38,7 +38,8 @@ UploadFileElementReader::UploadFileElementReader(
       content_length_(0),
       bytes_remaining_(0),
       next_state_(State::IDLE),
-      init_called_while_operation_pending_(false) {
+      init_called_while_operation_pending_(false),
+      sent_file_range_directly_(false) {
   DCHECK(file.IsValid());
   DCHECK(task_runner_.get());
   file_stream_ = std::make_unique<FileStream>(std::move(file), task_runner);
@@ -58,7 +59,8 @@ UploadFileElementReader::UploadFileElementReader(
       content_length_(0),
       bytes_remaining_(0),
       next_state_(State::IDLE),
-      init_called_while_operation_pending_(false) {
+      init_called_while_operation_pending_(false),
+      sent_file_range_directly_(false) {
   DCHECK(task_runner_.get());
 }
 
@@ -74,6 +76,7 @@ int UploadFileElementReader::Init(CompletionOnceCallback callback) {
   bytes_remaining_ = 0;
   content_length_ = 0;
   pending_callback_.Reset();
+  sent_file_range_directly_ = false;
 
   // If the file is being opened, just update the callback, and continue
   // waiting.
@@ -122,6 +125,7 @@ int UploadFileElementReader::Read(IOBuffer* buf,
   DCHECK(!callback.is_null());
   DCHECK_EQ(next_state_, State::IDLE);
   DCHECK(file_stream_);
+  DCHECK(!sent_file_range_directly_);
 
   int num_bytes_to_read = static_cast<int>(
       std::min(BytesRemaining(), static_cast<uint64_t>(buf_length)));
@@ -143,6 +147,26 @@ int UploadFileElementReader::Read(IOBuffer* buf,
   return result;
 }
 
+bool UploadFileElementReader::GetRemainingFileRange(base::PlatformFile* file,
+                                                    uint64_t* offset) {
+  DCHECK_EQ(next_state_, State::IDLE);
+  if (!file_stream_ || BytesRemaining() == 0)
+    return false;
+
+  *file = file_stream_->GetPlatformFile();
+  if (*file == base::kInvalidPlatformFile)
+    return false;
+  *offset = range_offset_ + GetContentLength() - BytesRemaining();
+  return true;
+}
+
+void UploadFileElementReader::DidSendFileRange(uint64_t bytes) {
+  DCHECK_EQ(next_state_, State::IDLE);
+  DCHECK_GE(bytes_remaining_, bytes);
+  sent_file_range_directly_ = true;
+  bytes_remaining_ -= bytes;
+}
+
 int UploadFileElementReader::DoLoop(int result) {
   DCHECK_NE(result, ERR_IO_PENDING);
 
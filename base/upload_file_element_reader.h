@@ -72,6 +72,9 @@ class NET_EXPORT UploadFileElementReader : public UploadElementReader {
   int Read(IOBuffer* buf,
            int buf_length,
            CompletionOnceCallback callback) override;
+  bool GetRemainingFileRange(base::PlatformFile* file,
+                             uint64_t* offset) override;
+  void DidSendFileRange(uint64_t bytes) override;
 
  private:
   enum class State {
@@ -128,6 +131,9 @@ class NET_EXPORT UploadFileElementReader : public UploadElementReader {
   CompletionOnceCallback pending_callback_;
   // True if Init() was called while an async operation was in progress.
   bool init_called_while_operation_pending_;
+  // True if bytes have been sent directly from the file since the last Init(),
+  // which leaves the file position behind, so Read() may not be used.
+  bool sent_file_range_directly_;
 
   base::WeakPtrFactory<UploadFileElementReader> weak_ptr_factory_{this};
 
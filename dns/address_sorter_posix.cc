@@ -36,6 +36,9 @@ namespace net {
 
 namespace {
 
+// Maximum number of destinations whose source address is cached.
+const size_t kMaxCachedDestinations = 256;
+
 // Address sorting is performed according to RFC3484 with revisions.
 // http://tools.ietf.org/html/draft-ietf-6man-rfc3484bis-06
 // Precedence and label are separate to support override through /etc/gai.conf.
@@ -250,7 +253,8 @@ bool CompareDestinations(const std::unique_ptr<DestinationInfo>& dst_a,
 }  // namespace
 
 AddressSorterPosix::AddressSorterPosix(ClientSocketFactory* socket_factory)
-    : socket_factory_(socket_factory),
+    : destination_source_cache_(kMaxCachedDestinations),
+      socket_factory_(socket_factory),
       precedence_table_(LoadPolicy(kDefaultPrecedenceTable,
                                    base::size(kDefaultPrecedenceTable))),
       label_table_(
@@ -258,12 +262,14 @@ AddressSorterPosix::AddressSorterPosix(ClientSocketFactory* socket_factory)
       ipv4_scope_table_(LoadPolicy(kDefaultIPv4ScopeTable,
                                    base::size(kDefaultIPv4ScopeTable))) {
   NetworkChangeNotifier::AddIPAddressObserver(this);
+  NetworkChangeNotifier::AddConnectionTypeObserver(this);
   OnIPAddressChanged();
 }
 
 AddressSorterPosix::~AddressSorterPosix() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   NetworkChangeNotifier::RemoveIPAddressObserver(this);
+  NetworkChangeNotifier::RemoveConnectionTypeObserver(this);
 }
 
 void AddressSorterPosix::Sort(const AddressList& list,
@@ -278,40 +284,23 @@ void AddressSorterPosix::Sort(const AddressList& list,
     info->precedence = GetPolicyValue(precedence_table_, info->address);
     info->label = GetPolicyValue(label_table_, info->address);
 
-    // Each socket can only be bound once.
-    std::unique_ptr<DatagramClientSocket> socket(
-        socket_factory_->CreateDatagramClientSocket(
-            DatagramSocket::DEFAULT_BIND, nullptr /* NetLog */,
-            NetLogSource()));
-
-    // Even though no packets are sent, cannot use port 0 in Connect.
-    IPEndPoint dest(info->address, 80 /* port */);
-    int rv = socket->Connect(dest);
-    if (rv != OK) {
-      VLOG(1) << "Could not connect to " << dest.ToStringWithoutPort()
-              << " reason " << rv;
-      continue;
-    }
     // Filter out unusable destinations.
-    IPEndPoint src;
-    rv = socket->GetLocalAddress(&src);
-    if (rv != OK) {
-      LOG(WARNING) << "Could not get local address for "
-                   << dest.ToStringWithoutPort() << " reason " << rv;
+    base::Optional<IPAddress> src_address = GetSourceAddress(info->address);
+    if (!src_address)
       continue;
-    }
+    const IPAddress& src = src_address.value();
 
-    SourceAddressInfo& src_info = source_map_[src.address()];
+    SourceAddressInfo& src_info = source_map_[src];
     if (src_info.scope == SCOPE_UNDEFINED) {
       // If |source_info_| is out of date, |src| might be missing, but we still
       // want to sort, even though the HostCache will be cleared soon.
-      FillPolicy(src.address(), &src_info);
+      FillPolicy(src, &src_info);
     }
     info->src = &src_info;
 
-    if (info->address.size() == src.address().size()) {
+    if (info->address.size() == src.size()) {
       info->common_prefix_length =
-          std::min(CommonPrefixLength(info->address, src.address()),
+          std::min(CommonPrefixLength(info->address, src),
                    info->src->prefix_length);
     }
     sort_list.push_back(std::move(info));
@@ -329,6 +318,7 @@ void AddressSorterPosix::Sort(const AddressList& list,
 void AddressSorterPosix::OnIPAddressChanged() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   source_map_.clear();
+  destination_source_cache_.Clear();
 #if defined(OS_LINUX) || defined(OS_CHROMEOS)
   const internal::AddressTrackerLinux* tracker =
       NetworkChangeNotifier::GetAddressTracker();
@@ -395,6 +385,46 @@ void AddressSorterPosix::OnIPAddressChanged() {
 #endif
 }
 
+base::Optional<IPAddress> AddressSorterPosix::GetSourceAddress(
+    const IPAddress& destination) const {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  auto cached = destination_source_cache_.Get(destination);
+  if (cached != destination_source_cache_.end())
+    return cached->second;
+
+  // Each socket can only be bound once.
+  std::unique_ptr<DatagramClientSocket> socket(
+      socket_factory_->CreateDatagramClientSocket(
+          DatagramSocket::DEFAULT_BIND, nullptr /* NetLog */, NetLogSource()));
+
+  // Even though no packets are sent, cannot use port 0 in Connect.
+  IPEndPoint dest(destination, 80 /* port */);
+  int rv = socket->Connect(dest);
+  if (rv != OK) {
+    VLOG(1) << "Could not connect to " << dest.ToStringWithoutPort()
+            << " reason " << rv;
+    return base::nullopt;
+  }
+  IPEndPoint src;
+  rv = socket->GetLocalAddress(&src);
+  if (rv != OK) {
+    LOG(WARNING) << "Could not get local address for "
+                 << dest.ToStringWithoutPort() << " reason " << rv;
+    return base::nullopt;
+  }
+
+  destination_source_cache_.Put(destination, src.address());
+  return src.address();
+}
+
+void AddressSorterPosix::OnConnectionTypeChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  // Routes may change without any local address changing, e.g. when switching
+  // between networks that hand out the same addresses.
+  destination_source_cache_.Clear();
+}
+
 void AddressSorterPosix::FillPolicy(const IPAddress& address,
                                     SourceAddressInfo* info) const {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
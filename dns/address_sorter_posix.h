@@ -8,7 +8,9 @@
 #include <map>
 #include <vector>
 
+#include "base/containers/mru_cache.h"
 #include "base/macros.h"
+#include "base/optional.h"
 #include "base/threading/thread_checker.h"
 #include "net/base/address_list.h"
 #include "net/base/ip_address.h"
@@ -24,7 +26,8 @@ class ClientSocketFactory;
 // thread-safe and always completes synchronously.
 class NET_EXPORT_PRIVATE AddressSorterPosix
     : public AddressSorter,
-      public NetworkChangeNotifier::IPAddressObserver {
+      public NetworkChangeNotifier::IPAddressObserver,
+      public NetworkChangeNotifier::ConnectionTypeObserver {
  public:
   // Generic policy entry.
   struct PolicyEntry {
@@ -59,6 +62,9 @@ class NET_EXPORT_PRIVATE AddressSorterPosix
 
   typedef std::map<IPAddress, SourceAddressInfo> SourceAddressMap;
 
+  // Source address chosen by the OS for a destination.
+  typedef base::MRUCache<IPAddress, IPAddress> DestinationSourceCache;
+
   explicit AddressSorterPosix(ClientSocketFactory* socket_factory);
   ~AddressSorterPosix() override;
 
@@ -71,13 +77,32 @@ class NET_EXPORT_PRIVATE AddressSorterPosix
   // NetworkChangeNotifier::IPAddressObserver:
   void OnIPAddressChanged() override;
 
+  // NetworkChangeNotifier::ConnectionTypeObserver:
+  void OnConnectionTypeChanged(
+      NetworkChangeNotifier::ConnectionType type) override;
+
   // Fills |info| with values for |address| from policy tables.
   void FillPolicy(const IPAddress& address, SourceAddressInfo* info) const;
 
+  // Returns the source address the OS would use to reach |destination|, or
+  // nullopt if |destination| is unusable. Source addresses are cached until
+  // the next OnIPAddressChanged() or OnConnectionTypeChanged(). Failures are
+  // not cached, as they are often transient, e.g. no route yet after a network
+  // change.
+  base::Optional<IPAddress> GetSourceAddress(
+      const IPAddress& destination) const;
+
   // Mutable to allow using default values for source addresses which were not
   // found in most recent OnIPAddressChanged.
   mutable SourceAddressMap source_map_;
 
+  // Finding the source address for a destination takes a socket() and a
+  // connect() syscall, and the same destinations are sorted over and over, so
+  // the results are cached. Source selection only depends on local addresses
+  // and routes, so the cache is cleared with |source_map_| and whenever the
+  // connection type changes.
+  mutable DestinationSourceCache destination_source_cache_;
+
   ClientSocketFactory* socket_factory_;
   PolicyTable precedence_table_;
   PolicyTable label_table_;
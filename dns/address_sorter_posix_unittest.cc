@@ -149,6 +149,7 @@ class TestSocketFactory : public ClientSocketFactory {
       DatagramSocket::BindType,
       NetLog*,
       const NetLogSource&) override {
+    ++num_datagram_sockets_created_;
     return std::unique_ptr<DatagramClientSocket>(
         new TestUDPClientSocket(&mapping_));
   }
@@ -187,8 +188,13 @@ class TestSocketFactory : public ClientSocketFactory {
     mapping_[dst] = src;
   }
 
+  int num_datagram_sockets_created() const {
+    return num_datagram_sockets_created_;
+  }
+
  private:
   AddressMapping mapping_;
+  int num_datagram_sockets_created_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(TestSocketFactory);
 };
@@ -224,6 +230,12 @@ class AddressSorterPosixTest : public TestWithTaskEnvironment {
     return info;
   }
 
+  void OnIPAddressChanged() { sorter_.OnIPAddressChanged(); }
+
+  void OnConnectionTypeChanged() {
+    sorter_.OnConnectionTypeChanged(NetworkChangeNotifier::CONNECTION_WIFI);
+  }
+
   // Verify that NULL-terminated |addresses| matches (-1)-terminated |order|
   // after sorting.
   void Verify(const char* const addresses[], const int order[]) {
@@ -391,4 +403,51 @@ TEST_F(AddressSorterPosixTest, MultipleRules) {
   Verify(addresses, order);
 }
 
+// Source addresses are only looked up once per destination until local IP
+// addresses change.
+TEST_F(AddressSorterPosixTest, CachesSourceAddresses) {
+  AddMapping("4000::1", "4000::10");
+  AddMapping("10.0.0.231", "10.0.0.1");
+  const char* const addresses[] = {"4000::1", "10.0.0.231", "4001::1", NULL};
+  const int order[] = {0, 1, -1};
+  Verify(addresses, order);
+  EXPECT_EQ(3, socket_factory_.num_datagram_sockets_created());
+
+  // Only the usable destinations are cached.
+  Verify(addresses, order);
+  EXPECT_EQ(4, socket_factory_.num_datagram_sockets_created());
+
+  OnIPAddressChanged();
+  Verify(addresses, order);
+  EXPECT_EQ(7, socket_factory_.num_datagram_sockets_created());
+}
+
+// A destination that could not be reached is looked up again, so a transient
+// failure doesn't make it unusable until the next IP address change.
+TEST_F(AddressSorterPosixTest, DoesNotCacheFailures) {
+  AddMapping("4000::1", "4000::10");
+  const char* const addresses[] = {"4000::1", "4001::1", NULL};
+  const int order[] = {0, -1};
+  Verify(addresses, order);
+
+  AddMapping("4001::1", "4000::10");
+  const int new_order[] = {0, 1, -1};
+  Verify(addresses, new_order);
+}
+
+// Cached source addresses are dropped when the connection type changes, as
+// routes may have changed with it.
+TEST_F(AddressSorterPosixTest, ClearsCacheOnConnectionTypeChange) {
+  AddMapping("4000::1", "4000::10");
+  const char* const addresses[] = {"4000::1", NULL};
+  const int order[] = {0, -1};
+  Verify(addresses, order);
+  Verify(addresses, order);
+  EXPECT_EQ(1, socket_factory_.num_datagram_sockets_created());
+
+  OnConnectionTypeChanged();
+  Verify(addresses, order);
+  EXPECT_EQ(2, socket_factory_.num_datagram_sockets_created());
+}
+
 }  // namespace net
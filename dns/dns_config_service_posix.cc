@@ -376,7 +376,9 @@ class DnsConfigServicePosix::HostsReader : public SerialWorker {
     base::TimeTicks start_time = base::TimeTicks::Now();
     base::ScopedBlockingCall scoped_blocking_call(
         FROM_HERE, base::BlockingType::MAY_BLOCK);
-    success_ = ParseHostsFile(file_path_hosts_, &hosts_);
+    // |hosts_| still holds the result of the previous read, which lets
+    // |parser_| only parse lines appended to the file since then.
+    success_ = parser_.ParseFile(file_path_hosts_, &hosts_);
     UMA_HISTOGRAM_BOOLEAN("AsyncDNS.HostParseResult", success_);
     UMA_HISTOGRAM_TIMES("AsyncDNS.HostsParseDuration",
                         base::TimeTicks::Now() - start_time);
@@ -399,6 +401,8 @@ class DnsConfigServicePosix::HostsReader : public SerialWorker {
   // Written in DoWork, read in OnWorkFinished, no locking necessary.
   DnsHosts hosts_;
   bool success_;
+  // Only used in DoWork, which SerialWorker never runs concurrently.
+  IncrementalHostsParser parser_;
 
   DISALLOW_COPY_AND_ASSIGN(HostsReader);
 };
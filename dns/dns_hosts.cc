@@ -4,10 +4,17 @@
 
 #include "net/dns/dns_hosts.h"
 
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
 #include "base/check.h"
 #include "base/files/file_util.h"
 #include "base/macros.h"
 #include "base/strings/string_util.h"
+#include "crypto/secure_hash.h"
 #include "net/dns/dns_util.h"
 
 using base::StringPiece;
@@ -16,6 +23,32 @@ namespace net {
 
 namespace {
 
+// Character classes recognized by HostsParser. Looked up from a static table
+// rather than with StringPiece::find_first_of(), which builds a fresh lookup
+// table on every call and dominates parse time for large hosts files.
+enum HostsCharClass : uint8_t {
+  HOSTS_CHAR_TOKEN = 0,
+  HOSTS_CHAR_WHITESPACE = 1 << 0,
+  HOSTS_CHAR_COMMA = 1 << 1,
+  HOSTS_CHAR_NEWLINE = 1 << 2,
+  HOSTS_CHAR_COMMENT = 1 << 3,
+};
+
+struct HostsCharClassTable {
+  constexpr HostsCharClassTable() : classes() {
+    classes[static_cast<uint8_t>(' ')] = HOSTS_CHAR_WHITESPACE;
+    classes[static_cast<uint8_t>('\t')] = HOSTS_CHAR_WHITESPACE;
+    classes[static_cast<uint8_t>(',')] = HOSTS_CHAR_COMMA;
+    classes[static_cast<uint8_t>('\r')] = HOSTS_CHAR_NEWLINE;
+    classes[static_cast<uint8_t>('\n')] = HOSTS_CHAR_NEWLINE;
+    classes[static_cast<uint8_t>('#')] = HOSTS_CHAR_COMMENT;
+  }
+
+  uint8_t classes[256];
+};
+
+constexpr HostsCharClassTable kHostsCharClasses;
+
 // Parses the contents of a hosts file.  Returns one token (IP or hostname) at
 // a time.  Doesn't copy anything; accepts the file as a StringPiece and
 // returns tokens as StringPieces.
@@ -27,14 +60,19 @@ class HostsParser {
         end_(text.size()),
         pos_(0),
         token_is_ip_(false),
-        comma_mode_(comma_mode) {}
+        comma_mode_(comma_mode),
+        whitespace_mask_(comma_mode == PARSE_HOSTS_COMMA_IS_WHITESPACE
+                             ? HOSTS_CHAR_WHITESPACE | HOSTS_CHAR_COMMA
+                             : HOSTS_CHAR_WHITESPACE),
+        token_end_mask_(whitespace_mask_ | HOSTS_CHAR_NEWLINE |
+                        HOSTS_CHAR_COMMENT) {}
 
   // Advances to the next token (IP or hostname).  Returns whether another
   // token was available.  |token_is_ip| and |token| can be used to find out
   // the type and text of the token.
   bool Advance() {
     bool next_is_ip = (pos_ == 0);
-    while (pos_ < end_ && pos_ != std::string::npos) {
+    while (pos_ < end_) {
       switch (text_[pos_]) {
         case ' ':
         case '\t':
@@ -63,9 +101,8 @@ class HostsParser {
         default: {
           size_t token_start = pos_;
           SkipToken();
-          size_t token_end = (pos_ == std::string::npos) ? end_ : pos_;
 
-          token_ = StringPiece(data_ + token_start, token_end - token_start);
+          token_ = StringPiece(data_ + token_start, pos_ - token_start);
           token_is_ip_ = next_is_ip;
 
           return true;
@@ -80,7 +117,8 @@ class HostsParser {
   // address doesn't parse, to avoid wasting time tokenizing hostnames that
   // will be ignored.
   void SkipRestOfLine() {
-    pos_ = text_.find("\n", pos_);
+    const void* newline = memchr(data_ + pos_, '\n', end_ - pos_);
+    pos_ = newline ? static_cast<const char*>(newline) - data_ : end_;
   }
 
   // Returns whether the last-parsed token is an IP address (true) or a
@@ -94,26 +132,18 @@ class HostsParser {
   const StringPiece& token() { return token_; }
 
  private:
+  uint8_t CharClassAt(size_t pos) const {
+    return kHostsCharClasses.classes[static_cast<uint8_t>(data_[pos])];
+  }
+
   void SkipToken() {
-    switch (comma_mode_) {
-      case PARSE_HOSTS_COMMA_IS_TOKEN:
-        pos_ = text_.find_first_of(" \t\n\r#", pos_);
-        break;
-      case PARSE_HOSTS_COMMA_IS_WHITESPACE:
-        pos_ = text_.find_first_of(" ,\t\n\r#", pos_);
-        break;
-    }
+    while (pos_ < end_ && !(CharClassAt(pos_) & token_end_mask_))
+      pos_++;
   }
 
   void SkipWhitespace() {
-    switch (comma_mode_) {
-      case PARSE_HOSTS_COMMA_IS_TOKEN:
-        pos_ = text_.find_first_not_of(" \t", pos_);
-        break;
-      case PARSE_HOSTS_COMMA_IS_WHITESPACE:
-        pos_ = text_.find_first_not_of(" ,\t", pos_);
-        break;
-    }
+    while (pos_ < end_ && (CharClassAt(pos_) & whitespace_mask_))
+      pos_++;
   }
 
   const StringPiece text_;
@@ -125,18 +155,31 @@ class HostsParser {
   bool token_is_ip_;
 
   const ParseHostsCommaMode comma_mode_;
+  const uint8_t whitespace_mask_;
+  const uint8_t token_end_mask_;
 
   DISALLOW_COPY_AND_ASSIGN(HostsParser);
 };
 
-void ParseHostsWithCommaMode(const std::string& contents,
+// Parses |contents| and adds its entries to |dns_hosts|, keeping any entry
+// already present (first hit counts).
+void ParseHostsWithCommaMode(StringPiece contents,
                              DnsHosts* dns_hosts,
                              ParseHostsCommaMode comma_mode) {
   CHECK(dns_hosts);
 
+  // Most lines of large hosts files hold a single hostname, so the line count
+  // is a cheap estimate that avoids rehashing in the typical case. Lines with
+  // several hostnames may still grow the table past it.
+  dns_hosts->reserve(dns_hosts->size() +
+                     std::count(contents.begin(), contents.end(), '\n') + 1);
+
   StringPiece ip_text;
   IPAddress ip;
   AddressFamily family = ADDRESS_FAMILY_IPV4;
+  // Reused for every hostname so that names which are already present, or
+  // which fail validation, never allocate.
+  DnsHostsKey key;
   HostsParser parser(contents, comma_mode);
   while (parser.Advance()) {
     if (parser.token_is_ip()) {
@@ -155,41 +198,32 @@ void ParseHostsWithCommaMode(const std::string& contents,
         }
       }
     } else {
-      DnsHostsKey key(parser.token().as_string(), family);
-      if (!IsValidDNSDomain(key.first))
+      StringPiece hostname = parser.token();
+      if (!IsValidDNSDomain(hostname))
         continue;
-      key.first = base::ToLowerASCII(key.first);
-      IPAddress* mapped_ip = &(*dns_hosts)[key];
-      if (mapped_ip->empty())
-        *mapped_ip = ip;
+      key.first.assign(hostname.data(), hostname.size());
+      for (char& c : key.first)
+        c = base::ToLowerASCII(c);
+      key.second = family;
+      if (dns_hosts->find(key) == dns_hosts->end())
+        dns_hosts->emplace(key, ip);
       // else ignore this entry (first hit counts)
     }
   }
 }
 
-}  // namespace
-
-void ParseHostsWithCommaModeForTesting(const std::string& contents,
-                                       DnsHosts* dns_hosts,
-                                       ParseHostsCommaMode comma_mode) {
-  ParseHostsWithCommaMode(contents, dns_hosts, comma_mode);
-}
-
-void ParseHosts(const std::string& contents, DnsHosts* dns_hosts) {
-  ParseHostsCommaMode comma_mode;
+ParseHostsCommaMode GetDefaultCommaMode() {
 #if defined(OS_APPLE)
   // Mac OS X allows commas to separate hostnames.
-  comma_mode = PARSE_HOSTS_COMMA_IS_WHITESPACE;
+  return PARSE_HOSTS_COMMA_IS_WHITESPACE;
 #else
   // Linux allows commas in hostnames.
-  comma_mode = PARSE_HOSTS_COMMA_IS_TOKEN;
+  return PARSE_HOSTS_COMMA_IS_TOKEN;
 #endif
-
-  ParseHostsWithCommaMode(contents, dns_hosts, comma_mode);
 }
 
-bool ParseHostsFile(const base::FilePath& path, DnsHosts* dns_hosts) {
-  dns_hosts->clear();
+bool ReadHostsFile(const base::FilePath& path, std::string* contents) {
+  contents->clear();
   // Missing file indicates empty HOSTS.
   if (!base::PathExists(path))
     return true;
@@ -203,12 +237,98 @@ bool ParseHostsFile(const base::FilePath& path, DnsHosts* dns_hosts) {
   if (size > kMaxHostsSize)
     return false;
 
+  return base::ReadFileToString(path, contents);
+}
+
+}  // namespace
+
+void ParseHostsWithCommaModeForTesting(const std::string& contents,
+                                       DnsHosts* dns_hosts,
+                                       ParseHostsCommaMode comma_mode) {
+  ParseHostsWithCommaMode(contents, dns_hosts, comma_mode);
+}
+
+void ParseHosts(const std::string& contents, DnsHosts* dns_hosts) {
+  ParseHostsWithCommaMode(contents, dns_hosts, GetDefaultCommaMode());
+}
+
+bool ParseHostsFile(const base::FilePath& path, DnsHosts* dns_hosts) {
+  dns_hosts->clear();
   std::string contents;
-  if (!base::ReadFileToString(path, &contents))
+  if (!ReadHostsFile(path, &contents))
     return false;
 
   ParseHosts(contents, dns_hosts);
   return true;
 }
 
+IncrementalHostsParser::IncrementalHostsParser()
+    : IncrementalHostsParser(GetDefaultCommaMode()) {}
+
+IncrementalHostsParser::IncrementalHostsParser(ParseHostsCommaMode comma_mode)
+    : comma_mode_(comma_mode) {}
+
+IncrementalHostsParser::~IncrementalHostsParser() = default;
+
+bool IncrementalHostsParser::Parse(const std::string& contents,
+                                   DnsHosts* dns_hosts) {
+  DCHECK(dns_hosts);
+
+  // |contents| is hashed in a single pass. The prefix that was parsed last
+  // time is hashed first, so that its digest can be compared with
+  // |parsed_digest_| before the rest is added.
+  std::unique_ptr<crypto::SecureHash> hash =
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256);
+  size_t hashed_length = 0;
+  bool incremental = false;
+  if (has_parsed_ && contents.size() >= parsed_length_) {
+    hash->Update(contents.data(), parsed_length_);
+    hashed_length = parsed_length_;
+    Digest prefix_digest;
+    hash->Clone()->Finish(prefix_digest.data(), prefix_digest.size());
+    incremental = prefix_digest == parsed_digest_;
+  }
+  if (!incremental)
+    dns_hosts->clear();
+
+  size_t start = incremental ? parsed_length_ : 0;
+  ParseHostsWithCommaMode(StringPiece(contents).substr(start), dns_hosts,
+                          comma_mode_);
+
+  // Only remember the contents up to the last complete line; a trailing
+  // partial line may still be extended by the next write to the file, and
+  // its tokens would otherwise be parsed with the wrong line context.
+  size_t last_newline = contents.rfind('\n');
+  if (last_newline == std::string::npos || last_newline + 1 < contents.size()) {
+    // Without a trailing newline the whole file must be reparsed next time.
+    Reset();
+    return incremental;
+  }
+  hash->Update(contents.data() + hashed_length,
+               contents.size() - hashed_length);
+  hash->Finish(parsed_digest_.data(), parsed_digest_.size());
+  has_parsed_ = true;
+  parsed_length_ = contents.size();
+  return incremental;
+}
+
+bool IncrementalHostsParser::ParseFile(const base::FilePath& path,
+                                       DnsHosts* dns_hosts) {
+  std::string contents;
+  if (!ReadHostsFile(path, &contents)) {
+    Reset();
+    dns_hosts->clear();
+    return false;
+  }
+
+  Parse(contents, dns_hosts);
+  return true;
+}
+
+void IncrementalHostsParser::Reset() {
+  has_parsed_ = false;
+  parsed_length_ = 0;
+  parsed_digest_ = {};
+}
+
 }  // namespace net
@@ -6,7 +6,9 @@
 #define NET_DNS_DNS_HOSTS_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
+#include <array>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -14,7 +16,9 @@
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/macros.h"
 #include "base/strings/string_piece.h"
+#include "crypto/sha2.h"
 #include "net/base/address_family.h"
 #include "net/base/ip_address.h"
 #include "net/base/net_export.h"
@@ -70,7 +74,45 @@ void NET_EXPORT_PRIVATE ParseHosts(const std::string& contents,
 bool NET_EXPORT_PRIVATE ParseHostsFile(const base::FilePath& path,
                                        DnsHosts* dns_hosts);
 
-
+// Parses successive versions of the same hosts file, reusing the previous
+// result when possible. Large blocklist-style hosts files are usually updated
+// by appending lines, so when the new contents start with the complete lines
+// that were parsed last time, only the appended lines are parsed and merged
+// into the existing DnsHosts. Any other change falls back to a full parse.
+//
+// The parser only remembers the length and a SHA-256 digest of the previously
+// parsed contents, not the contents themselves, so that an accidental match
+// that would keep stale entries is not a practical concern.
+class NET_EXPORT_PRIVATE IncrementalHostsParser {
+ public:
+  IncrementalHostsParser();
+  explicit IncrementalHostsParser(ParseHostsCommaMode comma_mode);
+  ~IncrementalHostsParser();
+
+  // Parses |contents| into |dns_hosts|. |dns_hosts| must be unmodified since
+  // the previous call to Parse() or ParseFile() on this parser, if any.
+  // Returns true if only the lines appended since that call were parsed.
+  bool Parse(const std::string& contents, DnsHosts* dns_hosts);
+
+  // As above but reads the file pointed to by |path|. Returns false, and
+  // clears |dns_hosts|, if the file could not be read.
+  bool ParseFile(const base::FilePath& path, DnsHosts* dns_hosts);
+
+  // Forgets the previously parsed contents, forcing the next parse to be a
+  // full one.
+  void Reset();
+
+ private:
+  using Digest = std::array<uint8_t, crypto::kSHA256Length>;
+
+  const ParseHostsCommaMode comma_mode_;
+
+  bool has_parsed_ = false;
+  size_t parsed_length_ = 0;
+  Digest parsed_digest_ = {};
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementalHostsParser);
+};
 
 }  // namespace net
 
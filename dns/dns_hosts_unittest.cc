@@ -179,6 +179,78 @@ TEST(DnsHostsTest, HostsParser_EndsWithNewlineAndToken) {
   EXPECT_EQ(1u, hosts.size());
 }
 
+TEST(DnsHostsTest, IncrementalParser_AppendedLines) {
+  IncrementalHostsParser parser(PARSE_HOSTS_COMMA_IS_TOKEN);
+  DnsHosts hosts;
+  EXPECT_FALSE(parser.Parse("127.0.0.1 localhost\n", &hosts));
+  EXPECT_EQ(1u, hosts.size());
+
+  // Appended lines are merged into the previous result, and earlier entries
+  // still win.
+  const std::string kAppended =
+      "127.0.0.1 localhost\n"
+      "10.0.0.1 localhost\n"
+      "10.0.0.2 Foo.example\n";
+  EXPECT_TRUE(parser.Parse(kAppended, &hosts));
+
+  DnsHosts expected_hosts;
+  ParseHostsWithCommaModeForTesting(kAppended, &expected_hosts,
+                                    PARSE_HOSTS_COMMA_IS_TOKEN);
+  EXPECT_EQ(expected_hosts, hosts);
+
+  // Unchanged contents need no parsing at all.
+  EXPECT_TRUE(parser.Parse(kAppended, &hosts));
+  EXPECT_EQ(expected_hosts, hosts);
+}
+
+TEST(DnsHostsTest, IncrementalParser_ModifiedLines) {
+  IncrementalHostsParser parser(PARSE_HOSTS_COMMA_IS_TOKEN);
+  DnsHosts hosts;
+  EXPECT_FALSE(parser.Parse("127.0.0.1 localhost\n10.0.0.1 foo\n", &hosts));
+  EXPECT_EQ(2u, hosts.size());
+
+  // A change to an existing line forces a full parse, dropping stale entries.
+  const std::string kModified = "127.0.0.1 localhost\n10.0.0.2 bar\n";
+  EXPECT_FALSE(parser.Parse(kModified, &hosts));
+
+  DnsHosts expected_hosts;
+  ParseHostsWithCommaModeForTesting(kModified, &expected_hosts,
+                                    PARSE_HOSTS_COMMA_IS_TOKEN);
+  EXPECT_EQ(expected_hosts, hosts);
+}
+
+TEST(DnsHostsTest, IncrementalParser_ModifiedAndAppendedLines) {
+  IncrementalHostsParser parser(PARSE_HOSTS_COMMA_IS_TOKEN);
+  DnsHosts hosts;
+  EXPECT_FALSE(parser.Parse("127.0.0.1 localhost\n10.0.0.1 foo\n", &hosts));
+
+  // The previously parsed length is still a prefix, but its bytes differ, so
+  // the appended line must not be merged into the stale entries.
+  const std::string kModified =
+      "127.0.0.1 localhost\n10.0.0.2 bar\n10.0.0.3 baz\n";
+  EXPECT_FALSE(parser.Parse(kModified, &hosts));
+
+  DnsHosts expected_hosts;
+  ParseHostsWithCommaModeForTesting(kModified, &expected_hosts,
+                                    PARSE_HOSTS_COMMA_IS_TOKEN);
+  EXPECT_EQ(expected_hosts, hosts);
+}
+
+TEST(DnsHostsTest, IncrementalParser_PartialLastLine) {
+  IncrementalHostsParser parser(PARSE_HOSTS_COMMA_IS_TOKEN);
+  DnsHosts hosts;
+  EXPECT_FALSE(parser.Parse("127.0.0.1 localhost\n10.0.0.1 foo", &hosts));
+
+  // The unterminated line could have been extended, so it is not reused.
+  const std::string kExtended = "127.0.0.1 localhost\n10.0.0.1 foobar\n";
+  EXPECT_FALSE(parser.Parse(kExtended, &hosts));
+
+  DnsHosts expected_hosts;
+  ParseHostsWithCommaModeForTesting(kExtended, &expected_hosts,
+                                    PARSE_HOSTS_COMMA_IS_TOKEN);
+  EXPECT_EQ(expected_hosts, hosts);
+}
+
 }  // namespace
 
 }  // namespace net
@@ -31,6 +31,58 @@ const size_t kHeaderSize = sizeof(dns_protocol::Header);
 
 const uint8_t kRcodeMask = 0xf;
 
+// Remembers the packet offsets of names known to match the name currently
+// being looked for. Owner names in an answer section are almost always
+// compressed to a single pointer to the question name or to the previous
+// CNAME target, so once one record has matched, the following ones can be
+// matched by their pointer alone instead of walking and comparing the labels
+// again.
+class NameMatchCache {
+ public:
+  NameMatchCache(const DnsRecordParser& parser, const char* packet)
+      : parser_(parser), packet_(packet) {}
+
+  // Returns true if the name at |pos| matches |dotted|. |dotted| must be the
+  // same as in previous calls since the last Clear().
+  bool Matches(const char* pos, base::StringPiece dotted) {
+    // A name that starts with a pointer is the same as the name it points at.
+    uint16_t offset = pos - packet_;
+    if ((*pos & dns_protocol::kLabelMask) == dns_protocol::kLabelPointer &&
+        parser_.ReadName(pos, nullptr) == sizeof(uint16_t)) {
+      base::ReadBigEndian<uint16_t>(pos, &offset);
+      offset &= dns_protocol::kOffsetMask;
+    }
+
+    for (size_t i = 0; i < num_offsets_; ++i) {
+      if (offsets_[i] == offset)
+        return true;
+    }
+    if (!parser_.NameMatches(pos, dotted))
+      return false;
+    offsets_[next_slot_] = offset;
+    next_slot_ = (next_slot_ + 1) % kMaxOffsets;
+    if (num_offsets_ < kMaxOffsets)
+      ++num_offsets_;
+    return true;
+  }
+
+  void Clear() {
+    num_offsets_ = 0;
+    next_slot_ = 0;
+  }
+
+ private:
+  static constexpr size_t kMaxOffsets = 4;
+
+  const DnsRecordParser& parser_;
+  const char* const packet_;
+  uint16_t offsets_[kMaxOffsets];
+  size_t num_offsets_ = 0;
+  size_t next_slot_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(NameMatchCache);
+};
+
 }  // namespace
 
 DnsResourceRecord::DnsResourceRecord() = default;
@@ -122,8 +174,10 @@ DnsRecordParser::DnsRecordParser(const void* packet,
   DCHECK_LE(offset, length);
 }
 
-unsigned DnsRecordParser::ReadName(const void* const vpos,
-                                   std::string* out) const {
+template <typename LabelCallback>
+unsigned DnsRecordParser::WalkName(const void* const vpos,
+                                   bool stop_at_pointer,
+                                   LabelCallback on_label) const {
   static const char kAbortMsg[] = "Abort parsing of noncompliant DNS record.";
 
   const char* const pos = reinterpret_cast<const char*>(vpos);
@@ -147,11 +201,6 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
   if (pos >= end)
     return 0;
 
-  if (out) {
-    out->clear();
-    out->reserve(dns_protocol::kMaxNameLength);
-  }
-
   for (;;) {
     // The first two bits of the length give the type of the length. It's
     // either a direct length or a pointer to the remainder of the name.
@@ -163,8 +212,8 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
         }
         if (consumed == 0) {
           consumed = p - pos + sizeof(uint16_t);
-          if (!out)
-            return consumed;  // If name is not stored, that's all we need.
+          if (stop_at_pointer)
+            return consumed;  // If name is not needed, that's all we need.
         }
         seen += sizeof(uint16_t);
         // If seen the whole packet, then we must be in a loop.
@@ -203,11 +252,8 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
           VLOG(1) << kAbortMsg << " Truncated or missing label.";
           return 0;  // Truncated or missing label.
         }
-        if (out) {
-          if (!out->empty())
-            out->append(".");
-          out->append(p, label_len);
-        }
+        if (!on_label(p, label_len))
+          return 0;
         p += label_len;
         seen += 1 + label_len;
         break;
@@ -220,6 +266,48 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
   }
 }
 
+unsigned DnsRecordParser::ReadName(const void* const vpos,
+                                   std::string* out) const {
+  if (out) {
+    out->clear();
+    out->reserve(dns_protocol::kMaxNameLength);
+  }
+
+  // If the name is not stored, parsing can stop at the first label pointer.
+  return WalkName(vpos, /*stop_at_pointer=*/!out,
+                  [out](const char* label, uint8_t label_len) {
+                    if (out) {
+                      if (!out->empty())
+                        out->append(".");
+                      out->append(label, label_len);
+                    }
+                    return true;
+                  });
+}
+
+bool DnsRecordParser::NameMatches(const void* pos,
+                                  base::StringPiece dotted) const {
+  size_t matched = 0;
+  unsigned consumed = WalkName(
+      pos, /*stop_at_pointer=*/false,
+      [dotted, &matched](const char* label, uint8_t label_len) {
+        if (matched != 0) {
+          if (matched == dotted.size() || dotted[matched] != '.')
+            return false;
+          ++matched;
+        }
+        if (dotted.size() - matched < label_len ||
+            !base::EqualsCaseInsensitiveASCII(
+                base::StringPiece(label, label_len),
+                dotted.substr(matched, label_len))) {
+          return false;
+        }
+        matched += label_len;
+        return true;
+      });
+  return consumed != 0 && matched == dotted.size();
+}
+
 bool DnsRecordParser::ReadRecord(DnsResourceRecord* out) {
   DCHECK(packet_);
   size_t consumed = ReadName(cur_, &out->name);
@@ -239,6 +327,26 @@ bool DnsRecordParser::ReadRecord(DnsResourceRecord* out) {
   return false;
 }
 
+bool DnsRecordParser::ReadRecordView(DnsResourceRecordView* out) {
+  DCHECK(packet_);
+  size_t consumed = ReadName(cur_, nullptr);
+  if (!consumed)
+    return false;
+  base::BigEndianReader reader(cur_ + consumed,
+                               packet_ + length_ - (cur_ + consumed));
+  uint16_t rdlen;
+  if (reader.ReadU16(&out->type) &&
+      reader.ReadU16(&out->klass) &&
+      reader.ReadU32(&out->ttl) &&
+      reader.ReadU16(&rdlen) &&
+      reader.ReadPiece(&out->rdata, rdlen)) {
+    out->name_pos = cur_;
+    cur_ = reader.ptr();
+    return true;
+  }
+  return false;
+}
+
 bool DnsRecordParser::SkipQuestion() {
   size_t consumed = ReadName(cur_, nullptr);
   if (!consumed)
@@ -510,11 +618,15 @@ DnsResponse::Result DnsResponse::ParseToAddressList(
   base::Optional<base::TimeDelta> ttl;
   IPAddressList ip_addresses;
   DnsRecordParser parser = Parser();
-  DnsResourceRecord record;
+  // Records are only viewed in place; the only name ever decoded is the
+  // target of each CNAME, which becomes the next expected owner name.
+  DnsResourceRecordView record;
+  NameMatchCache name_cache(parser, io_buffer_->data());
   unsigned ancount = answer_count();
+  ip_addresses.reserve(ancount);
 
   for (unsigned i = 0; i < ancount; ++i) {
-    if (!parser.ReadRecord(&record))
+    if (!parser.ReadRecordView(&record))
       return DNS_MALFORMED_RESPONSE;
 
     base::TimeDelta record_ttl = base::TimeDelta::FromSeconds(record.ttl);
@@ -523,19 +635,20 @@ DnsResponse::Result DnsResponse::ParseToAddressList(
       if (!ip_addresses.empty())
         return DNS_CNAME_AFTER_ADDRESS;
 
-      if (!base::EqualsCaseInsensitiveASCII(record.name, expected_name))
+      if (!name_cache.Matches(record.name_pos, expected_name))
         return DNS_NAME_MISMATCH;
 
       if (record.rdata.size() !=
           parser.ReadName(record.rdata.begin(), &expected_name))
         return DNS_MALFORMED_CNAME;
+      name_cache.Clear();
 
       ttl = std::min(ttl.value_or(base::TimeDelta::Max()), record_ttl);
     } else if (record.type == expected_type) {
       if (record.rdata.size() != expected_size)
         return DNS_SIZE_MISMATCH;
 
-      if (!base::EqualsCaseInsensitiveASCII(record.name, expected_name))
+      if (!name_cache.Matches(record.name_pos, expected_name))
         return DNS_NAME_MISMATCH;
 
       ttl = std::min(ttl.value_or(base::TimeDelta::Max()), record_ttl);
@@ -551,7 +664,8 @@ DnsResponse::Result DnsResponse::ParseToAddressList(
     bool soa_found = false;
     unsigned nscount = base::NetToHost16(header()->nscount);
     for (unsigned i = 0; i < nscount; ++i) {
-      if (parser.ReadRecord(&record) && record.type == dns_protocol::kTypeSOA) {
+      if (parser.ReadRecordView(&record) &&
+          record.type == dns_protocol::kTypeSOA) {
         soa_found = true;
         base::TimeDelta record_ttl = base::TimeDelta::FromSeconds(record.ttl);
         ttl = std::min(ttl.value_or(base::TimeDelta::Max()), record_ttl);
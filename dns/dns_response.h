@@ -65,6 +65,19 @@ struct NET_EXPORT_PRIVATE DnsResourceRecord {
   std::string owned_rdata;
 };
 
+// Resource Record as returned by DnsRecordParser::ReadRecordView(). Unlike
+// DnsResourceRecord, nothing is copied out of the response buffer: the owner
+// name is left in its (possibly compressed) wire form at |name_pos| and can be
+// decoded on demand with DnsRecordParser::ReadName() or compared with
+// DnsRecordParser::NameMatches(). Only valid while the response buffer is.
+struct NET_EXPORT_PRIVATE DnsResourceRecordView {
+  const char* name_pos = nullptr;
+  uint16_t type = 0;
+  uint16_t klass = 0;
+  uint32_t ttl = 0;
+  base::StringPiece rdata;
+};
+
 // Iterator to walk over resource records of the DNS response packet.
 class NET_EXPORT_PRIVATE DnsRecordParser {
  public:
@@ -93,13 +106,33 @@ class NET_EXPORT_PRIVATE DnsRecordParser {
   // See RFC 1035 section 4.1.4.
   unsigned ReadName(const void* pos, std::string* out) const;
 
+  // Returns true if the (possibly compressed) DNS name at |pos| is valid and
+  // equal, ignoring ASCII case, to |dotted|, which must be in the dotted form
+  // produced by ReadName(). Unlike comparing the output of ReadName(), never
+  // allocates.
+  bool NameMatches(const void* pos, base::StringPiece dotted) const;
+
   // Parses the next resource record into |record|. Returns true if succeeded.
   bool ReadRecord(DnsResourceRecord* record);
 
+  // Like ReadRecord() but does not decode or copy the owner name. Returns true
+  // if succeeded.
+  bool ReadRecordView(DnsResourceRecordView* record);
+
   // Skip a question section, returns true if succeeded.
   bool SkipQuestion();
 
  private:
+  // Walks the labels of the (possibly compressed) DNS name at |pos|, calling
+  // |on_label(const char* label, uint8_t label_len)| for each one in order.
+  // Parsing aborts if |on_label| returns false. If |stop_at_pointer|, returns
+  // as soon as the number of consumed bytes is known, without following label
+  // pointers. Returns the number of bytes consumed or 0 on failure.
+  template <typename LabelCallback>
+  unsigned WalkName(const void* pos,
+                    bool stop_at_pointer,
+                    LabelCallback on_label) const;
+
   const char* packet_;
   size_t length_;
   // Current offset within the packet.
@@ -0,0 +1,151 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/dns_response.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/big_endian.h"
+#include "base/check.h"
+#include "base/optional.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/dns/dns_query.h"
+#include "net/dns/dns_util.h"
+#include "net/dns/public/dns_protocol.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 100000;
+const size_t kMaxResponseSize = dns_protocol::kMaxMulticastSize;
+const char kHostname[] = "www.example.com";
+const char kCanonicalName[] = "www.example.com.cdn.example.net";
+
+static constexpr char kMetricPrefixDnsResponse[] = "DnsResponseParse.";
+static constexpr char kMetricParseTimeMs[] = "parse_time";
+
+perf_test::PerfResultReporter SetUpDnsResponseReporter(
+    const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixDnsResponse, story);
+  reporter.RegisterImportantMetric(kMetricParseTimeMs, "ms");
+  return reporter;
+}
+
+// Builds a response to |query| the way most recursive resolvers write them:
+// a single CNAME followed by |num_addresses| A records, with every owner name
+// compressed into a pointer.
+std::vector<char> BuildResponse(const DnsQuery& query, size_t num_addresses) {
+  std::string canonical_name;
+  CHECK(DNSDomainFromDot(kCanonicalName, &canonical_name));
+
+  std::vector<char> packet(kMaxResponseSize);
+  base::BigEndianWriter writer(packet.data(), packet.size());
+  const uint16_t kQuestionOffset = sizeof(dns_protocol::Header);
+  CHECK(writer.WriteU16(query.id()));
+  CHECK(writer.WriteU16(dns_protocol::kFlagResponse | dns_protocol::kFlagRD));
+  CHECK(writer.WriteU16(1));                  // QDCOUNT
+  CHECK(writer.WriteU16(1 + num_addresses));  // ANCOUNT
+  CHECK(writer.WriteU16(0));                  // NSCOUNT
+  CHECK(writer.WriteU16(0));                  // ARCOUNT
+  CHECK(writer.WriteBytes(query.qname().data(), query.qname().size()));
+  CHECK(writer.WriteU16(query.qtype()));
+  CHECK(writer.WriteU16(dns_protocol::kClassIN));
+
+  // CNAME from the question name to |kCanonicalName|.
+  CHECK(writer.WriteU16(dns_protocol::kLabelPointer << 8 | kQuestionOffset));
+  CHECK(writer.WriteU16(dns_protocol::kTypeCNAME));
+  CHECK(writer.WriteU16(dns_protocol::kClassIN));
+  CHECK(writer.WriteU32(300));
+  CHECK(writer.WriteU16(canonical_name.size()));
+  const uint16_t cname_target_offset = writer.ptr() - packet.data();
+  CHECK(writer.WriteBytes(canonical_name.data(), canonical_name.size()));
+
+  for (size_t i = 0; i < num_addresses; ++i) {
+    CHECK(writer.WriteU16(dns_protocol::kLabelPointer << 8 |
+                          cname_target_offset));
+    CHECK(writer.WriteU16(dns_protocol::kTypeA));
+    CHECK(writer.WriteU16(dns_protocol::kClassIN));
+    CHECK(writer.WriteU32(60));
+    CHECK(writer.WriteU16(4));
+    CHECK(writer.WriteU32(0x0a000000 + i));
+  }
+
+  packet.resize(writer.ptr() - packet.data());
+  return packet;
+}
+
+class DnsResponseParseBenchmark : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    std::string qname;
+    ASSERT_TRUE(DNSDomainFromDot(kHostname, &qname));
+    query_.emplace(0x1234, qname, dns_protocol::kTypeA);
+    std::vector<char> packet = BuildResponse(*query_, GetParam());
+    response_ = std::make_unique<DnsResponse>(kMaxResponseSize);
+    memcpy(response_->io_buffer()->data(), packet.data(), packet.size());
+    ASSERT_TRUE(response_->InitParse(packet.size(), *query_));
+  }
+
+  std::string Story(const char* prefix) const {
+    return prefix + std::to_string(GetParam()) + "_addresses";
+  }
+
+  base::Optional<DnsQuery> query_;
+  std::unique_ptr<DnsResponse> response_;
+};
+
+TEST_P(DnsResponseParseBenchmark, ParseToAddressList) {
+  auto reporter = SetUpDnsResponseReporter(Story("address_list_"));
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    AddressList addresses;
+    base::Optional<base::TimeDelta> ttl;
+    CHECK_EQ(DnsResponse::DNS_PARSE_OK,
+             response_->ParseToAddressList(&addresses, &ttl));
+    CHECK_EQ(GetParam(), addresses.size());
+  }
+  reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+}
+
+// Walks the answer section copying every record, for comparison with the
+// view-based walk below.
+TEST_P(DnsResponseParseBenchmark, ReadRecord) {
+  auto reporter = SetUpDnsResponseReporter(Story("read_record_"));
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    DnsRecordParser parser = response_->Parser();
+    DnsResourceRecord record;
+    for (unsigned j = 0; j < response_->answer_count(); ++j)
+      CHECK(parser.ReadRecord(&record));
+  }
+  reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+}
+
+TEST_P(DnsResponseParseBenchmark, ReadRecordView) {
+  auto reporter = SetUpDnsResponseReporter(Story("read_record_view_"));
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    DnsRecordParser parser = response_->Parser();
+    DnsResourceRecordView record;
+    for (unsigned j = 0; j < response_->answer_count(); ++j)
+      CHECK(parser.ReadRecordView(&record));
+  }
+  reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         DnsResponseParseBenchmark,
+                         ::testing::Values(1, 8, 64));
+
+}  // namespace
+
+}  // namespace net
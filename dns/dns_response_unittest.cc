@@ -242,6 +242,78 @@ TEST(DnsRecordParserTest, ReadRecord) {
   EXPECT_FALSE(parser.ReadRecord(&record));
 }
 
+TEST(DnsRecordParserTest, ReadRecordView) {
+  const uint8_t data[] = {
+      // Type CNAME record.
+      0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00, 0x00,
+      0x05,                    // TYPE is CNAME.
+      0x00, 0x01,              // CLASS is IN.
+      0x00, 0x01, 0x24, 0x74,  // TTL is 0x00012474.
+      0x00, 0x06,              // RDLENGTH is 6 bytes.
+      0x03, 'f', 'o', 'o',     // compressed name in record
+      0xc0, 0x00,
+      // Type A record.
+      0x03, 'b', 'a', 'r',     // compressed owner name
+      0xc0, 0x00, 0x00, 0x01,  // TYPE is A.
+      0x00, 0x01,              // CLASS is IN.
+      0x00, 0x20, 0x13, 0x55,  // TTL is 0x00201355.
+      0x00, 0x04,              // RDLENGTH is 4 bytes.
+      0x7f, 0x02, 0x04, 0x01,  // IP is 127.2.4.1
+  };
+
+  DnsRecordParser parser(data, sizeof(data), 0);
+
+  DnsResourceRecordView record;
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_EQ(reinterpret_cast<const char*>(data), record.name_pos);
+  EXPECT_TRUE(parser.NameMatches(record.name_pos, "example.com"));
+  EXPECT_EQ(dns_protocol::kTypeCNAME, record.type);
+  EXPECT_EQ(dns_protocol::kClassIN, record.klass);
+  EXPECT_EQ(0x00012474u, record.ttl);
+  EXPECT_TRUE(parser.NameMatches(record.rdata.data(), "foo.example.com"));
+
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_TRUE(parser.NameMatches(record.name_pos, "BAR.example.COM"));
+  EXPECT_EQ(dns_protocol::kTypeA, record.type);
+  EXPECT_EQ(0x00201355u, record.ttl);
+  EXPECT_EQ(base::StringPiece("\x7f\x02\x04\x01"), record.rdata);
+  EXPECT_TRUE(parser.AtEnd());
+
+  // Test truncated record.
+  parser = DnsRecordParser(data, sizeof(data) - 2, 0);
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_FALSE(parser.ReadRecordView(&record));
+}
+
+TEST(DnsRecordParserTest, NameMatches) {
+  const uint8_t data[] = {
+      // all labels "foo.example.com"
+      0x03, 'f', 'o', 'o', 0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c',
+      'o', 'm',
+      // byte 0x10
+      0x00,
+      // byte 0x11
+      // part label, part pointer, "bar.example.com"
+      0x03, 'b', 'a', 'r', 0xc0, 0x04,
+      // byte 0x17
+      // pointer loop
+      0xc0, 0x19, 0xc0, 0x17,
+  };
+
+  DnsRecordParser parser(data, sizeof(data), 0);
+
+  EXPECT_TRUE(parser.NameMatches(data + 0x00, "foo.example.com"));
+  EXPECT_TRUE(parser.NameMatches(data + 0x00, "Foo.Example.Com"));
+  EXPECT_TRUE(parser.NameMatches(data + 0x10, ""));
+  EXPECT_TRUE(parser.NameMatches(data + 0x11, "bar.example.com"));
+
+  EXPECT_FALSE(parser.NameMatches(data + 0x00, "foo.example"));
+  EXPECT_FALSE(parser.NameMatches(data + 0x00, "foo.example.com.net"));
+  EXPECT_FALSE(parser.NameMatches(data + 0x00, "fooexample.com"));
+  EXPECT_FALSE(parser.NameMatches(data + 0x11, "foo.example.com"));
+  EXPECT_FALSE(parser.NameMatches(data + 0x17, ""));
+}
+
 TEST(DnsResponseTest, InitParse) {
   // This includes \0 at the end.
   const char qname_data[] = "\x0A""codereview""\x08""chromium""\x03""org";
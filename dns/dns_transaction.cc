@@ -16,6 +16,7 @@
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/containers/circular_deque.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
@@ -37,6 +38,7 @@
 #include "net/base/backoff_entry.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/elements_upload_data_stream.h"
+#include "net/base/features.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
@@ -1190,6 +1192,7 @@ class DnsTransactionImpl : public DnsTransaction,
     CHECK(result.rv != OK || response != nullptr);
 
     timer_.Stop();
+    hedge_timer_.Stop();
 
     net_log_.EndEventWithNetErrorCode(NetLogEventType::DNS_TRANSACTION,
                                       result.rv);
@@ -1234,7 +1237,8 @@ class DnsTransactionImpl : public DnsTransaction,
 
     size_t attempt_number = attempts_.size();
     AttemptResult result;
-    if (session_->udp_tracker()->low_entropy()) {
+    bool is_udp = !session_->udp_tracker()->low_entropy();
+    if (!is_udp) {
       result = MakeTcpAttempt(server_index, std::move(query));
       RecordAttemptUma(DnsAttemptType::kTcpLowEntropy);
     } else {
@@ -1248,11 +1252,36 @@ class DnsTransactionImpl : public DnsTransaction,
               server_index, attempt_number, session_.get());
       timer_.Start(FROM_HERE, fallback_period, this,
                    &DnsTransactionImpl::OnFallbackPeriodExpired);
+      // Only UDP attempts are hedged. The RTTs the hedging delay is derived
+      // from are UDP ones, and a TCP attempt also pays for a handshake.
+      if (is_udp)
+        MaybeStartHedgeTimer(server_index, attempt_number);
+      else
+        hedge_timer_.Stop();
     }
 
     return result;
   }
 
+  // If hedging is enabled, starts |hedge_timer_| to duplicate the pending
+  // attempt to |server_index| onto the next server once the attempt has taken
+  // longer than that server usually does. Each query is hedged at most once.
+  void MaybeStartHedgeTimer(size_t server_index, size_t attempt_number) {
+    hedge_timer_.Stop();
+    if (hedged_ || !MoreAttemptsAllowed() ||
+        !base::FeatureList::IsEnabled(features::kDnsHedgedQueries)) {
+      return;
+    }
+
+    base::Optional<base::TimeDelta> hedge_delay =
+        resolve_context_->NextClassicHedgeDelay(server_index, attempt_number,
+                                                session_.get());
+    if (!hedge_delay)
+      return;
+    hedge_timer_.Start(FROM_HERE, hedge_delay.value(), this,
+                       &DnsTransactionImpl::OnHedgeDelayExpired);
+  }
+
   // Makes another attempt at the current name, |qnames_.front()|, using the
   // next nameserver.
   AttemptResult MakeUdpAttempt(size_t server_index,
@@ -1378,6 +1407,9 @@ class DnsTransactionImpl : public DnsTransaction,
 
     attempts_.clear();
     had_tcp_retry_ = false;
+    hedged_ = false;
+    hedged_attempt_ = nullptr;
+    hedge_timer_.Stop();
     if (secure_) {
       dns_server_iterator_ = resolve_context_->GetDohIterator(
           session_->config(), secure_dns_mode_, session_.get());
@@ -1391,6 +1423,9 @@ class DnsTransactionImpl : public DnsTransaction,
     if (!dns_server_iterator_->AttemptAvailable())
       return AttemptResult(ERR_BLOCKED_BY_CLIENT, nullptr);
 
+    if (!secure_)
+      resolve_context_->RecordClassicQueryForHedging(session_.get());
+
     return MakeAttempt();
   }
 
@@ -1462,6 +1497,9 @@ class DnsTransactionImpl : public DnsTransaction,
           break;
         case ERR_CONNECTION_REFUSED:
         case ERR_DNS_TIMED_OUT:
+          // A new attempt follows, after which pending attempts are only
+          // waited on as in the unhedged case.
+          hedged_attempt_ = nullptr;
           if (result.attempt) {
             resolve_context_->RecordServerFailure(
                 result.attempt->server_index(), secure_ /* is_doh_server */,
@@ -1484,6 +1522,17 @@ class DnsTransactionImpl : public DnsTransaction,
           // Server failure.
           DCHECK(result.attempt);
 
+          // The attempt that was hedged failed while the hedge is still
+          // pending. Nothing recorded it yet, as it never reached its fallback
+          // period, so record it now and keep waiting for the hedge.
+          if (result.attempt == hedged_attempt_) {
+            hedged_attempt_ = nullptr;
+            resolve_context_->RecordServerFailure(
+                result.attempt->server_index(), secure_ /* is_doh_server */,
+                result.rv, session_.get());
+            return AttemptResult(ERR_IO_PENDING, nullptr);
+          }
+
           // If attempt is not the most recent attempt, means this error is for
           // a previous attempt that passed its fallback period and was treated
           // as complete but allowed to continue attempting in parallel with new
@@ -1497,6 +1546,11 @@ class DnsTransactionImpl : public DnsTransaction,
           resolve_context_->RecordServerFailure(result.attempt->server_index(),
                                                 secure_ /* is_doh_server */,
                                                 result.rv, session_.get());
+          // The hedge failed, but the attempt it duplicated may still answer.
+          if (hedged_attempt_) {
+            hedged_attempt_ = nullptr;
+            return AttemptResult(ERR_IO_PENDING, nullptr);
+          }
           if (!MoreAttemptsAllowed()) {
             return result;
           }
@@ -1512,6 +1566,8 @@ class DnsTransactionImpl : public DnsTransaction,
   void ClearAttempts(const DnsAttempt* leave_attempt) {
     for (auto it = attempts_.begin(); it != attempts_.end();) {
       if (!(*it)->is_completed() && it->get() != leave_attempt) {
+        if (it->get() == hedged_attempt_)
+          hedged_attempt_ = nullptr;
         it = attempts_.erase(it);
       } else {
         ++it;
@@ -1529,6 +1585,45 @@ class DnsTransactionImpl : public DnsTransaction,
       DoCallback(result);
   }
 
+  // Unlike OnFallbackPeriodExpired(), does not consider the pending attempt
+  // failed: both attempts keep running and the first valid answer wins.
+  void OnHedgeDelayExpired() {
+    if (callback_.is_null())
+      return;
+    DCHECK(!attempts_.empty());
+    if (!MoreAttemptsAllowed() ||
+        !resolve_context_->ConsumeClassicHedgeBudget(session_.get())) {
+      return;
+    }
+
+    hedged_ = true;
+    hedged_attempt_ = attempts_.back().get();
+    AttemptResult result = MakeAttempt();
+    if (result.rv == ERR_IO_PENDING)
+      return;
+    hedged_attempt_ = nullptr;
+
+    if (result.rv != OK && result.rv != ERR_NAME_NOT_RESOLVED &&
+        result.rv != ERR_DNS_SERVER_REQUIRES_TCP) {
+      // The hedge failed synchronously, so its fallback period was not
+      // started and the original attempt is still covered by its own. Record
+      // the failure and drop the hedge, which makes the original the most
+      // recent attempt again, so that its result is handled as if there had
+      // been no hedge.
+      if (result.attempt) {
+        resolve_context_->RecordServerFailure(result.attempt->server_index(),
+                                              secure_ /* is_doh_server */,
+                                              result.rv, session_.get());
+      }
+      attempts_.pop_back();
+      return;
+    }
+
+    result = ProcessAttemptResult(result);
+    if (result.rv != ERR_IO_PENDING)
+      DoCallback(result);
+  }
+
   scoped_refptr<DnsSession> session_;
   std::string hostname_;
   uint16_t qtype_;
@@ -1552,10 +1647,19 @@ class DnsTransactionImpl : public DnsTransaction,
   // Records when an attempt was retried via TCP due to a truncation error.
   bool had_tcp_retry_;
 
+  // Records when an attempt for the current name was hedged.
+  bool hedged_ = false;
+
+  // The attempt that was hedged, while it and the hedge, the most recent
+  // attempt, are both still waited on. Null otherwise.
+  const DnsAttempt* hedged_attempt_ = nullptr;
+
   // Iterator to get the index of the DNS server for each search query.
   std::unique_ptr<DnsServerIterator> dns_server_iterator_;
 
   base::OneShotTimer timer_;
+  // Fires when the pending classic attempt should be hedged.
+  base::OneShotTimer hedge_timer_;
 
   // TODO(ericorth@chromium.org): Use base::UnownedPtr once available.
   ResolveContext* resolve_context_;
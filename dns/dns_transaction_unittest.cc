@@ -21,9 +21,11 @@
 #include "base/strings/stringprintf.h"
 #include "base/sys_byteorder.h"
 #include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
 #include "base/values.h"
+#include "net/base/features.h"
 #include "net/base/ip_address.h"
 #include "net/base/port_util.h"
 #include "net/base/upload_bytes_element_reader.h"
@@ -1245,6 +1247,134 @@ TEST_F(DnsTransactionTestWithMockTime, ServerFallbackAndRotate) {
   CheckServerOrder(kOrder, base::size(kOrder));
 }
 
+TEST_F(DnsTransactionTestWithMockTime, HedgedQuery) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsHedgedQueries, {{"DnsHedgedQueriesMaxRatio", "1"}});
+  ConfigureNumServers(2);
+  ConfigureFactory();
+
+  // The first server usually answers quickly, but has a long tail.
+  for (int i = 0; i < 97; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromMilliseconds(20), OK,
+                                session_.get());
+  }
+  for (int i = 0; i < 3; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromSeconds(2), OK,
+                                session_.get());
+  }
+  base::Optional<base::TimeDelta> hedge_delay =
+      resolve_context_->NextClassicHedgeDelay(0, 0, session_.get());
+  ASSERT_TRUE(hedge_delay);
+  EXPECT_LT(hedge_delay.value(),
+            resolve_context_->NextClassicFallbackPeriod(0, 0, session_.get()));
+
+  AddHangingQuery(kT0HostName, kT0Qtype);
+  AddAsyncQueryAndResponse(0 /* id */, kT0HostName, kT0Qtype,
+                           kT0ResponseDatagram,
+                           base::size(kT0ResponseDatagram));
+
+  TransactionHelper helper0(kT0HostName, kT0Qtype, false /* secure */,
+                            kT0RecordCount, resolve_context_.get());
+  EXPECT_FALSE(helper0.Run(transaction_factory_.get()));
+
+  // The second server is queried without waiting for the fallback period, and
+  // its answer completes the transaction.
+  FastForwardBy(hedge_delay.value());
+  EXPECT_TRUE(helper0.has_completed());
+
+  size_t kOrder[] = {0, 1};
+  CheckServerOrder(kOrder, base::size(kOrder));
+}
+
+// A hedge that fails synchronously is dropped, and a later failure of the
+// attempt it duplicated still completes the transaction.
+TEST_F(DnsTransactionTestWithMockTime, HedgedQuery_SynchronousFailure) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsHedgedQueries, {{"DnsHedgedQueriesMaxRatio", "1"}});
+  config_.attempts = 1;
+  ConfigureNumServers(2);
+  ConfigureFactory();
+
+  for (int i = 0; i < 97; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromMilliseconds(20), OK,
+                                session_.get());
+  }
+  for (int i = 0; i < 3; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromSeconds(2), OK,
+                                session_.get());
+  }
+  base::Optional<base::TimeDelta> hedge_delay =
+      resolve_context_->NextClassicHedgeDelay(0, 0, session_.get());
+  ASSERT_TRUE(hedge_delay);
+
+  // The first server answers with SERVFAIL, but only once resumed.
+  auto original_data = std::make_unique<DnsSocketData>(
+      0 /* id */, kT0HostName, kT0Qtype, ASYNC, Transport::UDP);
+  original_data->AddReadError(ERR_IO_PENDING, ASYNC);
+  original_data->AddRcode(dns_protocol::kRcodeSERVFAIL, ASYNC);
+  SequencedSocketData* original_provider = original_data->GetProvider();
+  AddSocketData(std::move(original_data));
+  // The second server fails the hedge right away.
+  AddSyncQueryAndRcode(kT0HostName, kT0Qtype, dns_protocol::kRcodeSERVFAIL);
+
+  TransactionHelper helper0(kT0HostName, kT0Qtype, false /* secure */,
+                            ERR_DNS_SERVER_FAILED, resolve_context_.get());
+  EXPECT_FALSE(helper0.Run(transaction_factory_.get()));
+
+  FastForwardBy(hedge_delay.value());
+  EXPECT_FALSE(helper0.has_completed());
+
+  // The failure of the first server ends the transaction without waiting for
+  // its fallback period.
+  original_provider->Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(helper0.has_completed());
+
+  size_t kOrder[] = {0, 1};
+  CheckServerOrder(kOrder, base::size(kOrder));
+}
+
+TEST_F(DnsTransactionTestWithMockTime, HedgedQuery_NoBudget) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsHedgedQueries, {{"DnsHedgedQueriesMaxRatio", "0"}});
+  ConfigureNumServers(2);
+  ConfigureFactory();
+
+  for (int i = 0; i < 97; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromMilliseconds(20), OK,
+                                session_.get());
+  }
+  for (int i = 0; i < 3; ++i) {
+    resolve_context_->RecordRtt(0 /* server_index */, false /* is_doh_server */,
+                                base::TimeDelta::FromSeconds(2), OK,
+                                session_.get());
+  }
+  base::Optional<base::TimeDelta> hedge_delay =
+      resolve_context_->NextClassicHedgeDelay(0, 0, session_.get());
+  ASSERT_TRUE(hedge_delay);
+
+  AddHangingQuery(kT0HostName, kT0Qtype);
+
+  TransactionHelper helper0(kT0HostName, kT0Qtype, false /* secure */,
+                            ERR_DNS_TIMED_OUT, resolve_context_.get());
+  EXPECT_FALSE(helper0.Run(transaction_factory_.get()));
+
+  // Without hedging budget, no second query is sent before the fallback
+  // period.
+  FastForwardBy(hedge_delay.value());
+  EXPECT_FALSE(helper0.has_completed());
+  size_t kOrder[] = {0};
+  CheckServerOrder(kOrder, base::size(kOrder));
+}
+
 TEST_F(DnsTransactionTest, SuffixSearchAboveNdots) {
   config_.ndots = 2;
   config_.search.push_back("a");
@@ -7,6 +7,7 @@
 #include <algorithm>
 
 #include "base/bind.h"
+#include "base/hash/hash.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/numerics/safe_conversions.h"
@@ -45,6 +46,7 @@ const char kExpirationKey[] = "expiration";
 const char kTtlKey[] = "ttl";
 const char kNetworkChangesKey[] = "network_changes";
 const char kNetErrorKey[] = "net_error";
+const char kNxdomainKey[] = "nxdomain";
 const char kAddressesKey[] = "addresses";
 const char kTextRecordsKey[] = "text_records";
 const char kHostnameResultsKey[] = "hostname_results";
@@ -182,6 +184,9 @@ HostCache::Entry HostCache::Entry::MergeEntries(Entry front, Entry back) {
   front.network_changes_ =
       std::max(front.network_changes(), back.network_changes());
 
+  // The name only does not exist if every transaction said so.
+  front.nxdomain_ = front.nxdomain() && back.nxdomain();
+
   front.total_hits_ = front.total_hits_ + back.total_hits_;
   front.stale_hits_ = front.stale_hits_ + back.stale_hits_;
 
@@ -237,6 +242,7 @@ HostCache::Entry::Entry(const HostCache::Entry& entry,
       integrity_data_(entry.integrity_data()),
       source_(entry.source()),
       ttl_(entry.ttl()),
+      nxdomain_(entry.nxdomain()),
       expires_(now + ttl),
       network_changes_(network_changes) {}
 
@@ -326,6 +332,8 @@ base::Value HostCache::Entry::GetAsValue(bool include_staleness) const {
 
   if (error() != OK) {
     entry_dict.SetIntKey(kNetErrorKey, error());
+    if (nxdomain())
+      entry_dict.SetBoolKey(kNxdomainKey, true);
   } else {
     if (addresses()) {
       // Append all of the resolved addresses.
@@ -416,6 +424,38 @@ const std::pair<const HostCache::Key, HostCache::Entry>* HostCache::LookupStale(
   return result;
 }
 
+const std::pair<const HostCache::Key, HostCache::Entry>*
+HostCache::LookupNxdomainAncestor(const Key& key,
+                                  base::TimeTicks now,
+                                  bool ignore_secure) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  if (caching_is_disabled() || nxdomain_filter_.none())
+    return nullptr;
+
+  base::StringPiece hostname = key.hostname;
+  Key ancestor_key = key;
+  for (size_t dot = hostname.find('.'); dot != base::StringPiece::npos;
+       dot = hostname.find('.', dot + 1)) {
+    base::StringPiece ancestor = hostname.substr(dot + 1);
+    if (ancestor.empty() || !NxdomainFilterMayContain(ancestor))
+      continue;
+
+    ancestor_key.hostname = std::string(ancestor);
+    auto* result =
+        LookupInternalIgnoringFields(ancestor_key, now, ignore_secure);
+    if (!result)
+      continue;
+
+    auto* entry = &result->second;
+    if (!entry->nxdomain() || entry->IsStale(now, network_changes_))
+      continue;
+
+    entry->CountHit(/* hit_is_stale= */ false);
+    return result;
+  }
+  return nullptr;
+}
+
 // static
 std::pair<const HostCache::Key, HostCache::Entry>*
 HostCache::GetLessStaleMoreSecureResult(
@@ -544,7 +584,7 @@ void HostCache::Set(const Key& key,
     result_changed =
         entry.error() == OK && (it->second.error() != entry.error() ||
                                 overall_delta != DELTA_IDENTICAL);
-    entries_.erase(it);
+    EraseEntry(it);
   } else {
     result_changed = true;
     if (size() == max_entries_)
@@ -554,6 +594,7 @@ void HostCache::Set(const Key& key,
   Entry entry_for_cache(entry, now, ttl, network_changes_);
   entry_for_cache.PrepareForCacheInsertion();
   AddEntry(key, std::move(entry_for_cache));
+  MaybeRebuildNxdomainFilter();
 
   if (delegate_ && result_changed)
     delegate_->ScheduleWrite();
@@ -562,10 +603,23 @@ void HostCache::Set(const Key& key,
 void HostCache::AddEntry(const Key& key, Entry&& entry) {
   DCHECK_GT(max_entries_, size());
   DCHECK_EQ(0u, entries_.count(key));
+  if (entry.nxdomain()) {
+    AddToNxdomainFilter(key.hostname);
+    ++nxdomain_entries_;
+  }
   entries_.emplace(key, std::move(entry));
   DCHECK_GE(max_entries_, size());
 }
 
+HostCache::EntryMap::iterator HostCache::EraseEntry(EntryMap::iterator it) {
+  if (it->second.nxdomain()) {
+    DCHECK_LT(0u, nxdomain_entries_);
+    --nxdomain_entries_;
+    ++nxdomain_filter_stale_entries_;
+  }
+  return entries_.erase(it);
+}
+
 void HostCache::Invalidate() {
   ++network_changes_;
 }
@@ -585,6 +639,7 @@ void HostCache::clear() {
     return;
 
   entries_.clear();
+  RebuildNxdomainFilter();
   if (delegate_)
     delegate_->ScheduleWrite();
 }
@@ -603,13 +658,15 @@ void HostCache::ClearForHosts(
     auto next_it = std::next(it);
 
     if (host_filter.Run(it->first.hostname)) {
-      entries_.erase(it);
+      EraseEntry(it);
       changed = true;
     }
 
     it = next_it;
   }
 
+  MaybeRebuildNxdomainFilter();
+
   if (delegate_ && changed)
     delegate_->ScheduleWrite();
 }
@@ -717,6 +774,7 @@ bool HostCache::RestoreFromListValue(const base::ListValue& old_cache) {
     bool secure = entry_dict.FindBoolKey(kSecureKey).value_or(false);
 
     int error = OK;
+    bool nxdomain = false;
     const base::Value* addresses_value = nullptr;
     const base::Value* text_records_value = nullptr;
     const base::Value* hostname_records_value = nullptr;
@@ -724,6 +782,7 @@ bool HostCache::RestoreFromListValue(const base::ListValue& old_cache) {
     base::Optional<int> maybe_error = entry_dict.FindIntKey(kNetErrorKey);
     if (maybe_error.has_value()) {
       error = maybe_error.value();
+      nxdomain = entry_dict.FindBoolKey(kNxdomainKey).value_or(false);
     } else {
       addresses_value = entry_dict.FindListKey(kAddressesKey);
       text_records_value = entry_dict.FindListKey(kTextRecordsKey);
@@ -800,10 +859,11 @@ bool HostCache::RestoreFromListValue(const base::ListValue& old_cache) {
     // replace the entry.
     auto found = entries_.find(key);
     if (found == entries_.end()) {
-      AddEntry(key, Entry(error, address_list, std::move(text_records),
-                          std::move(hostname_records),
-                          std::move(integrity_data), Entry::SOURCE_UNKNOWN,
-                          expiration_time, network_changes_ - 1));
+      Entry entry(error, address_list, std::move(text_records),
+                  std::move(hostname_records), std::move(integrity_data),
+                  Entry::SOURCE_UNKNOWN, expiration_time, network_changes_ - 1);
+      entry.set_nxdomain(nxdomain);
+      AddEntry(key, std::move(entry));
       restore_size_++;
     }
   }
@@ -842,7 +902,43 @@ void HostCache::EvictOneEntry(base::TimeTicks now) {
     }
   }
 
-  entries_.erase(oldest_it);
+  EraseEntry(oldest_it);
+}
+
+void HostCache::AddToNxdomainFilter(base::StringPiece hostname) {
+  static_assert((kNxdomainFilterBits & (kNxdomainFilterBits - 1)) == 0,
+                "filter size must be a power of two");
+  uint32_t hash = base::PersistentHash(hostname.data(), hostname.size());
+  nxdomain_filter_.set(hash & (kNxdomainFilterBits - 1));
+  nxdomain_filter_.set((hash >> 16) & (kNxdomainFilterBits - 1));
+}
+
+bool HostCache::NxdomainFilterMayContain(base::StringPiece hostname) const {
+  uint32_t hash = base::PersistentHash(hostname.data(), hostname.size());
+  return nxdomain_filter_.test(hash & (kNxdomainFilterBits - 1)) &&
+         nxdomain_filter_.test((hash >> 16) & (kNxdomainFilterBits - 1));
+}
+
+void HostCache::MaybeRebuildNxdomainFilter() {
+  // Rebuilding takes a pass over |entries_|, so wait until enough names have
+  // been erased to pay for it, but not so long that their bits make up most of
+  // the filter.
+  if (nxdomain_filter_stale_entries_ >
+      nxdomain_entries_ + kNxdomainFilterBits / 64) {
+    RebuildNxdomainFilter();
+  }
+}
+
+void HostCache::RebuildNxdomainFilter() {
+  nxdomain_filter_.reset();
+  nxdomain_entries_ = 0;
+  nxdomain_filter_stale_entries_ = 0;
+  for (const auto& pair : entries_) {
+    if (pair.second.nxdomain()) {
+      AddToNxdomainFilter(pair.first.hostname);
+      ++nxdomain_entries_;
+    }
+  }
 }
 
 const HostCache::Key* HostCache::GetMatchingKey(
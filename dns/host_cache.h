@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 
+#include <bitset>
 #include <functional>
 #include <map>
 #include <memory>
@@ -20,6 +21,7 @@
 #include "base/macros.h"
 #include "base/numerics/clamped_math.h"
 #include "base/optional.h"
+#include "base/strings/string_piece.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
 #include "base/values.h"
@@ -174,6 +176,11 @@ class NET_EXPORT HostCache {
     base::Optional<base::TimeDelta> GetOptionalTtl() const;
     void set_ttl(base::TimeDelta ttl) { ttl_ = ttl; }
 
+    // True if this ERR_NAME_NOT_RESOLVED result came from an NXDOMAIN answer,
+    // as opposed to a NODATA answer or a failure of some other source.
+    bool nxdomain() const { return nxdomain_; }
+    void set_nxdomain(bool nxdomain) { nxdomain_ = nxdomain; }
+
     base::TimeTicks expires() const { return expires_; }
 
     // Public for the net-internals UI.
@@ -254,6 +261,7 @@ class NET_EXPORT HostCache {
     Source source_ = SOURCE_UNKNOWN;
     // TTL obtained from the nameserver. Negative if unknown.
     base::TimeDelta ttl_ = base::TimeDelta::FromSeconds(-1);
+    bool nxdomain_ = false;
 
     base::TimeTicks expires_;
     // Copied from the cache's network_changes_ when the entry is set; can
@@ -312,6 +320,17 @@ class NET_EXPORT HostCache {
                                                  EntryStaleness* stale_out,
                                                  bool ignore_secure = false);
 
+  // Returns a pointer to a (key, entry) pair, valid at time |now|, holding an
+  // NXDOMAIN result for a proper ancestor of |key.hostname| and otherwise
+  // matching |key|. Per RFC 8020, nothing exists below a name that does not
+  // exist, so the returned entry also answers |key|. If |ignore_secure| is
+  // true, ignores the secure field in |key|. Returns NULL if there is no such
+  // entry.
+  const std::pair<const Key, Entry>* LookupNxdomainAncestor(
+      const Key& key,
+      base::TimeTicks now,
+      bool ignore_secure = false);
+
   // Overwrites or creates an entry for |key|.
   // |entry| is the value to set, |now| is the current time
   // |ttl| is the "time to live".
@@ -369,6 +388,10 @@ class NET_EXPORT HostCache {
   int network_changes() const { return network_changes_; }
   const EntryMap& entries() const { return entries_; }
 
+  size_t GetNxdomainFilterBitsSetForTesting() const {
+    return nxdomain_filter_.count();
+  }
+
   // Creates a default cache.
   static std::unique_ptr<HostCache> CreateDefaultCache();
 
@@ -406,11 +429,30 @@ class NET_EXPORT HostCache {
   void EvictOneEntry(base::TimeTicks now);
   // Helper to insert an Entry into the cache.
   void AddEntry(const Key& key, Entry&& entry);
+  // Helper to erase an entry from the cache. Returns the following iterator.
+  EntryMap::iterator EraseEntry(EntryMap::iterator it);
+
+  // Bloom filter over the hostnames of NXDOMAIN entries, so that
+  // LookupNxdomainAncestor() only searches |entries_| for ancestors that
+  // probably have one. Bits are never cleared on erase, so it may yield false
+  // positives but never false negatives. It is rebuilt from |entries_| once
+  // the erased names it still holds outnumber the live ones, so that it
+  // doesn't fill up in long-running processes.
+  static constexpr size_t kNxdomainFilterBits = 4096;
+  void AddToNxdomainFilter(base::StringPiece hostname);
+  bool NxdomainFilterMayContain(base::StringPiece hostname) const;
+  void MaybeRebuildNxdomainFilter();
+  void RebuildNxdomainFilter();
 
   // Map from hostname (presumably in lowercase canonicalized format) to
   // a resolved result entry.
   EntryMap entries_;
   size_t max_entries_;
+  std::bitset<kNxdomainFilterBits> nxdomain_filter_;
+  // Number of NXDOMAIN entries in |entries_|.
+  size_t nxdomain_entries_ = 0;
+  // Number of NXDOMAIN entries erased since |nxdomain_filter_| was rebuilt.
+  size_t nxdomain_filter_stale_entries_ = 0;
   int network_changes_;
   // Number of cache entries that were restored in the last call to
   // RestoreFromListValue(). Used in histograms.
@@ -272,6 +272,155 @@ TEST(HostCacheTest, CacheNegativeEntry) {
   EXPECT_FALSE(cache.Lookup(key2, now));
 }
 
+TEST(HostCacheTest, LookupNxdomainAncestor) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(kMaxCacheEntries);
+
+  // Start at t=0.
+  base::TimeTicks now;
+
+  HostCache::Entry nxdomain_entry(ERR_NAME_NOT_RESOLVED,
+                                  HostCache::Entry::SOURCE_DNS);
+  nxdomain_entry.set_nxdomain(true);
+  HostCache::Entry nodata_entry(ERR_NAME_NOT_RESOLVED,
+                                HostCache::Entry::SOURCE_DNS);
+
+  cache.Set(Key("nx.example.com"), nxdomain_entry, now, kTTL);
+  cache.Set(Key("nodata.example.com"), nodata_entry, now, kTTL);
+
+  // Names below the NXDOMAIN name are answered by its entry.
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      cache.LookupNxdomainAncestor(Key("a.nx.example.com"), now);
+  ASSERT_TRUE(result);
+  EXPECT_EQ("nx.example.com", result->first.hostname);
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, result->second.error());
+  EXPECT_TRUE(result->second.nxdomain());
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("b.a.nx.example.com"), now));
+
+  // The name itself, siblings, ancestors, and names below a NODATA answer are
+  // not.
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("nx.example.com"), now));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.example.com"), now));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("example.com"), now));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.nodata.example.com"), now));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.xnx.example.com"), now));
+
+  // Other key fields must match.
+  HostCache::Key a_key = Key("a.nx.example.com");
+  a_key.dns_query_type = DnsQueryType::A;
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(a_key, now));
+  HostCache::Key secure_key = Key("a.nx.example.com");
+  secure_key.secure = true;
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(secure_key, now));
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(secure_key, now,
+                                           true /* ignore_secure */));
+
+  // Stale entries are not used.
+  now += kTTL;
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.nx.example.com"), now));
+  cache.Set(Key("nx.example.com"), nxdomain_entry, now, kTTL);
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("a.nx.example.com"), now));
+  cache.Invalidate();
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.nx.example.com"), now));
+}
+
+TEST(HostCacheTest, LookupNxdomainAncestorAfterClear) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(kMaxCacheEntries);
+  base::TimeTicks now;
+
+  HostCache::Entry nxdomain_entry(ERR_NAME_NOT_RESOLVED,
+                                  HostCache::Entry::SOURCE_DNS);
+  nxdomain_entry.set_nxdomain(true);
+
+  cache.Set(Key("foobar1.com"), nxdomain_entry, now, kTTL);
+  cache.Set(Key("foobar2.com"), nxdomain_entry, now, kTTL);
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("a.foobar1.com"), now));
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("a.foobar2.com"), now));
+
+  cache.ClearForHosts(base::BindRepeating(&FoobarIndexIsOdd));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.foobar1.com"), now));
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("a.foobar2.com"), now));
+
+  cache.clear();
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.foobar2.com"), now));
+}
+
+// The NXDOMAIN filter is rebuilt as entries are evicted, so that it doesn't
+// fill up with names that are no longer cached.
+TEST(HostCacheTest, NxdomainFilterRebuiltOnEviction) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(10);
+  base::TimeTicks now;
+
+  HostCache::Entry nxdomain_entry(ERR_NAME_NOT_RESOLVED,
+                                  HostCache::Entry::SOURCE_DNS);
+  nxdomain_entry.set_nxdomain(true);
+
+  // Each entry expires after the previous one, so the oldest is evicted.
+  for (int i = 0; i < 4000; ++i) {
+    now += base::TimeDelta::FromMilliseconds(1);
+    cache.Set(Key(base::StringPrintf("nx%d.example.com", i)), nxdomain_entry,
+              now, kTTL);
+  }
+  EXPECT_EQ(10u, cache.size());
+
+  // At most two bits for each cached name and for each name erased since the
+  // last rebuild, of which there are at most 10 + 4096 / 64. Without rebuilds,
+  // thousands of bits would be set.
+  EXPECT_GE(2u * (10 + 10 + 64), cache.GetNxdomainFilterBitsSetForTesting());
+  EXPECT_TRUE(cache.LookupNxdomainAncestor(Key("a.nx3999.example.com"), now));
+  EXPECT_FALSE(cache.LookupNxdomainAncestor(Key("a.nx0.example.com"), now));
+}
+
+TEST(HostCacheTest, SerializeAndDeserializeNxdomain) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(kMaxCacheEntries);
+  base::TimeTicks now;
+
+  HostCache::Entry nxdomain_entry(ERR_NAME_NOT_RESOLVED,
+                                  HostCache::Entry::SOURCE_DNS);
+  nxdomain_entry.set_nxdomain(true);
+  HostCache::Entry nodata_entry(ERR_NAME_NOT_RESOLVED,
+                                HostCache::Entry::SOURCE_DNS);
+  cache.Set(Key("nx.example.com"), nxdomain_entry, now, kTTL);
+  cache.Set(Key("nodata.example.com"), nodata_entry, now, kTTL);
+
+  base::ListValue serialized_cache;
+  cache.GetAsListValue(&serialized_cache, false /* include_staleness */,
+                       HostCache::SerializationType::kRestorable);
+  HostCache restored_cache(kMaxCacheEntries);
+  EXPECT_TRUE(restored_cache.RestoreFromListValue(serialized_cache));
+
+  HostCache::EntryStaleness stale;
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      restored_cache.LookupStale(Key("nx.example.com"), now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_TRUE(result->second.nxdomain());
+  result = restored_cache.LookupStale(Key("nodata.example.com"), now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_FALSE(result->second.nxdomain());
+}
+
+TEST(HostCacheTest, MergeNxdomainEntries) {
+  HostCache::Entry nxdomain_entry(ERR_NAME_NOT_RESOLVED,
+                                  HostCache::Entry::SOURCE_DNS);
+  nxdomain_entry.set_nxdomain(true);
+  HostCache::Entry nodata_entry(ERR_NAME_NOT_RESOLVED,
+                                HostCache::Entry::SOURCE_DNS);
+
+  EXPECT_TRUE(HostCache::Entry::MergeEntries(nxdomain_entry, nxdomain_entry)
+                  .nxdomain());
+  EXPECT_FALSE(
+      HostCache::Entry::MergeEntries(nxdomain_entry, nodata_entry).nxdomain());
+  EXPECT_FALSE(
+      HostCache::Entry::MergeEntries(nodata_entry, nxdomain_entry).nxdomain());
+}
+
 // Tests that the same hostname can be duplicated in the cache, so long as
 // the query type differs.
 TEST(HostCacheTest, DnsQueryTypeIsPartOfKey) {
@@ -1287,6 +1287,11 @@ class HostResolverManager::DnsTask : public base::SupportsWeakPtr<DnsTask> {
     }
     DCHECK_LT(parse_result, DnsResponse::DNS_PARSE_RESULT_MAX);
 
+    if (results.error() == ERR_NAME_NOT_RESOLVED && response &&
+        response->rcode() == dns_protocol::kRcodeNXDOMAIN) {
+      results.set_nxdomain(true);
+    }
+
     if (results.error() != OK && results.error() != ERR_NAME_NOT_RESOLVED) {
       OnFailure(results.error(), parse_result, results.GetOptionalTtl());
       return;
@@ -3103,6 +3108,8 @@ HostCache::Entry HostResolverManager::ResolveLocally(
     return resolved.value();
 
   // Do initial cache lookup.
+  base::Optional<HostCache::Key> cache_key;
+  bool cache_ignore_secure = false;
   if (!out_tasks->empty() &&
       (out_tasks->front() == TaskType::SECURE_CACHE_LOOKUP ||
        out_tasks->front() == TaskType::INSECURE_CACHE_LOOKUP ||
@@ -3120,6 +3127,11 @@ HostCache::Entry HostResolverManager::ResolveLocally(
 
     out_tasks->pop_front();
 
+    if (cache && cache_usage != ResolveHostParameters::CacheUsage::DISALLOWED) {
+      cache_key = key;
+      cache_ignore_secure = ignore_secure;
+    }
+
     resolved = MaybeServeFromCache(cache, key, cache_usage, ignore_secure,
                                    source_net_log, out_stale_info);
     if (resolved) {
@@ -3145,6 +3157,24 @@ HostCache::Entry HostResolverManager::ResolveLocally(
     return resolved.value();
   }
 
+  // Only consult cached NXDOMAIN answers for ancestors after HOSTS, which may
+  // define names below a name that does not exist in DNS.
+  if (cache_key && base::FeatureList::IsEnabled(features::kDnsNxdomainCut)) {
+    if (cache_key->host_resolver_source == HostResolverSource::LOCAL_ONLY)
+      cache_key->host_resolver_source = HostResolverSource::ANY;
+    const std::pair<const HostCache::Key, HostCache::Entry>* cache_result =
+        cache->LookupNxdomainAncestor(cache_key.value(),
+                                      tick_clock_->NowTicks(),
+                                      cache_ignore_secure);
+    if (cache_result) {
+      *out_stale_info = HostCache::kNotStale;
+      NetLogHostCacheEntry(source_net_log,
+                           NetLogEventType::HOST_RESOLVER_IMPL_CACHE_HIT,
+                           NetLogEventPhase::NONE, cache_result->second);
+      return cache_result->second;
+    }
+  }
+
   return HostCache::Entry(ERR_DNS_CACHE_MISS, HostCache::Entry::SOURCE_UNKNOWN);
 }
 
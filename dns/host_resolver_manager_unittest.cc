@@ -6552,6 +6552,55 @@ TEST_F(HostResolverManagerDnsTest, CachedError) {
   EXPECT_FALSE(cache_hit_response.request()->GetStaleInfo().value().is_stale());
 }
 
+// Tests that with kDnsNxdomainCut, a cached NXDOMAIN error also answers
+// lookups for names below the nonexistent name.
+TEST_F(HostResolverManagerDnsTest, CachedError_NxdomainCut) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kDnsNxdomainCut);
+
+  CreateResolver();
+  set_allow_fallback_to_proctask(false);
+  ChangeDnsConfig(CreateValidDnsConfig());
+
+  HostResolver::ResolveHostParameters cache_only_parameters;
+  cache_only_parameters.source = HostResolverSource::LOCAL_ONLY;
+
+  // NODATA for "empty" does not imply anything about names below it.
+  ResolveHostResponseHelper no_data_response(resolver_->CreateRequest(
+      HostPortPair("empty", 80), NetworkIsolationKey(), NetLogWithSource(),
+      base::nullopt, resolve_context_.get(), resolve_context_->host_cache()));
+  EXPECT_THAT(no_data_response.result_error(), IsError(ERR_NAME_NOT_RESOLVED));
+  ResolveHostResponseHelper below_no_data_response(resolver_->CreateRequest(
+      HostPortPair("sub.empty", 80), NetworkIsolationKey(), NetLogWithSource(),
+      cache_only_parameters, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  EXPECT_THAT(below_no_data_response.result_error(),
+              IsError(ERR_DNS_CACHE_MISS));
+
+  // Populate cache with an NXDOMAIN error.
+  ResolveHostResponseHelper no_domain_response(resolver_->CreateRequest(
+      HostPortPair("nodomain", 80), NetworkIsolationKey(), NetLogWithSource(),
+      base::nullopt, resolve_context_.get(), resolve_context_->host_cache()));
+  EXPECT_THAT(no_domain_response.result_error(),
+              IsError(ERR_NAME_NOT_RESOLVED));
+
+  // Names below it are answered from the cache.
+  ResolveHostResponseHelper cache_hit_response(resolver_->CreateRequest(
+      HostPortPair("a.b.nodomain", 80), NetworkIsolationKey(),
+      NetLogWithSource(), cache_only_parameters, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  EXPECT_THAT(cache_hit_response.result_error(),
+              IsError(ERR_NAME_NOT_RESOLVED));
+  EXPECT_FALSE(cache_hit_response.request()->GetStaleInfo().value().is_stale());
+
+  // Unrelated names are not.
+  ResolveHostResponseHelper cache_miss_response(resolver_->CreateRequest(
+      HostPortPair("a.nodomain2", 80), NetworkIsolationKey(),
+      NetLogWithSource(), cache_only_parameters, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  EXPECT_THAT(cache_miss_response.result_error(), IsError(ERR_DNS_CACHE_MISS));
+}
+
 TEST_F(HostResolverManagerDnsTest, CachedError_AutomaticMode) {
   CreateResolver();
   set_allow_fallback_to_proctask(false);
@@ -19,6 +19,7 @@
 #include "base/no_destructor.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/strings/stringprintf.h"
+#include "net/base/features.h"
 #include "net/base/network_change_notifier.h"
 #include "net/dns/dns_server_iterator.h"
 #include "net/dns/dns_session.h"
@@ -48,6 +49,10 @@ const int kRttPercentile = 99;
 // Number of samples to seed the histogram with.
 const base::HistogramBase::Count kNumSeeds = 2;
 
+// Number of hedged queries that may be sent back to back before the budget,
+// which is replenished by kDnsHedgedQueriesMaxRatio per query, runs out.
+const double kMaxHedgeBudget = 5;
+
 base::TimeDelta GetDefaultFallbackPeriod(const DnsConfig& config) {
   NetworkChangeNotifier::ConnectionType type =
       NetworkChangeNotifier::GetConnectionType();
@@ -78,6 +83,24 @@ static RttBuckets* GetRttBuckets() {
   return buckets.get();
 }
 
+// Returns the upper bound of the bucket holding the |percentile|th percentile
+// of |samples|.
+base::TimeDelta GetRttPercentile(const base::SampleVector& samples,
+                                 int percentile) {
+  static_assert(std::numeric_limits<base::HistogramBase::Count>::is_signed,
+                "histogram base count assumed to be signed");
+
+  base::HistogramBase::Count total = samples.TotalCount();
+  base::HistogramBase::Count remaining_count = percentile * total / 100;
+  size_t index = 0;
+  while (remaining_count > 0 && index < GetRttBuckets()->size()) {
+    remaining_count -= samples.GetCountAtIndex(index);
+    ++index;
+  }
+
+  return base::TimeDelta::FromMilliseconds(GetRttBuckets()->range(index));
+}
+
 static std::unique_ptr<base::SampleVector> GetRttHistogram(
     base::TimeDelta rtt_estimate) {
   std::unique_ptr<base::SampleVector> histogram =
@@ -251,6 +274,44 @@ base::TimeDelta ResolveContext::NextClassicFallbackPeriod(
       attempt / current_session_->config().nameservers.size());
 }
 
+base::Optional<base::TimeDelta> ResolveContext::NextClassicHedgeDelay(
+    size_t classic_server_index,
+    int attempt,
+    const DnsSession* session) {
+  if (!IsCurrentSession(session))
+    return base::nullopt;
+
+  ServerStats* stats =
+      GetServerStats(classic_server_index, false /* is _doh_server */);
+  base::TimeDelta fallback_period = NextFallbackPeriodHelper(
+      stats, attempt / current_session_->config().nameservers.size());
+  base::TimeDelta hedge_delay =
+      std::max(GetRttPercentile(*stats->rtt_histogram,
+                                features::kDnsHedgedQueriesRttPercentile.Get()),
+               features::kDnsHedgedQueriesMinDelay.Get());
+  if (hedge_delay >= fallback_period)
+    return base::nullopt;
+  return hedge_delay;
+}
+
+void ResolveContext::RecordClassicQueryForHedging(const DnsSession* session) {
+  if (!IsCurrentSession(session))
+    return;
+
+  classic_hedge_budget_ =
+      std::min(classic_hedge_budget_ +
+                   std::max(features::kDnsHedgedQueriesMaxRatio.Get(), 0.0),
+               kMaxHedgeBudget);
+}
+
+bool ResolveContext::ConsumeClassicHedgeBudget(const DnsSession* session) {
+  if (!IsCurrentSession(session) || classic_hedge_budget_ < 1)
+    return false;
+
+  classic_hedge_budget_ -= 1;
+  return true;
+}
+
 base::TimeDelta ResolveContext::NextDohFallbackPeriod(
     size_t doh_server_index,
     const DnsSession* session) {
@@ -291,6 +352,7 @@ void ResolveContext::InvalidateCachesAndPerSessionData(
   doh_server_stats_.clear();
   initial_fallback_period_ = base::TimeDelta();
   max_fallback_period_ = GetMaxFallbackPeriod();
+  classic_hedge_budget_ = 0;
 
   if (!new_session) {
     NotifyDohStatusObserversOfSessionChanged();
@@ -372,22 +434,9 @@ base::TimeDelta ResolveContext::NextFallbackPeriodHelper(
   if (initial_fallback_period_ > max_fallback_period_)
     return initial_fallback_period_;
 
-  static_assert(std::numeric_limits<base::HistogramBase::Count>::is_signed,
-                "histogram base count assumed to be signed");
-
   // Use fixed percentile of observed samples.
-  const base::SampleVector& samples = *server_stats->rtt_histogram;
-
-  base::HistogramBase::Count total = samples.TotalCount();
-  base::HistogramBase::Count remaining_count = kRttPercentile * total / 100;
-  size_t index = 0;
-  while (remaining_count > 0 && index < GetRttBuckets()->size()) {
-    remaining_count -= samples.GetCountAtIndex(index);
-    ++index;
-  }
-
   base::TimeDelta fallback_period =
-      base::TimeDelta::FromMilliseconds(GetRttBuckets()->range(index));
+      GetRttPercentile(*server_stats->rtt_histogram, kRttPercentile);
 
   fallback_period = std::max(fallback_period, kMinFallbackPeriod);
 
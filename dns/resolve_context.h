@@ -123,6 +123,26 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
                                             int attempt,
                                             const DnsSession* session);
 
+  // Return the delay after which a still-running query to the classic server
+  // should be hedged, i.e. duplicated to the next server, when
+  // features::kDnsHedgedQueries is enabled. Based on the same RTT history as
+  // NextClassicFallbackPeriod(), but at a lower percentile. Returns nullopt if
+  // the query should not be hedged because the delay would not be shorter
+  // than the fallback period, or if |session| is not the current session.
+  base::Optional<base::TimeDelta> NextClassicHedgeDelay(
+      size_t classic_server_index,
+      int attempt,
+      const DnsSession* session);
+
+  // Record that a classic DNS query was started, accruing budget for hedged
+  // queries. Noop if |session| is not the current session.
+  void RecordClassicQueryForHedging(const DnsSession* session);
+
+  // Consumes budget for one hedged query if available. Returns false if the
+  // query must not be hedged because the budget is exhausted or |session| is
+  // not the current session.
+  bool ConsumeClassicHedgeBudget(const DnsSession* session);
+
   // Return the period the next DoH query should run before fallback to next
   // attempt or out of the transaction.
   base::TimeDelta NextDohFallbackPeriod(size_t doh_server_index,
@@ -250,6 +270,9 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
   std::vector<ServerStats> classic_server_stats_;
   // Track runtime statistics of each DoH server.
   std::vector<ServerStats> doh_server_stats_;
+  // Number of hedged classic queries that may currently be sent. Grows with
+  // every classic query, up to a small burst allowance.
+  double classic_hedge_budget_ = 0;
 
   const IsolationInfo isolation_info_;
 };
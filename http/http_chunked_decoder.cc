@@ -44,6 +44,8 @@
 
 #include "net/http/http_chunked_decoder.h"
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/logging.h"
@@ -67,40 +69,49 @@ HttpChunkedDecoder::HttpChunkedDecoder()
 }
 
 int HttpChunkedDecoder::FilterBuf(char* buf, int buf_len) {
-  int result = 0;
-
-  while (buf_len > 0) {
+  // Chunk data is compacted towards the start of |buf| as chunk markers are
+  // skipped over, so each byte of data is moved at most once, and not at all
+  // until the first chunk marker in |buf|.  Moving the rest of |buf| over each
+  // marker instead would be quadratic in the number of chunks per read.
+  char* out = buf;
+  const char* in = buf;
+  const char* const end = buf + buf_len;
+
+  while (in < end) {
+    int remaining = static_cast<int>(end - in);
     if (chunk_remaining_ > 0) {
-      // Since |chunk_remaining_| is positive and |buf_len| an int, the minimum
-      // of the two must be an int.
+      // Since |chunk_remaining_| is positive and |remaining| an int, the
+      // minimum of the two must be an int.
       int num = static_cast<int>(
-          std::min(chunk_remaining_, static_cast<int64_t>(buf_len)));
+          std::min(chunk_remaining_, static_cast<int64_t>(remaining)));
 
-      buf_len -= num;
+      if (out != in)
+        memmove(out, in, num);
+      out += num;
+      in += num;
       chunk_remaining_ -= num;
 
-      result += num;
-      buf += num;
-
       // After each chunk's data there should be a CRLF.
       if (chunk_remaining_ == 0)
         chunk_terminator_remaining_ = true;
       continue;
     } else if (reached_eof_) {
-      bytes_after_eof_ += buf_len;
+      // Callers expect any bytes after the final CRLF to immediately follow
+      // the decoded data.
+      bytes_after_eof_ += remaining;
+      if (out != in)
+        memmove(out, in, remaining);
       break;  // Done!
     }
 
-    int bytes_consumed = ScanForChunkRemaining(buf, buf_len);
+    int bytes_consumed = ScanForChunkRemaining(in, remaining);
     if (bytes_consumed < 0)
       return bytes_consumed; // Error
 
-    buf_len -= bytes_consumed;
-    if (buf_len > 0)
-      memmove(buf, buf + bytes_consumed, buf_len);
+    in += bytes_consumed;
   }
 
-  return result;
+  return static_cast<int>(out - buf);
 }
 
 int HttpChunkedDecoder::ScanForChunkRemaining(const char* buf, int buf_len) {
@@ -109,8 +120,9 @@ int HttpChunkedDecoder::ScanForChunkRemaining(const char* buf, int buf_len) {
 
   int bytes_consumed = 0;
 
-  size_t index_of_lf = base::StringPiece(buf, buf_len).find('\n');
-  if (index_of_lf != base::StringPiece::npos) {
+  const char* lf = static_cast<const char*>(memchr(buf, '\n', buf_len));
+  if (lf) {
+    size_t index_of_lf = lf - buf;
     buf_len = static_cast<int>(index_of_lf);
     if (buf_len && buf[buf_len - 1] == '\r')  // Eliminate a preceding CR.
       buf_len--;
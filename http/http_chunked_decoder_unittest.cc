@@ -395,6 +395,33 @@ TEST(HttpChunkedDecoderTest, MultipleExtraDataBlocks) {
   RunTest(inputs, base::size(inputs), "hello", true, 11);
 }
 
+// HttpStreamParser copies the bytes after the final CRLF from right after the
+// decoded data, so they must end up there.
+TEST(HttpChunkedDecoderTest, ExtraDataFollowsDecodedData) {
+  HttpChunkedDecoder decoder;
+  std::string input = "3\r\nabc\r\n2;ext\r\nde\r\n0\r\n\r\nHTTP/1.1";
+  int n = decoder.FilterBuf(&input[0], static_cast<int>(input.size()));
+  ASSERT_EQ(5, n);
+  EXPECT_TRUE(decoder.reached_eof());
+  ASSERT_EQ(8, decoder.bytes_after_eof());
+  EXPECT_EQ("abcdeHTTP/1.1", input.substr(0, n + decoder.bytes_after_eof()));
+}
+
+// Many small chunks in a single read, as sent by streaming APIs.
+TEST(HttpChunkedDecoderTest, ManySmallChunks) {
+  std::string input;
+  std::string expected_output;
+  for (int i = 0; i < 1000; ++i) {
+    std::string data(1 + i % 16, 'a' + i % 26);
+    input += base::StringPrintf("%" PRIxS "\r\n", data.size());
+    input += data + "\r\n";
+    expected_output += data;
+  }
+  input += "0\r\n\r\n";
+  const char* const inputs[] = {input.c_str()};
+  RunTest(inputs, base::size(inputs), expected_output.c_str(), true, 0);
+}
+
 // Test when the line with the chunk length is too long.
 TEST(HttpChunkedDecoderTest, LongChunkLengthLine) {
   int big_chunk_length = HttpChunkedDecoder::kMaxLineBufLen;
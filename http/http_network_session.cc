@@ -23,6 +23,7 @@
 #include "net/dns/host_resolver.h"
 #include "net/http/http_auth_handler_factory.h"
 #include "net/http/http_response_body_drainer.h"
+#include "net/http/http_startup_preconnector.h"
 #include "net/http/http_stream_factory.h"
 #include "net/http/url_security_manager.h"
 #include "net/proxy_resolution/proxy_resolution_service.h"
@@ -95,7 +96,8 @@ HttpNetworkSession::Params::Params()
       enable_quic(true),
       enable_quic_proxies_for_https_urls(false),
       disable_idle_sockets_close_on_memory_pressure(false),
-      key_auth_cache_server_entries_by_network_isolation_key(false) {
+      key_auth_cache_server_entries_by_network_isolation_key(false),
+      startup_preconnect_servers(0) {
   enable_early_data =
       base::FeatureList::IsEnabled(features::kEnableTLS13EarlyData);
 }
@@ -184,6 +186,7 @@ HttpNetworkSession::HttpNetworkSession(const Params& params,
                          params.spdy_session_max_recv_window_size,
                          params.spdy_session_max_queued_capped_frames,
                          AddDefaultHttp2Settings(params.http2_settings),
+                         params.http2_header_table_sizes,
                          params.greased_http2_frame,
                          params.http2_end_stream_with_data_frame,
                          params.time_func,
@@ -218,6 +221,12 @@ HttpNetworkSession::HttpNetworkSession(const Params& params,
         FROM_HERE, base::BindRepeating(&HttpNetworkSession::OnMemoryPressure,
                                        base::Unretained(this)));
   }
+
+  if (params_.startup_preconnect_servers > 0) {
+    startup_preconnector_ = std::make_unique<HttpStartupPreconnector>(
+        this, params_.startup_preconnect_servers);
+    startup_preconnector_->Start();
+  }
 }
 
 HttpNetworkSession::~HttpNetworkSession() {
@@ -454,6 +463,7 @@ void HttpNetworkSession::OnMemoryPressure(
     case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
     case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
       CloseIdleConnections("Low memory");
+      spdy_session_pool_.ShrinkRecvWindows();
       break;
   }
 }
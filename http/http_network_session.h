@@ -57,6 +57,7 @@ class HttpAuthHandlerFactory;
 class HttpNetworkSessionPeer;
 class HttpResponseBodyDrainer;
 class HttpServerProperties;
+class HttpStartupPreconnector;
 class HttpUserAgentSettings;
 class NetLog;
 #if BUILDFLAG(ENABLE_REPORTING)
@@ -115,6 +116,12 @@ class NET_EXPORT HttpNetworkSession {
     // The same setting will be sent on every connection to prevent the retry
     // logic from hiding broken servers.
     spdy::SettingsMap http2_settings;
+    // HPACK dynamic table sizes for HTTP/2 sessions to particular origins,
+    // overriding spdy::SETTINGS_HEADER_TABLE_SIZE in |http2_settings|. This
+    // only bounds the table used to decode responses; the table used to
+    // encode requests is sized by the server. Larger tables compress
+    // repetitive headers better, at the cost of memory.
+    SpdySessionPool::HeaderTableSizeMap http2_header_table_sizes;
     // If set, an HTTP/2 frame with a reserved frame type will be sent after
     // every HTTP/2 SETTINGS frame and before every HTTP/2 DATA frame.
     // https://tools.ietf.org/html/draft-bishop-httpbis-grease-00.
@@ -152,6 +159,11 @@ class NET_EXPORT HttpNetworkSession {
     bool disable_idle_sockets_close_on_memory_pressure;
 
     bool key_auth_cache_server_entries_by_network_isolation_key;
+
+    // If non-zero, once HttpServerProperties have been loaded, a connection
+    // is opened to each of up to this many of the most recently used HTTP/2
+    // and QUIC servers, ahead of any requests to them.
+    size_t startup_preconnect_servers;
   };
 
   // Structure with pointers to the dependencies of the HttpNetworkSession.
@@ -319,6 +331,7 @@ class NET_EXPORT HttpNetworkSession {
   QuicStreamFactory quic_stream_factory_;
   SpdySessionPool spdy_session_pool_;
   std::unique_ptr<HttpStreamFactory> http_stream_factory_;
+  std::unique_ptr<HttpStartupPreconnector> startup_preconnector_;
   std::map<HttpResponseBodyDrainer*, std::unique_ptr<HttpResponseBodyDrainer>>
       response_drainers_;
   NextProtoVector next_protos_;
@@ -4,10 +4,13 @@
 
 #include "net/http/http_request_headers.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "base/logging.h"
 #include "base/notreached.h"
+#include "base/stl_util.h"
 #include "base/strings/strcat.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
@@ -21,6 +24,59 @@
 
 namespace net {
 
+namespace {
+
+// Canonical names of HttpRequestHeaders::WellKnownHeader values, indexed by
+// the enum value.  Entries after the first are sorted by length.
+constexpr base::StringPiece kWellKnownHeaderNames[] = {
+    "",
+    "DNT",
+    "Via",
+    "From",
+    "Host",
+    "Range",
+    "Accept",
+    "Cookie",
+    "Expect",
+    "Origin",
+    "Pragma",
+    "Purpose",
+    "Referer",
+    "If-Match",
+    "If-Range",
+    "Connection",
+    "Early-Data",
+    "User-Agent",
+    "Content-Type",
+    "Max-Forwards",
+    "Authorization",
+    "Cache-Control",
+    "If-None-Match",
+    "Accept-Charset",
+    "Content-Length",
+    "Accept-Encoding",
+    "Accept-Language",
+    "X-Forwarded-For",
+    "Proxy-Connection",
+    "If-Modified-Since",
+    "Transfer-Encoding",
+    "If-Unmodified-Since",
+    "Proxy-Authorization",
+    "Upgrade-Insecure-Requests",
+};
+
+static_assert(
+    base::size(kWellKnownHeaderNames) ==
+        static_cast<size_t>(HttpRequestHeaders::WellKnownHeader::kMaxValue) +
+            1,
+    "kWellKnownHeaderNames must have an entry for every WellKnownHeader");
+
+// Most requests carry fewer headers than this, so reserving it up front
+// avoids repeatedly growing the vector as a request is assembled.
+const size_t kInitialHeaderCapacity = 10;
+
+}  // namespace
+
 const char HttpRequestHeaders::kConnectMethod[] = "CONNECT";
 const char HttpRequestHeaders::kGetMethod[] = "GET";
 const char HttpRequestHeaders::kHeadMethod[] = "HEAD";
@@ -58,7 +114,17 @@ HttpRequestHeaders::HeaderKeyValuePair::HeaderKeyValuePair() = default;
 HttpRequestHeaders::HeaderKeyValuePair::HeaderKeyValuePair(
     const base::StringPiece& key,
     const base::StringPiece& value)
-    : key(key.data(), key.size()), value(value.data(), value.size()) {}
+    : HeaderKeyValuePair(key, LookupWellKnownHeader(key), value) {}
+
+HttpRequestHeaders::HeaderKeyValuePair::HeaderKeyValuePair(
+    const base::StringPiece& key,
+    WellKnownHeader well_known_header,
+    const base::StringPiece& value)
+    : key(key.data(), key.size()),
+      value(value.data(), value.size()),
+      well_known_header(well_known_header) {
+  DCHECK_EQ(LookupWellKnownHeader(key), well_known_header);
+}
 
 HttpRequestHeaders::Iterator::Iterator(const HttpRequestHeaders& headers)
     : started_(false),
@@ -80,6 +146,36 @@ bool HttpRequestHeaders::Iterator::GetNext() {
   return curr_ != end_;
 }
 
+// static
+HttpRequestHeaders::WellKnownHeader HttpRequestHeaders::LookupWellKnownHeader(
+    const base::StringPiece& name) {
+  // Binary search for the first name of the right length, then compare
+  // against the handful of names that share it.
+  const base::StringPiece* first = std::lower_bound(
+      std::begin(kWellKnownHeaderNames) + 1, std::end(kWellKnownHeaderNames),
+      name, [](const base::StringPiece& candidate,
+               const base::StringPiece& name) {
+        return candidate.size() < name.size();
+      });
+  for (const base::StringPiece* it = first;
+       it != std::end(kWellKnownHeaderNames) && it->size() == name.size();
+       ++it) {
+    if (base::EqualsCaseInsensitiveASCII(*it, name)) {
+      return static_cast<WellKnownHeader>(it -
+                                          std::begin(kWellKnownHeaderNames));
+    }
+  }
+  return WellKnownHeader::kNone;
+}
+
+// static
+base::StringPiece HttpRequestHeaders::GetWellKnownHeaderName(
+    WellKnownHeader header) {
+  DCHECK_NE(WellKnownHeader::kNone, header);
+  DCHECK_LE(header, WellKnownHeader::kMaxValue);
+  return kWellKnownHeaderNames[static_cast<size_t>(header)];
+}
+
 HttpRequestHeaders::HttpRequestHeaders() = default;
 HttpRequestHeaders::HttpRequestHeaders(const HttpRequestHeaders& other) =
     default;
@@ -119,9 +215,9 @@ void HttpRequestHeaders::SetHeaderIfMissing(const base::StringPiece& key,
   // browser-internal headers.
   DCHECK(HttpUtil::IsValidHeaderName(key));
   DCHECK(HttpUtil::IsValidHeaderValue(value));
-  auto it = FindHeader(key);
-  if (it == headers_.end())
-    headers_.push_back(HeaderKeyValuePair(key, value));
+  WellKnownHeader well_known_header = LookupWellKnownHeader(key);
+  if (FindHeader(key, well_known_header) == headers_.end())
+    AppendHeader(key, well_known_header, value);
 }
 
 void HttpRequestHeaders::RemoveHeader(const base::StringPiece& key) {
@@ -212,31 +308,51 @@ base::Value HttpRequestHeaders::NetLogParams(
 
 HttpRequestHeaders::HeaderVector::iterator HttpRequestHeaders::FindHeader(
     const base::StringPiece& key) {
-  for (auto it = headers_.begin(); it != headers_.end(); ++it) {
-    if (base::EqualsCaseInsensitiveASCII(key, it->key))
-      return it;
-  }
-
-  return headers_.end();
+  HeaderVector::const_iterator it =
+      static_cast<const HttpRequestHeaders*>(this)->FindHeader(key);
+  return headers_.begin() + (it - headers_.cbegin());
 }
 
 HttpRequestHeaders::HeaderVector::const_iterator HttpRequestHeaders::FindHeader(
     const base::StringPiece& key) const {
+  return FindHeader(key, LookupWellKnownHeader(key));
+}
+
+HttpRequestHeaders::HeaderVector::const_iterator HttpRequestHeaders::FindHeader(
+    const base::StringPiece& key,
+    WellKnownHeader well_known_header) const {
+  // A well-known name can only match a header interned as the same value, and
+  // an unknown name can only match another unknown one.
   for (auto it = headers_.begin(); it != headers_.end(); ++it) {
-    if (base::EqualsCaseInsensitiveASCII(key, it->key))
+    if (it->well_known_header != well_known_header)
+      continue;
+    if (well_known_header != WellKnownHeader::kNone ||
+        base::EqualsCaseInsensitiveASCII(key, it->key)) {
       return it;
+    }
   }
 
   return headers_.end();
 }
 
+void HttpRequestHeaders::AppendHeader(const base::StringPiece& key,
+                                      WellKnownHeader well_known_header,
+                                      const base::StringPiece& value) {
+  if (headers_.capacity() == 0)
+    headers_.reserve(kInitialHeaderCapacity);
+  headers_.emplace_back(key, well_known_header, value);
+}
+
 void HttpRequestHeaders::SetHeaderInternal(const base::StringPiece& key,
                                            const base::StringPiece& value) {
-  auto it = FindHeader(key);
-  if (it != headers_.end())
-    it->value.assign(value.data(), value.size());
-  else
-    headers_.push_back(HeaderKeyValuePair(key, value));
+  WellKnownHeader well_known_header = LookupWellKnownHeader(key);
+  HeaderVector::const_iterator const_it = FindHeader(key, well_known_header);
+  if (const_it == headers_.end()) {
+    AppendHeader(key, well_known_header, value);
+    return;
+  }
+  auto it = headers_.begin() + (const_it - headers_.cbegin());
+  it->value.assign(value.data(), value.size());
 }
 
 }  // namespace net
@@ -5,11 +5,15 @@
 // HttpRequestHeaders manages the request headers.
 // It maintains these in a vector of header key/value pairs, thereby maintaining
 // the order of the headers.  This means that any lookups are linear time
-// operations.
+// operations.  To keep those scans cheap, each pair also records which, if any,
+// well-known header name it holds, so that most comparisons are between small
+// integers rather than case-insensitive string comparisons.
 
 #ifndef NET_HTTP_HTTP_REQUEST_HEADERS_H_
 #define NET_HTTP_HTTP_REQUEST_HEADERS_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,13 +31,62 @@ namespace net {
 
 class NET_EXPORT HttpRequestHeaders {
  public:
+  // Header names that are common enough in requests to be worth interning.
+  // This is the set of request header names from the HPACK (RFC 7541,
+  // Appendix A) and QPACK (RFC 9204, Appendix A) static tables, plus the
+  // hop-by-hop headers that HttpRequestHeaders has constants for.  Values are
+  // ordered by the length of the name, which LookupWellKnownHeader() relies
+  // on.  These values are not persisted and may be renumbered.
+  enum class WellKnownHeader : uint8_t {
+    kNone = 0,
+    kDnt,
+    kVia,
+    kFrom,
+    kHost,
+    kRange,
+    kAccept,
+    kCookie,
+    kExpect,
+    kOrigin,
+    kPragma,
+    kPurpose,
+    kReferer,
+    kIfMatch,
+    kIfRange,
+    kConnection,
+    kEarlyData,
+    kUserAgent,
+    kContentType,
+    kMaxForwards,
+    kAuthorization,
+    kCacheControl,
+    kIfNoneMatch,
+    kAcceptCharset,
+    kContentLength,
+    kAcceptEncoding,
+    kAcceptLanguage,
+    kXForwardedFor,
+    kProxyConnection,
+    kIfModifiedSince,
+    kTransferEncoding,
+    kIfUnmodifiedSince,
+    kProxyAuthorization,
+    kUpgradeInsecureRequests,
+    kMaxValue = kUpgradeInsecureRequests,
+  };
+
   struct NET_EXPORT HeaderKeyValuePair {
     HeaderKeyValuePair();
     HeaderKeyValuePair(const base::StringPiece& key,
                        const base::StringPiece& value);
+    HeaderKeyValuePair(const base::StringPiece& key,
+                       WellKnownHeader well_known_header,
+                       const base::StringPiece& value);
 
     std::string key;
     std::string value;
+    // The interned form of |key|, or kNone if |key| is not a well-known name.
+    WellKnownHeader well_known_header = WellKnownHeader::kNone;
   };
 
   typedef std::vector<HeaderKeyValuePair> HeaderVector;
@@ -93,6 +146,14 @@ class NET_EXPORT HttpRequestHeaders {
   static const char kTransferEncoding[];
   static const char kUserAgent[];
 
+  // Returns the WellKnownHeader that case-insensitively matches |name|, or
+  // WellKnownHeader::kNone if there is none.
+  static WellKnownHeader LookupWellKnownHeader(const base::StringPiece& name);
+
+  // Returns the canonical capitalization of |header|, which must not be
+  // WellKnownHeader::kNone.
+  static base::StringPiece GetWellKnownHeaderName(WellKnownHeader header);
+
   HttpRequestHeaders();
   HttpRequestHeaders(const HttpRequestHeaders& other);
   HttpRequestHeaders(HttpRequestHeaders&& other);
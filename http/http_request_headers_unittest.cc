@@ -5,7 +5,9 @@
 #include "net/http/http_request_headers.h"
 
 #include <memory>
+#include <string>
 
+#include "base/strings/string_piece.h"
 #include "base/values.h"
 #include "net/log/net_log_capture_mode.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -167,6 +169,85 @@ TEST(HttpRequestHeaders, CopyFrom) {
   EXPECT_EQ("B: b\r\nC: c\r\n\r\n", headers.ToString());
 }
 
+TEST(HttpRequestHeaders, LookupWellKnownHeader) {
+  using WellKnownHeader = HttpRequestHeaders::WellKnownHeader;
+  EXPECT_EQ(WellKnownHeader::kUserAgent,
+            HttpRequestHeaders::LookupWellKnownHeader("User-Agent"));
+  EXPECT_EQ(WellKnownHeader::kUserAgent,
+            HttpRequestHeaders::LookupWellKnownHeader("user-agent"));
+  EXPECT_EQ(WellKnownHeader::kDnt,
+            HttpRequestHeaders::LookupWellKnownHeader("dnt"));
+  EXPECT_EQ(WellKnownHeader::kUpgradeInsecureRequests,
+            HttpRequestHeaders::LookupWellKnownHeader(
+                "UPGRADE-INSECURE-REQUESTS"));
+  EXPECT_EQ(WellKnownHeader::kNone,
+            HttpRequestHeaders::LookupWellKnownHeader(""));
+  EXPECT_EQ(WellKnownHeader::kNone,
+            HttpRequestHeaders::LookupWellKnownHeader("User-Agen"));
+  EXPECT_EQ(WellKnownHeader::kNone,
+            HttpRequestHeaders::LookupWellKnownHeader("X-User-Agent"));
+  EXPECT_EQ(WellKnownHeader::kNone,
+            HttpRequestHeaders::LookupWellKnownHeader(
+                "Upgrade-Insecure-Requests-"));
+}
+
+// Every well-known name must be found by LookupWellKnownHeader(), which
+// depends on the names being ordered by length.
+TEST(HttpRequestHeaders, WellKnownHeaderNamesRoundTrip) {
+  using WellKnownHeader = HttpRequestHeaders::WellKnownHeader;
+  size_t previous_length = 0;
+  for (int i = 1; i <= static_cast<int>(WellKnownHeader::kMaxValue); ++i) {
+    WellKnownHeader header = static_cast<WellKnownHeader>(i);
+    base::StringPiece name = HttpRequestHeaders::GetWellKnownHeaderName(header);
+    EXPECT_LE(previous_length, name.size()) << name;
+    previous_length = name.size();
+    EXPECT_EQ(header, HttpRequestHeaders::LookupWellKnownHeader(name)) << name;
+  }
+
+  EXPECT_EQ(WellKnownHeader::kCookie,
+            HttpRequestHeaders::LookupWellKnownHeader(
+                HttpRequestHeaders::kCookie));
+  EXPECT_EQ(WellKnownHeader::kProxyConnection,
+            HttpRequestHeaders::LookupWellKnownHeader(
+                HttpRequestHeaders::kProxyConnection));
+}
+
+TEST(HttpRequestHeaders, WellKnownHeadersMatchCaseInsensitively) {
+  HttpRequestHeaders headers;
+  headers.SetHeader("accept-language", "en");
+  headers.SetHeader("X-Custom", "1");
+  headers.SetHeader(HttpRequestHeaders::kAcceptLanguage, "fr");
+  headers.SetHeader("x-custom", "2");
+  EXPECT_EQ("accept-language: fr\r\nX-Custom: 2\r\n\r\n",
+            headers.ToString());
+
+  std::string value;
+  EXPECT_TRUE(headers.GetHeader("ACCEPT-LANGUAGE", &value));
+  EXPECT_EQ("fr", value);
+  EXPECT_FALSE(headers.HasHeader(HttpRequestHeaders::kAccept));
+
+  headers.RemoveHeader("Accept-Language");
+  EXPECT_EQ("X-Custom: 2\r\n\r\n", headers.ToString());
+}
+
+// A well-known name must not match an unknown name that contains it, or vice
+// versa.
+TEST(HttpRequestHeaders, WellKnownAndUnknownHeadersDoNotMatch) {
+  HttpRequestHeaders headers;
+  headers.SetHeader("Range", "bytes=0-1");
+  headers.SetHeader("Ranges", "x");
+  EXPECT_EQ("Range: bytes=0-1\r\nRanges: x\r\n\r\n", headers.ToString());
+
+  headers.SetHeaderIfMissing("ranges", "y");
+  headers.SetHeaderIfMissing("range", "z");
+  EXPECT_EQ("Range: bytes=0-1\r\nRanges: x\r\n\r\n", headers.ToString());
+
+  HttpRequestHeaders copy(headers);
+  copy.RemoveHeader("ranges");
+  EXPECT_TRUE(copy.HasHeader("RANGE"));
+  EXPECT_FALSE(copy.HasHeader("Ranges"));
+}
+
 }  // namespace
 
 }  // namespace net
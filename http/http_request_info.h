@@ -58,6 +58,11 @@ struct NET_EXPORT HttpRequestInfo {
   // Network traffic annotation received from URL request.
   net::MutableNetworkTrafficAnnotationTag traffic_annotation;
 
+  // Whether the response may be processed as it arrives, rather than only as
+  // a whole, and so can share bandwidth with other responses of the same
+  // priority. Sent as the RFC 9218 incremental parameter.
+  bool priority_incremental;
+
   // Reporting upload nesting depth of this request.
   //
   // If the request is not a Reporting upload, the depth is 0.
@@ -9,6 +9,8 @@
 
 #include "net/http/http_response_headers.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <limits>
 #include <memory>
@@ -137,6 +139,31 @@ void CheckDoesNotHaveEmbeddedNulls(base::StringPiece str) {
   CHECK(!HasEmbeddedNulls(str));
 }
 
+// Whether |gap|, found between a header's name and its first value or between
+// two of its values, is |separator| with optional LWS around it.
+bool IsValueSeparator(base::StringPiece gap, char separator) {
+  gap = HttpUtil::TrimLWS(gap);
+  return gap.size() == 1 && gap[0] == separator;
+}
+
+// Whether [|value_begin|, |value_end|) is a value that Parse() could have
+// found: one without leading or trailing LWS and, for a header that is split
+// on commas, without a comma outside quotes.
+bool IsParsedValue(std::string::const_iterator value_begin,
+                   std::string::const_iterator value_end,
+                   bool coalescing) {
+  if (value_begin == value_end)
+    return true;
+  if (HttpUtil::IsLWS(*value_begin) || HttpUtil::IsLWS(*(value_end - 1)))
+    return false;
+  if (!coalescing)
+    return true;
+  HttpUtil::ValuesIterator values(value_begin, value_end, ',',
+                                  false /* ignore_empty_values */);
+  return values.GetNext() && values.value_begin() == value_begin &&
+         values.value_end() == value_end && !values.GetNext();
+}
+
 }  // namespace
 
 const char HttpResponseHeaders::kContentRange[] = "Content-Range";
@@ -184,6 +211,17 @@ HttpResponseHeaders::HttpResponseHeaders(base::PickleIterator* iter)
     Parse(raw_input);
 }
 
+HttpResponseHeaders::HttpResponseHeaders(const std::string& raw_input,
+                                         base::StringPiece index)
+    : response_code_(-1) {
+  if (!InitFromIndex(raw_input, index)) {
+    parsed_.clear();
+    raw_headers_.clear();
+    response_code_ = -1;
+    Parse(raw_input);
+  }
+}
+
 scoped_refptr<HttpResponseHeaders> HttpResponseHeaders::TryToCreate(
     base::StringPiece headers) {
   // Reject strings with nulls.
@@ -203,6 +241,64 @@ void HttpResponseHeaders::Persist(base::Pickle* pickle,
     return;  // Done.
   }
 
+  pickle->WriteString(GetPersistedHeaders(options, nullptr));
+}
+
+void HttpResponseHeaders::PersistWithIndex(base::Pickle* pickle,
+                                           PersistOptions options) {
+  std::vector<uint32_t> index;
+  pickle->WriteString(GetPersistedHeaders(options, &index));
+  pickle->WriteData(reinterpret_cast<const char*>(index.data()),
+                    index.size() * sizeof(uint32_t));
+}
+
+// static
+scoped_refptr<HttpResponseHeaders> HttpResponseHeaders::CreateFromIndexedPickle(
+    base::PickleIterator* iter) {
+  std::string raw_input;
+  const char* index_data;
+  int index_length;
+  if (!iter->ReadString(&raw_input) ||
+      !iter->ReadData(&index_data, &index_length)) {
+    return nullptr;
+  }
+  return base::WrapRefCounted(new HttpResponseHeaders(
+      raw_input, base::StringPiece(index_data, index_length)));
+}
+
+std::string HttpResponseHeaders::GetPersistedHeaders(
+    PersistOptions options,
+    std::vector<uint32_t>* index) const {
+  // Each entry of |index| is the offsets of the name and value bounds of one
+  // element of |parsed_|. Continuations have an empty name at offset 0.
+  auto add_to_index = [index](const ParsedHeader& header, size_t name_begin,
+                              size_t value_begin, size_t value_end) {
+    if (!index)
+      return;
+    size_t name_end = name_begin;
+    if (!header.is_continuation())
+      name_end += header.name_end - header.name_begin;
+    index->insert(index->end(), {static_cast<uint32_t>(name_begin),
+                                 static_cast<uint32_t>(name_end),
+                                 static_cast<uint32_t>(value_begin),
+                                 static_cast<uint32_t>(value_end)});
+  };
+
+  if (options == PERSIST_RAW) {
+    if (index) {
+      index->reserve(parsed_.size() * 4);
+      for (const ParsedHeader& header : parsed_) {
+        add_to_index(header,
+                     header.is_continuation()
+                         ? 0
+                         : header.name_begin - raw_headers_.begin(),
+                     header.value_begin - raw_headers_.begin(),
+                     header.value_end - raw_headers_.begin());
+      }
+    }
+    return raw_headers_;
+  }
+
   HeaderSet filter_headers;
 
   // Construct set of headers to filter out based on options.
@@ -243,8 +339,18 @@ void HttpResponseHeaders::Persist(base::Pickle* pickle,
     std::string header_name = base::ToLowerASCII(
         base::StringPiece(parsed_[i].name_begin, parsed_[i].name_end));
     if (filter_headers.find(header_name) == filter_headers.end()) {
+      // The header and its continuations are copied as a single line, so
+      // their offsets within it are unchanged.
+      std::string::const_iterator line_begin = parsed_[i].name_begin;
+      size_t offset = blob.size();
+      for (size_t j = i; j <= k; ++j) {
+        add_to_index(parsed_[j], j == i ? offset : 0,
+                     offset + (parsed_[j].value_begin - line_begin),
+                     offset + (parsed_[j].value_end - line_begin));
+      }
+
       // Make sure there is a null after the value.
-      blob.append(parsed_[i].name_begin, parsed_[k].value_end);
+      blob.append(line_begin, parsed_[k].value_end);
       blob.push_back('\0');
     }
 
@@ -252,7 +358,7 @@ void HttpResponseHeaders::Persist(base::Pickle* pickle,
   }
   blob.push_back('\0');
 
-  pickle->WriteString(blob);
+  return blob;
 }
 
 void HttpResponseHeaders::Update(const HttpResponseHeaders& new_headers) {
@@ -497,6 +603,110 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
   DCHECK_EQ('\0', raw_headers_[raw_headers_.size() - 1]);
 }
 
+bool HttpResponseHeaders::InitFromIndex(const std::string& raw_input,
+                                        base::StringPiece index) {
+  const size_t kEntrySize = 4 * sizeof(uint32_t);
+  if (index.size() % kEntrySize != 0)
+    return false;
+
+  // The status line is short, so normalize it again rather than trusting the
+  // persisted copy, and require that doing so is a no-op.
+  size_t status_line_len = raw_input.find('\0');
+  if (status_line_len == std::string::npos ||
+      raw_input.size() < status_line_len + 2 ||
+      raw_input[raw_input.size() - 2] != '\0' ||
+      raw_input[raw_input.size() - 1] != '\0') {
+    return false;
+  }
+  bool has_headers = raw_input[status_line_len + 1] != '\0';
+  ParseStatusLine(raw_input.begin(), raw_input.begin() + status_line_len,
+                  has_headers);
+  if (raw_headers_.compare(0, std::string::npos, raw_input, 0,
+                           status_line_len) != 0) {
+    return false;
+  }
+
+  raw_headers_ = raw_input;
+  const char* const data = raw_headers_.data();
+  // The NUL that ends the line of the previous entry, or the status line.
+  size_t line_end = status_line_len;
+  // The end of the previous entry's value.
+  size_t prev_value_end = status_line_len;
+  // Whether the previous entry's header is split on commas.
+  bool coalescing = false;
+  size_t num_entries = index.size() / kEntrySize;
+  parsed_.reserve(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    uint32_t entry[4];
+    memcpy(entry, index.data() + i * kEntrySize, kEntrySize);
+    uint32_t name_begin = entry[0];
+    uint32_t name_end = entry[1];
+    uint32_t value_begin = entry[2];
+    uint32_t value_end = entry[3];
+
+    if (name_begin == name_end) {
+      // A continuation is a further value of the previous entry's header, so
+      // it follows that value on the same line, after a comma. Only a header
+      // that is split on commas can be continued.
+      if (parsed_.empty() || !coalescing || value_begin < prev_value_end ||
+          value_begin > value_end || value_end > line_end ||
+          !IsValueSeparator(base::StringPiece(data + prev_value_end,
+                                              value_begin - prev_value_end),
+                            ',') ||
+          !IsParsedValue(raw_headers_.begin() + value_begin,
+                         raw_headers_.begin() + value_end, coalescing)) {
+        return false;
+      }
+      AddToParsed(raw_headers_.end(), raw_headers_.end(),
+                  raw_headers_.begin() + value_begin,
+                  raw_headers_.begin() + value_end);
+    } else {
+      // A header starts its own line, right after the line of the previous
+      // entry, which must not be the last one and must have nothing but LWS
+      // after its last value. Its name is a token and is separated from its
+      // value by a colon, as HttpUtil::HeadersIterator would find them.
+      if (name_begin != line_end + 1 || name_begin >= raw_headers_.size() - 2 ||
+          !HttpUtil::TrimLWS(base::StringPiece(data + prev_value_end,
+                                               line_end - prev_value_end))
+               .empty()) {
+        return false;
+      }
+      line_end = static_cast<const char*>(
+                     memchr(data + name_begin, '\0',
+                            raw_headers_.size() - name_begin)) -
+                 data;
+      if (name_begin > name_end || name_end > value_begin ||
+          value_begin > value_end || value_end > line_end) {
+        return false;
+      }
+      base::StringPiece name(data + name_begin, name_end - name_begin);
+      if (!HttpUtil::IsToken(name) ||
+          !IsValueSeparator(
+              base::StringPiece(data + name_end, value_begin - name_end),
+              ':')) {
+        return false;
+      }
+      coalescing = !HttpUtil::IsNonCoalescingHeader(name);
+      if (!IsParsedValue(raw_headers_.begin() + value_begin,
+                         raw_headers_.begin() + value_end, coalescing)) {
+        return false;
+      }
+      AddToParsed(raw_headers_.begin() + name_begin,
+                  raw_headers_.begin() + name_end,
+                  raw_headers_.begin() + value_begin,
+                  raw_headers_.begin() + value_end);
+    }
+    prev_value_end = value_end;
+  }
+
+  // Every header line must have been indexed, up to its end, so that the
+  // headers are the same as Parse() would find.
+  return line_end == raw_headers_.size() - 2 &&
+         HttpUtil::TrimLWS(base::StringPiece(data + prev_value_end,
+                                             line_end - prev_value_end))
+             .empty();
+}
+
 bool HttpResponseHeaders::GetNormalizedHeader(base::StringPiece name,
                                               std::string* value) const {
   // If you hit this assertion, please use EnumerateHeader instead!
@@ -92,6 +92,17 @@ class NET_EXPORT HttpResponseHeaders
   // The options argument can be a combination of PersistOptions.
   void Persist(base::Pickle* pickle, PersistOptions options);
 
+  // Like Persist(), but also appends the offsets of the parsed headers, so
+  // that CreateFromIndexedPickle() can restore the object without parsing the
+  // header block again.
+  void PersistWithIndex(base::Pickle* pickle, PersistOptions options);
+
+  // Restores headers appended by PersistWithIndex(). An index that does not
+  // match the header block is ignored, and the block parsed instead. Returns
+  // nullptr if the pickle could not be read.
+  static scoped_refptr<HttpResponseHeaders> CreateFromIndexedPickle(
+      base::PickleIterator* pickle_iter);
+
   // Performs header merging as described in 13.5.3 of RFC 2616.
   void Update(const HttpResponseHeaders& new_headers);
 
@@ -322,11 +333,29 @@ class NET_EXPORT HttpResponseHeaders
   struct ParsedHeader;
   typedef std::vector<ParsedHeader> HeaderList;
 
+  // Initializes from |raw_headers| as written by Persist(), using |index| as
+  // written by PersistWithIndex() to locate the headers when it is valid.
+  HttpResponseHeaders(const std::string& raw_headers, base::StringPiece index);
+
   ~HttpResponseHeaders();
 
   // Initializes from the given raw headers.
   void Parse(const std::string& raw_input);
 
+  // Initializes from the given persisted raw headers and header index.
+  // Returns false, leaving the object in an unspecified state, if |index|
+  // does not describe the headers Parse() would find in |raw_input|: its
+  // entries must be in order, must not overlap or span lines, and must cover
+  // every header line. Each header must start its line with a token name
+  // followed by a colon, and values must be trimmed and split on commas as
+  // Parse() splits them.
+  bool InitFromIndex(const std::string& raw_input, base::StringPiece index);
+
+  // Returns the header block that Persist() writes for |options|. If |index|
+  // is not null, fills it with the offsets of |parsed_| within that block.
+  std::string GetPersistedHeaders(PersistOptions options,
+                                  std::vector<uint32_t>* index) const;
+
   // Helper function for ParseStatusLine.
   // Tries to extract the "HTTP/X.Y" from a status line formatted like:
   //    HTTP/1.1 200 OK
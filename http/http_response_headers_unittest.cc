@@ -5,12 +5,14 @@
 #include "net/http/http_response_headers.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "base/pickle.h"
 #include "base/time/time.h"
@@ -332,6 +334,18 @@ TEST_P(PersistenceTest, Persist) {
   scoped_refptr<HttpResponseHeaders> parsed2(new HttpResponseHeaders(&iter));
 
   EXPECT_EQ(std::string(test.expected_headers), ToSimpleString(parsed2));
+
+  // Restoring from the header index must give the same result as parsing.
+  base::Pickle indexed_pickle;
+  parsed1->PersistWithIndex(&indexed_pickle, test.options);
+
+  base::PickleIterator indexed_iter(indexed_pickle);
+  scoped_refptr<HttpResponseHeaders> parsed3 =
+      HttpResponseHeaders::CreateFromIndexedPickle(&indexed_iter);
+  ASSERT_TRUE(parsed3);
+
+  EXPECT_EQ(parsed2->raw_headers(), parsed3->raw_headers());
+  EXPECT_EQ(std::string(test.expected_headers), ToSimpleString(parsed3));
 }
 
 const struct PersistData persistence_tests[] = {
@@ -496,6 +510,204 @@ INSTANTIATE_TEST_SUITE_P(HttpResponseHeaders,
                          PersistenceTest,
                          testing::ValuesIn(persistence_tests));
 
+TEST(HttpResponseHeadersTest, PersistWithIndex_CoalescedValues) {
+  std::string headers =
+      "HTTP/1.1 404 Not Found\n"
+      "Cache-Control: private, max-age=60\n"
+      "Set-Cookie: a=b\n"
+      "ETag: \"abc\"\n";
+  HeadersToRaw(&headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(headers);
+
+  base::Pickle pickle;
+  parsed->PersistWithIndex(&pickle, HttpResponseHeaders::PERSIST_SANS_COOKIES);
+  base::PickleIterator iter(pickle);
+  scoped_refptr<HttpResponseHeaders> restored =
+      HttpResponseHeaders::CreateFromIndexedPickle(&iter);
+  ASSERT_TRUE(restored);
+
+  EXPECT_EQ(404, restored->response_code());
+  EXPECT_EQ(HttpVersion(1, 1), restored->GetHttpVersion());
+  EXPECT_FALSE(restored->HasHeader("Set-Cookie"));
+
+  size_t it = 0;
+  std::string value;
+  ASSERT_TRUE(restored->EnumerateHeader(&it, "cache-control", &value));
+  EXPECT_EQ("private", value);
+  ASSERT_TRUE(restored->EnumerateHeader(&it, "cache-control", &value));
+  EXPECT_EQ("max-age=60", value);
+  EXPECT_FALSE(restored->EnumerateHeader(&it, "cache-control", &value));
+
+  base::TimeDelta max_age;
+  ASSERT_TRUE(restored->GetMaxAgeValue(&max_age));
+  EXPECT_EQ(base::TimeDelta::FromSeconds(60), max_age);
+  EXPECT_TRUE(restored->HasStrongValidators());
+}
+
+// An index that does not match the header block is ignored.
+TEST(HttpResponseHeadersTest, CreateFromIndexedPickle_InvalidIndex) {
+  std::string headers =
+      "HTTP/1.1 200 OK\n"
+      "Cache-Control: private, max-age=60\n";
+  HeadersToRaw(&headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(headers);
+
+  const uint32_t kOutOfBounds[] = {17, 30, 1000, 1010};
+  const uint32_t kLeadingContinuation[] = {0, 0, 32, 39};
+  const uint32_t kInStatusLine[] = {0, 8, 9, 12};
+  const std::string kInvalidIndices[] = {
+      "abc",
+      std::string(reinterpret_cast<const char*>(kOutOfBounds),
+                  sizeof(kOutOfBounds)),
+      std::string(reinterpret_cast<const char*>(kLeadingContinuation),
+                  sizeof(kLeadingContinuation)),
+      std::string(reinterpret_cast<const char*>(kInStatusLine),
+                  sizeof(kInStatusLine)),
+  };
+
+  for (const std::string& index : kInvalidIndices) {
+    base::Pickle pickle;
+    pickle.WriteString(parsed->raw_headers());
+    pickle.WriteData(index.data(), index.size());
+
+    base::PickleIterator iter(pickle);
+    scoped_refptr<HttpResponseHeaders> restored =
+        HttpResponseHeaders::CreateFromIndexedPickle(&iter);
+    ASSERT_TRUE(restored);
+    EXPECT_EQ(200, restored->response_code());
+    EXPECT_EQ(ToSimpleString(parsed), ToSimpleString(restored));
+  }
+
+  // A pickle without an index cannot be read.
+  base::Pickle pickle;
+  parsed->Persist(&pickle, HttpResponseHeaders::PERSIST_RAW);
+  base::PickleIterator iter(pickle);
+  EXPECT_FALSE(HttpResponseHeaders::CreateFromIndexedPickle(&iter));
+}
+
+// An index whose entries are out of order, overlap, span lines or leave out a
+// line is ignored, even though all its offsets are in bounds.
+TEST(HttpResponseHeadersTest, CreateFromIndexedPickle_CorruptedIndex) {
+  std::string headers =
+      "HTTP/1.1 200 OK\n"
+      "Cache-Control: private, max-age=60\n"
+      "ETag: \"abc\"\n";
+  HeadersToRaw(&headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(headers);
+
+  base::Pickle valid_pickle;
+  parsed->PersistWithIndex(&valid_pickle, HttpResponseHeaders::PERSIST_RAW);
+  base::PickleIterator valid_iter(valid_pickle);
+  std::string raw_headers;
+  const char* index_data;
+  int index_length;
+  ASSERT_TRUE(valid_iter.ReadString(&raw_headers));
+  ASSERT_TRUE(valid_iter.ReadData(&index_data, &index_length));
+  // "Cache-Control: private", ", max-age=60" and "ETag: "abc"".
+  ASSERT_EQ(12 * sizeof(uint32_t), static_cast<size_t>(index_length));
+  std::vector<uint32_t> valid_index(12);
+  memcpy(valid_index.data(), index_data, index_length);
+
+  std::vector<std::vector<uint32_t>> corrupted_indices;
+  // The second header starts where the first one does.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[8] = valid_index[0];
+  corrupted_indices.back()[9] = valid_index[1];
+  // The continuation starts before the value it continues ends.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[6] = valid_index[2];
+  // The first value runs into the next line.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[3] = valid_index[10];
+  // The last header line is left out.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back().resize(8);
+
+  for (const std::vector<uint32_t>& index : corrupted_indices) {
+    base::Pickle pickle;
+    pickle.WriteString(raw_headers);
+    pickle.WriteData(reinterpret_cast<const char*>(index.data()),
+                     index.size() * sizeof(uint32_t));
+
+    base::PickleIterator iter(pickle);
+    scoped_refptr<HttpResponseHeaders> restored =
+        HttpResponseHeaders::CreateFromIndexedPickle(&iter);
+    ASSERT_TRUE(restored);
+    EXPECT_EQ(ToSimpleString(parsed), ToSimpleString(restored));
+  }
+}
+
+// An index whose entries are in order and within their lines, but that
+// describes names or values Parse() would not find, is ignored.
+TEST(HttpResponseHeadersTest, CreateFromIndexedPickle_IndexDisagreesWithParse) {
+  std::string headers =
+      "HTTP/1.1 200 OK\n"
+      "X-Foo: Set-Cookie: a=b\n"
+      "Cache-Control: private , max-age=60\n";
+  HeadersToRaw(&headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(headers);
+
+  base::Pickle valid_pickle;
+  parsed->PersistWithIndex(&valid_pickle, HttpResponseHeaders::PERSIST_RAW);
+  base::PickleIterator valid_iter(valid_pickle);
+  std::string raw_headers;
+  const char* index_data;
+  int index_length;
+  ASSERT_TRUE(valid_iter.ReadString(&raw_headers));
+  ASSERT_TRUE(valid_iter.ReadData(&index_data, &index_length));
+  // "X-Foo: Set-Cookie: a=b", "Cache-Control: private" and ", max-age=60".
+  ASSERT_EQ(12 * sizeof(uint32_t), static_cast<size_t>(index_length));
+  std::vector<uint32_t> valid_index(12);
+  memcpy(valid_index.data(), index_data, index_length);
+  size_t value_length = valid_index[3] - valid_index[2];
+  ASSERT_EQ("Set-Cookie: a=b",
+            raw_headers.substr(valid_index[2], value_length));
+
+  std::vector<std::vector<uint32_t>> corrupted_indices;
+  // The name starts in the middle of the line, at "Set-Cookie".
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[0] = valid_index[2];
+  corrupted_indices.back()[1] = valid_index[2] + 10;
+  corrupted_indices.back()[2] = valid_index[2] + 12;
+  // The name is "X-Foo: Set-Cookie", which is not a token.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[1] = valid_index[2] + 10;
+  corrupted_indices.back()[2] = valid_index[2] + 12;
+  // The name is "X-F", which is not followed by a colon.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[1] = valid_index[0] + 3;
+  // The value has leading LWS.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[2] = valid_index[2] - 1;
+  // The value has trailing LWS.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[7] = valid_index[7] + 1;
+  // The value stops before the end of the line.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[3] = valid_index[3] - 2;
+  // The continuation has leading LWS.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[10] = valid_index[10] - 1;
+  // The values of a header that is split on commas are not split.
+  corrupted_indices.push_back(valid_index);
+  corrupted_indices.back()[7] = valid_index[11];
+  corrupted_indices.back().resize(8);
+
+  for (const std::vector<uint32_t>& index : corrupted_indices) {
+    base::Pickle pickle;
+    pickle.WriteString(raw_headers);
+    pickle.WriteData(reinterpret_cast<const char*>(index.data()),
+                     index.size() * sizeof(uint32_t));
+
+    base::PickleIterator iter(pickle);
+    scoped_refptr<HttpResponseHeaders> restored =
+        HttpResponseHeaders::CreateFromIndexedPickle(&iter);
+    ASSERT_TRUE(restored);
+    EXPECT_EQ(ToSimpleString(parsed), ToSimpleString(restored));
+    EXPECT_FALSE(restored->HasHeader("Set-Cookie"));
+  }
+}
+
 TEST(HttpResponseHeadersTest, EnumerateHeader_Coalesced) {
   // Ensure that commas in quoted strings are not regarded as value separators.
   // Ensure that whitespace following a value is trimmed properly.
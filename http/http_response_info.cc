@@ -44,7 +44,9 @@ bool KeyExchangeGroupIsValid(int ssl_connection_status) {
 // serialized HttpResponseInfo.
 enum {
   // The version of the response info used when persisting response info.
-  RESPONSE_INFO_VERSION = 3,
+  // Version 4 follows the response headers with the offsets of the parsed
+  // headers (see HttpResponseHeaders::PersistWithIndex()).
+  RESPONSE_INFO_VERSION = 4,
 
   // The minimum version supported for deserializing response info.
   RESPONSE_INFO_MINIMUM_VERSION = 3,
@@ -228,8 +230,11 @@ bool HttpResponseInfo::InitFromPickle(const base::Pickle& pickle,
   response_time = Time::FromInternalValue(time_val);
 
   // Read response-headers
-  headers = new HttpResponseHeaders(&iter);
-  if (headers->response_code() == -1)
+  if (version >= 4)
+    headers = HttpResponseHeaders::CreateFromIndexedPickle(&iter);
+  else
+    headers = new HttpResponseHeaders(&iter);
+  if (!headers || headers->response_code() == -1)
     return false;
 
   // Read ssl-info
@@ -427,7 +432,7 @@ void HttpResponseInfo::Persist(base::Pickle* pickle,
                       HttpResponseHeaders::PERSIST_SANS_SECURITY_STATE;
   }
 
-  headers->Persist(pickle, persist_options);
+  headers->PersistWithIndex(pickle, persist_options);
 
   if (ssl_info.is_valid()) {
     ssl_info.cert->Persist(pickle);
@@ -35,6 +35,41 @@ class HttpResponseInfoTest : public testing::Test {
   HttpResponseInfo response_info_;
 };
 
+// Entries written before the header index was added must still be readable.
+TEST_F(HttpResponseInfoTest, InitFromVersion3Pickle) {
+  const char kRawHeaders[] = "HTTP/1.1 200 OK\0Cache-Control: max-age=60\0\0";
+  std::string raw_headers(kRawHeaders, sizeof(kRawHeaders) - 1);
+  base::Pickle pickle;
+  pickle.WriteInt(3);               // flags
+  pickle.WriteInt64(0);             // request_time
+  pickle.WriteInt64(0);             // response_time
+  pickle.WriteString(raw_headers);  // headers
+  pickle.WriteString("");           // remote_endpoint host
+  pickle.WriteUInt16(0);            // remote_endpoint port
+
+  HttpResponseInfo restored_response_info;
+  bool truncated = false;
+  ASSERT_TRUE(restored_response_info.InitFromPickle(pickle, &truncated));
+  EXPECT_EQ(200, restored_response_info.headers->response_code());
+  EXPECT_EQ(raw_headers, restored_response_info.headers->raw_headers());
+}
+
+TEST_F(HttpResponseInfoTest, HeadersPersist) {
+  const char kRawHeaders[] =
+      "HTTP/1.1 200 OK\0Set-Cookie: a=b\0ETag: \"x\"\0\0";
+  response_info_.headers = base::MakeRefCounted<HttpResponseHeaders>(
+      std::string(kRawHeaders, sizeof(kRawHeaders) - 1));
+  base::Pickle pickle;
+  response_info_.Persist(&pickle, true /* skip_transient_headers */, false);
+
+  HttpResponseInfo restored_response_info;
+  bool truncated = false;
+  ASSERT_TRUE(restored_response_info.InitFromPickle(pickle, &truncated));
+  EXPECT_EQ(200, restored_response_info.headers->response_code());
+  EXPECT_FALSE(restored_response_info.headers->HasHeader("Set-Cookie"));
+  EXPECT_TRUE(restored_response_info.headers->HasHeaderValue("ETag", "\"x\""));
+}
+
 TEST_F(HttpResponseInfoTest, UnusedSincePrefetchDefault) {
   EXPECT_FALSE(response_info_.unused_since_prefetch);
 }
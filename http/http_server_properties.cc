@@ -188,6 +188,7 @@ void HttpServerProperties::Clear(base::OnceClosure callback) {
   if (properties_manager_) {
     // Stop waiting for initial settings.
     is_initialized_ = true;
+    RunInitializationCallbacks();
     // Leaving this as-is doesn't actually have any effect, if it's true, but
     // seems best to be safe.
     queue_write_on_load_ = false;
@@ -571,6 +572,44 @@ bool HttpServerProperties::IsInitialized() const {
   return is_initialized_;
 }
 
+void HttpServerProperties::RunWhenInitialized(base::OnceClosure callback) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  if (!is_initialized_) {
+    initialization_callbacks_.push_back(std::move(callback));
+    return;
+  }
+  base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, std::move(callback));
+}
+
+std::vector<HttpServerProperties::ServerInfoMapKey>
+HttpServerProperties::GetRecentMultiplexedServers(size_t max_servers) const {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  std::vector<ServerInfoMapKey> servers;
+  const base::Time now = clock_->Now();
+  // |server_info_map_| is ordered from most to least recently used.
+  for (const auto& server_info : server_info_map_) {
+    if (servers.size() >= max_servers)
+      break;
+    const ServerInfoMapKey& key = server_info.first;
+    if (key.server.scheme() != url::kHttpsScheme)
+      continue;
+    bool multiplexed = server_info.second.supports_spdy.value_or(false);
+    if (!multiplexed && server_info.second.alternative_services.has_value()) {
+      for (const AlternativeServiceInfo& alternative_service_info :
+           server_info.second.alternative_services.value()) {
+        if (alternative_service_info.protocol() == kProtoQUIC &&
+            alternative_service_info.expiration() >= now) {
+          multiplexed = true;
+          break;
+        }
+      }
+    }
+    if (multiplexed)
+      servers.push_back(key);
+  }
+  return servers;
+}
+
 void HttpServerProperties::OnExpireBrokenAlternativeService(
     const AlternativeService& expired_alternative_service,
     const NetworkIsolationKey& network_isolation_key) {
@@ -1067,6 +1106,15 @@ const std::string* HttpServerProperties::GetCanonicalSuffix(
   return nullptr;
 }
 
+void HttpServerProperties::RunInitializationCallbacks() {
+  DCHECK(is_initialized_);
+  for (base::OnceClosure& callback : initialization_callbacks_) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE,
+                                                  std::move(callback));
+  }
+  initialization_callbacks_.clear();
+}
+
 void HttpServerProperties::OnPrefsLoaded(
     std::unique_ptr<ServerInfoMap> server_info_map,
     const IPAddress& last_local_address_when_quic_worked,
@@ -1094,6 +1142,7 @@ void HttpServerProperties::OnPrefsLoaded(
   }
 
   is_initialized_ = true;
+  RunInitializationCallbacks();
 
   if (queue_write_on_load_) {
     // Leaving this as true doesn't actually have any effect, but seems best to
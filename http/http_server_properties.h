@@ -413,6 +413,17 @@ class NET_EXPORT HttpServerProperties
   // Returns whether HttpServerProperties is initialized.
   bool IsInitialized() const;
 
+  // Invokes |callback| asynchronously once HttpServerProperties is
+  // initialized, or right away if it already is.
+  void RunWhenInitialized(base::OnceClosure callback);
+
+  // Returns the keys of up to |max_servers| https servers that are known to
+  // support HTTP/2 or to have an unexpired QUIC alternative service, most
+  // recently used first. Unlike the getters above, doesn't affect which
+  // servers count as recently used.
+  std::vector<ServerInfoMapKey> GetRecentMultiplexedServers(
+      size_t max_servers) const;
+
   // BrokenAlternativeServices::Delegate method.
   void OnExpireBrokenAlternativeService(
       const AlternativeService& expired_alternative_service,
@@ -555,6 +566,10 @@ class NET_EXPORT HttpServerProperties
   // exists.
   const std::string* GetCanonicalSuffix(const std::string& host) const;
 
+  // Posts the callbacks in |initialization_callbacks_|. Called once
+  // |is_initialized_| becomes true.
+  void RunInitializationCallbacks();
+
   void OnPrefsLoaded(std::unique_ptr<ServerInfoMap> server_info_map,
                      const IPAddress& last_local_address_when_quic_worked,
                      std::unique_ptr<QuicServerInfoMap> quic_server_info_map,
@@ -597,6 +612,10 @@ class NET_EXPORT HttpServerProperties
   // |properties_manager_|. Always true if |properties_manager_| is nullptr.
   bool is_initialized_;
 
+  // Callbacks passed to RunWhenInitialized() while |is_initialized_| was
+  // false.
+  std::vector<base::OnceClosure> initialization_callbacks_;
+
   // Queue a write when resources finish loading. Set to true when
   // MaybeQueueWriteProperties() is invoked while still waiting on
   // initialization to complete.
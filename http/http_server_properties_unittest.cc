@@ -532,6 +532,56 @@ TEST_F(HttpServerPropertiesTest, MRUOfServerInfoMap) {
   EXPECT_TRUE(it->first.network_isolation_key.IsEmpty());
 }
 
+TEST_F(HttpServerPropertiesTest, GetRecentMultiplexedServers) {
+  url::SchemeHostPort spdy_server("https", "www.google.com", 443);
+  url::SchemeHostPort http11_server("https", "mail.google.com", 443);
+  url::SchemeHostPort quic_server("https", "www.youtube.com", 443);
+  url::SchemeHostPort http_server("http", "docs.google.com", 80);
+
+  impl_.SetSupportsSpdy(spdy_server, NetworkIsolationKey(), true);
+  impl_.SetSupportsSpdy(http11_server, NetworkIsolationKey(), false);
+  SetAlternativeService(quic_server, AlternativeService(
+                                         kProtoQUIC, "www.youtube.com", 443));
+  impl_.SetSupportsSpdy(http_server, NetworkIsolationKey(), true);
+
+  // Only https servers that multiplex are returned, most recent first.
+  std::vector<HttpServerProperties::ServerInfoMapKey> servers =
+      impl_.GetRecentMultiplexedServers(10);
+  ASSERT_EQ(2u, servers.size());
+  EXPECT_EQ(quic_server, servers[0].server);
+  EXPECT_EQ(spdy_server, servers[1].server);
+
+  servers = impl_.GetRecentMultiplexedServers(1);
+  ASSERT_EQ(1u, servers.size());
+  EXPECT_EQ(quic_server, servers[0].server);
+
+  // Listing servers doesn't change which were used most recently.
+  EXPECT_EQ(http_server,
+            impl_.server_info_map_for_testing().begin()->first.server);
+
+  // Expired QUIC alternative services don't count.
+  test_clock_.Advance(base::TimeDelta::FromDays(2));
+  servers = impl_.GetRecentMultiplexedServers(10);
+  ASSERT_EQ(1u, servers.size());
+  EXPECT_EQ(spdy_server, servers[0].server);
+}
+
+TEST_F(HttpServerPropertiesTest, RunWhenInitialized) {
+  // |impl_| has no pref delegate, so is initialized from the start, but the
+  // callback still runs asynchronously.
+  bool callback_invoked = false;
+  base::RunLoop run_loop;
+  impl_.RunWhenInitialized(base::BindOnce(
+      [](bool* callback_invoked, base::OnceClosure quit_closure) {
+        *callback_invoked = true;
+        std::move(quit_closure).Run();
+      },
+      &callback_invoked, run_loop.QuitClosure()));
+  EXPECT_FALSE(callback_invoked);
+  run_loop.Run();
+  EXPECT_TRUE(callback_invoked);
+}
+
 typedef HttpServerPropertiesTest AlternateProtocolServerPropertiesTest;
 
 TEST_F(AlternateProtocolServerPropertiesTest, Basic) {
@@ -0,0 +1,93 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_startup_preconnector.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/time/time.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_server_properties.h"
+#include "net/http/http_stream_factory.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+
+namespace {
+
+constexpr NetworkTrafficAnnotationTag kStartupPreconnectTrafficAnnotation =
+    DefineNetworkTrafficAnnotation("http_startup_preconnect", R"(
+        semantics {
+          sender: "HTTP Startup Preconnector"
+          description:
+            "Connects to the HTTP/2 and QUIC servers that were used most "
+            "recently in a previous run, so that the first requests to them "
+            "don't have to wait for a connection to be set up."
+          trigger: "Network stack startup, if configured by the embedder."
+          data: "None beyond connection and TLS setup."
+          destination: OTHER
+        }
+        policy {
+          cookies_allowed: NO
+          setting: "This feature cannot be disabled by settings."
+          policy_exception_justification: "Not implemented."
+        })");
+
+}  // namespace
+
+HttpStartupPreconnector::HttpStartupPreconnector(HttpNetworkSession* session,
+                                                 size_t max_servers)
+    : session_(session), max_servers_(max_servers) {}
+
+HttpStartupPreconnector::~HttpStartupPreconnector() = default;
+
+void HttpStartupPreconnector::Start() {
+  session_->http_server_properties()->RunWhenInitialized(base::BindOnce(
+      &HttpStartupPreconnector::Preconnect, weak_factory_.GetWeakPtr()));
+}
+
+void HttpStartupPreconnector::Preconnect() {
+  HttpServerProperties* http_server_properties =
+      session_->http_server_properties();
+  std::vector<HttpServerProperties::ServerInfoMapKey> servers =
+      http_server_properties->GetRecentMultiplexedServers(max_servers_);
+
+  // Looking up a server makes it the most recently used one, so go from least
+  // to most recently used, to leave their order as it was.
+  std::vector<std::pair<base::TimeDelta, size_t>> srtts;
+  for (size_t i = servers.size(); i > 0; --i) {
+    const ServerNetworkStats* stats =
+        http_server_properties->GetServerNetworkStats(
+            servers[i - 1].server, servers[i - 1].network_isolation_key);
+    srtts.emplace_back(stats ? stats->srtt : base::TimeDelta(), i - 1);
+  }
+  // Longest smoothed RTT first, and otherwise most recently used first.
+  std::sort(srtts.begin(), srtts.end(),
+            [](const std::pair<base::TimeDelta, size_t>& a,
+               const std::pair<base::TimeDelta, size_t>& b) {
+              if (a.first != b.first)
+                return a.first > b.first;
+              return a.second < b.second;
+            });
+
+  for (const auto& srtt : srtts) {
+    const HttpServerProperties::ServerInfoMapKey& server =
+        servers[srtt.second];
+    HttpRequestInfo request_info;
+    request_info.method = "GET";
+    request_info.url = server.server.GetURL();
+    request_info.network_isolation_key = server.network_isolation_key;
+    request_info.traffic_annotation = MutableNetworkTrafficAnnotationTag(
+        kStartupPreconnectTrafficAnnotation);
+    // The server multiplexes requests, so a preconnect of one stream opens a
+    // single session.
+    session_->http_stream_factory()->PreconnectStreams(1, request_info);
+  }
+}
+
+}  // namespace net
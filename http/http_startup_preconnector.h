@@ -0,0 +1,52 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_STARTUP_PRECONNECTOR_H_
+#define NET_HTTP_HTTP_STARTUP_PRECONNECTOR_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+class HttpNetworkSession;
+
+// Warms up an HttpNetworkSession after process start by connecting to the
+// servers that were used most recently in a previous run, as recorded by its
+// HttpServerProperties.
+//
+// Only https servers known to support HTTP/2 or to have a QUIC alternative
+// service are considered, since a single connection can carry all of their
+// requests. Exactly one connection is opened to each, through
+// HttpStreamFactory::PreconnectStreams(), so it becomes a SpdySession or a
+// QUIC session that the first request to the server can use right away.
+// Servers with the longest smoothed RTT on record are connected to first, as
+// their connections take longest to set up.
+class NET_EXPORT_PRIVATE HttpStartupPreconnector {
+ public:
+  // Preconnects to up to |max_servers| servers. |session| must outlive this.
+  HttpStartupPreconnector(HttpNetworkSession* session, size_t max_servers);
+  ~HttpStartupPreconnector();
+
+  // Preconnects once the HttpServerProperties of |session| have been loaded.
+  // Must be called at most once.
+  void Start();
+
+ private:
+  void Preconnect();
+
+  HttpNetworkSession* const session_;
+  const size_t max_servers_;
+
+  base::WeakPtrFactory<HttpStartupPreconnector> weak_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(HttpStartupPreconnector);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_STARTUP_PRECONNECTOR_H_
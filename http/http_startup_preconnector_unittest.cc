@@ -0,0 +1,101 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_startup_preconnector.h"
+
+#include <memory>
+
+#include "base/run_loop.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_server.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_server_properties.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/socket_test_util.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_test_util_common.h"
+#include "net/test/cert_test_util.h"
+#include "net/test/test_data_directory.h"
+#include "net/test/test_with_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+namespace {
+
+SpdySessionKey KeyForServer(const url::SchemeHostPort& server) {
+  return SpdySessionKey(HostPortPair(server.host(), server.port()),
+                        ProxyServer::Direct(), PRIVACY_MODE_DISABLED,
+                        SpdySessionKey::IsProxySession::kFalse, SocketTag(),
+                        NetworkIsolationKey(), false /* disable_secure_dns */);
+}
+
+class HttpStartupPreconnectorTest : public TestWithTaskEnvironment {
+ protected:
+  HttpStartupPreconnectorTest()
+      : data_(reads_, base::span<MockWrite>()), ssl_(ASYNC, OK) {
+    // Expect a single connection.
+    data_.set_connect_data(MockConnect(SYNCHRONOUS, OK));
+    session_deps_.socket_factory->AddSocketDataProvider(&data_);
+    ssl_.next_proto = kProtoHTTP2;
+    ssl_.ssl_info.cert =
+        ImportCertFromFile(GetTestCertsDirectory(), "spdy_pooling.pem");
+    session_deps_.socket_factory->AddSSLSocketDataProvider(&ssl_);
+  }
+
+  HttpServerProperties* http_server_properties() {
+    return session_deps_.http_server_properties.get();
+  }
+
+  const url::SchemeHostPort www_server_{"https", "www.example.org", 443};
+  const url::SchemeHostPort mail_server_{"https", "mail.example.org", 443};
+
+  MockRead reads_[1] = {MockRead(SYNCHRONOUS, ERR_IO_PENDING)};
+  StaticSocketDataProvider data_;
+  SSLSocketDataProvider ssl_;
+  SpdySessionDependencies session_deps_;
+};
+
+TEST_F(HttpStartupPreconnectorTest, PreconnectsMultiplexedServers) {
+  http_server_properties()->SetSupportsSpdy(www_server_, NetworkIsolationKey(),
+                                            true);
+  http_server_properties()->SetSupportsSpdy(mail_server_,
+                                            NetworkIsolationKey(), false);
+  std::unique_ptr<HttpNetworkSession> session =
+      SpdySessionDependencies::SpdyCreateSession(&session_deps_);
+
+  HttpStartupPreconnector preconnector(session.get(), 10);
+  preconnector.Start();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_TRUE(
+      HasSpdySession(session->spdy_session_pool(), KeyForServer(www_server_)));
+  EXPECT_FALSE(
+      HasSpdySession(session->spdy_session_pool(), KeyForServer(mail_server_)));
+}
+
+TEST_F(HttpStartupPreconnectorTest, PreconnectsMostRecentlyUsedServers) {
+  http_server_properties()->SetSupportsSpdy(www_server_, NetworkIsolationKey(),
+                                            true);
+  http_server_properties()->SetSupportsSpdy(mail_server_,
+                                            NetworkIsolationKey(), true);
+  std::unique_ptr<HttpNetworkSession> session =
+      SpdySessionDependencies::SpdyCreateSession(&session_deps_);
+
+  HttpStartupPreconnector preconnector(session.get(), 1);
+  preconnector.Start();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_TRUE(
+      HasSpdySession(session->spdy_session_pool(), KeyForServer(mail_server_)));
+  EXPECT_FALSE(
+      HasSpdySession(session->spdy_session_pool(), KeyForServer(www_server_)));
+}
+
+}  // namespace
+
+}  // namespace net
@@ -9,10 +9,12 @@
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/strings/string_util.h"
 #include "base/values.h"
+#include "net/base/features.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/upload_data_stream.h"
@@ -218,6 +220,7 @@ HttpStreamParser::HttpStreamParser(StreamSocket* stream_socket,
       connection_is_reused_(connection_is_reused),
       net_log_(net_log),
       sent_last_chunk_(false),
+      try_send_file_(base::FeatureList::IsEnabled(features::kUploadSendFile)),
       upload_error_(OK) {
   io_callback_ = base::BindRepeating(&HttpStreamParser::OnIOComplete,
                                      weak_ptr_factory_.GetWeakPtr());
@@ -429,6 +432,10 @@ int HttpStreamParser::DoLoop(int result) {
         result = DoSendBodyComplete(result);
         DCHECK_NE(STATE_NONE, io_state_);
         break;
+      case STATE_SEND_FILE_COMPLETE:
+        result = DoSendFileComplete(result);
+        DCHECK_NE(STATE_NONE, io_state_);
+        break;
       case STATE_SEND_REQUEST_READ_BODY_COMPLETE:
         result = DoSendRequestReadBodyComplete(result);
         DCHECK_NE(STATE_NONE, io_state_);
@@ -531,6 +538,24 @@ int HttpStreamParser::DoSendBody() {
     return OK;
   }
 
+  base::PlatformFile file;
+  uint64_t offset;
+  uint64_t length;
+  if (try_send_file_ &&
+      request_->upload_data_stream->GetNextFileRange(&file, &offset, &length)) {
+    io_state_ = STATE_SEND_FILE_COMPLETE;
+    int rv = stream_socket_->SendFile(
+        file, offset,
+        static_cast<int>(
+            std::min(length, static_cast<uint64_t>(kMaxSendFileSize))),
+        io_callback_, NetworkTrafficAnnotationTag(traffic_annotation_));
+    if (rv != ERR_NOT_IMPLEMENTED)
+      return rv;
+    // The socket can't send directly from files, so read the rest of the body
+    // into memory instead.
+    try_send_file_ = false;
+  }
+
   request_body_read_buf_->Clear();
   io_state_ = STATE_SEND_REQUEST_READ_BODY_COMPLETE;
   return request_->upload_data_stream->Read(
@@ -558,6 +583,34 @@ int HttpStreamParser::DoSendBodyComplete(int result) {
   return OK;
 }
 
+int HttpStreamParser::DoSendFileComplete(int result) {
+  if (result < 0) {
+    // If |result| is an error that this should try reading after, stash the
+    // error for now and act like the request was successfully sent.
+    io_state_ = STATE_SEND_REQUEST_COMPLETE;
+    if (ShouldTryReadingOnUploadError(result)) {
+      upload_error_ = result;
+      return OK;
+    }
+    return result;
+  }
+
+  // As with UploadFileElementReader, reaching the end of the file early means
+  // it changed after the upload was initialized.
+  if (result == 0) {
+    io_state_ = STATE_SEND_REQUEST_COMPLETE;
+    return ERR_UPLOAD_FILE_CHANGED;
+  }
+
+  sent_bytes_ += result;
+  request_->upload_data_stream->DidSendFileRange(result);
+
+  io_state_ = request_->upload_data_stream->IsEOF()
+                  ? STATE_SEND_REQUEST_COMPLETE
+                  : STATE_SEND_BODY;
+  return OK;
+}
+
 int HttpStreamParser::DoSendRequestReadBodyComplete(int result) {
   // |result| is the result of read from the request body from the last call to
   // DoSendBody().
@@ -135,6 +135,7 @@ class NET_EXPORT_PRIVATE HttpStreamParser {
     STATE_SEND_HEADERS_COMPLETE,
     STATE_SEND_BODY,
     STATE_SEND_BODY_COMPLETE,
+    STATE_SEND_FILE_COMPLETE,
     STATE_SEND_REQUEST_READ_BODY_COMPLETE,
     STATE_SEND_REQUEST_COMPLETE,
     STATE_READ_HEADERS,
@@ -168,6 +169,7 @@ class NET_EXPORT_PRIVATE HttpStreamParser {
   int DoSendHeadersComplete(int result);
   int DoSendBody();
   int DoSendBodyComplete(int result);
+  int DoSendFileComplete(int result);
   int DoSendRequestReadBodyComplete(int result);
   int DoSendRequestComplete(int result);
   int DoReadHeaders();
@@ -291,6 +293,10 @@ class NET_EXPORT_PRIVATE HttpStreamParser {
   scoped_refptr<SeekableIOBuffer> request_body_send_buf_;
   bool sent_last_chunk_;
 
+  // True if file-backed parts of the request body should be sent with
+  // StreamSocket::SendFile(). Cleared if |stream_socket_| doesn't support it.
+  bool try_send_file_;
+
   // Error received when uploading the body, if any.
   int upload_error_;
 
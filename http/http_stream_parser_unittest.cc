@@ -19,10 +19,12 @@
 #include "base/run_loop.h"
 #include "base/stl_util.h"
 #include "base/strings/string_piece.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/task_environment.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "net/base/chunked_upload_data_stream.h"
 #include "net/base/elements_upload_data_stream.h"
+#include "net/base/features.h"
 #include "net/base/io_buffer.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
@@ -599,6 +601,70 @@ TEST(HttpStreamParser, SentBytesPost) {
   EXPECT_EQ(12u, progress.position());
 }
 
+// With kUploadSendFile enabled, a file-backed body is still written normally to
+// a socket that can't send directly from files.
+TEST(HttpStreamParser, SendFileFallsBackToWrite) {
+  base::test::TaskEnvironment task_environment(
+      base::test::TaskEnvironment::MainThreadType::IO);
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kUploadSendFile);
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath temp_file_path;
+  ASSERT_TRUE(
+      base::CreateTemporaryFileInDir(temp_dir.GetPath(), &temp_file_path));
+  ASSERT_EQ(12, base::WriteFile(temp_file_path, "hello world!", 12));
+
+  MockWrite writes[] = {
+      MockWrite(SYNCHRONOUS, 0, "POST / HTTP/1.1\r\n"),
+      MockWrite(SYNCHRONOUS, 1, "Content-Length: 12\r\n\r\n"),
+      MockWrite(SYNCHRONOUS, 2, "hello world!"),
+  };
+
+  SequencedSocketData data(base::span<MockRead>(), writes);
+  std::unique_ptr<StreamSocket> stream_socket = CreateConnectedSocket(&data);
+
+  {
+    std::vector<std::unique_ptr<UploadElementReader>> element_readers;
+    element_readers.push_back(std::make_unique<UploadFileElementReader>(
+        base::ThreadTaskRunnerHandle::Get().get(), temp_file_path, 0, 12,
+        base::Time()));
+    ElementsUploadDataStream upload_data_stream(std::move(element_readers), 0);
+    TestCompletionCallback init_callback;
+    ASSERT_THAT(init_callback.GetResult(upload_data_stream.Init(
+                    init_callback.callback(), NetLogWithSource())),
+                IsOk());
+
+    HttpRequestInfo request;
+    request.method = "POST";
+    request.url = GURL("http://localhost");
+    request.upload_data_stream = &upload_data_stream;
+
+    scoped_refptr<GrowableIOBuffer> read_buffer =
+        base::MakeRefCounted<GrowableIOBuffer>();
+    HttpStreamParser parser(stream_socket.get(), false /* is_reused */,
+                            &request, read_buffer.get(), NetLogWithSource());
+
+    HttpRequestHeaders headers;
+    headers.SetHeader("Content-Length", "12");
+
+    HttpResponseInfo response;
+    TestCompletionCallback callback;
+    EXPECT_THAT(callback.GetResult(parser.SendRequest(
+                    "POST / HTTP/1.1\r\n", headers,
+                    TRAFFIC_ANNOTATION_FOR_TESTS, &response,
+                    callback.callback())),
+                IsOk());
+
+    EXPECT_EQ(CountWriteBytes(writes), parser.sent_bytes());
+    EXPECT_TRUE(upload_data_stream.IsEOF());
+  }
+
+  // UploadFileElementReaders may post clean-up tasks on destruction.
+  base::RunLoop().RunUntilIdle();
+}
+
 TEST(HttpStreamParser, SentBytesChunkedPostError) {
   base::test::TaskEnvironment task_environment;
 
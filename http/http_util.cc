@@ -8,6 +8,8 @@
 
 #include "net/http/http_util.h"
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/check_op.h"
@@ -28,6 +30,32 @@ namespace net {
 
 namespace {
 
+// Lookup table for HttpUtil::IsTokenChar(), indexed by the unsigned value of
+// the character. See RFC 7230 Sec 3.2.6.
+struct TokenCharTable {
+  constexpr TokenCharTable() : is_token() {
+    for (int c = 0x21; c < 0x7F; ++c)
+      is_token[c] = true;
+    const char* separators = "()<>@,;:\\\"/[]?={}";
+    for (size_t i = 0; separators[i]; ++i)
+      is_token[static_cast<uint8_t>(separators[i])] = false;
+  }
+
+  bool is_token[256];
+};
+
+constexpr TokenCharTable kTokenChars;
+
+// Returns a pointer to the first CR or LF in [begin, end), or |end| if there
+// is none.
+const char* FindLineBreak(const char* begin, const char* end) {
+  for (; begin < end; ++begin) {
+    if (*begin == '\n' || *begin == '\r')
+      break;
+  }
+  return begin;
+}
+
 template <typename ConstIterator>
 void TrimLWSImplementation(ConstIterator* begin, ConstIterator* end) {
   // leading whitespace
@@ -486,8 +514,8 @@ bool HttpUtil::IsNonCoalescingHeader(base::StringPiece name) {
 }
 
 bool HttpUtil::IsLWS(char c) {
-  const base::StringPiece kWhiteSpaceCharacters(HTTP_LWS);
-  return kWhiteSpaceCharacters.find(c) != base::StringPiece::npos;
+  // Must match HTTP_LWS.
+  return c == ' ' || c == '\t';
 }
 
 // static
@@ -505,10 +533,7 @@ base::StringPiece HttpUtil::TrimLWS(const base::StringPiece& string) {
 }
 
 bool HttpUtil::IsTokenChar(char c) {
-  return !(c >= 0x7F || c <= 0x20 || c == '(' || c == ')' || c == '<' ||
-           c == '>' || c == '@' || c == ',' || c == ';' || c == ':' ||
-           c == '\\' || c == '"' || c == '/' || c == '[' || c == ']' ||
-           c == '?' || c == '=' || c == '{' || c == '}');
+  return kTokenChars.is_token[static_cast<uint8_t>(c)];
 }
 
 // See RFC 7230 Sec 3.2.6 for the definition of |token|.
@@ -633,25 +658,37 @@ static size_t LocateEndOfHeadersHelper(const char* buf,
                                        size_t buf_len,
                                        size_t i,
                                        bool accept_empty_header_list) {
-  char last_c = '\0';
-  bool was_lf = false;
-  if (accept_empty_header_list) {
+  // The headers end at an LF followed by either another LF or a CRLF.
+  // Returns the offset just past that terminator if it starts at |lf|.
+  auto end_after_lf = [buf, buf_len](size_t lf) -> size_t {
+    size_t next = lf + 1;
+    if (next < buf_len && buf[next] == '\n')
+      return next + 1;
+    if (next + 1 < buf_len && buf[next] == '\r' && buf[next + 1] == '\n')
+      return next + 2;
+    return std::string::npos;
+  };
+
+  if (accept_empty_header_list && i < buf_len) {
     // Normally two line breaks signal the end of a header list. An empty header
     // list ends with a single line break at the start of the buffer.
-    last_c = '\n';
-    was_lf = true;
+    if (buf[i] == '\n')
+      return i + 1;
+    if (i + 1 < buf_len && buf[i] == '\r' && buf[i + 1] == '\n')
+      return i + 2;
   }
 
-  for (; i < buf_len; ++i) {
-    char c = buf[i];
-    if (c == '\n') {
-      if (was_lf)
-        return i + 1;
-      was_lf = true;
-    } else if (c != '\r' || last_c != '\n') {
-      was_lf = false;
-    }
-    last_c = c;
+  // Jump from one LF to the next with memchr() rather than examining every
+  // byte of the (typically long) header lines in between.
+  while (i < buf_len) {
+    const void* lf = memchr(buf + i, '\n', buf_len - i);
+    if (!lf)
+      break;
+    size_t lf_offset = static_cast<const char*>(lf) - buf;
+    size_t end = end_after_lf(lf_offset);
+    if (end != std::string::npos)
+      return end;
+    i = lf_offset + 1;
   }
   return std::string::npos;
 }
@@ -692,10 +729,7 @@ static bool IsLineSegmentContinuable(base::StringPiece line) {
 
 // Helper used by AssembleRawHeaders, to find the end of the status line.
 static size_t FindStatusLineEnd(base::StringPiece str) {
-  size_t i = str.find_first_of("\r\n");
-  if (i == base::StringPiece::npos)
-    return str.size();
-  return i;
+  return FindLineBreak(str.data(), str.data() + str.size()) - str.data();
 }
 
 // Helper used by AssembleRawHeaders, to skip past leading LWS.
@@ -728,14 +762,20 @@ std::string HttpUtil::AssembleRawHeaders(base::StringPiece input) {
   // line's field-value.
 
   // TODO(ericroman): is this too permissive? (delimits on [\r\n]+)
-  base::CStringTokenizer lines(input.data(), input.data() + input.size(),
-                               "\r\n");
+  const char* pos = input.data();
+  const char* const end = input.data() + input.size();
 
   // This variable is true when the previous line was continuable.
   bool prev_line_continuable = false;
 
-  while (lines.GetNext()) {
-    base::StringPiece line = lines.token_piece();
+  while (pos < end) {
+    const char* line_end = FindLineBreak(pos, end);
+    base::StringPiece line(pos, line_end - pos);
+    pos = line_end;
+    while (pos < end && (*pos == '\r' || *pos == '\n'))
+      ++pos;
+    if (line.empty())
+      continue;
 
     if (prev_line_continuable && IsLWS(line[0])) {
       // Join continuation; reduce the leading LWS to a single SP.
@@ -925,15 +965,20 @@ HttpUtil::HeadersIterator::HeadersIterator(
     std::string::const_iterator headers_begin,
     std::string::const_iterator headers_end,
     const std::string& line_delimiter)
-    : lines_(headers_begin, headers_end, line_delimiter) {
+    : headers_begin_(headers_begin),
+      headers_end_(headers_end),
+      line_delimiter_(line_delimiter),
+      line_begin_(headers_begin),
+      line_end_(headers_begin) {
+  DCHECK(!line_delimiter_.empty());
 }
 
 HttpUtil::HeadersIterator::~HeadersIterator() = default;
 
 bool HttpUtil::HeadersIterator::GetNext() {
-  while (lines_.GetNext()) {
-    name_begin_ = lines_.token_begin();
-    values_end_ = lines_.token_end();
+  while (NextLine()) {
+    name_begin_ = line_begin_;
+    values_end_ = line_end_;
 
     std::string::const_iterator colon(std::find(name_begin_, values_end_, ':'));
     if (colon == values_end_)
@@ -961,6 +1006,32 @@ bool HttpUtil::HeadersIterator::GetNext() {
   return false;
 }
 
+bool HttpUtil::HeadersIterator::NextLine() {
+  auto is_delimiter = [this](char c) {
+    return line_delimiter_.find(c) != std::string::npos;
+  };
+
+  line_begin_ = line_end_;
+  while (line_begin_ != headers_end_ && is_delimiter(*line_begin_))
+    ++line_begin_;
+  if (line_begin_ == headers_end_)
+    return false;
+
+  // Raw headers from HttpResponseHeaders use a single '\0' delimiter, so look
+  // for it with memchr() rather than checking one character at a time.
+  if (line_delimiter_.size() == 1) {
+    const char* begin = &*line_begin_;
+    const void* delimiter =
+        memchr(begin, line_delimiter_[0], headers_end_ - line_begin_);
+    line_end_ = headers_end_;
+    if (delimiter)
+      line_end_ = line_begin_ + (static_cast<const char*>(delimiter) - begin);
+  } else {
+    line_end_ = std::find_if(line_begin_, headers_end_, is_delimiter);
+  }
+  return true;
+}
+
 bool HttpUtil::HeadersIterator::AdvanceTo(const char* name) {
   DCHECK(name != nullptr);
   DCHECK_EQ(0, base::ToLowerASCII(name).compare(name))
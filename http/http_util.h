@@ -278,9 +278,7 @@ class NET_EXPORT HttpUtil {
     // current position will be at the end of the headers.
     bool AdvanceTo(const char* lowercase_name);
 
-    void Reset() {
-      lines_.Reset();
-    }
+    void Reset() { line_end_ = headers_begin_; }
 
     std::string::const_iterator name_begin() const {
       return name_begin_;
@@ -309,7 +307,15 @@ class NET_EXPORT HttpUtil {
     }
 
    private:
-    base::StringTokenizer lines_;
+    // Sets [|line_begin_|, |line_end_|) to the next non-empty line after the
+    // current one. Returns false if there are no more lines.
+    bool NextLine();
+
+    const std::string::const_iterator headers_begin_;
+    const std::string::const_iterator headers_end_;
+    const std::string line_delimiter_;
+    std::string::const_iterator line_begin_;
+    std::string::const_iterator line_end_;
     std::string::const_iterator name_begin_;
     std::string::const_iterator name_end_;
     std::string::const_iterator values_begin_;
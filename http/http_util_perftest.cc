@@ -0,0 +1,161 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_util.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/check_op.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/strcat.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/http/http_response_headers.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 20000;
+
+static constexpr char kMetricPrefixHeaderParsing[] = "HttpHeaderParsing.";
+static constexpr char kMetricParseTimeMs[] = "parse_time";
+
+perf_test::PerfResultReporter SetUpHeaderParsingReporter(
+    const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHeaderParsing, story);
+  reporter.RegisterImportantMetric(kMetricParseTimeMs, "ms");
+  return reporter;
+}
+
+// A small response, like those for images and other subresources.
+const char kSmallResponse[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Mon, 13 Jul 2020 20:12:03 GMT\r\n"
+    "Content-Type: image/png\r\n"
+    "Content-Length: 4728\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: public, max-age=31536000\r\n"
+    "ETag: \"5f0c4a0b-1278\"\r\n"
+    "Last-Modified: Mon, 13 Jul 2020 11:43:39 GMT\r\n"
+    "Accept-Ranges: bytes\r\n"
+    "\r\n";
+
+// Builds a document response with the large Set-Cookie and
+// Content-Security-Policy headers typical of big sites.
+std::string BuildLargeResponse() {
+  std::string response =
+      "HTTP/1.1 200 OK\r\n"
+      "Date: Mon, 13 Jul 2020 20:12:03 GMT\r\n"
+      "Content-Type: text/html; charset=utf-8\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "Connection: keep-alive\r\n"
+      "Cache-Control: private, no-cache, no-store, must-revalidate\r\n"
+      "Vary: Accept-Encoding, Cookie\r\n"
+      "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+      "X-Content-Type-Options: nosniff\r\n"
+      "X-Frame-Options: SAMEORIGIN\r\n";
+
+  response += "Content-Security-Policy: default-src 'self'";
+  for (int i = 0; i < 40; ++i) {
+    base::StrAppend(&response, {"; script-src https://cdn", std::to_string(i),
+                                ".example.com 'nonce-0123456789abcdef'"});
+  }
+  response += "\r\n";
+
+  for (int i = 0; i < 12; ++i) {
+    base::StrAppend(
+        &response,
+        {"Set-Cookie: cookie", std::to_string(i), "=",
+         std::string(200, 'a' + i),
+         "; Domain=.example.com; Path=/; Expires=Tue, 13 Jul 2021 20:12:03 "
+         "GMT; Secure; HttpOnly; SameSite=Lax\r\n"});
+  }
+  response += "\r\n";
+  return response;
+}
+
+class HttpHeaderParsingBenchmark : public ::testing::Test {
+ protected:
+  void RunLocateEndOfHeaders(const std::string& story,
+                             const std::string& response) {
+    auto reporter = SetUpHeaderParsingReporter(story);
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      CHECK_EQ(response.size(),
+               HttpUtil::LocateEndOfHeaders(response.data(), response.size()));
+    }
+    reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+  }
+
+  void RunParseHeaders(const std::string& story, const std::string& response) {
+    auto reporter = SetUpHeaderParsingReporter(story);
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      scoped_refptr<HttpResponseHeaders> headers =
+          HttpResponseHeaders::TryToCreate(response);
+      CHECK(headers);
+      CHECK_EQ(200, headers->response_code());
+    }
+    reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+  }
+
+  // Simulates headers arriving a few bytes at a time, as HttpStreamParser
+  // sees them on a slow connection.
+  void RunLocateEndOfHeadersIncrementally(const std::string& story,
+                                          const std::string& response) {
+    const size_t kReadSize = 64;
+    auto reporter = SetUpHeaderParsingReporter(story);
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      size_t end = std::string::npos;
+      for (size_t read = kReadSize; end == std::string::npos;
+           read += kReadSize) {
+        size_t available = std::min(read, response.size());
+        size_t search_start = available > kReadSize + 3
+                                  ? available - kReadSize - 3
+                                  : 0;
+        end = HttpUtil::LocateEndOfHeaders(response.data(), available,
+                                           search_start);
+      }
+      CHECK_EQ(response.size(), end);
+    }
+    reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+  }
+};
+
+TEST_F(HttpHeaderParsingBenchmark, LocateEndOfHeaders) {
+  RunLocateEndOfHeaders("locate_end_small", kSmallResponse);
+  RunLocateEndOfHeaders("locate_end_large", BuildLargeResponse());
+}
+
+TEST_F(HttpHeaderParsingBenchmark, LocateEndOfHeadersIncrementally) {
+  RunLocateEndOfHeadersIncrementally("locate_end_incremental_large",
+                                     BuildLargeResponse());
+}
+
+TEST_F(HttpHeaderParsingBenchmark, ParseResponseHeaders) {
+  RunParseHeaders("parse_small", kSmallResponse);
+  RunParseHeaders("parse_large", BuildLargeResponse());
+}
+
+TEST_F(HttpHeaderParsingBenchmark, HeadersIterator) {
+  const std::string response = BuildLargeResponse();
+  auto reporter = SetUpHeaderParsingReporter("headers_iterator_large");
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    HttpUtil::HeadersIterator it(response.begin(), response.end(), "\r\n");
+    int num_headers = 0;
+    while (it.GetNext())
+      ++num_headers;
+    CHECK_EQ(22, num_headers);
+  }
+  reporter.AddResult(kMetricParseTimeMs, timer.Elapsed().InMillisecondsF());
+}
+
+}  // namespace
+
+}  // namespace net
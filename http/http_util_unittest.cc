@@ -118,6 +118,25 @@ TEST(HttpUtilTest, HeadersIterator) {
   EXPECT_FALSE(it.GetNext());
 }
 
+TEST(HttpUtilTest, HeadersIterator_NullDelimiter) {
+  // The format used by HttpResponseHeaders, with empty lines in between.
+  const char kHeaders[] = "\0foo: 1\0\0bar: 2 \0\0";
+  std::string headers(kHeaders, sizeof(kHeaders) - 1);
+
+  HttpUtil::HeadersIterator it(headers.begin(), headers.end(),
+                               std::string(1, '\0'));
+
+  ASSERT_TRUE(it.GetNext());
+  EXPECT_EQ(std::string("foo"), it.name());
+  EXPECT_EQ(std::string("1"), it.values());
+
+  ASSERT_TRUE(it.GetNext());
+  EXPECT_EQ(std::string("bar"), it.name());
+  EXPECT_EQ(std::string("2"), it.values());
+
+  EXPECT_FALSE(it.GetNext());
+}
+
 TEST(HttpUtilTest, HeadersIterator_MalformedLine) {
   std::string headers = "foo: 1\n: 2\n3\nbar: 4";
 
@@ -337,6 +356,8 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
       {"foo\nbar\n\njunk", 9},
       {"foo\nbar\n\r\njunk", 10},
       {"foo\nbar\r\n\njunk", 10},
+      {"foo\n\rbar\n\n", 10},
+      {"foo\n\r\r\n\n", 8},
   };
   for (size_t i = 0; i < base::size(tests); ++i) {
     size_t input_len = strlen(tests[i].input);
@@ -345,6 +366,20 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
   }
 }
 
+// Tests resuming the search part way through the buffer, as HttpStreamParser
+// does when more data arrives.
+TEST(HttpUtilTest, LocateEndOfHeadersFromOffset) {
+  const char kInput[] = "foo\r\nbar\r\n\r\njunk";
+  const size_t kInputLen = strlen(kInput);
+  for (size_t i = 0; i <= 9; ++i)
+    EXPECT_EQ(12u, HttpUtil::LocateEndOfHeaders(kInput, kInputLen, i));
+  // Starting after the first line break of the terminator misses it.
+  EXPECT_EQ(std::string::npos,
+            HttpUtil::LocateEndOfHeaders(kInput, kInputLen, 10));
+  EXPECT_EQ(std::string::npos,
+            HttpUtil::LocateEndOfHeaders(kInput, kInputLen - 4, 11));
+}
+
 TEST(HttpUtilTest, LocateEndOfAdditionalHeaders) {
   struct {
     const char* const input;
@@ -1594,6 +1594,13 @@ EVENT_TYPE(HTTP2_SESSION_POOL_FOUND_EXISTING_SESSION)
 //   }
 EVENT_TYPE(HTTP2_SESSION_POOL_FOUND_EXISTING_SESSION_FROM_IP_POOL)
 
+// This event indicates the pool found a session for a request, but did not
+// use it for that request because a PING sent on it is overdue.
+//   {
+//     "source_dependency": <The session id>,
+//   }
+EVENT_TYPE(HTTP2_SESSION_POOL_SKIPPED_SESSION_WITH_OVERDUE_PING)
+
 // This event indicates the pool created a new session
 //   {
 //     "source_dependency": <The session id>,
@@ -1663,6 +1670,13 @@ EVENT_TYPE(HTTP2_STREAM_ERROR)
 //   }
 EVENT_TYPE(HTTP2_STREAM_SEND_PRIORITY)
 
+// An RFC 9218 PRIORITY_UPDATE frame is sent to the server.
+//   {
+//     "stream_id":      <The stream id>,
+//     "priority_field": <The stream's new priority field value>,
+//   }
+EVENT_TYPE(HTTP2_STREAM_SEND_PRIORITY_UPDATE)
+
 // ------------------------------------------------------------------------
 // SpdyProxyClientSocket
 // ------------------------------------------------------------------------
@@ -8,9 +8,11 @@
 
 #include "base/auto_reset.h"
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/strings/string_split.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "net/base/features.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
@@ -211,6 +213,12 @@ int QuicHttpStream::SendRequest(const HttpRequestHeaders& request_headers,
   // Store the serialized request headers.
   CreateSpdyHeadersFromHttpRequest(*request_info_, request_headers,
                                    &request_headers_);
+  // Later changes of priority are signalled with PRIORITY_UPDATE frames by
+  // the stream itself.
+  if (base::FeatureList::IsEnabled(features::kPriorityHeader)) {
+    AddPriorityHeader(priority_, request_info_->priority_incremental,
+                      &request_headers_);
+  }
 
   // Store the request body.
   request_body_stream_ = request_info_->upload_data_stream;
@@ -0,0 +1,671 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/http2_connection.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+#include "net/log/net_log_with_source.h"
+#include "net/server/http_connection.h"
+#include "net/server/http_server_response_info.h"
+
+namespace net {
+
+namespace {
+
+// Headers that are specific to an HTTP/1.1 connection and must not be sent
+// over HTTP/2. See https://tools.ietf.org/html/rfc7540#section-8.1.2.2.
+bool IsConnectionSpecificHeader(base::StringPiece name) {
+  return name == "connection" || name == "keep-alive" ||
+         name == "proxy-connection" || name == "transfer-encoding" ||
+         name == "upgrade";
+}
+
+}  // namespace
+
+// static
+base::StringPiece Http2Connection::GetConnectionPreface() {
+  return base::StringPiece(spdy::kHttp2ConnectionHeaderPrefix,
+                           spdy::kHttp2ConnectionHeaderPrefixSize);
+}
+
+Http2Connection::Stream::Stream(spdy::SpdyStreamId stream_id,
+                                spdy::SpdyPriority priority)
+    : stream_id(stream_id), priority(priority) {}
+
+Http2Connection::Stream::~Stream() = default;
+
+Http2Connection::Http2Connection(HttpConnection* connection,
+                                 IdGenerator id_generator)
+    : connection_(connection),
+      id_generator_(std::move(id_generator)),
+      buffered_spdy_framer_(kMaxHeaderListSize, NetLogWithSource()),
+      session_send_window_(spdy::kInitialSessionWindowSize),
+      initial_stream_send_window_(spdy::kInitialStreamWindowSize),
+      max_frame_size_(spdy::kHttp2DefaultFramePayloadLimit) {
+  buffered_spdy_framer_.set_visitor(this);
+}
+
+Http2Connection::~Http2Connection() = default;
+
+void Http2Connection::Start() {
+  spdy::SettingsMap settings;
+  settings[spdy::SETTINGS_MAX_CONCURRENT_STREAMS] = kMaxConcurrentStreams;
+  settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] = kStreamRecvWindowSize;
+  settings[spdy::SETTINGS_MAX_HEADER_LIST_SIZE] = kMaxHeaderListSize;
+  settings[spdy::SETTINGS_ENABLE_PUSH] = 0;
+  QueueControlFrame(buffered_spdy_framer_.CreateSettings(settings));
+  QueueControlFrame(buffered_spdy_framer_.CreateWindowUpdate(
+      spdy::kSessionFlowControlStreamId,
+      kSessionRecvWindowSize - spdy::kInitialSessionWindowSize));
+}
+
+bool Http2Connection::Read(std::vector<Request>* requests,
+                           std::vector<int>* reset_ids) {
+  HttpConnection::ReadIOBuffer* read_buf = connection_->read_buf();
+  if (!preface_received_) {
+    base::StringPiece preface = GetConnectionPreface();
+    size_t size = std::min(static_cast<size_t>(read_buf->GetSize()),
+                           preface.size());
+    if (base::StringPiece(read_buf->StartOfBuffer(), size) !=
+        preface.substr(0, size)) {
+      return false;
+    }
+    if (size < preface.size())
+      return true;
+    read_buf->DidConsume(preface.size());
+    preface_received_ = true;
+  }
+
+  if (read_buf->GetSize() > 0) {
+    size_t consumed = buffered_spdy_framer_.ProcessInput(
+        read_buf->StartOfBuffer(), read_buf->GetSize());
+    read_buf->DidConsume(consumed);
+  }
+
+  for (spdy::SpdyStreamId stream_id : completed_requests_) {
+    Stream* stream = FindStream(stream_id);
+    if (!stream)
+      continue;
+    stream->id = id_generator_.Run();
+    id_to_stream_id_[stream->id] = stream_id;
+    requests->push_back({stream->id, std::move(stream->request)});
+  }
+  completed_requests_.clear();
+  reset_ids->insert(reset_ids->end(), reset_ids_.begin(), reset_ids_.end());
+  reset_ids_.clear();
+
+  return WriteFrames() && !connection_error_;
+}
+
+bool Http2Connection::SendResponse(int id,
+                                   const HttpServerResponseInfo& response) {
+  Stream* stream = FindStreamById(id);
+  if (!stream || stream->response_started)
+    return true;
+  StartResponse(stream, response.status_code(), response.headers());
+  AppendResponseBody(stream, response.body());
+  return WriteFrames();
+}
+
+bool Http2Connection::SendRaw(int id, base::StringPiece data) {
+  Stream* stream = FindStreamById(id);
+  if (!stream)
+    return true;
+  if (stream->response_started) {
+    AppendResponseBody(stream, data);
+    return WriteFrames();
+  }
+
+  if (!CanBufferResponseData(data.size())) {
+    ResetStream(stream->stream_id, spdy::ERROR_CODE_INTERNAL_ERROR);
+    return WriteFrames();
+  }
+  stream->raw_response.append(data.data(), data.size());
+  buffered_response_bytes_ += data.size();
+  size_t end_of_headers = HttpUtil::LocateEndOfHeaders(
+      stream->raw_response.data(), stream->raw_response.size());
+  if (end_of_headers == std::string::npos)
+    return true;
+
+  auto headers = base::MakeRefCounted<HttpResponseHeaders>(
+      HttpUtil::AssembleRawHeaders(base::StringPiece(
+          stream->raw_response.data(), end_of_headers)));
+  std::vector<std::pair<std::string, std::string>> header_list;
+  size_t iter = 0;
+  std::string name;
+  std::string value;
+  while (headers->EnumerateHeaderLines(&iter, &name, &value))
+    header_list.emplace_back(name, value);
+  StartResponse(stream, headers->response_code(), header_list);
+
+  std::string raw_response = std::move(stream->raw_response);
+  stream->raw_response.clear();
+  buffered_response_bytes_ -= raw_response.size();
+  AppendResponseBody(stream,
+                     base::StringPiece(raw_response).substr(end_of_headers));
+  return WriteFrames();
+}
+
+bool Http2Connection::CloseStream(int id) {
+  Stream* stream = FindStreamById(id);
+  if (!stream)
+    return true;
+  if (stream->response_started && stream->response_remaining < 0) {
+    stream->end_pending = true;
+  } else {
+    QueueControlFrame(buffered_spdy_framer_.CreateRstStream(
+        stream->stream_id, spdy::ERROR_CODE_CANCEL));
+    EraseStream(stream->stream_id);
+  }
+  return WriteFrames();
+}
+
+bool Http2Connection::WriteFrames() {
+  HttpConnection::QueuedWriteIOBuffer* write_buf = connection_->write_buf();
+  while (write_buf->total_size() < kWriteBufferHighWaterMark) {
+    if (!control_frames_.empty()) {
+      if (!write_buf->Append(control_frames_.front()))
+        return false;
+      control_frames_.pop_front();
+      continue;
+    }
+
+    // No stream frames are written once the connection has failed, only the
+    // GOAWAY queued above.
+    if (connection_error_)
+      return true;
+
+    Stream* stream = GetNextWritableStream();
+    if (!stream)
+      return true;
+    if (!WriteStreamFrame(stream))
+      return false;
+  }
+  return true;
+}
+
+bool Http2Connection::HasStream(int id) const {
+  return id_to_stream_id_.find(id) != id_to_stream_id_.end();
+}
+
+std::vector<int> Http2Connection::TakeResetStreams() {
+  return std::move(reset_ids_);
+}
+
+std::vector<int> Http2Connection::TakeClosedStreams() {
+  return std::move(closed_ids_);
+}
+
+std::vector<int> Http2Connection::GetStreamIds() const {
+  std::vector<int> ids;
+  ids.reserve(id_to_stream_id_.size());
+  for (const auto& it : id_to_stream_id_)
+    ids.push_back(it.first);
+  return ids;
+}
+
+void Http2Connection::OnError(
+    http2::Http2DecoderAdapter::SpdyFramerError spdy_framer_error) {
+  CloseConnection(spdy::ERROR_CODE_PROTOCOL_ERROR,
+                  http2::Http2DecoderAdapter::SpdyFramerErrorToString(
+                      spdy_framer_error));
+}
+
+void Http2Connection::OnStreamError(spdy::SpdyStreamId stream_id,
+                                    const std::string& description) {
+  ResetStream(stream_id, spdy::ERROR_CODE_PROTOCOL_ERROR);
+}
+
+void Http2Connection::OnHeaders(spdy::SpdyStreamId stream_id,
+                                bool has_priority,
+                                int weight,
+                                spdy::SpdyStreamId parent_stream_id,
+                                bool exclusive,
+                                bool fin,
+                                spdy::SpdyHeaderBlock headers,
+                                base::TimeTicks recv_first_byte_time) {
+  if (Stream* stream = FindStream(stream_id)) {
+    // Trailers. Their fields are not passed on to the delegate.
+    if (!fin || stream->request_complete) {
+      ResetStream(stream_id, spdy::ERROR_CODE_PROTOCOL_ERROR);
+      return;
+    }
+    OnStreamEnd(stream_id);
+    return;
+  }
+
+  if (stream_id % 2 == 0) {
+    CloseConnection(spdy::ERROR_CODE_PROTOCOL_ERROR,
+                    "HEADERS on a server stream id.");
+    return;
+  }
+  if (stream_id <= last_stream_id_) {
+    // Most likely trailers for a stream that has already been reset.
+    QueueControlFrame(buffered_spdy_framer_.CreateRstStream(
+        stream_id, spdy::ERROR_CODE_STREAM_CLOSED));
+    return;
+  }
+  last_stream_id_ = stream_id;
+
+  if (streams_.size() >= kMaxConcurrentStreams) {
+    QueueControlFrame(buffered_spdy_framer_.CreateRstStream(
+        stream_id, spdy::ERROR_CODE_REFUSED_STREAM));
+    return;
+  }
+
+  auto stream = std::make_unique<Stream>(
+      stream_id, spdy::Http2WeightToSpdy3Priority(
+                     has_priority ? weight : spdy::kHttp2DefaultStreamWeight));
+  stream->send_window = initial_stream_send_window_;
+  HttpServerRequestInfo& request = stream->request;
+  for (const auto& it : headers) {
+    base::StringPiece name = base::StringViewToStringPiece(it.first);
+    base::StringPiece value = base::StringViewToStringPiece(it.second);
+    if (name == spdy::kHttp2MethodHeader) {
+      request.method = std::string(value);
+    } else if (name == spdy::kHttp2PathHeader) {
+      request.path = std::string(value);
+    } else if (name == spdy::kHttp2AuthorityHeader) {
+      request.headers["host"] = std::string(value);
+    } else if (!name.empty() && name[0] != ':') {
+      // SpdyHeaderBlock joins repeated fields with NUL, and cookie crumbs
+      // with "; ". Match the "," that HttpServer::ParseHeaders() uses.
+      std::string joined_value;
+      base::ReplaceChars(value, base::StringPiece("\0", 1), ",",
+                         &joined_value);
+      request.headers[std::string(name)] = std::move(joined_value);
+    }
+  }
+  if (request.method.empty() || request.path.empty()) {
+    QueueControlFrame(buffered_spdy_framer_.CreateRstStream(
+        stream_id, spdy::ERROR_CODE_PROTOCOL_ERROR));
+    return;
+  }
+
+  streams_[stream_id] = std::move(stream);
+  if (fin)
+    OnStreamEnd(stream_id);
+}
+
+void Http2Connection::OnDataFrameHeader(spdy::SpdyStreamId stream_id,
+                                        size_t length,
+                                        bool fin) {}
+
+void Http2Connection::OnStreamFrameData(spdy::SpdyStreamId stream_id,
+                                        const char* data,
+                                        size_t len) {
+  if (stream_id > last_stream_id_) {
+    CloseConnection(spdy::ERROR_CODE_PROTOCOL_ERROR,
+                    "DATA on an idle stream.");
+    return;
+  }
+  IncreaseRecvWindows(stream_id, len);
+
+  Stream* stream = FindStream(stream_id);
+  if (!stream || stream->request_complete)
+    return;
+  if (stream->request.data.size() + len > kMaxBodySize) {
+    ResetStream(stream_id, spdy::ERROR_CODE_CANCEL);
+    return;
+  }
+  stream->request.data.append(data, len);
+}
+
+void Http2Connection::OnStreamEnd(spdy::SpdyStreamId stream_id) {
+  Stream* stream = FindStream(stream_id);
+  if (!stream || stream->request_complete)
+    return;
+  stream->request_complete = true;
+  completed_requests_.push_back(stream_id);
+}
+
+void Http2Connection::OnStreamPadding(spdy::SpdyStreamId stream_id,
+                                      size_t len) {
+  IncreaseRecvWindows(stream_id, len);
+}
+
+void Http2Connection::OnSettings() {
+  QueueControlFrame(
+      std::make_unique<spdy::SpdySerializedFrame>(
+          buffered_spdy_framer_.SerializeFrame(spdy::SpdySettingsIR())));
+}
+
+void Http2Connection::OnSetting(spdy::SpdySettingsId id, uint32_t value) {
+  switch (id) {
+    case spdy::SETTINGS_HEADER_TABLE_SIZE:
+      buffered_spdy_framer_.UpdateHeaderEncoderTableSize(value);
+      break;
+    case spdy::SETTINGS_INITIAL_WINDOW_SIZE: {
+      if (value > static_cast<uint32_t>(std::numeric_limits<int32_t>::max())) {
+        CloseConnection(spdy::ERROR_CODE_FLOW_CONTROL_ERROR,
+                        "Invalid initial window size.");
+        return;
+      }
+      int32_t delta =
+          static_cast<int32_t>(value) - initial_stream_send_window_;
+      initial_stream_send_window_ = value;
+      for (auto& it : streams_)
+        it.second->send_window += delta;
+      break;
+    }
+    case spdy::SETTINGS_MAX_FRAME_SIZE:
+      // RFC 7540 section 6.5.2.
+      if (value < spdy::kHttp2DefaultFramePayloadLimit ||
+          value > spdy::kSpdyMaxFrameSizeLimit) {
+        CloseConnection(spdy::ERROR_CODE_PROTOCOL_ERROR,
+                        "Invalid max frame size.");
+        return;
+      }
+      max_frame_size_ = value;
+      break;
+    default:
+      break;
+  }
+}
+
+void Http2Connection::OnSettingsAck() {}
+
+void Http2Connection::OnSettingsEnd() {}
+
+void Http2Connection::OnPing(spdy::SpdyPingId unique_id, bool is_ack) {
+  if (!is_ack) {
+    QueueControlFrame(
+        buffered_spdy_framer_.CreatePingFrame(unique_id, /*is_ack=*/true));
+  }
+}
+
+void Http2Connection::OnRstStream(spdy::SpdyStreamId stream_id,
+                                  spdy::SpdyErrorCode error_code) {
+  Stream* stream = FindStream(stream_id);
+  if (!stream)
+    return;
+  if (stream->id)
+    reset_ids_.push_back(stream->id);
+  EraseStream(stream_id);
+}
+
+void Http2Connection::OnGoAway(spdy::SpdyStreamId last_accepted_stream_id,
+                               spdy::SpdyErrorCode error_code,
+                               base::StringPiece debug_data) {}
+
+void Http2Connection::OnWindowUpdate(spdy::SpdyStreamId stream_id,
+                                     int delta_window_size) {
+  int32_t* window = &session_send_window_;
+  if (stream_id != spdy::kSessionFlowControlStreamId) {
+    Stream* stream = FindStream(stream_id);
+    if (!stream)
+      return;
+    window = &stream->send_window;
+  }
+  if (delta_window_size < 1 ||
+      *window > std::numeric_limits<int32_t>::max() - delta_window_size) {
+    if (stream_id == spdy::kSessionFlowControlStreamId) {
+      CloseConnection(spdy::ERROR_CODE_FLOW_CONTROL_ERROR,
+                      "Invalid WINDOW_UPDATE.");
+    } else {
+      ResetStream(stream_id, spdy::ERROR_CODE_FLOW_CONTROL_ERROR);
+    }
+    return;
+  }
+  *window += delta_window_size;
+}
+
+void Http2Connection::OnPushPromise(spdy::SpdyStreamId stream_id,
+                                    spdy::SpdyStreamId promised_stream_id,
+                                    spdy::SpdyHeaderBlock headers) {
+  CloseConnection(spdy::ERROR_CODE_PROTOCOL_ERROR,
+                  "PUSH_PROMISE from a client.");
+}
+
+void Http2Connection::OnAltSvc(
+    spdy::SpdyStreamId stream_id,
+    base::StringPiece origin,
+    const spdy::SpdyAltSvcWireFormat::AlternativeServiceVector& altsvc_vector) {
+}
+
+bool Http2Connection::OnUnknownFrame(spdy::SpdyStreamId stream_id,
+                                     uint8_t frame_type) {
+  // Extension frames are ignored.
+  return true;
+}
+
+Http2Connection::Stream* Http2Connection::FindStream(
+    spdy::SpdyStreamId stream_id) {
+  auto it = streams_.find(stream_id);
+  return it == streams_.end() ? nullptr : it->second.get();
+}
+
+Http2Connection::Stream* Http2Connection::FindStreamById(int id) {
+  auto it = id_to_stream_id_.find(id);
+  return it == id_to_stream_id_.end() ? nullptr : FindStream(it->second);
+}
+
+void Http2Connection::StartResponse(
+    Stream* stream,
+    int status_code,
+    const std::vector<std::pair<std::string, std::string>>& headers) {
+  DCHECK(!stream->response_started);
+  stream->response_started = true;
+
+  spdy::SpdyHeaderBlock block;
+  block[spdy::kHttp2StatusHeader] = base::NumberToString(status_code);
+  for (const auto& header : headers) {
+    std::string name = base::ToLowerASCII(header.first);
+    if (IsConnectionSpecificHeader(name))
+      continue;
+    if (name == "content-length") {
+      int64_t content_length;
+      if (base::StringToInt64(header.second, &content_length) &&
+          content_length >= 0) {
+        stream->response_remaining = content_length;
+      }
+    }
+    block.AppendValueOrAddHeader(name, header.second);
+  }
+  stream->response_headers = std::move(block);
+  if (stream->response_remaining == 0)
+    stream->end_pending = true;
+}
+
+void Http2Connection::AppendResponseBody(Stream* stream,
+                                         base::StringPiece data) {
+  if (data.empty() || stream->end_pending)
+    return;
+  if (stream->response_remaining >= 0) {
+    // Bytes beyond the Content-Length would start a new response on an
+    // HTTP/1.1 connection; there is no equivalent on a stream.
+    if (static_cast<int64_t>(data.size()) > stream->response_remaining)
+      data = data.substr(0, stream->response_remaining);
+  }
+  // A client that does not open its flow control windows would otherwise
+  // have every response it asks for buffered in full.
+  if (!CanBufferResponseData(data.size())) {
+    ResetStream(stream->stream_id, spdy::ERROR_CODE_INTERNAL_ERROR);
+    return;
+  }
+  if (stream->response_remaining >= 0) {
+    stream->response_remaining -= data.size();
+    if (stream->response_remaining == 0)
+      stream->end_pending = true;
+  }
+  stream->response_body.append(data.data(), data.size());
+  buffered_response_bytes_ += data.size();
+}
+
+bool Http2Connection::CanBufferResponseData(size_t size) const {
+  return buffered_response_bytes_ + size <=
+         static_cast<size_t>(connection_->write_buf()->max_buffer_size());
+}
+
+bool Http2Connection::IsWritable(const Stream& stream) const {
+  if (stream.response_headers)
+    return true;
+  if (!stream.response_started)
+    return false;
+  if (stream.response_body_offset < stream.response_body.size())
+    return stream.send_window > 0 && session_send_window_ > 0;
+  return stream.end_pending;
+}
+
+Http2Connection::Stream* Http2Connection::GetNextWritableStream() {
+  Stream* next = nullptr;
+  for (auto& it : streams_) {
+    Stream* stream = it.second.get();
+    if (!stream->id || !IsWritable(*stream))
+      continue;
+    if (!next || stream->priority < next->priority ||
+        (stream->priority == next->priority &&
+         stream->last_write < next->last_write)) {
+      next = stream;
+    }
+  }
+  return next;
+}
+
+bool Http2Connection::WriteStreamFrame(Stream* stream) {
+  DCHECK(stream->id);
+  const spdy::SpdyStreamId stream_id = stream->stream_id;
+  stream->last_write = ++write_sequence_;
+  bool body_pending =
+      stream->response_body_offset < stream->response_body.size();
+  bool fin = false;
+
+  if (stream->response_headers) {
+    fin = stream->end_pending && !body_pending;
+    spdy::SpdyHeadersIR headers(stream_id,
+                                std::move(*stream->response_headers));
+    headers.set_fin(fin);
+    stream->response_headers.reset();
+    if (!AppendToWriteBuffer(buffered_spdy_framer_.SerializeFrame(headers)))
+      return false;
+  } else {
+    size_t len = 0;
+    if (body_pending) {
+      len = std::min<size_t>(
+          {stream->response_body.size() - stream->response_body_offset,
+           max_frame_size_, static_cast<size_t>(stream->send_window),
+           static_cast<size_t>(session_send_window_)});
+    }
+    fin = stream->end_pending &&
+          stream->response_body_offset + len == stream->response_body.size();
+    std::unique_ptr<spdy::SpdySerializedFrame> frame =
+        buffered_spdy_framer_.CreateDataFrame(
+            stream_id,
+            stream->response_body.data() + stream->response_body_offset, len,
+            fin ? spdy::DATA_FLAG_FIN : spdy::DATA_FLAG_NONE);
+    stream->response_body_offset += len;
+    buffered_response_bytes_ -= len;
+    stream->send_window -= len;
+    session_send_window_ -= len;
+    if (stream->response_body_offset == stream->response_body.size()) {
+      stream->response_body.clear();
+      stream->response_body_offset = 0;
+    }
+    if (!AppendToWriteBuffer(*frame))
+      return false;
+  }
+
+  if (fin) {
+    // The client may still be sending a request body it no longer needs.
+    // See https://tools.ietf.org/html/rfc7540#section-8.1.
+    if (!stream->request_complete) {
+      QueueControlFrame(buffered_spdy_framer_.CreateRstStream(
+          stream_id, spdy::ERROR_CODE_NO_ERROR));
+    }
+    closed_ids_.push_back(stream->id);
+    // |stream| is deleted here.
+    EraseStream(stream_id);
+  }
+  return true;
+}
+
+bool Http2Connection::AppendToWriteBuffer(
+    const spdy::SpdySerializedFrame& frame) {
+  return connection_->write_buf()->Append(
+      std::string(frame.data(), frame.size()));
+}
+
+void Http2Connection::QueueControlFrame(
+    std::unique_ptr<spdy::SpdySerializedFrame> frame) {
+  control_frames_.emplace_back(frame->data(), frame->size());
+}
+
+void Http2Connection::ResetStream(spdy::SpdyStreamId stream_id,
+                                  spdy::SpdyErrorCode error_code) {
+  Stream* stream = FindStream(stream_id);
+  if (stream && stream->id)
+    reset_ids_.push_back(stream->id);
+  QueueControlFrame(
+      buffered_spdy_framer_.CreateRstStream(stream_id, error_code));
+  EraseStream(stream_id);
+}
+
+void Http2Connection::CloseConnection(spdy::SpdyErrorCode error_code,
+                                      const std::string& description) {
+  if (connection_error_)
+    return;
+  DLOG(WARNING) << "HTTP/2 connection error: " << description;
+  connection_error_ = true;
+  spdy::SpdyGoAwayIR goaway(last_stream_id_, error_code, description);
+  QueueControlFrame(std::make_unique<spdy::SpdySerializedFrame>(
+      buffered_spdy_framer_.SerializeFrame(goaway)));
+}
+
+void Http2Connection::EraseStream(spdy::SpdyStreamId stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end())
+    return;
+  const Stream& stream = *it->second;
+  buffered_response_bytes_ -= stream.raw_response.size() +
+                              stream.response_body.size() -
+                              stream.response_body_offset;
+  if (stream.id)
+    id_to_stream_id_.erase(stream.id);
+  streams_.erase(it);
+}
+
+void Http2Connection::IncreaseRecvWindows(spdy::SpdyStreamId stream_id,
+                                          size_t len) {
+  session_recv_window_ -= len;
+  if (session_recv_window_ < 0) {
+    CloseConnection(spdy::ERROR_CODE_FLOW_CONTROL_ERROR,
+                    "Session receive window exceeded.");
+    return;
+  }
+  session_unacked_recv_bytes_ += len;
+  if (session_unacked_recv_bytes_ >= kSessionRecvWindowSize / 2) {
+    QueueControlFrame(buffered_spdy_framer_.CreateWindowUpdate(
+        spdy::kSessionFlowControlStreamId, session_unacked_recv_bytes_));
+    session_recv_window_ += session_unacked_recv_bytes_;
+    session_unacked_recv_bytes_ = 0;
+  }
+
+  Stream* stream = FindStream(stream_id);
+  if (!stream || stream->request_complete)
+    return;
+  stream->recv_window -= len;
+  if (stream->recv_window < 0) {
+    ResetStream(stream_id, spdy::ERROR_CODE_FLOW_CONTROL_ERROR);
+    return;
+  }
+  stream->unacked_recv_bytes += len;
+  if (stream->unacked_recv_bytes >= kStreamRecvWindowSize / 2) {
+    QueueControlFrame(buffered_spdy_framer_.CreateWindowUpdate(
+        stream_id, stream->unacked_recv_bytes));
+    stream->recv_window += stream->unacked_recv_bytes;
+    stream->unacked_recv_bytes = 0;
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,248 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SERVER_HTTP2_CONNECTION_H_
+#define NET_SERVER_HTTP2_CONNECTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/strings/string_piece.h"
+#include "net/server/http_server_request_info.h"
+#include "net/spdy/buffered_spdy_framer.h"
+#include "net/third_party/quiche/src/spdy/core/spdy_header_block.h"
+#include "net/third_party/quiche/src/spdy/core/spdy_protocol.h"
+
+namespace net {
+
+class HttpConnection;
+class HttpServerResponseInfo;
+
+// Serves HTTP/2 on an HttpConnection whose client either negotiated "h2" with
+// ALPN or sent the connection preface with prior knowledge. Every request
+// stream is given an id from the same space as HttpServer connection ids, so
+// the HttpServer::Delegate API works unchanged with one id per stream.
+//
+// Frames are appended to the connection's write buffer, no more than
+// kWriteBufferHighWaterMark at a time so that higher priority streams can
+// overtake a large response already being sent. HttpServer owns the socket
+// and calls WriteFrames() whenever the write buffer drains. Response data
+// that flow control holds back counts against the write buffer's
+// max_buffer_size(), as it would on an HTTP/1.1 connection; a stream whose
+// response would exceed it is reset.
+class Http2Connection final : public BufferedSpdyFramerVisitorInterface {
+ public:
+  // Returns a new, unused HttpServer connection id.
+  using IdGenerator = base::RepeatingCallback<int()>;
+
+  // A request whose headers and body have been fully received.
+  struct Request {
+    int id;
+    HttpServerRequestInfo info;
+  };
+
+  // The client connection preface, "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n".
+  static base::StringPiece GetConnectionPreface();
+
+  static const size_t kMaxConcurrentStreams = 100;
+  static const int32_t kSessionRecvWindowSize = 15 * 1024 * 1024;
+  static const int32_t kStreamRecvWindowSize = 6 * 1024 * 1024;
+  static const uint32_t kMaxHeaderListSize = 256 * 1024;
+  static const size_t kMaxBodySize = 100 << 20;
+  static const int kWriteBufferHighWaterMark = 64 * 1024;
+
+  Http2Connection(HttpConnection* connection, IdGenerator id_generator);
+  ~Http2Connection() override;
+
+  // Queues the server connection preface.
+  void Start();
+
+  // Consumes all of the connection's read buffer. Appends requests that have
+  // been fully received to |requests|, and the ids of requests the client
+  // reset before their response was complete to |reset_ids|. Returns false
+  // on a connection error, after queuing a GOAWAY.
+  bool Read(std::vector<Request>* requests, std::vector<int>* reset_ids);
+
+  // Sends the response headers and any body of |response| on stream |id|.
+  // The stream ends once as many body bytes as the Content-Length header
+  // declares have been sent.
+  bool SendResponse(int id, const HttpServerResponseInfo& response);
+
+  // Sends |data| on stream |id|. Until a response has been started, |data| is
+  // taken to be a serialized HTTP/1.1 response and its status line and
+  // headers are converted to a HEADERS frame.
+  bool SendRaw(int id, base::StringPiece data);
+
+  // Returns the ids of streams reset since the last call or Read() because
+  // the response data buffered for the connection grew too large.
+  std::vector<int> TakeResetStreams();
+
+  // Ends stream |id|. A response with no Content-Length ends with END_STREAM
+  // after its queued data has been sent; any other stream is reset.
+  bool CloseStream(int id);
+
+  // Moves frames to the connection's write buffer, highest priority stream
+  // first, as far as flow control and kWriteBufferHighWaterMark allow.
+  // Returns false if a frame does not fit in the write buffer.
+  bool WriteFrames();
+
+  bool HasStream(int id) const;
+
+  // Returns the ids of streams the server has finished since the last call.
+  std::vector<int> TakeClosedStreams();
+
+  // Ids of all streams whose request has been handed to the delegate.
+  std::vector<int> GetStreamIds() const;
+
+  // BufferedSpdyFramerVisitorInterface implementation.
+  void OnError(
+      http2::Http2DecoderAdapter::SpdyFramerError spdy_framer_error) override;
+  void OnStreamError(spdy::SpdyStreamId stream_id,
+                     const std::string& description) override;
+  void OnHeaders(spdy::SpdyStreamId stream_id,
+                 bool has_priority,
+                 int weight,
+                 spdy::SpdyStreamId parent_stream_id,
+                 bool exclusive,
+                 bool fin,
+                 spdy::SpdyHeaderBlock headers,
+                 base::TimeTicks recv_first_byte_time) override;
+  void OnDataFrameHeader(spdy::SpdyStreamId stream_id,
+                         size_t length,
+                         bool fin) override;
+  void OnStreamFrameData(spdy::SpdyStreamId stream_id,
+                         const char* data,
+                         size_t len) override;
+  void OnStreamEnd(spdy::SpdyStreamId stream_id) override;
+  void OnStreamPadding(spdy::SpdyStreamId stream_id, size_t len) override;
+  void OnSettings() override;
+  void OnSetting(spdy::SpdySettingsId id, uint32_t value) override;
+  void OnSettingsAck() override;
+  void OnSettingsEnd() override;
+  void OnPing(spdy::SpdyPingId unique_id, bool is_ack) override;
+  void OnRstStream(spdy::SpdyStreamId stream_id,
+                   spdy::SpdyErrorCode error_code) override;
+  void OnGoAway(spdy::SpdyStreamId last_accepted_stream_id,
+                spdy::SpdyErrorCode error_code,
+                base::StringPiece debug_data) override;
+  void OnWindowUpdate(spdy::SpdyStreamId stream_id,
+                      int delta_window_size) override;
+  void OnPushPromise(spdy::SpdyStreamId stream_id,
+                     spdy::SpdyStreamId promised_stream_id,
+                     spdy::SpdyHeaderBlock headers) override;
+  void OnAltSvc(spdy::SpdyStreamId stream_id,
+                base::StringPiece origin,
+                const spdy::SpdyAltSvcWireFormat::AlternativeServiceVector&
+                    altsvc_vector) override;
+  bool OnUnknownFrame(spdy::SpdyStreamId stream_id,
+                      uint8_t frame_type) override;
+
+ private:
+  struct Stream {
+    Stream(spdy::SpdyStreamId stream_id, spdy::SpdyPriority priority);
+    ~Stream();
+
+    const spdy::SpdyStreamId stream_id;
+    // HttpServer connection id, assigned once the request is complete.
+    int id = 0;
+    spdy::SpdyPriority priority;
+    // Sequence number of the last frame written, for round-robin between
+    // streams of the same priority.
+    uint64_t last_write = 0;
+
+    HttpServerRequestInfo request;
+    bool request_complete = false;
+    int32_t recv_window = kStreamRecvWindowSize;
+    int32_t unacked_recv_bytes = 0;
+
+    // SendRaw() data received before the end of the response headers.
+    std::string raw_response;
+    bool response_started = false;
+    // Response headers not yet written. HPACK-encoded only when written, as
+    // the encoder's dynamic table depends on the order of HEADERS frames.
+    base::Optional<spdy::SpdyHeaderBlock> response_headers;
+    std::string response_body;
+    size_t response_body_offset = 0;
+    // Body bytes still expected from the delegate, or -1 if the response had
+    // no Content-Length.
+    int64_t response_remaining = -1;
+    // Whether END_STREAM follows the buffered body.
+    bool end_pending = false;
+    int32_t send_window;
+  };
+
+  Stream* FindStream(spdy::SpdyStreamId stream_id);
+  Stream* FindStreamById(int id);
+
+  void StartResponse(Stream* stream,
+                     int status_code,
+                     const std::vector<std::pair<std::string, std::string>>&
+                         headers);
+  // Buffers |data| as part of |stream|'s response, or resets the stream if
+  // that would take the response data buffered for the connection beyond the
+  // write buffer's max_buffer_size().
+  void AppendResponseBody(Stream* stream, base::StringPiece data);
+  bool CanBufferResponseData(size_t size) const;
+
+  bool IsWritable(const Stream& stream) const;
+  Stream* GetNextWritableStream();
+  // Writes the next HEADERS or DATA frame of |stream|, and finishes the
+  // stream if that frame carries END_STREAM.
+  bool WriteStreamFrame(Stream* stream);
+  bool AppendToWriteBuffer(const spdy::SpdySerializedFrame& frame);
+
+  void QueueControlFrame(std::unique_ptr<spdy::SpdySerializedFrame> frame);
+  // Resets a stream because of an error in what the client sent. The
+  // delegate is told if it has been given the stream's request.
+  void ResetStream(spdy::SpdyStreamId stream_id,
+                   spdy::SpdyErrorCode error_code);
+  void CloseConnection(spdy::SpdyErrorCode error_code,
+                       const std::string& description);
+  void EraseStream(spdy::SpdyStreamId stream_id);
+  void IncreaseRecvWindows(spdy::SpdyStreamId stream_id, size_t len);
+
+  HttpConnection* const connection_;
+  const IdGenerator id_generator_;
+  BufferedSpdyFramer buffered_spdy_framer_;
+
+  bool preface_received_ = false;
+  bool connection_error_ = false;
+  spdy::SpdyStreamId last_stream_id_ = 0;
+
+  std::map<spdy::SpdyStreamId, std::unique_ptr<Stream>> streams_;
+  std::map<int, spdy::SpdyStreamId> id_to_stream_id_;
+  // Streams whose request ended during the current Read().
+  std::vector<spdy::SpdyStreamId> completed_requests_;
+  std::vector<int> reset_ids_;
+  std::vector<int> closed_ids_;
+
+  // SETTINGS, PING, WINDOW_UPDATE, RST_STREAM and GOAWAY frames, which are
+  // written ahead of any stream's frames.
+  base::circular_deque<std::string> control_frames_;
+  uint64_t write_sequence_ = 0;
+  // Size of every stream's |raw_response| and unwritten |response_body|.
+  size_t buffered_response_bytes_ = 0;
+
+  int32_t session_send_window_;
+  int32_t session_recv_window_ = kSessionRecvWindowSize;
+  int32_t session_unacked_recv_bytes_ = 0;
+  int32_t initial_stream_send_window_;
+  uint32_t max_frame_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(Http2Connection);
+};
+
+}  // namespace net
+
+#endif  // NET_SERVER_HTTP2_CONNECTION_H_
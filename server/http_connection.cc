@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "base/logging.h"
+#include "net/server/http2_connection.h"
 #include "net/server/web_socket.h"
 #include "net/socket/stream_socket.h"
 
@@ -164,4 +165,16 @@ void HttpConnection::SetWebSocket(std::unique_ptr<WebSocket> web_socket) {
   web_socket_ = std::move(web_socket);
 }
 
+void HttpConnection::SetHttp2Connection(
+    std::unique_ptr<Http2Connection> http2_connection) {
+  DCHECK(!web_socket_);
+  DCHECK(!http2_connection_);
+  http2_connection_ = std::move(http2_connection);
+}
+
+void HttpConnection::SetRequestBodyStream(
+    std::unique_ptr<RequestBodyStream> request_body_stream) {
+  request_body_stream_ = std::move(request_body_stream);
+}
+
 }  // namespace net
@@ -5,6 +5,8 @@
 #ifndef NET_SERVER_HTTP_CONNECTION_H_
 #define NET_SERVER_HTTP_CONNECTION_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <string>
 
@@ -12,9 +14,11 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/io_buffer.h"
+#include "net/http/http_chunked_decoder.h"
 
 namespace net {
 
+class Http2Connection;
 class StreamSocket;
 class WebSocket;
 
@@ -112,6 +116,14 @@ class HttpConnection {
     DISALLOW_COPY_AND_ASSIGN(QueuedWriteIOBuffer);
   };
 
+  // State of a request body that is passed to the delegate as it arrives.
+  struct RequestBodyStream {
+    // Bytes left of a body with a Content-Length.
+    int64_t remaining = 0;
+    // Set instead for a body with chunked transfer coding.
+    std::unique_ptr<HttpChunkedDecoder> chunked_decoder;
+  };
+
   HttpConnection(int id, std::unique_ptr<StreamSocket> socket);
   ~HttpConnection();
 
@@ -123,6 +135,26 @@ class HttpConnection {
   WebSocket* web_socket() const { return web_socket_.get(); }
   void SetWebSocket(std::unique_ptr<WebSocket> web_socket);
 
+  Http2Connection* http2_connection() const { return http2_connection_.get(); }
+  void SetHttp2Connection(std::unique_ptr<Http2Connection> http2_connection);
+
+  RequestBodyStream* request_body_stream() const {
+    return request_body_stream_.get();
+  }
+  void SetRequestBodyStream(
+      std::unique_ptr<RequestBodyStream> request_body_stream);
+
+  // Whether data should neither be read from the socket nor handled until
+  // reading is resumed.
+  bool read_paused() const { return read_paused_; }
+  void set_read_paused(bool read_paused) { read_paused_ = read_paused; }
+
+  // Whether a socket Read() into |read_buf_| has not completed yet.
+  bool read_in_progress() const { return read_in_progress_; }
+  void set_read_in_progress(bool read_in_progress) {
+    read_in_progress_ = read_in_progress;
+  }
+
  private:
   const int id_;
   const std::unique_ptr<StreamSocket> socket_;
@@ -130,6 +162,11 @@ class HttpConnection {
   const scoped_refptr<QueuedWriteIOBuffer> write_buf_;
 
   std::unique_ptr<WebSocket> web_socket_;
+  std::unique_ptr<Http2Connection> http2_connection_;
+  std::unique_ptr<RequestBodyStream> request_body_stream_;
+
+  bool read_paused_ = false;
+  bool read_in_progress_ = false;
 
   DISALLOW_COPY_AND_ASSIGN(HttpConnection);
 };
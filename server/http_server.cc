@@ -4,23 +4,33 @@
 
 #include "net/server/http_server.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/bind_helpers.h"
 #include "base/compiler_specific.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
 #include "base/sys_byteorder.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
+#include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
+#include "net/http/http_chunked_decoder.h"
+#include "net/server/http2_connection.h"
 #include "net/server/http_connection.h"
 #include "net/server/http_server_request_info.h"
 #include "net/server/http_server_response_info.h"
 #include "net/server/web_socket.h"
+#include "net/socket/next_proto.h"
 #include "net/socket/server_socket.h"
 #include "net/socket/stream_socket.h"
 #include "net/socket/tcp_server_socket.h"
@@ -50,12 +60,82 @@ constexpr NetworkTrafficAnnotationTag
           "Not implemented, not used if HTTP Server is not activated."
       })");
 
+constexpr NetworkTrafficAnnotationTag kHttpServerHttp2TrafficAnnotation =
+    DefineNetworkTrafficAnnotation("http_server_http2", R"(
+      semantics {
+        sender: "HTTP Server"
+        description:
+          "HTTP/2 connection management frames from the built-in HTTP "
+          "server, such as SETTINGS, WINDOW_UPDATE and PING acknowledgements."
+        trigger: "A client connecting to the HTTP server with HTTP/2."
+        data: "HTTP/2 connection state, no user data."
+        destination: OTHER
+        destination_other: "Any destination the consumer selects."
+      }
+      policy {
+        cookies_allowed: NO
+        setting:
+          "This request cannot be disabled in settings. However it will never "
+          "be made unless user activates an HTTP server."
+        policy_exception_justification:
+          "Not implemented, not used if HTTP Server is not activated."
+      })");
+
+// Most that is read from a ResponseBodyProducer at once, and how little data
+// must be waiting to be written before it is read from again.
+const int kResponseBodyReadSize = 16 * 1024;
+const int kResponseBodyLowWaterMark = 64 * 1024;
+
+const int64_t kMaxBufferedBodySize = 100 << 20;
+
+bool HasContentLength(const HttpServerResponseInfo& response) {
+  for (const auto& header : response.headers()) {
+    if (base::EqualsCaseInsensitiveASCII(header.first, "Content-Length"))
+      return true;
+  }
+  return false;
+}
+
 }  // namespace
 
+struct HttpServer::StreamingResponse {
+  StreamingResponse(std::unique_ptr<ResponseBodyProducer> producer,
+                    bool chunked,
+                    bool send_files_directly,
+                    NetworkTrafficAnnotationTag traffic_annotation)
+      : producer(std::move(producer)),
+        chunked(chunked),
+        traffic_annotation(traffic_annotation),
+        buffer(base::MakeRefCounted<IOBufferWithSize>(kResponseBodyReadSize)),
+        try_send_file(send_files_directly && !chunked) {}
+
+  const std::unique_ptr<ResponseBodyProducer> producer;
+  const bool chunked;
+  const NetworkTrafficAnnotationTag traffic_annotation;
+  const scoped_refptr<IOBufferWithSize> buffer;
+  bool read_in_progress = false;
+  // Cleared if the socket can't send the file with StreamSocket::SendFile().
+  bool try_send_file;
+  bool send_file_in_progress = false;
+};
+
+bool HttpServer::ResponseBodyProducer::GetNextFileRange(
+    base::PlatformFile* file,
+    int64_t* offset,
+    int64_t* length) {
+  return false;
+}
+
+void HttpServer::ResponseBodyProducer::DidSendFileRange(int64_t bytes) {
+  NOTREACHED();
+}
+
 HttpServer::HttpServer(std::unique_ptr<ServerSocket> server_socket,
-                       HttpServer::Delegate* delegate)
+                       HttpServer::Delegate* delegate,
+                       bool send_files_directly)
     : server_socket_(std::move(server_socket)),
       delegate_(delegate),
+      send_files_directly_(send_files_directly),
       last_id_(0) {
   DCHECK(server_socket_);
   // Start accepting connections in next run loop in case when delegate is not
@@ -89,12 +169,32 @@ void HttpServer::SendOverWebSocket(
   connection->web_socket()->Send(data, traffic_annotation);
 }
 
+void HttpServer::SendFragmentOverWebSocket(
+    int connection_id,
+    base::StringPiece data,
+    bool final,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection == nullptr)
+    return;
+  DCHECK(connection->web_socket());
+  connection->web_socket()->SendFragment(data, final, traffic_annotation);
+}
+
 void HttpServer::SendRaw(int connection_id,
                          const std::string& data,
                          NetworkTrafficAnnotationTag traffic_annotation) {
   HttpConnection* connection = FindConnection(connection_id);
-  if (connection == nullptr)
+  if (connection == nullptr) {
+    connection = FindHttp2StreamConnection(connection_id);
+    if (connection) {
+      bool writing_in_progress = !connection->write_buf()->IsEmpty();
+      bool ok = connection->http2_connection()->SendRaw(connection_id, data);
+      FlushHttp2AfterSend(connection, ok, writing_in_progress,
+                          traffic_annotation);
+    }
     return;
+  }
 
   bool writing_in_progress = !connection->write_buf()->IsEmpty();
   if (connection->write_buf()->Append(data) && !writing_in_progress)
@@ -104,6 +204,15 @@ void HttpServer::SendRaw(int connection_id,
 void HttpServer::SendResponse(int connection_id,
                               const HttpServerResponseInfo& response,
                               NetworkTrafficAnnotationTag traffic_annotation) {
+  HttpConnection* connection = FindHttp2StreamConnection(connection_id);
+  if (connection) {
+    bool writing_in_progress = !connection->write_buf()->IsEmpty();
+    bool ok =
+        connection->http2_connection()->SendResponse(connection_id, response);
+    FlushHttp2AfterSend(connection, ok, writing_in_progress,
+                        traffic_annotation);
+    return;
+  }
   SendRaw(connection_id, response.Serialize(), traffic_annotation);
 }
 
@@ -138,13 +247,69 @@ void HttpServer::Send500(int connection_id,
                traffic_annotation);
 }
 
+void HttpServer::SendStreamingResponse(
+    int connection_id,
+    const HttpServerResponseInfo& response,
+    std::unique_ptr<ResponseBodyProducer> producer,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  DCHECK(response.body().empty());
+  HttpConnection* connection = FindConnection(connection_id);
+  if (!connection || connection->http2_connection()) {
+    Close(connection_id);
+    return;
+  }
+  DCHECK(!connection->web_socket());
+  DCHECK_EQ(0u, streaming_responses_.count(connection_id));
+
+  bool chunked = !HasContentLength(response);
+  HttpServerResponseInfo head = response;
+  if (chunked)
+    head.AddHeader("Transfer-Encoding", "chunked");
+  bool writing_in_progress = !connection->write_buf()->IsEmpty();
+  if (!connection->write_buf()->Append(head.Serialize())) {
+    Close(connection_id);
+    return;
+  }
+  streaming_responses_[connection_id] = std::make_unique<StreamingResponse>(
+      std::move(producer), chunked, send_files_directly_, traffic_annotation);
+  ReadResponseBody(connection);
+  if (HasClosedConnection(connection))
+    return;
+  if (!writing_in_progress)
+    DoWriteLoop(connection, traffic_annotation);
+}
+
 void HttpServer::Close(int connection_id) {
   auto it = id_to_connection_.find(connection_id);
-  if (it == id_to_connection_.end())
+  if (it == id_to_connection_.end()) {
+    HttpConnection* connection = FindHttp2StreamConnection(connection_id);
+    if (!connection)
+      return;
+    http2_stream_to_connection_.erase(connection_id);
+    bool writing_in_progress = !connection->write_buf()->IsEmpty();
+    bool ok = connection->http2_connection()->CloseStream(connection_id);
+    FlushHttp2(connection, ok, writing_in_progress,
+               kHttpServerHttp2TrafficAnnotation);
+    delegate_->OnClose(connection_id);
     return;
+  }
 
   std::unique_ptr<HttpConnection> connection = std::move(it->second);
   id_to_connection_.erase(it);
+  // The socket may still be sending from the producer's file, so the producer
+  // is destroyed after the connection.
+  std::unique_ptr<StreamingResponse> streaming_response;
+  auto response_it = streaming_responses_.find(connection_id);
+  if (response_it != streaming_responses_.end()) {
+    streaming_response = std::move(response_it->second);
+    streaming_responses_.erase(response_it);
+  }
+  if (connection->http2_connection()) {
+    for (int stream_id : connection->http2_connection()->GetStreamIds()) {
+      if (http2_stream_to_connection_.erase(stream_id))
+        delegate_->OnClose(stream_id);
+    }
+  }
   delegate_->OnClose(connection_id);
 
   // The call stack might have callbacks which still have the pointer of
@@ -153,6 +318,28 @@ void HttpServer::Close(int connection_id) {
   // callbacks in the call stack return.
   base::ThreadTaskRunnerHandle::Get()->DeleteSoon(FROM_HERE,
                                                   connection.release());
+  if (streaming_response) {
+    base::ThreadTaskRunnerHandle::Get()->DeleteSoon(
+        FROM_HERE, streaming_response.release());
+  }
+}
+
+void HttpServer::PauseReading(int connection_id) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection)
+    connection->set_read_paused(true);
+}
+
+void HttpServer::ResumeReading(int connection_id) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (!connection || !connection->read_paused())
+    return;
+  connection->set_read_paused(false);
+  // Handles the data read before pausing in a new task, as this may be called
+  // from a delegate callback.
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, base::BindOnce(&HttpServer::OnReadResumed,
+                                weak_ptr_factory_.GetWeakPtr(), connection_id));
 }
 
 int HttpServer::GetLocalAddress(IPEndPoint* address) {
@@ -195,18 +382,28 @@ int HttpServer::HandleAcceptResult(int rv) {
   }
 
   std::unique_ptr<HttpConnection> connection_ptr =
-      std::make_unique<HttpConnection>(++last_id_, std::move(accepted_socket_));
+      std::make_unique<HttpConnection>(GetNextConnectionId(),
+                                       std::move(accepted_socket_));
   HttpConnection* connection = connection_ptr.get();
   id_to_connection_[connection->id()] = std::move(connection_ptr);
   delegate_->OnConnect(connection->id());
-  if (!HasClosedConnection(connection))
-    DoReadLoop(connection);
+  if (HasClosedConnection(connection))
+    return OK;
+  if (connection->socket()->GetNegotiatedProtocol() == kProtoHTTP2) {
+    StartHttp2(connection);
+    if (HasClosedConnection(connection))
+      return OK;
+  }
+  DoReadLoop(connection);
   return OK;
 }
 
 void HttpServer::DoReadLoop(HttpConnection* connection) {
   int rv;
   do {
+    if (connection->read_paused())
+      return;
+
     HttpConnection::ReadIOBuffer* read_buf = connection->read_buf();
     // Increases read buffer size if necessary.
     if (read_buf->RemainingCapacity() == 0 && !read_buf->IncreaseCapacity()) {
@@ -218,8 +415,10 @@ void HttpServer::DoReadLoop(HttpConnection* connection) {
         read_buf, read_buf->RemainingCapacity(),
         base::BindOnce(&HttpServer::OnReadCompleted,
                        weak_ptr_factory_.GetWeakPtr(), connection->id()));
-    if (rv == ERR_IO_PENDING)
+    if (rv == ERR_IO_PENDING) {
+      connection->set_read_in_progress(true);
       return;
+    }
     rv = HandleReadResult(connection, rv);
   } while (rv == OK);
 }
@@ -229,6 +428,7 @@ void HttpServer::OnReadCompleted(int connection_id, int rv) {
   if (!connection)  // It might be closed right before by write error.
     return;
 
+  connection->set_read_in_progress(false);
   if (HandleReadResult(connection, rv) == OK)
     DoReadLoop(connection);
 }
@@ -239,11 +439,31 @@ int HttpServer::HandleReadResult(HttpConnection* connection, int rv) {
     return rv == 0 ? ERR_CONNECTION_CLOSED : rv;
   }
 
-  HttpConnection::ReadIOBuffer* read_buf = connection->read_buf();
-  read_buf->DidRead(rv);
+  connection->read_buf()->DidRead(rv);
+  return HandleReadData(connection);
+}
+
+int HttpServer::HandleReadData(HttpConnection* connection) {
+  if (connection->read_paused())
+    return ERR_IO_PENDING;
+
+  if (connection->http2_connection())
+    return HandleHttp2ReadResult(connection);
 
   // Handles http requests or websocket messages.
+  HttpConnection::ReadIOBuffer* read_buf = connection->read_buf();
   while (read_buf->GetSize() > 0) {
+    // The rest of the data is handled once reading is resumed.
+    if (connection->read_paused())
+      return ERR_IO_PENDING;
+
+    if (connection->request_body_stream()) {
+      int rv = HandleRequestBodyData(connection);
+      if (rv != OK)
+        return rv;
+      continue;
+    }
+
     if (connection->web_socket()) {
       std::string message;
       WebSocket::ParseResult result = connection->web_socket()->Read(&message);
@@ -261,6 +481,21 @@ int HttpServer::HandleReadResult(HttpConnection* connection, int rv) {
       continue;
     }
 
+    if (http2_prior_knowledge_enabled_) {
+      base::StringPiece preface = Http2Connection::GetConnectionPreface();
+      size_t size =
+          std::min(static_cast<size_t>(read_buf->GetSize()), preface.size());
+      if (base::StringPiece(read_buf->StartOfBuffer(), size) ==
+          preface.substr(0, size)) {
+        if (size < preface.size())
+          break;  // Not enough data to tell yet.
+        StartHttp2(connection);
+        if (HasClosedConnection(connection))
+          return ERR_CONNECTION_CLOSED;
+        return HandleHttp2ReadResult(connection);
+      }
+    }
+
     HttpServerRequestInfo request;
     size_t pos = 0;
     if (!ParseHeaders(read_buf->StartOfBuffer(), read_buf->GetSize(),
@@ -288,23 +523,53 @@ int HttpServer::HandleReadResult(HttpConnection* connection, int rv) {
     }
 
     const char kContentLength[] = "content-length";
-    if (request.headers.count(kContentLength) > 0) {
-      size_t content_length = 0;
-      const size_t kMaxBodySize = 100 << 20;
-      if (!base::StringToSizeT(request.GetHeaderValue(kContentLength),
-                               &content_length) ||
-          content_length > kMaxBodySize) {
-        SendResponse(connection->id(),
-                     HttpServerResponseInfo::CreateFor500(
-                         "request content-length too big or unknown."),
-                     kHttpServerErrorResponseTrafficAnnotation);
-        Close(connection->id());
+    bool has_content_length = request.headers.count(kContentLength) > 0;
+    int64_t content_length = 0;
+    bool valid_content_length =
+        !has_content_length ||
+        (base::StringToInt64(request.GetHeaderValue(kContentLength),
+                             &content_length) &&
+         content_length >= 0);
+    bool chunked = request.HasHeaderValue("transfer-encoding", "chunked");
+
+    bool stream_body = false;
+    if (valid_content_length && (chunked || content_length > 0)) {
+      stream_body =
+          delegate_->ShouldStreamRequestBody(connection->id(), request);
+      if (HasClosedConnection(connection))
         return ERR_CONNECTION_CLOSED;
-      }
+    }
 
-      if (read_buf->GetSize() - pos < content_length)
+    // Only bodies that are buffered are limited in size.
+    if (!valid_content_length ||
+        (!stream_body && content_length > kMaxBufferedBodySize)) {
+      SendResponse(connection->id(),
+                   HttpServerResponseInfo::CreateFor500(
+                       "request content-length too big or unknown."),
+                   kHttpServerErrorResponseTrafficAnnotation);
+      Close(connection->id());
+      return ERR_CONNECTION_CLOSED;
+    }
+
+    if (stream_body) {
+      auto body_stream = std::make_unique<HttpConnection::RequestBodyStream>();
+      if (chunked)
+        body_stream->chunked_decoder = std::make_unique<HttpChunkedDecoder>();
+      else
+        body_stream->remaining = content_length;
+      connection->SetRequestBodyStream(std::move(body_stream));
+      read_buf->DidConsume(pos);
+      delegate_->OnHttpRequest(connection->id(), request);
+      if (HasClosedConnection(connection))
+        return ERR_CONNECTION_CLOSED;
+      continue;
+    }
+
+    if (content_length > 0) {
+      if (static_cast<int64_t>(read_buf->GetSize() - pos) < content_length)
         break;  // Not enough data was received yet.
-      request.data.assign(read_buf->StartOfBuffer() + pos, content_length);
+      request.data.assign(read_buf->StartOfBuffer() + pos,
+                          static_cast<size_t>(content_length));
       pos += content_length;
     }
 
@@ -317,6 +582,66 @@ int HttpServer::HandleReadResult(HttpConnection* connection, int rv) {
   return OK;
 }
 
+int HttpServer::HandleRequestBodyData(HttpConnection* connection) {
+  HttpConnection::ReadIOBuffer* read_buf = connection->read_buf();
+  HttpConnection::RequestBodyStream* body_stream =
+      connection->request_body_stream();
+  int size = read_buf->GetSize();
+  int body_size;
+  int consumed;
+  bool complete;
+  if (HttpChunkedDecoder* decoder = body_stream->chunked_decoder.get()) {
+    body_size = decoder->FilterBuf(read_buf->StartOfBuffer(), size);
+    if (body_size < 0) {
+      Close(connection->id());
+      return ERR_CONNECTION_CLOSED;
+    }
+    consumed = size;
+    complete = decoder->reached_eof();
+    if (complete) {
+      // The decoder leaves what follows the body right after the decoded
+      // data. Moves it to the end of the buffer, past the consumed bytes.
+      int bytes_after_eof = decoder->bytes_after_eof();
+      consumed -= bytes_after_eof;
+      memmove(read_buf->StartOfBuffer() + consumed,
+              read_buf->StartOfBuffer() + body_size, bytes_after_eof);
+    }
+  } else {
+    body_size = static_cast<int>(
+        std::min(static_cast<int64_t>(size), body_stream->remaining));
+    body_stream->remaining -= body_size;
+    consumed = body_size;
+    complete = body_stream->remaining == 0;
+  }
+
+  if (body_size > 0) {
+    delegate_->OnHttpRequestBodyData(
+        connection->id(),
+        base::StringPiece(read_buf->StartOfBuffer(), body_size));
+    if (HasClosedConnection(connection))
+      return ERR_CONNECTION_CLOSED;
+  }
+  read_buf->DidConsume(consumed);
+  if (complete) {
+    connection->SetRequestBodyStream(nullptr);
+    delegate_->OnHttpRequestBodyComplete(connection->id());
+    if (HasClosedConnection(connection))
+      return ERR_CONNECTION_CLOSED;
+  }
+  return OK;
+}
+
+void HttpServer::OnReadResumed(int connection_id) {
+  HttpConnection* connection = FindConnection(connection_id);
+  // A read in progress handles the data once it completes.
+  if (!connection || connection->read_paused() ||
+      connection->read_in_progress()) {
+    return;
+  }
+  if (HandleReadData(connection) == OK)
+    DoReadLoop(connection);
+}
+
 void HttpServer::DoWriteLoop(HttpConnection* connection,
                              NetworkTrafficAnnotationTag traffic_annotation) {
   int rv = OK;
@@ -353,9 +678,229 @@ int HttpServer::HandleWriteResult(HttpConnection* connection, int rv) {
   }
 
   connection->write_buf()->DidConsume(rv);
+  if (Http2Connection* http2_connection = connection->http2_connection()) {
+    bool ok = http2_connection->WriteFrames();
+    ForgetHttp2Streams(connection);
+    if (!ok) {
+      Close(connection->id());
+      return ERR_CONNECTION_CLOSED;
+    }
+  }
+  ReadResponseBody(connection);
+  if (HasClosedConnection(connection))
+    return ERR_CONNECTION_CLOSED;
   return OK;
 }
 
+void HttpServer::ReadResponseBody(HttpConnection* connection) {
+  while (connection->write_buf()->total_size() < kResponseBodyLowWaterMark) {
+    auto it = streaming_responses_.find(connection->id());
+    if (it == streaming_responses_.end() || it->second->read_in_progress ||
+        it->second->send_file_in_progress) {
+      return;
+    }
+    StreamingResponse* response = it->second.get();
+
+    base::PlatformFile file;
+    int64_t offset;
+    int64_t length;
+    if (response->try_send_file &&
+        response->producer->GetNextFileRange(&file, &offset, &length)) {
+      // The range is sent once the data queued before it has been written.
+      if (!connection->write_buf()->IsEmpty())
+        return;
+      int rv = connection->socket()->SendFile(
+          file, offset,
+          static_cast<int>(
+              std::min(length, static_cast<int64_t>(kMaxSendFileSize))),
+          base::BindOnce(&HttpServer::OnResponseFileSent,
+                         weak_ptr_factory_.GetWeakPtr(), connection->id()),
+          response->traffic_annotation);
+      if (rv == ERR_IO_PENDING) {
+        response->send_file_in_progress = true;
+        return;
+      }
+      if (HandleResponseFileSent(connection, rv) != OK)
+        return;
+      continue;
+    }
+
+    int rv = response->producer->Read(
+        response->buffer.get(), response->buffer->size(),
+        base::BindOnce(&HttpServer::OnResponseBodyReadCompleted,
+                       weak_ptr_factory_.GetWeakPtr(), connection->id()));
+    if (rv == ERR_IO_PENDING) {
+      response->read_in_progress = true;
+      return;
+    }
+    if (HandleResponseBodyReadResult(connection, rv) != OK)
+      return;
+  }
+}
+
+void HttpServer::OnResponseBodyReadCompleted(int connection_id, int rv) {
+  HttpConnection* connection = FindConnection(connection_id);
+  auto it = streaming_responses_.find(connection_id);
+  if (!connection || it == streaming_responses_.end())
+    return;
+
+  it->second->read_in_progress = false;
+  NetworkTrafficAnnotationTag traffic_annotation =
+      it->second->traffic_annotation;
+  bool writing_in_progress = !connection->write_buf()->IsEmpty();
+  if (HandleResponseBodyReadResult(connection, rv) != OK)
+    return;
+  ReadResponseBody(connection);
+  if (HasClosedConnection(connection))
+    return;
+  if (!writing_in_progress)
+    DoWriteLoop(connection, traffic_annotation);
+}
+
+int HttpServer::HandleResponseBodyReadResult(HttpConnection* connection,
+                                             int rv) {
+  auto it = streaming_responses_.find(connection->id());
+  DCHECK(it != streaming_responses_.end());
+  StreamingResponse* response = it->second.get();
+  if (rv < 0) {
+    // The client can only tell that the body is incomplete from the
+    // connection closing early.
+    Close(connection->id());
+    return rv;
+  }
+
+  std::string data;
+  if (rv == 0) {
+    if (response->chunked)
+      data = "0\r\n\r\n";
+    streaming_responses_.erase(it);
+  } else if (response->chunked) {
+    data = base::StringPrintf("%X\r\n", rv);
+    data.append(response->buffer->data(), rv);
+    data.append("\r\n");
+  } else {
+    data.assign(response->buffer->data(), rv);
+  }
+  if (!connection->write_buf()->Append(data)) {
+    Close(connection->id());
+    return ERR_CONNECTION_CLOSED;
+  }
+  return OK;
+}
+
+void HttpServer::OnResponseFileSent(int connection_id, int rv) {
+  HttpConnection* connection = FindConnection(connection_id);
+  auto it = streaming_responses_.find(connection_id);
+  if (!connection || it == streaming_responses_.end())
+    return;
+
+  it->second->send_file_in_progress = false;
+  NetworkTrafficAnnotationTag traffic_annotation =
+      it->second->traffic_annotation;
+  if (HandleResponseFileSent(connection, rv) != OK)
+    return;
+  ReadResponseBody(connection);
+  if (HasClosedConnection(connection))
+    return;
+  // Nothing else was written while the file was being sent.
+  if (!connection->write_buf()->IsEmpty())
+    DoWriteLoop(connection, traffic_annotation);
+}
+
+int HttpServer::HandleResponseFileSent(HttpConnection* connection, int rv) {
+  if (rv == ERR_NOT_IMPLEMENTED) {
+    // Nothing was sent, and the socket can't send this file, so the rest of
+    // the body is Read().
+    streaming_responses_[connection->id()]->try_send_file = false;
+    return OK;
+  }
+  if (rv <= 0) {
+    // Sending failed, or the file ended before the body did. The client can
+    // only tell from the connection closing early.
+    Close(connection->id());
+    return rv == 0 ? ERR_CONTENT_LENGTH_MISMATCH : rv;
+  }
+  streaming_responses_[connection->id()]->producer->DidSendFileRange(rv);
+  return OK;
+}
+
+void HttpServer::StartHttp2(HttpConnection* connection) {
+  connection->SetHttp2Connection(std::make_unique<Http2Connection>(
+      connection, base::BindRepeating(&HttpServer::GetNextConnectionId,
+                                      base::Unretained(this))));
+  bool writing_in_progress = !connection->write_buf()->IsEmpty();
+  connection->http2_connection()->Start();
+  FlushHttp2(connection, connection->http2_connection()->WriteFrames(),
+             writing_in_progress, kHttpServerHttp2TrafficAnnotation);
+}
+
+int HttpServer::HandleHttp2ReadResult(HttpConnection* connection) {
+  std::vector<Http2Connection::Request> requests;
+  std::vector<int> reset_ids;
+  bool writing_in_progress = !connection->write_buf()->IsEmpty();
+  bool ok = connection->http2_connection()->Read(&requests, &reset_ids);
+  for (int id : reset_ids)
+    http2_stream_to_connection_.erase(id);
+  FlushHttp2(connection, ok, writing_in_progress,
+             kHttpServerHttp2TrafficAnnotation);
+  if (HasClosedConnection(connection))
+    return ERR_CONNECTION_CLOSED;
+
+  for (int id : reset_ids) {
+    delegate_->OnClose(id);
+    if (HasClosedConnection(connection))
+      return ERR_CONNECTION_CLOSED;
+  }
+
+  for (Http2Connection::Request& request : requests) {
+    http2_stream_to_connection_[request.id] = connection->id();
+    connection->socket()->GetPeerAddress(&request.info.peer);
+    delegate_->OnHttpRequest(request.id, request.info);
+    if (HasClosedConnection(connection))
+      return ERR_CONNECTION_CLOSED;
+  }
+  return OK;
+}
+
+void HttpServer::FlushHttp2(HttpConnection* connection,
+                            bool ok,
+                            bool writing_in_progress,
+                            NetworkTrafficAnnotationTag traffic_annotation) {
+  ForgetHttp2Streams(connection);
+  if (!ok) {
+    // Make one attempt to send the GOAWAY queued for a connection error. The
+    // connection is closed whether or not it completes.
+    HttpConnection::QueuedWriteIOBuffer* write_buf = connection->write_buf();
+    if (!writing_in_progress && write_buf->GetSizeToWrite() > 0) {
+      connection->socket()->Write(write_buf, write_buf->GetSizeToWrite(),
+                                  base::DoNothing(), traffic_annotation);
+    }
+    Close(connection->id());
+    return;
+  }
+  if (!writing_in_progress && !connection->write_buf()->IsEmpty())
+    DoWriteLoop(connection, traffic_annotation);
+}
+
+void HttpServer::ForgetHttp2Streams(HttpConnection* connection) {
+  for (int id : connection->http2_connection()->TakeClosedStreams())
+    http2_stream_to_connection_.erase(id);
+}
+
+void HttpServer::FlushHttp2AfterSend(
+    HttpConnection* connection,
+    bool ok,
+    bool writing_in_progress,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  std::vector<int> reset_ids =
+      connection->http2_connection()->TakeResetStreams();
+  for (int id : reset_ids)
+    http2_stream_to_connection_.erase(id);
+  FlushHttp2(connection, ok, writing_in_progress, traffic_annotation);
+  for (int id : reset_ids)
+    delegate_->OnClose(id);
+}
+
 namespace {
 
 //
@@ -484,9 +1029,18 @@ bool HttpServer::ParseHeaders(const char* data,
         case ST_URL:
         case ST_PROTO:
         case ST_VALUE:
-        case ST_NAME:
-          buffer.append(&ch, 1);
+        case ST_NAME: {
+          // Append the whole run of characters that stay in this state at
+          // once, rather than one character at a time.
+          size_t run_end = pos;
+          while (run_end < data_len &&
+                 parser_state[state][charToInput(data[run_end])] == state) {
+            ++run_end;
+          }
+          buffer.append(data + pos - 1, run_end - pos + 1);
+          pos = run_end;
           break;
+        }
         case ST_DONE:
           // We got CR to get this far, also need the LF
           return (input == INPUT_LF);
@@ -508,6 +1062,20 @@ HttpConnection* HttpServer::FindConnection(int connection_id) {
   return it->second.get();
 }
 
+HttpConnection* HttpServer::FindHttp2StreamConnection(int stream_id) {
+  auto it = http2_stream_to_connection_.find(stream_id);
+  if (it == http2_stream_to_connection_.end())
+    return nullptr;
+  HttpConnection* connection = FindConnection(it->second);
+  if (!connection || !connection->http2_connection()->HasStream(stream_id))
+    return nullptr;
+  return connection;
+}
+
+int HttpServer::GetNextConnectionId() {
+  return ++last_id_;
+}
+
 // This is called after any delegate callbacks are called to check if Close()
 // has been called during callback processing. Using the pointer of connection,
 // |connection| is safe here because Close() deletes the connection in next run
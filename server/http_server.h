@@ -12,15 +12,18 @@
 #include <memory>
 #include <string>
 
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/strings/string_piece.h"
+#include "net/base/completion_once_callback.h"
 #include "net/http/http_status_code.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 
 namespace net {
 
 class HttpConnection;
+class IOBuffer;
 class HttpServerRequestInfo;
 class HttpServerResponseInfo;
 class IPEndPoint;
@@ -31,6 +34,13 @@ class HttpServer {
  public:
   // Delegate to handle http/websocket events. Beware that it is not safe to
   // destroy the HttpServer in any of these callbacks.
+  //
+  // On an HTTP/2 connection, OnConnect() and OnClose() are called for the
+  // connection, and every request stream is passed to OnHttpRequest() with a
+  // connection id of its own, which is then used to send the response.
+  // OnClose() is called for a stream if the client resets it, if the
+  // connection closes, or if Close() is called with its id, before the
+  // response has been sent. It's not called once the response is complete.
   class Delegate {
    public:
     virtual ~Delegate() {}
@@ -42,14 +52,64 @@ class HttpServer {
                                     const HttpServerRequestInfo& info) = 0;
     virtual void OnWebSocketMessage(int connection_id, std::string data) = 0;
     virtual void OnClose(int connection_id) = 0;
+
+    // Returns whether the body of the request |info| is passed to
+    // OnHttpRequestBodyData() as it arrives, after OnHttpRequest(), instead of
+    // being buffered into |info.data|. Streamed bodies are not limited in
+    // size, may use chunked transfer coding, and are read no faster than
+    // PauseReading() allows. Only asked about HTTP/1.1 requests that have a
+    // body. It must not call into the server, and may be asked again about the
+    // same request while a buffered body is arriving.
+    virtual bool ShouldStreamRequestBody(int connection_id,
+                                         const HttpServerRequestInfo& info) {
+      return false;
+    }
+    // Called with each piece of a streamed request body, and then once the
+    // whole body has been received.
+    virtual void OnHttpRequestBodyData(int connection_id,
+                                       base::StringPiece data) {}
+    virtual void OnHttpRequestBodyComplete(int connection_id) {}
+  };
+
+  // Supplies the body of a response sent with SendStreamingResponse().
+  class ResponseBodyProducer {
+   public:
+    virtual ~ResponseBodyProducer() {}
+
+    // Reads up to |buf_len| bytes of the body into |buf|. Returns the number
+    // of bytes read, 0 at the end of the body, or a network error. If it
+    // returns ERR_IO_PENDING, |callback| is run with the result instead.
+    virtual int Read(IOBuffer* buf,
+                     int buf_len,
+                     CompletionOnceCallback callback) = 0;
+
+    // Lets the next |*length| bytes of the body be sent straight from |*file|,
+    // starting at |*offset|, with StreamSocket::SendFile() instead of being
+    // Read(). Returns false if the body doesn't continue with a file range.
+    // The server reports how much it sent with DidSendFileRange(), or falls
+    // back to Read() if the socket can't send the file. Only used by servers
+    // created with |send_files_directly|, for bodies that are not sent with
+    // chunked transfer coding.
+    virtual bool GetNextFileRange(base::PlatformFile* file,
+                                  int64_t* offset,
+                                  int64_t* length);
+    virtual void DidSendFileRange(int64_t bytes);
   };
 
   // Instantiates a http server with |server_socket| which already started
   // listening, but not accepting.  This constructor schedules accepting
   // connections asynchronously in case when |delegate| is not ready to get
   // callbacks yet.
+  //
+  // If |send_files_directly| is true, the file ranges offered by
+  // ResponseBodyProducers are sent with StreamSocket::SendFile(). That saves
+  // copying the files through memory, but sendfile(2) reads them on the
+  // server's thread, which blocks on disk I/O for anything not already in the
+  // page cache, and unlike writes it can't suppress SIGPIPE. Only set it for
+  // servers whose thread may block, in processes that ignore SIGPIPE.
   HttpServer(std::unique_ptr<ServerSocket> server_socket,
-             HttpServer::Delegate* delegate);
+             HttpServer::Delegate* delegate,
+             bool send_files_directly = false);
   ~HttpServer();
 
   void AcceptWebSocket(int connection_id,
@@ -58,6 +118,14 @@ class HttpServer {
   void SendOverWebSocket(int connection_id,
                          base::StringPiece data,
                          NetworkTrafficAnnotationTag traffic_annotation);
+  // Sends |data| as one fragment of a message that is streamed over the
+  // WebSocket in several frames; the fragment with |final| set ends it. Other
+  // messages must not be sent on the connection until then.
+  void SendFragmentOverWebSocket(
+      int connection_id,
+      base::StringPiece data,
+      bool final,
+      NetworkTrafficAnnotationTag traffic_annotation);
   // Sends the provided data directly to the given connection. No validation is
   // performed that data constitutes a valid HTTP response. A valid HTTP
   // response may be split across multiple calls to SendRaw.
@@ -83,17 +151,45 @@ class HttpServer {
                const std::string& message,
                NetworkTrafficAnnotationTag traffic_annotation);
 
+  // Sends |response|, which must not have a body of its own, followed by a
+  // body read from |producer|. Unless |response| has a Content-Length, the body
+  // is sent with chunked transfer coding. The producer is only read from while
+  // little data is waiting to be written, so that a slow client holds up the
+  // producer instead of the body piling up in memory. Nothing else may be sent
+  // on the connection until the body has been. Only HTTP/1.1 connections
+  // support this; an HTTP/2 stream is closed instead.
+  void SendStreamingResponse(int connection_id,
+                             const HttpServerResponseInfo& response,
+                             std::unique_ptr<ResponseBodyProducer> producer,
+                             NetworkTrafficAnnotationTag traffic_annotation);
+
   void Close(int connection_id);
 
+  // Stops reading from, and handling requests on, the connection until
+  // ResumeReading() is called, e.g. while a streamed request body is written
+  // somewhere slower than it arrives. |connection_id| must be a connection's,
+  // not an HTTP/2 stream's.
+  void PauseReading(int connection_id);
+  void ResumeReading(int connection_id);
+
   void SetReceiveBufferSize(int connection_id, int32_t size);
   void SetSendBufferSize(int connection_id, int32_t size);
 
   // Copies the local address to |address|. Returns a network error code.
   int GetLocalAddress(IPEndPoint* address);
 
+  // Whether connections that start with the HTTP/2 connection preface are
+  // served as HTTP/2 ("prior knowledge"). Connections whose socket negotiated
+  // "h2" with ALPN always are.
+  void set_http2_prior_knowledge_enabled(bool enabled) {
+    http2_prior_knowledge_enabled_ = enabled;
+  }
+
  private:
   friend class HttpServerTest;
 
+  struct StreamingResponse;
+
   void DoAcceptLoop();
   void OnAcceptCompleted(int rv);
   int HandleAcceptResult(int rv);
@@ -101,6 +197,12 @@ class HttpServer {
   void DoReadLoop(HttpConnection* connection);
   void OnReadCompleted(int connection_id, int rv);
   int HandleReadResult(HttpConnection* connection, int rv);
+  // Handles the data in |connection|'s read buffer. Returns OK if more should
+  // be read, ERR_IO_PENDING if reading is paused, or an error if the
+  // connection was closed.
+  int HandleReadData(HttpConnection* connection);
+  int HandleRequestBodyData(HttpConnection* connection);
+  void OnReadResumed(int connection_id);
 
   void DoWriteLoop(HttpConnection* connection,
                    NetworkTrafficAnnotationTag traffic_annotation);
@@ -109,6 +211,32 @@ class HttpServer {
                         int rv);
   int HandleWriteResult(HttpConnection* connection, int rv);
 
+  // Queues data read from the producer of |connection|'s streaming response
+  // while little data is waiting to be written. Does not start writing.
+  void ReadResponseBody(HttpConnection* connection);
+  void OnResponseBodyReadCompleted(int connection_id, int rv);
+  int HandleResponseBodyReadResult(HttpConnection* connection, int rv);
+  void OnResponseFileSent(int connection_id, int rv);
+  int HandleResponseFileSent(HttpConnection* connection, int rv);
+
+  void StartHttp2(HttpConnection* connection);
+  int HandleHttp2ReadResult(HttpConnection* connection);
+  // Starts writing frames that |connection|'s Http2Connection has queued,
+  // unless a write was already in progress, and forgets streams it has
+  // finished. Closes the connection if |ok| is false.
+  void FlushHttp2(HttpConnection* connection,
+                  bool ok,
+                  bool writing_in_progress,
+                  NetworkTrafficAnnotationTag traffic_annotation);
+  void ForgetHttp2Streams(HttpConnection* connection);
+  // Like FlushHttp2(), after the delegate sent response data on a stream of
+  // |connection|. Tells the delegate about streams that were reset because
+  // too much response data was buffered.
+  void FlushHttp2AfterSend(HttpConnection* connection,
+                           bool ok,
+                           bool writing_in_progress,
+                           NetworkTrafficAnnotationTag traffic_annotation);
+
   // Expects the raw data to be stored in recv_data_. If parsing is successful,
   // will remove the data parsed from recv_data_, leaving only the unused
   // recv data. If all data has been consumed successfully, but the headers are
@@ -120,6 +248,10 @@ class HttpServer {
                     size_t* pos);
 
   HttpConnection* FindConnection(int connection_id);
+  // Returns the HTTP/2 connection carrying the stream with id |stream_id|.
+  HttpConnection* FindHttp2StreamConnection(int stream_id);
+
+  int GetNextConnectionId();
 
   // Whether or not Close() has been called during delegate callback processing.
   bool HasClosedConnection(HttpConnection* connection);
@@ -127,9 +259,16 @@ class HttpServer {
   const std::unique_ptr<ServerSocket> server_socket_;
   std::unique_ptr<StreamSocket> accepted_socket_;
   HttpServer::Delegate* const delegate_;
+  const bool send_files_directly_;
 
   int last_id_;
   std::map<int, std::unique_ptr<HttpConnection>> id_to_connection_;
+  // Ids of HTTP/2 streams, mapped to the id of their connection.
+  std::map<int, int> http2_stream_to_connection_;
+  // Responses whose body is being streamed, by connection id.
+  std::map<int, std::unique_ptr<StreamingResponse>> streaming_responses_;
+
+  bool http2_prior_knowledge_enabled_ = false;
 
   base::WeakPtrFactory<HttpServer> weak_ptr_factory_{this};
 
@@ -69,6 +69,10 @@ HttpStatusCode HttpServerResponseInfo::status_code() const {
   return status_code_;
 }
 
+const base::StringPairs& HttpServerResponseInfo::headers() const {
+  return headers_;
+}
+
 const std::string& HttpServerResponseInfo::body() const {
   return body_;
 }
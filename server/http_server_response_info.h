@@ -37,6 +37,7 @@ class HttpServerResponseInfo {
   std::string Serialize() const;
 
   HttpStatusCode status_code() const;
+  const base::StringPairs& headers() const;
   const std::string& body() const;
 
  private:
@@ -0,0 +1,148 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/http_server_test_util.h"
+
+#include <stdint.h>
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+#include "net/log/net_log_source.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kReadBufferSize = 2048;
+
+}  // namespace
+
+TestHttpClient::TestHttpClient() = default;
+
+TestHttpClient::~TestHttpClient() = default;
+
+int TestHttpClient::ConnectAndWait(const IPEndPoint& address) {
+  AddressList addresses(address);
+  NetLogSource source;
+  socket_.reset(
+      new TCPClientSocket(addresses, nullptr, nullptr, nullptr, source));
+
+  TestCompletionCallback callback;
+  int rv = socket_->Connect(callback.callback());
+  return callback.GetResult(rv);
+}
+
+void TestHttpClient::Send(const std::string& data) {
+  write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(
+      base::MakeRefCounted<StringIOBuffer>(data), data.length());
+  Write();
+}
+
+bool TestHttpClient::Read(std::string* message, int expected_bytes) {
+  int total_bytes_received = 0;
+  message->clear();
+  while (total_bytes_received < expected_bytes) {
+    TestCompletionCallback callback;
+    ReadInternal(&callback);
+    int bytes_received = callback.WaitForResult();
+    if (bytes_received <= 0)
+      return false;
+
+    total_bytes_received += bytes_received;
+    message->append(read_buffer_->data(), bytes_received);
+  }
+  return true;
+}
+
+bool TestHttpClient::ReadResponse(std::string* message,
+                                  bool is_head_response) {
+  if (!Read(message, 1))
+    return false;
+  while (!IsCompleteResponse(*message, is_head_response)) {
+    std::string chunk;
+    if (!Read(&chunk, 1))
+      return false;
+    message->append(chunk);
+  }
+  return true;
+}
+
+std::string TestHttpClient::ReadUntil(const std::string& suffix) {
+  std::string message;
+  while (!base::EndsWith(message, suffix, base::CompareCase::SENSITIVE)) {
+    std::string chunk;
+    if (!Read(&chunk, 1))
+      break;
+    message.append(chunk);
+  }
+  return message;
+}
+
+void TestHttpClient::ExpectUsedThenDisconnectedWithNoData() {
+  // Check that the socket was opened...
+  ASSERT_TRUE(socket_->WasEverUsed());
+
+  // ...then closed when the server disconnected. Verify that the socket was
+  // closed by checking that a Read() fails.
+  std::string response;
+  ASSERT_FALSE(Read(&response, 1u));
+  ASSERT_TRUE(response.empty());
+}
+
+void TestHttpClient::Write() {
+  int result = socket_->Write(
+      write_buffer_.get(), write_buffer_->BytesRemaining(),
+      base::BindOnce(&TestHttpClient::OnWrite, base::Unretained(this)),
+      TRAFFIC_ANNOTATION_FOR_TESTS);
+  if (result != ERR_IO_PENDING)
+    OnWrite(result);
+}
+
+void TestHttpClient::OnWrite(int result) {
+  ASSERT_GT(result, 0);
+  write_buffer_->DidConsume(result);
+  if (write_buffer_->BytesRemaining())
+    Write();
+}
+
+void TestHttpClient::ReadInternal(TestCompletionCallback* callback) {
+  read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize);
+  int result =
+      socket_->Read(read_buffer_.get(), kReadBufferSize, callback->callback());
+  if (result != ERR_IO_PENDING)
+    callback->callback().Run(result);
+}
+
+bool TestHttpClient::IsCompleteResponse(const std::string& response,
+                                        bool is_head_response) {
+  // Check end of headers first.
+  size_t end_of_headers =
+      HttpUtil::LocateEndOfHeaders(response.data(), response.size());
+  if (end_of_headers == std::string::npos)
+    return false;
+  if (is_head_response)
+    return true;
+
+  // Return true if response has data equal to or more than content length.
+  int64_t body_size = static_cast<int64_t>(response.size()) - end_of_headers;
+  DCHECK_LE(0, body_size);
+  auto headers =
+      base::MakeRefCounted<HttpResponseHeaders>(HttpUtil::AssembleRawHeaders(
+          base::StringPiece(response.data(), end_of_headers)));
+  return body_size >= headers->GetContentLength();
+}
+
+}  // namespace net
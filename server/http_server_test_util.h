@@ -0,0 +1,67 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SERVER_HTTP_SERVER_TEST_UTIL_H_
+#define NET_SERVER_HTTP_SERVER_TEST_UTIL_H_
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/socket/tcp_client_socket.h"
+
+namespace net {
+
+class DrainableIOBuffer;
+class IOBufferWithSize;
+class IPEndPoint;
+class TestCompletionCallback;
+
+// A plain TCP client for tests of HttpServer and the servers built on it.
+class TestHttpClient {
+ public:
+  TestHttpClient();
+  ~TestHttpClient();
+
+  int ConnectAndWait(const IPEndPoint& address);
+
+  // Writes all of |data|, completing asynchronously if the socket can't take
+  // it at once.
+  void Send(const std::string& data);
+
+  // Reads until at least |expected_bytes| have been received into |message|.
+  // Returns false if the connection is closed or fails first.
+  bool Read(std::string* message, int expected_bytes);
+
+  // Reads a complete HTTP/1.1 response, whose body is as long as its
+  // Content-Length header says. The body of a response to a HEAD request is
+  // empty, whatever its headers say, so |is_head_response| must be set to
+  // read one.
+  bool ReadResponse(std::string* message, bool is_head_response = false);
+
+  // Reads until the data received ends with |suffix|, or the connection is
+  // closed, and returns everything read.
+  std::string ReadUntil(const std::string& suffix);
+
+  void ExpectUsedThenDisconnectedWithNoData();
+
+  TCPClientSocket& socket() { return *socket_; }
+
+ private:
+  void Write();
+  void OnWrite(int result);
+  void ReadInternal(TestCompletionCallback* callback);
+  bool IsCompleteResponse(const std::string& response, bool is_head_response);
+
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+  scoped_refptr<DrainableIOBuffer> write_buffer_;
+  std::unique_ptr<TCPClientSocket> socket_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestHttpClient);
+};
+
+}  // namespace net
+
+#endif  // NET_SERVER_HTTP_SERVER_TEST_UTIL_H_
@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -23,9 +24,12 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
 #include "base/notreached.h"
+#include "base/optional.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
@@ -40,11 +44,17 @@
 #include "net/http/http_util.h"
 #include "net/log/net_log_source.h"
 #include "net/log/net_log_with_source.h"
+#include "net/server/http_connection.h"
 #include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+#include "net/server/http_server_test_util.h"
+#include "net/socket/next_proto.h"
 #include "net/socket/tcp_client_socket.h"
 #include "net/socket/tcp_server_socket.h"
+#include "net/spdy/buffered_spdy_framer.h"
 #include "net/test/gtest_util.h"
 #include "net/test/test_with_task_environment.h"
+#include "net/third_party/quiche/src/spdy/core/spdy_protocol.h"
 #include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -53,121 +63,6 @@ using net::test::IsOk;
 
 namespace net {
 
-namespace {
-
-const int kMaxExpectedResponseLength = 2048;
-
-class TestHttpClient {
- public:
-  TestHttpClient() = default;
-
-  int ConnectAndWait(const IPEndPoint& address) {
-    AddressList addresses(address);
-    NetLogSource source;
-    socket_.reset(
-        new TCPClientSocket(addresses, nullptr, nullptr, nullptr, source));
-
-    TestCompletionCallback callback;
-    int rv = socket_->Connect(callback.callback());
-    return callback.GetResult(rv);
-  }
-
-  void Send(const std::string& data) {
-    write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(
-        base::MakeRefCounted<StringIOBuffer>(data), data.length());
-    Write();
-  }
-
-  bool Read(std::string* message, int expected_bytes) {
-    int total_bytes_received = 0;
-    message->clear();
-    while (total_bytes_received < expected_bytes) {
-      TestCompletionCallback callback;
-      ReadInternal(&callback);
-      int bytes_received = callback.WaitForResult();
-      if (bytes_received <= 0)
-        return false;
-
-      total_bytes_received += bytes_received;
-      message->append(read_buffer_->data(), bytes_received);
-    }
-    return true;
-  }
-
-  bool ReadResponse(std::string* message) {
-    if (!Read(message, 1))
-      return false;
-    while (!IsCompleteResponse(*message)) {
-      std::string chunk;
-      if (!Read(&chunk, 1))
-        return false;
-      message->append(chunk);
-    }
-    return true;
-  }
-
-  void ExpectUsedThenDisconnectedWithNoData() {
-    // Check that the socket was opened...
-    ASSERT_TRUE(socket_->WasEverUsed());
-
-    // ...then closed when the server disconnected. Verify that the socket was
-    // closed by checking that a Read() fails.
-    std::string response;
-    ASSERT_FALSE(Read(&response, 1u));
-    ASSERT_TRUE(response.empty());
-  }
-
-  TCPClientSocket& socket() { return *socket_; }
-
- private:
-  void Write() {
-    int result = socket_->Write(
-        write_buffer_.get(), write_buffer_->BytesRemaining(),
-        base::BindOnce(&TestHttpClient::OnWrite, base::Unretained(this)),
-        TRAFFIC_ANNOTATION_FOR_TESTS);
-    if (result != ERR_IO_PENDING)
-      OnWrite(result);
-  }
-
-  void OnWrite(int result) {
-    ASSERT_GT(result, 0);
-    write_buffer_->DidConsume(result);
-    if (write_buffer_->BytesRemaining())
-      Write();
-  }
-
-  void ReadInternal(TestCompletionCallback* callback) {
-    read_buffer_ =
-        base::MakeRefCounted<IOBufferWithSize>(kMaxExpectedResponseLength);
-    int result = socket_->Read(read_buffer_.get(), kMaxExpectedResponseLength,
-                               callback->callback());
-    if (result != ERR_IO_PENDING)
-      callback->callback().Run(result);
-  }
-
-  bool IsCompleteResponse(const std::string& response) {
-    // Check end of headers first.
-    size_t end_of_headers =
-        HttpUtil::LocateEndOfHeaders(response.data(), response.size());
-    if (end_of_headers == std::string::npos)
-      return false;
-
-    // Return true if response has data equal to or more than content length.
-    int64_t body_size = static_cast<int64_t>(response.size()) - end_of_headers;
-    DCHECK_LE(0, body_size);
-    auto headers =
-        base::MakeRefCounted<HttpResponseHeaders>(HttpUtil::AssembleRawHeaders(
-            base::StringPiece(response.data(), end_of_headers)));
-    return body_size >= headers->GetContentLength();
-  }
-
-  scoped_refptr<IOBufferWithSize> read_buffer_;
-  scoped_refptr<DrainableIOBuffer> write_buffer_;
-  std::unique_ptr<TCPClientSocket> socket_;
-};
-
-}  // namespace
-
 class HttpServerTest : public TestWithTaskEnvironment,
                        public HttpServer::Delegate {
  public:
@@ -572,8 +467,12 @@ class MockStreamSocket : public StreamSocket {
   }
   const NetLogWithSource& NetLog() const override { return net_log_; }
   bool WasEverUsed() const override { return true; }
-  bool WasAlpnNegotiated() const override { return false; }
-  NextProto GetNegotiatedProtocol() const override { return kProtoUnknown; }
+  bool WasAlpnNegotiated() const override {
+    return negotiated_protocol_ != kProtoUnknown;
+  }
+  NextProto GetNegotiatedProtocol() const override {
+    return negotiated_protocol_;
+  }
   bool GetSSLInfo(SSLInfo* ssl_info) override { return false; }
   void GetConnectionAttempts(ConnectionAttempts* out) const override {
     out->clear();
@@ -607,11 +506,18 @@ class MockStreamSocket : public StreamSocket {
     return read_len;
   }
 
+  // Writes complete only when CompleteWrite() is called.
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation) override {
-    return ERR_NOT_IMPLEMENTED;
+    if (!connected_)
+      return ERR_SOCKET_NOT_CONNECTED;
+    DCHECK(write_callback_.is_null());
+    write_buf_ = buf;
+    write_buf_len_ = buf_len;
+    write_callback_ = std::move(callback);
+    return ERR_IO_PENDING;
   }
   int SetReceiveBufferSize(int32_t size) override {
     return ERR_NOT_IMPLEMENTED;
@@ -631,6 +537,20 @@ class MockStreamSocket : public StreamSocket {
     std::move(read_callback_).Run(read_len);
   }
 
+  bool has_pending_write() const { return !write_callback_.is_null(); }
+
+  void CompleteWrite() {
+    written_data_.append(write_buf_->data(), write_buf_len_);
+    write_buf_ = nullptr;
+    std::move(write_callback_).Run(write_buf_len_);
+  }
+
+  const std::string& written_data() const { return written_data_; }
+
+  void set_negotiated_protocol(NextProto negotiated_protocol) {
+    negotiated_protocol_ = negotiated_protocol;
+  }
+
  private:
   ~MockStreamSocket() override = default;
 
@@ -639,6 +559,11 @@ class MockStreamSocket : public StreamSocket {
   int read_buf_len_;
   CompletionOnceCallback read_callback_;
   std::string pending_read_data_;
+  scoped_refptr<IOBuffer> write_buf_;
+  int write_buf_len_ = 0;
+  CompletionOnceCallback write_callback_;
+  std::string written_data_;
+  NextProto negotiated_protocol_ = kProtoUnknown;
   NetLogWithSource net_log_;
 
   DISALLOW_COPY_AND_ASSIGN(MockStreamSocket);
@@ -711,6 +636,191 @@ TEST_F(HttpServerTest, MultipleRequestsOnSameConnection) {
                              base::CompareCase::SENSITIVE));
 }
 
+// Streams the bodies of requests, instead of buffering them.
+class StreamingHttpServerTest : public HttpServerTest {
+ public:
+  bool ShouldStreamRequestBody(int connection_id,
+                               const HttpServerRequestInfo& info) override {
+    return true;
+  }
+
+  void OnHttpRequestBodyData(int connection_id,
+                             base::StringPiece data) override {
+    body_pieces_.push_back(data.as_string());
+    if (pause_on_body_data_)
+      server_->PauseReading(connection_id);
+  }
+
+  void OnHttpRequestBodyComplete(int connection_id) override {
+    ++num_complete_bodies_;
+  }
+
+ protected:
+  std::vector<std::string> body_pieces_;
+  int num_complete_bodies_ = 0;
+  bool pause_on_body_data_ = false;
+};
+
+TEST_F(StreamingHttpServerTest, RequestBody) {
+  MockStreamSocket* socket = new MockStreamSocket();
+  HandleAcceptResult(base::WrapUnique<StreamSocket>(socket));
+  std::string data =
+      "POST /upload HTTP/1.1\r\n"
+      "Content-Length: 10\r\n\r\n"
+      "01234";
+  socket->DidRead(data.data(), data.size());
+  ASSERT_EQ(1u, requests_.size());
+  EXPECT_EQ("/upload", GetRequest(0).path);
+  EXPECT_TRUE(GetRequest(0).data.empty());
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("01234"));
+  EXPECT_EQ(0, num_complete_bodies_);
+
+  // The rest of the body is followed by a request without one.
+  data = "56789GET /next HTTP/1.1\r\n\r\n";
+  socket->DidRead(data.data(), data.size());
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("01234", "56789"));
+  EXPECT_EQ(1, num_complete_bodies_);
+  ASSERT_EQ(2u, requests_.size());
+  EXPECT_EQ("/next", GetRequest(1).path);
+}
+
+TEST_F(StreamingHttpServerTest, ChunkedRequestBody) {
+  MockStreamSocket* socket = new MockStreamSocket();
+  HandleAcceptResult(base::WrapUnique<StreamSocket>(socket));
+  std::string data =
+      "POST /upload HTTP/1.1\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "5\r\nHello\r\n";
+  socket->DidRead(data.data(), data.size());
+  ASSERT_EQ(1u, requests_.size());
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("Hello"));
+
+  data = "7\r\n, world\r\n0\r\n\r\nGET /next HTTP/1.1\r\n\r\n";
+  socket->DidRead(data.data(), data.size());
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("Hello", ", world"));
+  EXPECT_EQ(1, num_complete_bodies_);
+  ASSERT_EQ(2u, requests_.size());
+  EXPECT_EQ("/next", GetRequest(1).path);
+}
+
+TEST_F(StreamingHttpServerTest, PauseReading) {
+  MockStreamSocket* socket = new MockStreamSocket();
+  HandleAcceptResult(base::WrapUnique<StreamSocket>(socket));
+  pause_on_body_data_ = true;
+  std::string data =
+      "POST /upload HTTP/1.1\r\n"
+      "Content-Length: 10\r\n\r\n"
+      "01234";
+  socket->DidRead(data.data(), data.size());
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("01234"));
+
+  // Nothing is read from the socket while reading is paused.
+  data = "56789";
+  socket->DidRead(data.data(), data.size());
+  base::RunLoop().RunUntilIdle();
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("01234"));
+
+  pause_on_body_data_ = false;
+  server_->ResumeReading(GetConnectionId(0));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_THAT(body_pieces_, testing::ElementsAre("01234", "56789"));
+  EXPECT_EQ(1, num_complete_bodies_);
+}
+
+// Returns |pieces| of a response body one per Read(), completing every other
+// Read() asynchronously.
+class TestResponseBodyProducer : public HttpServer::ResponseBodyProducer {
+ public:
+  explicit TestResponseBodyProducer(std::vector<std::string> pieces)
+      : pieces_(std::move(pieces)) {}
+
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override {
+    if (next_piece_ == pieces_.size())
+      return 0;
+    const std::string& piece = pieces_[next_piece_++];
+    CHECK_LE(piece.size(), static_cast<size_t>(buf_len));
+    memcpy(buf->data(), piece.data(), piece.size());
+    bytes_read_ += piece.size();
+    if (next_piece_ % 2 == 0) {
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE,
+          base::BindOnce(std::move(callback), static_cast<int>(piece.size())));
+      return ERR_IO_PENDING;
+    }
+    return piece.size();
+  }
+
+  size_t bytes_read() const { return bytes_read_; }
+
+ private:
+  const std::vector<std::string> pieces_;
+  size_t next_piece_ = 0;
+  size_t bytes_read_ = 0;
+};
+
+TEST_F(HttpServerTest, StreamingResponse) {
+  TestHttpClient client;
+  CreateConnection(&client);
+  client.Send("GET /test HTTP/1.1\r\n\r\n");
+  RunUntilRequestsReceived(1);
+
+  HttpServerResponseInfo response;
+  response.AddHeader("Content-Type", "text/plain");
+  server_->SendStreamingResponse(
+      GetConnectionId(0), response,
+      std::make_unique<TestResponseBodyProducer>(
+          std::vector<std::string>{"Hello", ", ", "world!"}),
+      TRAFFIC_ANNOTATION_FOR_TESTS);
+
+  const std::string kExpectedResponse =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type:text/plain\r\n"
+      "Transfer-Encoding:chunked\r\n\r\n"
+      "5\r\nHello\r\n"
+      "2\r\n, \r\n"
+      "6\r\nworld!\r\n"
+      "0\r\n\r\n";
+  std::string received;
+  ASSERT_TRUE(client.Read(&received, kExpectedResponse.size()));
+  EXPECT_EQ(kExpectedResponse, received);
+}
+
+TEST_F(HttpServerTest, StreamingResponseBackpressure) {
+  MockStreamSocket* socket = new MockStreamSocket();
+  HandleAcceptResult(base::WrapUnique<StreamSocket>(socket));
+  std::string request = "GET /large HTTP/1.1\r\n\r\n";
+  socket->DidRead(request.data(), request.size());
+  ASSERT_EQ(1u, requests_.size());
+
+  const size_t kPieceSize = 16 * 1024;
+  const size_t kBodySize = 64 * kPieceSize;
+  auto producer = std::make_unique<TestResponseBodyProducer>(
+      std::vector<std::string>(kBodySize / kPieceSize,
+                               std::string(kPieceSize, 'x')));
+  TestResponseBodyProducer* producer_ptr = producer.get();
+  HttpServerResponseInfo response;
+  response.AddHeader("Content-Length", base::NumberToString(kBodySize));
+  server_->SendStreamingResponse(GetConnectionId(0), response,
+                                 std::move(producer),
+                                 TRAFFIC_ANNOTATION_FOR_TESTS);
+  base::RunLoop().RunUntilIdle();
+
+  // Little of the body is read while the socket takes none of it.
+  EXPECT_GT(producer_ptr->bytes_read(), 0u);
+  EXPECT_LT(producer_ptr->bytes_read(), kBodySize / 4);
+
+  while (socket->has_pending_write()) {
+    socket->CompleteWrite();
+    base::RunLoop().RunUntilIdle();
+  }
+  const std::string& written = socket->written_data();
+  size_t end_of_headers = written.find("\r\n\r\n");
+  ASSERT_NE(std::string::npos, end_of_headers);
+  EXPECT_EQ(kBodySize, written.size() - end_of_headers - 4);
+}
+
 class CloseOnConnectHttpServerTest : public HttpServerTest {
  public:
   void OnConnect(int connection_id) override {
@@ -740,6 +850,456 @@ TEST_F(CloseOnConnectHttpServerTest, ServerImmediatelyClosesConnection) {
   EXPECT_EQ(0ul, requests_.size());
 }
 
+
+// Speaks HTTP/2 with prior knowledge over a TestHttpClient connection, and
+// collects the responses the server sends.
+class TestHttp2Client : public BufferedSpdyFramerVisitorInterface {
+ public:
+  struct Response {
+    spdy::SpdyHeaderBlock headers;
+    std::string data;
+    std::vector<size_t> data_frame_sizes;
+    bool fin = false;
+    base::Optional<spdy::SpdyErrorCode> reset_error_code;
+  };
+
+  TestHttp2Client() : framer_(256 * 1024, NetLogWithSource()) {
+    framer_.set_visitor(this);
+  }
+
+  TestHttpClient& client() { return client_; }
+
+  void SendPreface(const spdy::SettingsMap& settings) {
+    std::string data(spdy::kHttp2ConnectionHeaderPrefix,
+                     spdy::kHttp2ConnectionHeaderPrefixSize);
+    std::unique_ptr<spdy::SpdySerializedFrame> frame =
+        framer_.CreateSettings(settings);
+    data.append(frame->data(), frame->size());
+    client_.Send(data);
+  }
+
+  void SendRequest(spdy::SpdyStreamId stream_id,
+                   const std::string& method,
+                   const std::string& path,
+                   const std::string& body,
+                   int weight = spdy::kHttp2DefaultStreamWeight) {
+    spdy::SpdyHeaderBlock block;
+    block[spdy::kHttp2MethodHeader] = method;
+    block[spdy::kHttp2SchemeHeader] = "http";
+    block[spdy::kHttp2AuthorityHeader] = "example.test";
+    block[spdy::kHttp2PathHeader] = path;
+    block["x-test"] = "value";
+    spdy::SpdyHeadersIR headers(stream_id, std::move(block));
+    headers.set_fin(body.empty());
+    if (weight != spdy::kHttp2DefaultStreamWeight) {
+      headers.set_has_priority(true);
+      headers.set_weight(weight);
+    }
+    spdy::SpdySerializedFrame headers_frame = framer_.SerializeFrame(headers);
+    std::string data(headers_frame.data(), headers_frame.size());
+    if (!body.empty()) {
+      std::unique_ptr<spdy::SpdySerializedFrame> data_frame =
+          framer_.CreateDataFrame(stream_id, body.data(), body.size(),
+                                  spdy::DATA_FLAG_FIN);
+      data.append(data_frame->data(), data_frame->size());
+    }
+    client_.Send(data);
+  }
+
+  void SendFrame(std::unique_ptr<spdy::SpdySerializedFrame> frame) {
+    client_.Send(std::string(frame->data(), frame->size()));
+  }
+
+  // Reads until |stream_id| has received at least |bytes| of body data, or
+  // has ended.
+  bool ReadUntilData(spdy::SpdyStreamId stream_id, size_t bytes) {
+    while (responses_[stream_id].data.size() < bytes &&
+           !responses_[stream_id].fin) {
+      if (!ReadOnce())
+        return false;
+    }
+    return true;
+  }
+
+  bool ReadUntilEnd(spdy::SpdyStreamId stream_id) {
+    while (!responses_[stream_id].fin) {
+      if (!ReadOnce())
+        return false;
+    }
+    return true;
+  }
+
+  bool ReadUntilReset(spdy::SpdyStreamId stream_id) {
+    while (!responses_[stream_id].reset_error_code) {
+      if (!ReadOnce())
+        return false;
+    }
+    return true;
+  }
+
+  bool ReadUntilGoAway() {
+    while (!goaway_error_code_) {
+      if (!ReadOnce())
+        return false;
+    }
+    return true;
+  }
+
+  const Response& response(spdy::SpdyStreamId stream_id) {
+    return responses_[stream_id];
+  }
+
+  const std::vector<spdy::SpdyStreamId>& reset_streams() const {
+    return reset_streams_;
+  }
+
+  // The stream of every DATA frame received, in order.
+  const std::vector<spdy::SpdyStreamId>& data_frame_streams() const {
+    return data_frame_streams_;
+  }
+
+  base::Optional<spdy::SpdyErrorCode> goaway_error_code() const {
+    return goaway_error_code_;
+  }
+
+  // BufferedSpdyFramerVisitorInterface implementation.
+  void OnError(
+      http2::Http2DecoderAdapter::SpdyFramerError spdy_framer_error) override {
+    ADD_FAILURE() << "Framer error " << spdy_framer_error;
+  }
+  void OnStreamError(spdy::SpdyStreamId stream_id,
+                     const std::string& description) override {
+    ADD_FAILURE() << "Stream error " << description;
+  }
+  void OnHeaders(spdy::SpdyStreamId stream_id,
+                 bool has_priority,
+                 int weight,
+                 spdy::SpdyStreamId parent_stream_id,
+                 bool exclusive,
+                 bool fin,
+                 spdy::SpdyHeaderBlock headers,
+                 base::TimeTicks recv_first_byte_time) override {
+    responses_[stream_id].headers = std::move(headers);
+    responses_[stream_id].fin = fin;
+  }
+  void OnDataFrameHeader(spdy::SpdyStreamId stream_id,
+                         size_t length,
+                         bool fin) override {}
+  void OnStreamFrameData(spdy::SpdyStreamId stream_id,
+                         const char* data,
+                         size_t len) override {
+    responses_[stream_id].data.append(data, len);
+    responses_[stream_id].data_frame_sizes.push_back(len);
+    data_frame_streams_.push_back(stream_id);
+  }
+  void OnStreamEnd(spdy::SpdyStreamId stream_id) override {
+    responses_[stream_id].fin = true;
+  }
+  void OnStreamPadding(spdy::SpdyStreamId stream_id, size_t len) override {}
+  void OnSettings() override {}
+  void OnSetting(spdy::SpdySettingsId id, uint32_t value) override {}
+  void OnSettingsAck() override {}
+  void OnSettingsEnd() override {}
+  void OnPing(spdy::SpdyPingId unique_id, bool is_ack) override {}
+  void OnRstStream(spdy::SpdyStreamId stream_id,
+                   spdy::SpdyErrorCode error_code) override {
+    reset_streams_.push_back(stream_id);
+    responses_[stream_id].reset_error_code = error_code;
+  }
+  void OnGoAway(spdy::SpdyStreamId last_accepted_stream_id,
+                spdy::SpdyErrorCode error_code,
+                base::StringPiece debug_data) override {
+    goaway_error_code_ = error_code;
+  }
+  void OnWindowUpdate(spdy::SpdyStreamId stream_id,
+                      int delta_window_size) override {}
+  void OnPushPromise(spdy::SpdyStreamId stream_id,
+                     spdy::SpdyStreamId promised_stream_id,
+                     spdy::SpdyHeaderBlock headers) override {}
+  void OnAltSvc(spdy::SpdyStreamId stream_id,
+                base::StringPiece origin,
+                const spdy::SpdyAltSvcWireFormat::AlternativeServiceVector&
+                    altsvc_vector) override {}
+  bool OnUnknownFrame(spdy::SpdyStreamId stream_id,
+                      uint8_t frame_type) override {
+    return false;
+  }
+
+  BufferedSpdyFramer& framer() { return framer_; }
+
+ private:
+  bool ReadOnce() {
+    std::string data;
+    if (!client_.Read(&data, 1))
+      return false;
+    framer_.ProcessInput(data.data(), data.size());
+    return !framer_.HasError();
+  }
+
+  TestHttpClient client_;
+  BufferedSpdyFramer framer_;
+  std::map<spdy::SpdyStreamId, Response> responses_;
+  std::vector<spdy::SpdyStreamId> reset_streams_;
+  std::vector<spdy::SpdyStreamId> data_frame_streams_;
+  base::Optional<spdy::SpdyErrorCode> goaway_error_code_;
+};
+
+class Http2HttpServerTest : public HttpServerTest {
+ public:
+  void SetUp() override {
+    HttpServerTest::SetUp();
+    server_->set_http2_prior_knowledge_enabled(true);
+  }
+
+  void OnHttpRequest(int connection_id,
+                     const HttpServerRequestInfo& info) override {
+    // Every stream is exposed to the delegate with an id of its own.
+    connection_map_[connection_id] = true;
+    HttpServerTest::OnHttpRequest(connection_id, info);
+  }
+};
+
+TEST_F(Http2HttpServerTest, MultiplexedRequests) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  int tcp_connection_id = connection_map().begin()->first;
+  client.SendPreface(spdy::SettingsMap());
+  client.SendRequest(1, "GET", "/a", std::string());
+  client.SendRequest(3, "POST", "/b", "request body");
+  RunUntilRequestsReceived(2);
+
+  ASSERT_EQ("GET", GetRequest(0).method);
+  ASSERT_EQ("/a", GetRequest(0).path);
+  ASSERT_EQ("", GetRequest(0).data);
+  ASSERT_EQ("example.test", GetRequest(0).GetHeaderValue("host"));
+  ASSERT_EQ("value", GetRequest(0).GetHeaderValue("x-test"));
+  ASSERT_TRUE(base::StartsWith(GetRequest(0).peer.ToString(), "127.0.0.1",
+                               base::CompareCase::SENSITIVE));
+  ASSERT_EQ("POST", GetRequest(1).method);
+  ASSERT_EQ("/b", GetRequest(1).path);
+  ASSERT_EQ("request body", GetRequest(1).data);
+
+  int id_a = GetConnectionId(0);
+  int id_b = GetConnectionId(1);
+  EXPECT_NE(id_a, id_b);
+  EXPECT_NE(tcp_connection_id, id_a);
+  EXPECT_NE(tcp_connection_id, id_b);
+
+  // Respond out of order.
+  server_->Send200(id_b, "response b", "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  server_->Send404(id_a, TRAFFIC_ANNOTATION_FOR_TESTS);
+  ASSERT_TRUE(client.ReadUntilEnd(1));
+  ASSERT_TRUE(client.ReadUntilEnd(3));
+
+  EXPECT_EQ("404", client.response(1).headers[spdy::kHttp2StatusHeader]);
+  EXPECT_EQ("", client.response(1).data);
+  EXPECT_EQ("200", client.response(3).headers[spdy::kHttp2StatusHeader]);
+  EXPECT_EQ("text/plain", client.response(3).headers["content-type"]);
+  EXPECT_EQ("response b", client.response(3).data);
+
+  // Finished streams are forgotten, and the connection stays open.
+  server_->Send200(id_a, "late", "text/plain", TRAFFIC_ANNOTATION_FOR_TESTS);
+  EXPECT_TRUE(connection_map()[tcp_connection_id]);
+}
+
+TEST_F(Http2HttpServerTest, SendRawResponse) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  client.SendPreface(spdy::SettingsMap());
+  client.SendRequest(1, "GET", "/raw", std::string());
+  RunUntilRequestsReceived(1);
+
+  // A serialized HTTP/1.1 response, split across calls, becomes HEADERS and
+  // DATA frames.
+  server_->SendRaw(GetConnectionId(0), "HTTP/1.1 200 OK\r\nContent-Len",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  server_->SendRaw(GetConnectionId(0),
+                   "gth: 5\r\nConnection: keep-alive\r\n\r\nhe",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  server_->SendRaw(GetConnectionId(0), "llo", TRAFFIC_ANNOTATION_FOR_TESTS);
+  ASSERT_TRUE(client.ReadUntilEnd(1));
+
+  EXPECT_EQ("200", client.response(1).headers[spdy::kHttp2StatusHeader]);
+  EXPECT_EQ("5", client.response(1).headers["content-length"]);
+  EXPECT_EQ(client.response(1).headers.end(),
+            client.response(1).headers.find("connection"));
+  EXPECT_EQ("hello", client.response(1).data);
+}
+
+TEST_F(Http2HttpServerTest, StreamFlowControl) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  spdy::SettingsMap settings;
+  settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] = 10;
+  client.SendPreface(settings);
+  client.SendRequest(1, "GET", "/", std::string());
+  RunUntilRequestsReceived(1);
+
+  const std::string body = "0123456789abcdefghijklmno";
+  server_->Send200(GetConnectionId(0), body, "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  ASSERT_TRUE(client.ReadUntilData(1, 10));
+  EXPECT_EQ("0123456789", client.response(1).data);
+  EXPECT_FALSE(client.response(1).fin);
+
+  client.SendFrame(client.framer().CreateWindowUpdate(1, 100));
+  ASSERT_TRUE(client.ReadUntilEnd(1));
+  EXPECT_EQ(body, client.response(1).data);
+  EXPECT_THAT(client.response(1).data_frame_sizes,
+              testing::ElementsAre(10u, 15u));
+}
+
+TEST_F(Http2HttpServerTest, PriorityOrdersStreams) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  // Hold back all response data until both responses have been sent.
+  spdy::SettingsMap settings;
+  settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] = 0;
+  client.SendPreface(settings);
+  client.SendRequest(1, "GET", "/low", std::string(), /*weight=*/1);
+  client.SendRequest(3, "GET", "/high", std::string(), /*weight=*/256);
+  RunUntilRequestsReceived(2);
+  ASSERT_EQ("/low", GetRequest(0).path);
+
+  server_->Send200(GetConnectionId(0), "low", "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  server_->Send200(GetConnectionId(1), "high", "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] = 100;
+  client.SendFrame(client.framer().CreateSettings(settings));
+  ASSERT_TRUE(client.ReadUntilEnd(1));
+  ASSERT_TRUE(client.ReadUntilEnd(3));
+
+  EXPECT_EQ("low", client.response(1).data);
+  EXPECT_EQ("high", client.response(3).data);
+  EXPECT_THAT(client.data_frame_streams(), testing::ElementsAre(3u, 1u));
+}
+
+// A client that never opens its flow control windows can't make the server
+// buffer more response data than a connection's write buffer holds.
+TEST_F(Http2HttpServerTest, ResponseBufferLimit) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  int tcp_connection_id = connection_map().begin()->first;
+  client.SendPreface(spdy::SettingsMap());
+  client.SendRequest(1, "GET", "/a", std::string());
+  client.SendRequest(3, "GET", "/b", std::string());
+  RunUntilRequestsReceived(2);
+
+  // Each response fits on its own, but not both together.
+  const std::string body(
+      HttpConnection::QueuedWriteIOBuffer::kDefaultMaxBufferSize * 3 / 4, 'x');
+  server_->Send200(GetConnectionId(0), body, "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  server_->Send200(GetConnectionId(1), body, "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  EXPECT_TRUE(connection_map()[GetConnectionId(0)]);
+  EXPECT_FALSE(connection_map()[GetConnectionId(1)]);
+
+  ASSERT_TRUE(client.ReadUntilReset(3));
+  EXPECT_EQ(spdy::ERROR_CODE_INTERNAL_ERROR,
+            client.response(3).reset_error_code);
+  ASSERT_TRUE(client.ReadUntilData(1, spdy::kInitialStreamWindowSize));
+  EXPECT_EQ(static_cast<size_t>(spdy::kInitialStreamWindowSize),
+            client.response(1).data.size());
+
+  // The first response completes once the client opens its windows.
+  client.SendFrame(client.framer().CreateWindowUpdate(
+      spdy::kSessionFlowControlStreamId, body.size()));
+  client.SendFrame(client.framer().CreateWindowUpdate(1, body.size()));
+  ASSERT_TRUE(client.ReadUntilEnd(1));
+  EXPECT_EQ(body, client.response(1).data);
+  EXPECT_TRUE(connection_map()[tcp_connection_id]);
+}
+
+TEST_F(Http2HttpServerTest, InvalidMaxFrameSize) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  int tcp_connection_id = connection_map().begin()->first;
+  spdy::SettingsMap settings;
+  // Smaller than the initial value, which is the minimum allowed.
+  settings[spdy::SETTINGS_MAX_FRAME_SIZE] =
+      spdy::kHttp2DefaultFramePayloadLimit - 1;
+  client.SendPreface(settings);
+
+  ASSERT_TRUE(client.ReadUntilGoAway());
+  EXPECT_EQ(spdy::ERROR_CODE_PROTOCOL_ERROR, client.goaway_error_code());
+  RunUntilConnectionIdClosed(tcp_connection_id);
+}
+
+TEST_F(Http2HttpServerTest, ClientResetsStream) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  client.SendPreface(spdy::SettingsMap());
+  client.SendRequest(1, "GET", "/", std::string());
+  RunUntilRequestsReceived(1);
+
+  client.SendFrame(
+      client.framer().CreateRstStream(1, spdy::ERROR_CODE_CANCEL));
+  RunUntilConnectionIdClosed(GetConnectionId(0));
+
+  // The connection itself is still open.
+  client.SendRequest(3, "GET", "/next", std::string());
+  RunUntilRequestsReceived(2);
+  ASSERT_EQ("/next", GetRequest(1).path);
+}
+
+TEST_F(Http2HttpServerTest, ClosingConnectionClosesStreams) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  int tcp_connection_id = connection_map().begin()->first;
+  client.SendPreface(spdy::SettingsMap());
+  client.SendRequest(1, "GET", "/", std::string());
+  RunUntilRequestsReceived(1);
+
+  server_->Close(tcp_connection_id);
+  EXPECT_FALSE(connection_map()[tcp_connection_id]);
+  EXPECT_FALSE(connection_map()[GetConnectionId(0)]);
+}
+
+TEST_F(HttpServerTest, Http2PriorKnowledgeDisabledByDefault) {
+  TestHttp2Client client;
+  CreateConnection(&client.client());
+  client.SendPreface(spdy::SettingsMap());
+  client.client().ExpectUsedThenDisconnectedWithNoData();
+}
+
+TEST_F(HttpServerTest, Http2NegotiatedWithAlpn) {
+  MockStreamSocket* socket = new MockStreamSocket();
+  socket->set_negotiated_protocol(kProtoHTTP2);
+  HandleAcceptResult(base::WrapUnique<StreamSocket>(socket));
+
+  // The server sends its SETTINGS frame, type 0x4, without waiting for the
+  // client's connection preface.
+  ASSERT_TRUE(socket->has_pending_write());
+  socket->CompleteWrite();
+  ASSERT_GE(socket->written_data().size(), spdy::kFrameHeaderSize);
+  EXPECT_EQ(0x4, socket->written_data()[3]);
+
+  BufferedSpdyFramer framer(256 * 1024, NetLogWithSource());
+  std::string data(spdy::kHttp2ConnectionHeaderPrefix,
+                   spdy::kHttp2ConnectionHeaderPrefixSize);
+  std::unique_ptr<spdy::SpdySerializedFrame> settings =
+      framer.CreateSettings(spdy::SettingsMap());
+  data.append(settings->data(), settings->size());
+  spdy::SpdyHeaderBlock block;
+  block[spdy::kHttp2MethodHeader] = "GET";
+  block[spdy::kHttp2SchemeHeader] = "https";
+  block[spdy::kHttp2AuthorityHeader] = "example.test";
+  block[spdy::kHttp2PathHeader] = "/alpn";
+  spdy::SpdyHeadersIR headers(1, std::move(block));
+  headers.set_fin(true);
+  spdy::SpdySerializedFrame headers_frame = framer.SerializeFrame(headers);
+  data.append(headers_frame.data(), headers_frame.size());
+
+  // Prior knowledge is disabled, so the request is only understood because
+  // "h2" was negotiated.
+  socket->DidRead(data.data(), data.size());
+  ASSERT_EQ(1u, requests_.size());
+  EXPECT_EQ("/alpn", GetRequest(0).path);
+}
+
 }  // namespace
 
 }  // namespace net
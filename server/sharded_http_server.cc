@@ -0,0 +1,458 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/sharded_http_server.h"
+
+#include <limits>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/containers/circular_deque.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/message_loop/message_pump_type.h"
+#include "base/notreached.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "net/base/net_errors.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+#include "net/socket/server_socket.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
+
+namespace net {
+
+namespace {
+
+// The ServerSocket of a shard's HttpServer. It "accepts" the connections
+// that ShardedHttpServer hands to the shard.
+class HandedOffServerSocket : public ServerSocket {
+ public:
+  explicit HandedOffServerSocket(const IPEndPoint& local_address)
+      : local_address_(local_address) {}
+  ~HandedOffServerSocket() override = default;
+
+  void AddSocket(std::unique_ptr<StreamSocket> socket) {
+    if (pending_callback_) {
+      *pending_socket_ = std::move(socket);
+      pending_socket_ = nullptr;
+      std::move(pending_callback_).Run(OK);
+      return;
+    }
+    sockets_.push_back(std::move(socket));
+  }
+
+  // ServerSocket implementation.
+  int Listen(const IPEndPoint& address, int backlog) override {
+    NOTREACHED();
+    return ERR_NOT_IMPLEMENTED;
+  }
+
+  int GetLocalAddress(IPEndPoint* address) const override {
+    *address = local_address_;
+    return OK;
+  }
+
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback) override {
+    DCHECK(!pending_callback_);
+    if (sockets_.empty()) {
+      pending_socket_ = socket;
+      pending_callback_ = std::move(callback);
+      return ERR_IO_PENDING;
+    }
+    *socket = std::move(sockets_.front());
+    sockets_.pop_front();
+    return OK;
+  }
+
+ private:
+  const IPEndPoint local_address_;
+  base::circular_deque<std::unique_ptr<StreamSocket>> sockets_;
+  std::unique_ptr<StreamSocket>* pending_socket_ = nullptr;
+  CompletionOnceCallback pending_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(HandedOffServerSocket);
+};
+
+}  // namespace
+
+// An HttpServer and the I/O thread it runs on. Translates the HttpServer's
+// connection ids to ids that are unique across shards.
+class ShardedHttpServer::Shard : public HttpServer::Delegate {
+ public:
+  Shard(size_t index,
+        size_t num_shards,
+        const IPEndPoint& local_address,
+        ShardedHttpServer::Delegate* delegate)
+      : index_(index),
+        num_shards_(num_shards),
+        delegate_(delegate),
+        thread_(base::StringPrintf("HttpServerShard%d",
+                                   static_cast<int>(index))) {
+    CHECK(thread_.StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0)));
+    // Kept past Shutdown(), unlike |thread_|'s, so that other threads can
+    // still post (dropped) tasks to the shard.
+    task_runner_ = thread_.task_runner();
+    task_runner()->PostTask(FROM_HERE,
+                            base::BindOnce(&Shard::Start,
+                                           base::Unretained(this),
+                                           local_address));
+  }
+
+  ~Shard() override { DCHECK(!thread_.IsRunning()); }
+
+  // Destroys the HttpServer and its connections on the shard thread, then
+  // joins it. Tasks posted to the shard afterwards are dropped.
+  void Shutdown() {
+    task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&Shard::Stop, base::Unretained(this)));
+    thread_.Stop();
+  }
+
+  const scoped_refptr<base::SingleThreadTaskRunner>& task_runner() const {
+    return task_runner_;
+  }
+
+  void AddConnection(std::unique_ptr<TCPSocket> socket,
+                     const IPEndPoint& peer_address) {
+    DCHECK(task_runner()->BelongsToCurrentThread());
+    server_socket_->AddSocket(
+        std::make_unique<TCPClientSocket>(std::move(socket), peer_address));
+  }
+
+  void RunTask(base::OnceCallback<void(HttpServer*, int)> task, int local_id) {
+    DCHECK(task_runner()->BelongsToCurrentThread());
+    if (server_)
+      std::move(task).Run(server_.get(), local_id);
+  }
+
+  void SetHttp2PriorKnowledgeEnabled(bool enabled) {
+    DCHECK(task_runner()->BelongsToCurrentThread());
+    server_->set_http2_prior_knowledge_enabled(enabled);
+  }
+
+  // HttpServer::Delegate implementation.
+  void OnConnect(int connection_id) override {
+    delegate_->OnConnect(ToShardedId(connection_id));
+  }
+
+  void OnHttpRequest(int connection_id,
+                     const HttpServerRequestInfo& info) override {
+    delegate_->OnHttpRequest(ToShardedId(connection_id), info);
+  }
+
+  void OnWebSocketRequest(int connection_id,
+                          const HttpServerRequestInfo& info) override {
+    delegate_->OnWebSocketRequest(ToShardedId(connection_id), info);
+  }
+
+  void OnWebSocketMessage(int connection_id, std::string data) override {
+    delegate_->OnWebSocketMessage(ToShardedId(connection_id),
+                                  std::move(data));
+  }
+
+  void OnClose(int connection_id) override {
+    delegate_->OnClose(ToShardedId(connection_id));
+  }
+
+  bool ShouldStreamRequestBody(int connection_id,
+                               const HttpServerRequestInfo& info) override {
+    return delegate_->ShouldStreamRequestBody(ToShardedId(connection_id),
+                                              info);
+  }
+
+  void OnHttpRequestBodyData(int connection_id,
+                             base::StringPiece data) override {
+    delegate_->OnHttpRequestBodyData(ToShardedId(connection_id), data);
+  }
+
+  void OnHttpRequestBodyComplete(int connection_id) override {
+    delegate_->OnHttpRequestBodyComplete(ToShardedId(connection_id));
+  }
+
+ private:
+  void Start(const IPEndPoint& local_address) {
+    auto server_socket = std::make_unique<HandedOffServerSocket>(local_address);
+    server_socket_ = server_socket.get();
+    server_ = std::make_unique<HttpServer>(std::move(server_socket), this);
+  }
+
+  void Stop() {
+    server_socket_ = nullptr;
+    server_.reset();
+  }
+
+  int ToShardedId(int connection_id) const {
+    DCHECK_LE(connection_id,
+              static_cast<int>((std::numeric_limits<int>::max() - index_) /
+                               num_shards_));
+    return connection_id * static_cast<int>(num_shards_) +
+           static_cast<int>(index_);
+  }
+
+  const size_t index_;
+  const size_t num_shards_;
+  ShardedHttpServer::Delegate* const delegate_;
+  base::Thread thread_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+
+  // Only used on |thread_|.
+  HandedOffServerSocket* server_socket_ = nullptr;
+  std::unique_ptr<HttpServer> server_;
+
+  DISALLOW_COPY_AND_ASSIGN(Shard);
+};
+
+ShardedHttpServer::ShardedHttpServer(std::unique_ptr<TCPSocket> listen_socket,
+                                     size_t num_shards,
+                                     Delegate* delegate)
+    : listen_socket_(std::move(listen_socket)) {
+  DCHECK(listen_socket_);
+  DCHECK_GT(num_shards, 0u);
+  IPEndPoint local_address;
+  listen_socket_->GetLocalAddress(&local_address);
+  for (size_t i = 0; i < num_shards; ++i) {
+    shards_.push_back(
+        std::make_unique<Shard>(i, num_shards, local_address, delegate));
+  }
+  // Start accepting connections in next run loop in case when delegate is not
+  // ready to get callbacks.
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, base::BindOnce(&ShardedHttpServer::DoAcceptLoop,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+ShardedHttpServer::~ShardedHttpServer() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // Stop every shard before destroying any, as delegate callbacks on a shard
+  // that is still running may call into the others.
+  for (const auto& shard : shards_)
+    shard->Shutdown();
+  shards_.clear();
+}
+
+void ShardedHttpServer::AcceptWebSocket(
+    int connection_id,
+    const HttpServerRequestInfo& request,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](const HttpServerRequestInfo& request,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->AcceptWebSocket(id, request, traffic_annotation);
+                 },
+                 request, traffic_annotation));
+}
+
+void ShardedHttpServer::SendOverWebSocket(
+    int connection_id,
+    base::StringPiece data,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](const std::string& data,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->SendOverWebSocket(id, data, traffic_annotation);
+                 },
+                 std::string(data), traffic_annotation));
+}
+
+void ShardedHttpServer::SendFragmentOverWebSocket(
+    int connection_id,
+    base::StringPiece data,
+    bool final,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](const std::string& data, bool final,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->SendFragmentOverWebSocket(id, data, final,
+                                                     traffic_annotation);
+                 },
+                 std::string(data), final, traffic_annotation));
+}
+
+void ShardedHttpServer::SendRaw(
+    int connection_id,
+    const std::string& data,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](const std::string& data,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->SendRaw(id, data, traffic_annotation);
+                 },
+                 data, traffic_annotation));
+}
+
+void ShardedHttpServer::SendResponse(
+    int connection_id,
+    const HttpServerResponseInfo& response,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](const HttpServerResponseInfo& response,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->SendResponse(id, response, traffic_annotation);
+                 },
+                 response, traffic_annotation));
+}
+
+void ShardedHttpServer::Send(int connection_id,
+                             HttpStatusCode status_code,
+                             const std::string& data,
+                             const std::string& mime_type,
+                             NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(connection_id,
+             base::BindOnce(
+                 [](HttpStatusCode status_code, const std::string& data,
+                    const std::string& mime_type,
+                    NetworkTrafficAnnotationTag traffic_annotation,
+                    HttpServer* server, int id) {
+                   server->Send(id, status_code, data, mime_type,
+                                traffic_annotation);
+                 },
+                 status_code, data, mime_type, traffic_annotation));
+}
+
+void ShardedHttpServer::Send200(
+    int connection_id,
+    const std::string& data,
+    const std::string& mime_type,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  Send(connection_id, HTTP_OK, data, mime_type, traffic_annotation);
+}
+
+void ShardedHttpServer::Send404(
+    int connection_id,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  SendResponse(connection_id, HttpServerResponseInfo::CreateFor404(),
+               traffic_annotation);
+}
+
+void ShardedHttpServer::Send500(
+    int connection_id,
+    const std::string& message,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  SendResponse(connection_id, HttpServerResponseInfo::CreateFor500(message),
+               traffic_annotation);
+}
+
+void ShardedHttpServer::SendStreamingResponse(
+    int connection_id,
+    const HttpServerResponseInfo& response,
+    std::unique_ptr<HttpServer::ResponseBodyProducer> producer,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  RunOnShard(
+      connection_id,
+      base::BindOnce(
+          [](const HttpServerResponseInfo& response,
+             std::unique_ptr<HttpServer::ResponseBodyProducer> producer,
+             NetworkTrafficAnnotationTag traffic_annotation,
+             HttpServer* server, int id) {
+            server->SendStreamingResponse(id, response, std::move(producer),
+                                          traffic_annotation);
+          },
+          response, std::move(producer), traffic_annotation));
+}
+
+void ShardedHttpServer::Close(int connection_id) {
+  RunOnShard(connection_id,
+             base::BindOnce([](HttpServer* server, int id) {
+               server->Close(id);
+             }));
+}
+
+void ShardedHttpServer::PauseReading(int connection_id) {
+  RunOnShard(connection_id,
+             base::BindOnce([](HttpServer* server, int id) {
+               server->PauseReading(id);
+             }));
+}
+
+void ShardedHttpServer::ResumeReading(int connection_id) {
+  RunOnShard(connection_id,
+             base::BindOnce([](HttpServer* server, int id) {
+               server->ResumeReading(id);
+             }));
+}
+
+void ShardedHttpServer::SetHttp2PriorKnowledgeEnabled(bool enabled) {
+  for (const auto& shard : shards_) {
+    shard->task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&Shard::SetHttp2PriorKnowledgeEnabled,
+                                  base::Unretained(shard.get()), enabled));
+  }
+}
+
+int ShardedHttpServer::GetLocalAddress(IPEndPoint* address) {
+  return listen_socket_->GetLocalAddress(address);
+}
+
+void ShardedHttpServer::DoAcceptLoop() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  int rv;
+  do {
+    rv = listen_socket_->Accept(
+        &accepted_socket_, &accepted_address_,
+        base::BindOnce(&ShardedHttpServer::OnAcceptCompleted,
+                       weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    rv = HandleAcceptResult(rv);
+  } while (rv == OK);
+}
+
+void ShardedHttpServer::OnAcceptCompleted(int rv) {
+  if (HandleAcceptResult(rv) == OK)
+    DoAcceptLoop();
+}
+
+int ShardedHttpServer::HandleAcceptResult(int rv) {
+  if (rv < 0) {
+    LOG(ERROR) << "Accept error: rv=" << rv;
+    return rv;
+  }
+
+  // The socket has not been used yet, so it can move to the shard's thread.
+  accepted_socket_->DetachFromThread();
+  Shard* shard = shards_[next_shard_].get();
+  next_shard_ = (next_shard_ + 1) % shards_.size();
+  shard->task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&Shard::AddConnection, base::Unretained(shard),
+                     std::move(accepted_socket_), accepted_address_));
+  return OK;
+}
+
+void ShardedHttpServer::RunOnShard(
+    int connection_id,
+    base::OnceCallback<void(HttpServer*, int)> task) {
+  if (connection_id <= 0)
+    return;
+  size_t num_shards = shards_.size();
+  Shard* shard = shards_[static_cast<size_t>(connection_id) % num_shards].get();
+  int local_id = static_cast<int>(static_cast<size_t>(connection_id) /
+                                  num_shards);
+  if (shard->task_runner()->BelongsToCurrentThread()) {
+    shard->RunTask(std::move(task), local_id);
+    return;
+  }
+  shard->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&Shard::RunTask, base::Unretained(shard),
+                                std::move(task), local_id));
+}
+
+}  // namespace net
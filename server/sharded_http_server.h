@@ -0,0 +1,136 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SERVER_SHARDED_HTTP_SERVER_H_
+#define NET_SERVER_SHARDED_HTTP_SERVER_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback_forward.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "base/strings/string_piece.h"
+#include "net/base/ip_endpoint.h"
+#include "net/http/http_status_code.h"
+#include "net/server/http_server.h"
+#include "net/socket/tcp_socket.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+
+class HttpServerRequestInfo;
+class HttpServerResponseInfo;
+
+// Spreads the connections of one listening socket over several HttpServers,
+// each running on an I/O thread of its own, so that a slow delegate callback
+// or a burst of connections on one shard does not hold up the others.
+//
+// Connections are accepted on the sequence ShardedHttpServer is created on,
+// and handed to the shards round-robin. Connection ids are unique across
+// shards and encode the shard, so that the Send*() and Close() methods can be
+// called from any thread; they run synchronously when called on the
+// connection's own shard, e.g. from a delegate callback, and are posted to it
+// otherwise.
+//
+// |delegate| is called on the shard thread that owns the connection, so it is
+// called concurrently from several threads and must be thread-safe. As with
+// HttpServer, it is not safe to destroy the ShardedHttpServer from a delegate
+// callback, nor while other threads may call into it.
+class ShardedHttpServer {
+ public:
+  using Delegate = HttpServer::Delegate;
+
+  // Serves connections accepted on |listen_socket|, which must already be
+  // listening, on |num_shards| I/O threads. Like HttpServer, accepting starts
+  // asynchronously.
+  ShardedHttpServer(std::unique_ptr<TCPSocket> listen_socket,
+                    size_t num_shards,
+                    Delegate* delegate);
+  ~ShardedHttpServer();
+
+  // The following may be called from any thread. They behave as their
+  // HttpServer equivalents.
+  void AcceptWebSocket(int connection_id,
+                       const HttpServerRequestInfo& request,
+                       NetworkTrafficAnnotationTag traffic_annotation);
+  void SendOverWebSocket(int connection_id,
+                         base::StringPiece data,
+                         NetworkTrafficAnnotationTag traffic_annotation);
+  void SendFragmentOverWebSocket(
+      int connection_id,
+      base::StringPiece data,
+      bool final,
+      NetworkTrafficAnnotationTag traffic_annotation);
+  void SendRaw(int connection_id,
+               const std::string& data,
+               NetworkTrafficAnnotationTag traffic_annotation);
+  void SendResponse(int connection_id,
+                    const HttpServerResponseInfo& response,
+                    NetworkTrafficAnnotationTag traffic_annotation);
+  void Send(int connection_id,
+            HttpStatusCode status_code,
+            const std::string& data,
+            const std::string& mime_type,
+            NetworkTrafficAnnotationTag traffic_annotation);
+  void Send200(int connection_id,
+               const std::string& data,
+               const std::string& mime_type,
+               NetworkTrafficAnnotationTag traffic_annotation);
+  void Send404(int connection_id,
+               NetworkTrafficAnnotationTag traffic_annotation);
+  void Send500(int connection_id,
+               const std::string& message,
+               NetworkTrafficAnnotationTag traffic_annotation);
+  // |producer| is read from on the connection's shard thread.
+  void SendStreamingResponse(
+      int connection_id,
+      const HttpServerResponseInfo& response,
+      std::unique_ptr<HttpServer::ResponseBodyProducer> producer,
+      NetworkTrafficAnnotationTag traffic_annotation);
+  void Close(int connection_id);
+  void PauseReading(int connection_id);
+  void ResumeReading(int connection_id);
+
+  // Applies HttpServer::set_http2_prior_knowledge_enabled() to all shards.
+  void SetHttp2PriorKnowledgeEnabled(bool enabled);
+
+  // Copies the local address to |address|. Returns a network error code.
+  int GetLocalAddress(IPEndPoint* address);
+
+  size_t num_shards() const { return shards_.size(); }
+
+ private:
+  class Shard;
+
+  void DoAcceptLoop();
+  void OnAcceptCompleted(int rv);
+  int HandleAcceptResult(int rv);
+
+  // Runs |task| with the HttpServer and shard-local id of |connection_id|, on
+  // that connection's shard.
+  void RunOnShard(int connection_id,
+                  base::OnceCallback<void(HttpServer*, int)> task);
+
+  const std::unique_ptr<TCPSocket> listen_socket_;
+  std::unique_ptr<TCPSocket> accepted_socket_;
+  IPEndPoint accepted_address_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  size_t next_shard_ = 0;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  base::WeakPtrFactory<ShardedHttpServer> weak_ptr_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedHttpServer);
+};
+
+}  // namespace net
+
+#endif  // NET_SERVER_SHARDED_HTTP_SERVER_H_
@@ -0,0 +1,221 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/sharded_http_server.h"
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/check_op.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_address.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_source.h"
+#include "net/server/http_server_request_info.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/test/test_with_task_environment.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+
+namespace {
+
+const int kNumClients = 32;
+const int kRequestsPerClient = 200;
+
+static constexpr char kMetricPrefixShardedHttpServer[] = "ShardedHttpServer.";
+static constexpr char kMetricRequestsPerSecond[] = "requests_per_second";
+
+const char kRequest[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+const char kBody[] = "metric_a 1\nmetric_b 2\nmetric_c 3\n";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixShardedHttpServer,
+                                         story);
+  reporter.RegisterImportantMetric(kMetricRequestsPerSecond, "count/s");
+  return reporter;
+}
+
+// Responds to every request, after spending |work_time| as a scrape handler
+// collecting its metrics would.
+class ScrapeDelegate : public ShardedHttpServer::Delegate {
+ public:
+  explicit ScrapeDelegate(base::TimeDelta work_time) : work_time_(work_time) {}
+
+  void set_server(ShardedHttpServer* server) { server_ = server; }
+
+  void OnConnect(int connection_id) override {}
+  void OnHttpRequest(int connection_id,
+                     const HttpServerRequestInfo& info) override {
+    if (!work_time_.is_zero())
+      base::PlatformThread::Sleep(work_time_);
+    server_->Send200(connection_id, kBody, "text/plain",
+                     TRAFFIC_ANNOTATION_FOR_TESTS);
+  }
+  void OnWebSocketRequest(int connection_id,
+                          const HttpServerRequestInfo& info) override {}
+  void OnWebSocketMessage(int connection_id, std::string data) override {}
+  void OnClose(int connection_id) override {}
+
+ private:
+  const base::TimeDelta work_time_;
+  ShardedHttpServer* server_ = nullptr;
+};
+
+// Sends |kRequestsPerClient| requests one after another on a keep-alive
+// connection, then runs |done_callback|.
+class LoadClient {
+ public:
+  LoadClient(const IPEndPoint& address,
+             size_t response_size,
+             base::OnceClosure done_callback)
+      : socket_(AddressList(address),
+                nullptr,
+                nullptr,
+                nullptr,
+                NetLogSource()),
+        request_buffer_(base::MakeRefCounted<StringIOBuffer>(kRequest)),
+        read_buffer_(base::MakeRefCounted<IOBufferWithSize>(4096)),
+        response_size_(response_size),
+        done_callback_(std::move(done_callback)) {}
+
+  void Start() {
+    int rv = socket_.Connect(
+        base::BindOnce(&LoadClient::OnConnected, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnConnected(rv);
+  }
+
+ private:
+  void OnConnected(int rv) {
+    CHECK_EQ(OK, rv);
+    SendRequest();
+  }
+
+  void SendRequest() {
+    int rv = socket_.Write(
+        request_buffer_.get(), request_buffer_->size(),
+        base::BindOnce(&LoadClient::OnWritten, base::Unretained(this)),
+        TRAFFIC_ANNOTATION_FOR_TESTS);
+    if (rv != ERR_IO_PENDING)
+      OnWritten(rv);
+  }
+
+  void OnWritten(int rv) {
+    CHECK_EQ(request_buffer_->size(), rv);
+    received_ = 0;
+    ReadResponse();
+  }
+
+  void ReadResponse() {
+    int rv = socket_.Read(
+        read_buffer_.get(), read_buffer_->size(),
+        base::BindOnce(&LoadClient::OnRead, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnRead(rv);
+  }
+
+  void OnRead(int rv) {
+    CHECK_GT(rv, 0);
+    received_ += rv;
+    if (received_ < response_size_) {
+      ReadResponse();
+      return;
+    }
+    CHECK_EQ(response_size_, received_);
+    if (++requests_sent_ < kRequestsPerClient) {
+      SendRequest();
+      return;
+    }
+    std::move(done_callback_).Run();
+  }
+
+  TCPClientSocket socket_;
+  scoped_refptr<StringIOBuffer> request_buffer_;
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+  const size_t response_size_;
+  size_t received_ = 0;
+  int requests_sent_ = 0;
+  base::OnceClosure done_callback_;
+};
+
+class ShardedHttpServerPerfTest : public TestWithTaskEnvironment {
+ protected:
+  void RunLoad(const std::string& story,
+               size_t num_shards,
+               base::TimeDelta work_time) {
+    auto listen_socket =
+        std::make_unique<TCPSocket>(nullptr, nullptr, NetLogSource());
+    ASSERT_EQ(OK, listen_socket->Open(ADDRESS_FAMILY_IPV4));
+    ASSERT_EQ(OK, listen_socket->AllowAddressReuse());
+    ASSERT_EQ(OK, listen_socket->Bind(IPEndPoint(IPAddress::IPv4Localhost(),
+                                                 0)));
+    ASSERT_EQ(OK, listen_socket->Listen(kNumClients));
+
+    ScrapeDelegate delegate(work_time);
+    ShardedHttpServer server(std::move(listen_socket), num_shards, &delegate);
+    delegate.set_server(&server);
+    IPEndPoint address;
+    ASSERT_EQ(OK, server.GetLocalAddress(&address));
+
+    std::string expected_response =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length:" +
+        base::NumberToString(strlen(kBody)) +
+        "\r\n"
+        "Content-Type:text/plain\r\n"
+        "\r\n" +
+        kBody;
+
+    base::RunLoop run_loop;
+    base::RepeatingClosure client_done =
+        base::BarrierClosure(kNumClients, run_loop.QuitClosure());
+    std::vector<std::unique_ptr<LoadClient>> clients;
+    for (int i = 0; i < kNumClients; ++i) {
+      clients.push_back(std::make_unique<LoadClient>(
+          address, expected_response.size(), client_done));
+    }
+
+    base::ElapsedTimer timer;
+    for (auto& client : clients)
+      client->Start();
+    run_loop.Run();
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    auto reporter = SetUpReporter(story);
+    reporter.AddResult(kMetricRequestsPerSecond,
+                       kNumClients * kRequestsPerClient / elapsed.InSecondsF());
+  }
+};
+
+TEST_F(ShardedHttpServerPerfTest, Loopback) {
+  RunLoad("1_shard", 1, base::TimeDelta());
+  RunLoad("4_shards", 4, base::TimeDelta());
+}
+
+// Each request blocks its shard for a while, as a slow delegate would.
+TEST_F(ShardedHttpServerPerfTest, LoopbackSlowDelegate) {
+  const base::TimeDelta kWorkTime = base::TimeDelta::FromMicroseconds(200);
+  RunLoad("slow_delegate_1_shard", 1, kWorkTime);
+  RunLoad("slow_delegate_4_shards", 4, kWorkTime);
+}
+
+}  // namespace
+
+}  // namespace net
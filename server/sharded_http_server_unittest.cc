@@ -0,0 +1,180 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/sharded_http_server.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/run_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "net/base/ip_address.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_source.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_test_util.h"
+#include "net/socket/tcp_socket.h"
+#include "net/test/gtest_util.h"
+#include "net/test/test_with_task_environment.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using net::test::IsOk;
+
+namespace net {
+
+namespace {
+
+std::unique_ptr<TCPSocket> CreateListenSocket() {
+  auto socket = std::make_unique<TCPSocket>(nullptr, nullptr, NetLogSource());
+  if (socket->Open(ADDRESS_FAMILY_IPV4) != OK ||
+      socket->AllowAddressReuse() != OK ||
+      socket->Bind(IPEndPoint(IPAddress::IPv4Localhost(), 0)) != OK ||
+      socket->Listen(10) != OK) {
+    return nullptr;
+  }
+  return socket;
+}
+
+// Records which threads requests arrive on, and either responds at once on
+// the shard or leaves the response to the test.
+class TestDelegate : public ShardedHttpServer::Delegate {
+ public:
+  TestDelegate()
+      : main_task_runner_(base::ThreadTaskRunnerHandle::Get()) {}
+
+  void set_server(ShardedHttpServer* server) { server_ = server; }
+  void set_respond_on_shard(bool respond) { respond_on_shard_ = respond; }
+
+  void WaitForRequests(size_t count) {
+    base::RunLoop run_loop;
+    {
+      base::AutoLock lock(lock_);
+      if (request_ids_.size() >= count)
+        return;
+      quit_after_request_count_ = count;
+      quit_closure_ = run_loop.QuitClosure();
+    }
+    run_loop.Run();
+  }
+
+  std::vector<int> request_ids() {
+    base::AutoLock lock(lock_);
+    return request_ids_;
+  }
+
+  std::set<base::PlatformThreadId> request_threads() {
+    base::AutoLock lock(lock_);
+    return request_threads_;
+  }
+
+  // ShardedHttpServer::Delegate implementation.
+  void OnConnect(int connection_id) override {}
+
+  void OnHttpRequest(int connection_id,
+                     const HttpServerRequestInfo& info) override {
+    if (respond_on_shard_) {
+      server_->Send200(connection_id, "shard response " + info.path,
+                       "text/plain", TRAFFIC_ANNOTATION_FOR_TESTS);
+    }
+    base::AutoLock lock(lock_);
+    request_ids_.push_back(connection_id);
+    request_threads_.insert(base::PlatformThread::CurrentId());
+    if (quit_closure_ && request_ids_.size() >= quit_after_request_count_)
+      main_task_runner_->PostTask(FROM_HERE, std::move(quit_closure_));
+  }
+
+  void OnWebSocketRequest(int connection_id,
+                          const HttpServerRequestInfo& info) override {}
+  void OnWebSocketMessage(int connection_id, std::string data) override {}
+  void OnClose(int connection_id) override {}
+
+ private:
+  const scoped_refptr<base::SingleThreadTaskRunner> main_task_runner_;
+  ShardedHttpServer* server_ = nullptr;
+  bool respond_on_shard_ = true;
+
+  base::Lock lock_;
+  std::vector<int> request_ids_ GUARDED_BY(lock_);
+  std::set<base::PlatformThreadId> request_threads_ GUARDED_BY(lock_);
+  size_t quit_after_request_count_ GUARDED_BY(lock_) = 0;
+  base::OnceClosure quit_closure_ GUARDED_BY(lock_);
+};
+
+class ShardedHttpServerTest : public TestWithTaskEnvironment {
+ public:
+  void CreateServer(size_t num_shards) {
+    std::unique_ptr<TCPSocket> listen_socket = CreateListenSocket();
+    ASSERT_TRUE(listen_socket);
+    server_ = std::make_unique<ShardedHttpServer>(std::move(listen_socket),
+                                                  num_shards, &delegate_);
+    delegate_.set_server(server_.get());
+    ASSERT_THAT(server_->GetLocalAddress(&server_address_), IsOk());
+  }
+
+  void TearDown() override { server_.reset(); }
+
+ protected:
+  TestDelegate delegate_;
+  std::unique_ptr<ShardedHttpServer> server_;
+  IPEndPoint server_address_;
+};
+
+TEST_F(ShardedHttpServerTest, ConnectionsAreSpreadOverShards) {
+  const size_t kNumShards = 3;
+  const size_t kNumClients = 6;
+  CreateServer(kNumShards);
+
+  std::vector<TestHttpClient> clients(kNumClients);
+  for (size_t i = 0; i < kNumClients; ++i) {
+    ASSERT_THAT(clients[i].ConnectAndWait(server_address_), IsOk());
+    clients[i].Send("GET /" + std::to_string(i) + " HTTP/1.1\r\n\r\n");
+  }
+  for (size_t i = 0; i < kNumClients; ++i) {
+    std::string body = "shard response /" + std::to_string(i);
+    std::string response = clients[i].ReadUntil(body);
+    EXPECT_THAT(response, testing::StartsWith("HTTP/1.1 200 OK"));
+    EXPECT_THAT(response, testing::EndsWith(body));
+  }
+
+  delegate_.WaitForRequests(kNumClients);
+  EXPECT_EQ(kNumShards, delegate_.request_threads().size());
+  EXPECT_EQ(0u, delegate_.request_threads().count(
+                    base::PlatformThread::CurrentId()));
+
+  // Connection ids are unique across shards.
+  std::vector<int> ids = delegate_.request_ids();
+  EXPECT_EQ(kNumClients, std::set<int>(ids.begin(), ids.end()).size());
+}
+
+TEST_F(ShardedHttpServerTest, RespondFromAnotherThread) {
+  CreateServer(2);
+  delegate_.set_respond_on_shard(false);
+
+  TestHttpClient client;
+  ASSERT_THAT(client.ConnectAndWait(server_address_), IsOk());
+  client.Send("GET /test HTTP/1.1\r\n\r\n");
+  delegate_.WaitForRequests(1);
+
+  server_->Send200(delegate_.request_ids()[0], "from main", "text/plain",
+                   TRAFFIC_ANNOTATION_FOR_TESTS);
+  std::string response = client.ReadUntil("from main");
+  EXPECT_THAT(response, testing::StartsWith("HTTP/1.1 200 OK"));
+  EXPECT_THAT(response, testing::EndsWith("from main"));
+
+  // Closing an unknown id on any shard is harmless.
+  server_->Close(delegate_.request_ids()[0] + 2 * 1000);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,467 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/static_file_responder.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/task_runner.h"
+#include "base/time/time.h"
+#include "net/base/escape.h"
+#include "net/base/file_stream.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mime_util.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_status_code.h"
+#include "net/http/http_util.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+
+namespace net {
+
+namespace {
+
+constexpr base::TimeDelta kCacheEntryLifetime = base::TimeDelta::FromSeconds(2);
+const size_t kMaxCachedFiles = 64;
+
+const int kFileOpenFlags =
+    base::File::FLAG_OPEN | base::File::FLAG_READ | base::File::FLAG_ASYNC;
+
+// Formats |time| as an HTTP-date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string FormatHttpDate(base::Time time) {
+  static const char* const kWeekdays[] = {"Sun", "Mon", "Tue", "Wed",
+                                          "Thu", "Fri", "Sat"};
+  static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr",
+                                        "May", "Jun", "Jul", "Aug",
+                                        "Sep", "Oct", "Nov", "Dec"};
+  base::Time::Exploded exploded;
+  time.UTCExplode(&exploded);
+  return base::StringPrintf(
+      "%s, %02d %s %04d %02d:%02d:%02d GMT", kWeekdays[exploded.day_of_week],
+      exploded.day_of_month, kMonths[exploded.month - 1], exploded.year,
+      exploded.hour, exploded.minute, exploded.second);
+}
+
+// Whether |entity_tags|, the value of an If-None-Match header, matches
+// |etag| with the weak comparison of RFC 7232 section 2.3.2.
+bool MatchesEntityTag(const std::string& entity_tags, const std::string& etag) {
+  for (base::StringPiece tag :
+       base::SplitStringPiece(entity_tags, ",", base::TRIM_WHITESPACE,
+                              base::SPLIT_WANT_NONEMPTY)) {
+    if (tag == "*")
+      return true;
+    if (base::StartsWith(tag, "W/", base::CompareCase::SENSITIVE))
+      tag.remove_prefix(2);
+    if (tag == etag)
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+// An open file and its metadata, shared by the responses that send it.
+class StaticFileResponder::CachedFile
+    : public base::RefCounted<StaticFileResponder::CachedFile> {
+ public:
+  CachedFile(const base::FilePath& path,
+             std::unique_ptr<FileStream> stream,
+             const base::File::Info& info)
+      : path_(path),
+        stream_(std::move(stream)),
+        size_(info.size),
+        // HTTP dates have a resolution of seconds.
+        last_modified_(base::Time::FromTimeT(info.last_modified.ToTimeT())),
+        last_modified_string_(FormatHttpDate(last_modified_)),
+        etag_(base::StringPrintf(
+            "\"%" PRIx64 "-%" PRIx64 "\"", static_cast<uint64_t>(info.size),
+            static_cast<uint64_t>(info.last_modified.ToDeltaSinceWindowsEpoch()
+                                      .InMicroseconds()))),
+        expiry_(base::TimeTicks::Now() + kCacheEntryLifetime) {}
+
+  const base::FilePath& path() const { return path_; }
+  // No operations are started on the stream once it is cached, so its file
+  // can be used by any number of responses at once.
+  base::PlatformFile platform_file() const {
+    return stream_->GetPlatformFile();
+  }
+  int64_t size() const { return size_; }
+  base::Time last_modified() const { return last_modified_; }
+  const std::string& last_modified_string() const {
+    return last_modified_string_;
+  }
+  const std::string& etag() const { return etag_; }
+  base::TimeTicks expiry() const { return expiry_; }
+
+ private:
+  friend class base::RefCounted<CachedFile>;
+  ~CachedFile() = default;
+
+  const base::FilePath path_;
+  const std::unique_ptr<FileStream> stream_;
+  const int64_t size_;
+  const base::Time last_modified_;
+  const std::string last_modified_string_;
+  const std::string etag_;
+  const base::TimeTicks expiry_;
+
+  DISALLOW_COPY_AND_ASSIGN(CachedFile);
+};
+
+// Opens a file that is not cached, and gets its metadata, on behalf of a
+// request for it.
+class StaticFileResponder::PendingOpen {
+ public:
+  PendingOpen(int connection_id,
+              const HttpServerRequestInfo& request,
+              const base::FilePath& path,
+              NetworkTrafficAnnotationTag traffic_annotation,
+              const scoped_refptr<base::TaskRunner>& file_task_runner)
+      : connection_id_(connection_id),
+        request_(request),
+        path_(path),
+        traffic_annotation_(traffic_annotation),
+        stream_(std::make_unique<FileStream>(file_task_runner)) {}
+
+  // Returns ERR_IO_PENDING and runs |callback| once done, or fails
+  // synchronously.
+  int Start(CompletionOnceCallback callback) {
+    int rv = stream_->Open(
+        path_, kFileOpenFlags,
+        base::BindOnce(&PendingOpen::OnOpened, base::Unretained(this)));
+    if (rv == ERR_IO_PENDING)
+      callback_ = std::move(callback);
+    return rv;
+  }
+
+  int connection_id() const { return connection_id_; }
+  const HttpServerRequestInfo& request() const { return request_; }
+  const base::FilePath& path() const { return path_; }
+  NetworkTrafficAnnotationTag traffic_annotation() const {
+    return traffic_annotation_;
+  }
+  const base::File::Info& info() const { return info_; }
+  std::unique_ptr<FileStream> TakeStream() { return std::move(stream_); }
+
+ private:
+  void OnOpened(int rv) {
+    if (rv == OK) {
+      rv = stream_->GetFileInfo(
+          &info_, base::BindOnce(&PendingOpen::OnGotFileInfo,
+                                 base::Unretained(this)));
+    }
+    if (rv != ERR_IO_PENDING)
+      std::move(callback_).Run(rv);
+  }
+
+  void OnGotFileInfo(int rv) { std::move(callback_).Run(rv); }
+
+  const int connection_id_;
+  const HttpServerRequestInfo request_;
+  const base::FilePath path_;
+  const NetworkTrafficAnnotationTag traffic_annotation_;
+  std::unique_ptr<FileStream> stream_;
+  base::File::Info info_;
+  CompletionOnceCallback callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingOpen);
+};
+
+// Supplies a range of a cached file as a response body. The range is offered
+// to the server to send straight from the file; if the socket can't do that,
+// it is read with a FileStream of the producer's own, as the cached file's
+// stream is shared.
+class StaticFileResponder::FileBodyProducer
+    : public HttpServer::ResponseBodyProducer {
+ public:
+  FileBodyProducer(scoped_refptr<CachedFile> file,
+                   int64_t offset,
+                   int64_t length,
+                   scoped_refptr<base::TaskRunner> file_task_runner)
+      : file_(std::move(file)),
+        offset_(offset),
+        remaining_(length),
+        file_task_runner_(std::move(file_task_runner)) {}
+  ~FileBodyProducer() override = default;
+
+  // HttpServer::ResponseBodyProducer implementation.
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override {
+    if (remaining_ == 0)
+      return 0;
+    read_buf_ = buf;
+    read_buf_len_ = static_cast<int>(
+        std::min(static_cast<int64_t>(buf_len), remaining_));
+    callback_ = std::move(callback);
+    int rv = stream_ ? ReadFile() : OpenFile();
+    if (rv != ERR_IO_PENDING)
+      callback_.Reset();
+    return rv;
+  }
+
+  bool GetNextFileRange(base::PlatformFile* file,
+                        int64_t* offset,
+                        int64_t* length) override {
+    if (remaining_ == 0 || stream_)
+      return false;
+    *file = file_->platform_file();
+    *offset = offset_;
+    *length = remaining_;
+    return true;
+  }
+
+  void DidSendFileRange(int64_t bytes) override {
+    DCHECK_LE(bytes, remaining_);
+    offset_ += bytes;
+    remaining_ -= bytes;
+  }
+
+ private:
+  int OpenFile() {
+    stream_ = std::make_unique<FileStream>(file_task_runner_);
+    return stream_->Open(file_->path(), kFileOpenFlags,
+                         base::BindOnce(&FileBodyProducer::OnOpened,
+                                        weak_ptr_factory_.GetWeakPtr()));
+  }
+
+  void OnOpened(int rv) {
+    if (rv == OK) {
+      rv = stream_->Seek(offset_,
+                         base::BindOnce(&FileBodyProducer::OnSeeked,
+                                        weak_ptr_factory_.GetWeakPtr()));
+    }
+    if (rv != ERR_IO_PENDING)
+      std::move(callback_).Run(rv);
+  }
+
+  void OnSeeked(int64_t rv) {
+    int result = rv < 0 ? static_cast<int>(rv) : ReadFile();
+    if (result != ERR_IO_PENDING)
+      std::move(callback_).Run(result);
+  }
+
+  int ReadFile() {
+    int rv = stream_->Read(read_buf_.get(), read_buf_len_,
+                           base::BindOnce(&FileBodyProducer::OnRead,
+                                          weak_ptr_factory_.GetWeakPtr()));
+    if (rv != ERR_IO_PENDING)
+      rv = HandleReadResult(rv);
+    return rv;
+  }
+
+  void OnRead(int rv) { std::move(callback_).Run(HandleReadResult(rv)); }
+
+  int HandleReadResult(int rv) {
+    read_buf_ = nullptr;
+    // The file has shrunk since it was cached.
+    if (rv == 0)
+      return ERR_CONTENT_LENGTH_MISMATCH;
+    if (rv > 0) {
+      offset_ += rv;
+      remaining_ -= rv;
+    }
+    return rv;
+  }
+
+  const scoped_refptr<CachedFile> file_;
+  int64_t offset_;
+  int64_t remaining_;
+  const scoped_refptr<base::TaskRunner> file_task_runner_;
+
+  // Only set once the body has to be read.
+  std::unique_ptr<FileStream> stream_;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_ = 0;
+  CompletionOnceCallback callback_;
+
+  base::WeakPtrFactory<FileBodyProducer> weak_ptr_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(FileBodyProducer);
+};
+
+StaticFileResponder::StaticFileResponder(
+    HttpServer* server,
+    const base::FilePath& root,
+    scoped_refptr<base::TaskRunner> file_task_runner)
+    : server_(server),
+      root_(root),
+      file_task_runner_(std::move(file_task_runner)),
+      file_cache_(kMaxCachedFiles) {
+  DCHECK(server_);
+}
+
+StaticFileResponder::~StaticFileResponder() = default;
+
+void StaticFileResponder::Respond(
+    int connection_id,
+    const HttpServerRequestInfo& request,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  if (request.method != "GET" && request.method != "HEAD") {
+    HttpServerResponseInfo response(HTTP_METHOD_NOT_ALLOWED);
+    response.AddHeader("Allow", "GET, HEAD");
+    response.AddHeader("Content-Length", "0");
+    server_->SendResponse(connection_id, response, traffic_annotation);
+    return;
+  }
+
+  base::FilePath path = GetFilePath(request.path);
+  if (path.empty()) {
+    server_->Send404(connection_id, traffic_annotation);
+    return;
+  }
+
+  auto it = file_cache_.Get(path);
+  if (it != file_cache_.end()) {
+    if (it->second->expiry() > base::TimeTicks::Now()) {
+      RespondWithFile(connection_id, request, it->second, traffic_annotation);
+      return;
+    }
+    file_cache_.Erase(it);
+  }
+
+  auto pending_open = std::make_unique<PendingOpen>(
+      connection_id, request, path, traffic_annotation, file_task_runner_);
+  PendingOpen* pending_open_ptr = pending_open.get();
+  pending_opens_[pending_open_ptr] = std::move(pending_open);
+  int rv = pending_open_ptr->Start(
+      base::BindOnce(&StaticFileResponder::OnFileOpened,
+                     base::Unretained(this), pending_open_ptr));
+  if (rv != ERR_IO_PENDING)
+    OnFileOpened(pending_open_ptr, rv);
+}
+
+base::FilePath StaticFileResponder::GetFilePath(
+    const std::string& path) const {
+  std::string escaped_path = path.substr(0, path.find_first_of("?#"));
+  std::string unescaped_path;
+  if (!base::StartsWith(escaped_path, "/", base::CompareCase::SENSITIVE) ||
+      !UnescapeBinaryURLComponentSafe(escaped_path,
+                                      false /* fail_on_path_separators */,
+                                      &unescaped_path)) {
+    return base::FilePath();
+  }
+  if (base::EndsWith(unescaped_path, "/", base::CompareCase::SENSITIVE))
+    unescaped_path += "index.html";
+
+  base::FilePath relative_path =
+      base::FilePath::FromUTF8Unsafe(unescaped_path.substr(1));
+  if (relative_path.empty() || relative_path.IsAbsolute() ||
+      relative_path.ReferencesParent()) {
+    return base::FilePath();
+  }
+  return root_.Append(relative_path);
+}
+
+void StaticFileResponder::OnFileOpened(PendingOpen* pending_open_ptr,
+                                       int rv) {
+  auto it = pending_opens_.find(pending_open_ptr);
+  DCHECK(it != pending_opens_.end());
+  std::unique_ptr<PendingOpen> pending_open = std::move(it->second);
+  pending_opens_.erase(it);
+
+  if (rv != OK || pending_open->info().is_directory) {
+    server_->Send404(pending_open->connection_id(),
+                     pending_open->traffic_annotation());
+    return;
+  }
+
+  auto file = base::MakeRefCounted<CachedFile>(
+      pending_open->path(), pending_open->TakeStream(), pending_open->info());
+  file_cache_.Put(file->path(), file);
+  RespondWithFile(pending_open->connection_id(), pending_open->request(), file,
+                  pending_open->traffic_annotation());
+}
+
+void StaticFileResponder::RespondWithFile(
+    int connection_id,
+    const HttpServerRequestInfo& request,
+    const scoped_refptr<CachedFile>& file,
+    NetworkTrafficAnnotationTag traffic_annotation) {
+  // See RFC 7232 section 6 for the order in which preconditions are checked.
+  bool not_modified = false;
+  base::Time if_modified_since;
+  if (request.headers.count("if-none-match")) {
+    not_modified =
+        MatchesEntityTag(request.GetHeaderValue("if-none-match"), file->etag());
+  } else if (base::Time::FromString(
+                 request.GetHeaderValue("if-modified-since").c_str(),
+                 &if_modified_since)) {
+    not_modified = file->last_modified() <= if_modified_since;
+  }
+
+  int64_t offset = 0;
+  int64_t length = file->size();
+  HttpStatusCode status_code = not_modified ? HTTP_NOT_MODIFIED : HTTP_OK;
+  std::string content_range;
+  std::vector<HttpByteRange> ranges;
+  // If-Range must match the validator exactly, and an entity tag strongly.
+  std::string if_range = request.GetHeaderValue("if-range");
+  if (!not_modified &&
+      (if_range.empty() || if_range == file->etag() ||
+       if_range == file->last_modified_string()) &&
+      HttpUtil::ParseRangeHeader(request.GetHeaderValue("range"), &ranges) &&
+      ranges.size() == 1) {
+    // Requests for several ranges get the whole file, which RFC 7233 allows.
+    HttpByteRange range = ranges[0];
+    if (!range.ComputeBounds(file->size()) ||
+        range.last_byte_position() < range.first_byte_position()) {
+      HttpServerResponseInfo response(HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+      response.AddHeader("Content-Range",
+                         base::StringPrintf("bytes */%" PRId64, file->size()));
+      response.AddHeader("Content-Length", "0");
+      server_->SendResponse(connection_id, response, traffic_annotation);
+      return;
+    }
+    offset = range.first_byte_position();
+    length = range.last_byte_position() - offset + 1;
+    status_code = HTTP_PARTIAL_CONTENT;
+    content_range = base::StringPrintf(
+        "bytes %" PRId64 "-%" PRId64 "/%" PRId64, offset,
+        range.last_byte_position(), file->size());
+  }
+
+  HttpServerResponseInfo response(status_code);
+  response.AddHeader("ETag", file->etag());
+  response.AddHeader("Last-Modified", file->last_modified_string());
+  response.AddHeader("Cache-Control", cache_control_);
+  if (not_modified) {
+    server_->SendResponse(connection_id, response, traffic_annotation);
+    return;
+  }
+
+  std::string mime_type = "application/octet-stream";
+  base::FilePath::StringType extension = file->path().Extension();
+  if (!extension.empty())
+    GetWellKnownMimeTypeFromExtension(extension.substr(1), &mime_type);
+  response.AddHeader("Accept-Ranges", "bytes");
+  if (!content_range.empty())
+    response.AddHeader("Content-Range", content_range);
+  response.SetContentHeaders(static_cast<size_t>(length), mime_type);
+
+  if (request.method == "HEAD") {
+    server_->SendResponse(connection_id, response, traffic_annotation);
+    return;
+  }
+  server_->SendStreamingResponse(
+      connection_id, response,
+      std::make_unique<FileBodyProducer>(file, offset, length,
+                                         file_task_runner_),
+      traffic_annotation);
+}
+
+}  // namespace net
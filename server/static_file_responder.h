@@ -0,0 +1,93 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SERVER_STATIC_FILE_RESPONDER_H_
+#define NET_SERVER_STATIC_FILE_RESPONDER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace base {
+class TaskRunner;
+}
+
+namespace net {
+
+class HttpServer;
+class HttpServerRequestInfo;
+
+// Responds to GET and HEAD requests on an HttpServer with the files under a
+// directory, for serving static assets such as an embedded UI.
+//
+// Responses carry an ETag and a Last-Modified date, and conditional requests
+// that they validate get a 304. Single byte ranges are served as 206 partial
+// responses. File bodies are sent from the file to the socket with
+// StreamSocket::SendFile() if the server was created with
+// |send_files_directly| and the socket supports it, and are otherwise read
+// with FileStream, so they are never held in memory as a whole. As with
+// HttpServer::SendStreamingResponse(), that requires an HTTP/1.1 connection.
+//
+// Opened files and their metadata are cached for a couple of seconds, so that
+// frequently requested files are not reopened for every request. Changes to a
+// file are picked up once its cache entry expires.
+class StaticFileResponder {
+ public:
+  // Serves the files under |root| on |server|, which must outlive this.
+  // |file_task_runner| is used for opening files and, when they can't be sent
+  // directly, reading them.
+  StaticFileResponder(HttpServer* server,
+                      const base::FilePath& root,
+                      scoped_refptr<base::TaskRunner> file_task_runner);
+  ~StaticFileResponder();
+
+  // Responds to |request|, which arrived on |connection_id|, e.g. from
+  // HttpServer::Delegate::OnHttpRequest(). Paths that name a directory, or
+  // that would lead outside |root|, get a 404. The response may be sent
+  // asynchronously.
+  void Respond(int connection_id,
+               const HttpServerRequestInfo& request,
+               NetworkTrafficAnnotationTag traffic_annotation);
+
+  // The value of the Cache-Control header sent with files. Defaults to
+  // "no-cache", so that clients always revalidate them.
+  void set_cache_control(const std::string& cache_control) {
+    cache_control_ = cache_control;
+  }
+
+ private:
+  class CachedFile;
+  class FileBodyProducer;
+  class PendingOpen;
+
+  // Returns the file under |root_| that |path| names, or an empty path if it
+  // names none.
+  base::FilePath GetFilePath(const std::string& path) const;
+
+  void OnFileOpened(PendingOpen* pending_open, int rv);
+  void RespondWithFile(int connection_id,
+                       const HttpServerRequestInfo& request,
+                       const scoped_refptr<CachedFile>& file,
+                       NetworkTrafficAnnotationTag traffic_annotation);
+
+  HttpServer* const server_;
+  const base::FilePath root_;
+  const scoped_refptr<base::TaskRunner> file_task_runner_;
+  std::string cache_control_ = "no-cache";
+
+  base::MRUCache<base::FilePath, scoped_refptr<CachedFile>> file_cache_;
+  std::map<PendingOpen*, std::unique_ptr<PendingOpen>> pending_opens_;
+
+  DISALLOW_COPY_AND_ASSIGN(StaticFileResponder);
+};
+
+}  // namespace net
+
+#endif  // NET_SERVER_STATIC_FILE_RESPONDER_H_
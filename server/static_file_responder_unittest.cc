@@ -0,0 +1,275 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/server/static_file_responder.h"
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/thread_pool.h"
+#include "net/base/ip_address.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_util.h"
+#include "net/log/net_log_source.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_test_util.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/test/gtest_util.h"
+#include "net/test/test_with_task_environment.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using net::test::IsOk;
+
+namespace net {
+
+namespace {
+
+const char kFileContents[] = "0123456789abcdefghij";
+
+// A response, split into its headers and body.
+struct Response {
+  std::string headers;
+  std::string body;
+};
+
+// Finds the value of |name| in |headers|, as written by HttpServer.
+std::string GetHeader(const std::string& headers, const std::string& name) {
+  std::string prefix = "\r\n" + name + ":";
+  size_t pos = headers.find(prefix);
+  if (pos == std::string::npos)
+    return std::string();
+  pos += prefix.size();
+  return headers.substr(pos, headers.find("\r\n", pos) - pos);
+}
+
+// Parameterized on whether the server sends file ranges with
+// StreamSocket::SendFile(). If it doesn't, bodies are read through the
+// FileStream of the responder's FileBodyProducer instead.
+class StaticFileResponderTest : public TestWithTaskEnvironment,
+                                public HttpServer::Delegate,
+                                public testing::WithParamInterface<bool> {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    WriteFile("file.txt", kFileContents);
+    ASSERT_TRUE(base::CreateDirectory(temp_dir_.GetPath().AppendASCII("dir")));
+    WriteFile("dir/index.html", "<html></html>");
+
+    auto server_socket =
+        std::make_unique<TCPServerSocket>(nullptr, NetLogSource());
+    server_socket->ListenWithAddressAndPort("127.0.0.1", 0, 1);
+    server_ = std::make_unique<HttpServer>(
+        std::move(server_socket), this, /*send_files_directly=*/GetParam());
+    ASSERT_THAT(server_->GetLocalAddress(&server_address_), IsOk());
+    responder_ = std::make_unique<StaticFileResponder>(
+        server_.get(), temp_dir_.GetPath(),
+        base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock()}));
+    ASSERT_THAT(client_.ConnectAndWait(server_address_), IsOk());
+  }
+
+  void WriteFile(const std::string& relative_path, const std::string& data) {
+    ASSERT_EQ(static_cast<int>(data.size()),
+              base::WriteFile(temp_dir_.GetPath().AppendASCII(relative_path),
+                              data.data(), data.size()));
+  }
+
+  // Sends |request| and reads the response to it, whose body is as long as
+  // its Content-Length header says, unless |head| is set.
+  Response Fetch(const std::string& request, bool head = false) {
+    client_.Send(request);
+    std::string message;
+    if (!client_.ReadResponse(&message, head))
+      return Response();
+
+    size_t headers_end =
+        HttpUtil::LocateEndOfHeaders(message.data(), message.size());
+    Response response;
+    response.headers = message.substr(0, headers_end);
+    response.body = message.substr(headers_end);
+    return response;
+  }
+
+  void TearDown() override {
+    responder_.reset();
+    server_.reset();
+    // Let the file streams close on the thread pool.
+    RunUntilIdle();
+  }
+
+  // HttpServer::Delegate implementation.
+  void OnConnect(int connection_id) override {}
+  void OnHttpRequest(int connection_id,
+                     const HttpServerRequestInfo& info) override {
+    responder_->Respond(connection_id, info, TRAFFIC_ANNOTATION_FOR_TESTS);
+  }
+  void OnWebSocketRequest(int connection_id,
+                          const HttpServerRequestInfo& info) override {}
+  void OnWebSocketMessage(int connection_id, std::string data) override {}
+  void OnClose(int connection_id) override {}
+
+ protected:
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<HttpServer> server_;
+  std::unique_ptr<StaticFileResponder> responder_;
+  IPEndPoint server_address_;
+  TestHttpClient client_;
+};
+
+INSTANTIATE_TEST_SUITE_P(All, StaticFileResponderTest, testing::Bool());
+
+TEST_P(StaticFileResponderTest, ServesFile) {
+  Response response = Fetch("GET /file.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ("text/plain", GetHeader(response.headers, "Content-Type"));
+  EXPECT_EQ("bytes", GetHeader(response.headers, "Accept-Ranges"));
+  EXPECT_EQ("no-cache", GetHeader(response.headers, "Cache-Control"));
+  EXPECT_FALSE(GetHeader(response.headers, "ETag").empty());
+  EXPECT_FALSE(GetHeader(response.headers, "Last-Modified").empty());
+  EXPECT_EQ(kFileContents, response.body);
+
+  // The second request is served from the cached file.
+  response = Fetch("GET /file.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(kFileContents, response.body);
+}
+
+TEST_P(StaticFileResponderTest, ServesIndex) {
+  Response response = Fetch("GET /dir/ HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ("text/html", GetHeader(response.headers, "Content-Type"));
+  EXPECT_EQ("<html></html>", response.body);
+}
+
+TEST_P(StaticFileResponderTest, Head) {
+  Response response =
+      Fetch("HEAD /file.txt HTTP/1.1\r\n\r\n", true /* head */);
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(base::NumberToString(strlen(kFileContents)),
+            GetHeader(response.headers, "Content-Length"));
+
+  // Nothing but headers was sent, so the connection is still usable.
+  response = Fetch("GET /file.txt HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(kFileContents, response.body);
+}
+
+TEST_P(StaticFileResponderTest, NotModified) {
+  Response response = Fetch("GET /file.txt HTTP/1.1\r\n\r\n");
+  std::string etag = GetHeader(response.headers, "ETag");
+  std::string last_modified = GetHeader(response.headers, "Last-Modified");
+
+  response =
+      Fetch("GET /file.txt HTTP/1.1\r\nIf-None-Match: " + etag + "\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 304 Not Modified\r\n"));
+  EXPECT_EQ(etag, GetHeader(response.headers, "ETag"));
+  EXPECT_TRUE(response.body.empty());
+
+  response = Fetch("GET /file.txt HTTP/1.1\r\nIf-None-Match: W/" + etag +
+                   "\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 304 Not Modified\r\n"));
+
+  response = Fetch("GET /file.txt HTTP/1.1\r\nIf-Modified-Since: " +
+                   last_modified + "\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 304 Not Modified\r\n"));
+
+  response =
+      Fetch("GET /file.txt HTTP/1.1\r\nIf-None-Match: \"other\"\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(kFileContents, response.body);
+}
+
+TEST_P(StaticFileResponderTest, Range) {
+  Response response =
+      Fetch("GET /file.txt HTTP/1.1\r\nRange: bytes=5-9\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 206 Partial Content\r\n"));
+  EXPECT_EQ("bytes 5-9/20", GetHeader(response.headers, "Content-Range"));
+  EXPECT_EQ("56789", response.body);
+
+  response = Fetch("GET /file.txt HTTP/1.1\r\nRange: bytes=-3\r\n\r\n");
+  EXPECT_EQ("bytes 17-19/20", GetHeader(response.headers, "Content-Range"));
+  EXPECT_EQ("hij", response.body);
+
+  // A stale If-Range gets the whole file.
+  response = Fetch(
+      "GET /file.txt HTTP/1.1\r\nRange: bytes=5-9\r\n"
+      "If-Range: \"stale\"\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(kFileContents, response.body);
+}
+
+// A range that takes several reads, or SendFile() calls, to send.
+TEST_P(StaticFileResponderTest, LargeRange) {
+  std::string contents;
+  for (int i = 0; contents.size() < 300 * 1024; ++i)
+    contents += base::NumberToString(i) + "\n";
+  WriteFile("large.txt", contents);
+
+  const size_t kOffset = 1000;
+  const size_t kLength = contents.size() - 2 * kOffset;
+  Response response = Fetch(
+      "GET /large.txt HTTP/1.1\r\nRange: bytes=" +
+      base::NumberToString(kOffset) + "-" +
+      base::NumberToString(kOffset + kLength - 1) + "\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 206 Partial Content\r\n"));
+  EXPECT_EQ(contents.substr(kOffset, kLength), response.body);
+
+  // The whole file, from the cache.
+  response = Fetch("GET /large.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(contents, response.body);
+}
+
+TEST_P(StaticFileResponderTest, UnsatisfiableRange) {
+  Response response =
+      Fetch("GET /file.txt HTTP/1.1\r\nRange: bytes=100-200\r\n\r\n");
+  EXPECT_THAT(
+      response.headers,
+      testing::StartsWith("HTTP/1.1 416 Requested Range Not Satisfiable\r\n"));
+  EXPECT_EQ("bytes */20", GetHeader(response.headers, "Content-Range"));
+  EXPECT_TRUE(response.body.empty());
+}
+
+TEST_P(StaticFileResponderTest, NotFound) {
+  Response response = Fetch("GET /missing.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 404 Not Found\r\n"));
+
+  response = Fetch("GET /dir HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 404 Not Found\r\n"));
+
+  response = Fetch("GET /dir/../../file.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 404 Not Found\r\n"));
+
+  response = Fetch("GET /%2e%2e/file.txt HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 404 Not Found\r\n"));
+}
+
+TEST_P(StaticFileResponderTest, MethodNotAllowed) {
+  Response response =
+      Fetch("POST /file.txt HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+  EXPECT_THAT(response.headers,
+              testing::StartsWith("HTTP/1.1 405 Method Not Allowed\r\n"));
+  EXPECT_EQ("GET, HEAD", GetHeader(response.headers, "Allow"));
+}
+
+}  // namespace
+
+}  // namespace net
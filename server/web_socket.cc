@@ -128,9 +128,21 @@ void WebSocket::Send(base::StringPiece message,
                      const NetworkTrafficAnnotationTag traffic_annotation) {
   if (closed_)
     return;
-  std::string encoded;
-  encoder_->EncodeFrame(message, 0, &encoded);
-  server_->SendRaw(connection_->id(), encoded, traffic_annotation);
+  encoder_->EncodeFrame(message, 0, &send_buffer_);
+  server_->SendRaw(connection_->id(), send_buffer_, traffic_annotation);
+}
+
+void WebSocket::SendFragment(
+    base::StringPiece fragment,
+    bool final,
+    const NetworkTrafficAnnotationTag traffic_annotation) {
+  if (closed_)
+    return;
+  if (!encoder_->EncodeFragment(fragment, final, 0, &send_buffer_)) {
+    Fail();
+    return;
+  }
+  server_->SendRaw(connection_->id(), send_buffer_, traffic_annotation);
 }
 
 void WebSocket::Fail() {
@@ -35,6 +35,11 @@ class WebSocket final {
   ParseResult Read(std::string* message);
   void Send(base::StringPiece message,
             const NetworkTrafficAnnotationTag traffic_annotation);
+  // Sends |fragment| as part of a message that is streamed in several frames,
+  // the last of which has |final| set.
+  void SendFragment(base::StringPiece fragment,
+                    bool final,
+                    const NetworkTrafficAnnotationTag traffic_annotation);
   ~WebSocket();
 
  private:
@@ -45,6 +50,8 @@ class WebSocket final {
   HttpServer* const server_;
   HttpConnection* const connection_;
   std::unique_ptr<WebSocketEncoder> encoder_;
+  // Reused for every outgoing frame.
+  std::string send_buffer_;
   bool closed_;
 
   DISALLOW_COPY_AND_ASSIGN(WebSocket);
@@ -4,11 +4,14 @@
 
 #include "net/server/web_socket_encoder.h"
 
+#include <string.h>
+
 #include <limits>
 #include <utility>
 #include <vector>
 
 #include "base/check.h"
+#include "base/check_op.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/string_number_conversions.h"
 #include "net/base/io_buffer.h"
@@ -48,6 +51,7 @@ const size_t kMaxSingleBytePayloadLength = 125;
 const size_t kTwoBytePayloadLengthField = 126;
 const size_t kEightBytePayloadLengthField = 127;
 const size_t kMaskingKeyWidthInBytes = 4;
+const size_t kMaxFrameHeaderSize = 2 + 8 + kMaskingKeyWidthInBytes;
 
 WebSocket::ParseResult DecodeFrameHybi17(const base::StringPiece& frame,
                                          bool client_frame,
@@ -140,47 +144,54 @@ WebSocket::ParseResult DecodeFrameHybi17(const base::StringPiece& frame,
   return closed ? WebSocket::FRAME_CLOSE : WebSocket::FRAME_OK;
 }
 
-void EncodeFrameHybi17(base::StringPiece message,
-                       int masking_key,
+// Appends a frame carrying |payload| to |output|. The header is built in
+// place, so a frame is only ever copied once, into |output|.
+void EncodeFrameHybi17(base::StringPiece payload,
+                       OpCode op_code,
+                       bool final,
                        bool compressed,
+                       int masking_key,
                        std::string* output) {
-  std::vector<char> frame;
-  OpCode op_code = kOpCodeText;
-  size_t data_length = message.length();
+  char header[kMaxFrameHeaderSize];
+  size_t header_size = 0;
+  size_t data_length = payload.length();
 
-  int reserved1 = compressed ? kReserved1Bit : 0;
-  frame.push_back(kFinalBit | op_code | reserved1);
+  header[header_size++] = (final ? kFinalBit : 0) |
+                          (compressed ? kReserved1Bit : 0) | op_code;
   char mask_key_bit = masking_key != 0 ? kMaskBit : 0;
   if (data_length <= kMaxSingleBytePayloadLength) {
-    frame.push_back(static_cast<char>(data_length) | mask_key_bit);
+    header[header_size++] = static_cast<char>(data_length) | mask_key_bit;
   } else if (data_length <= 0xFFFF) {
-    frame.push_back(kTwoBytePayloadLengthField | mask_key_bit);
-    frame.push_back((data_length & 0xFF00) >> 8);
-    frame.push_back(data_length & 0xFF);
+    header[header_size++] = kTwoBytePayloadLengthField | mask_key_bit;
+    header[header_size++] = (data_length & 0xFF00) >> 8;
+    header[header_size++] = data_length & 0xFF;
   } else {
-    frame.push_back(kEightBytePayloadLengthField | mask_key_bit);
-    char extended_payload_length[8];
+    header[header_size++] = kEightBytePayloadLengthField | mask_key_bit;
     size_t remaining = data_length;
-    // Fill the length into extended_payload_length in the network byte order.
-    for (int i = 0; i < 8; ++i) {
-      extended_payload_length[7 - i] = remaining & 0xFF;
+    // Fill the length into the header in the network byte order.
+    for (int i = 7; i >= 0; --i) {
+      header[header_size + i] = remaining & 0xFF;
       remaining >>= 8;
     }
-    frame.insert(frame.end(), extended_payload_length,
-                 extended_payload_length + 8);
+    header_size += 8;
     DCHECK(!remaining);
   }
+  const char* mask_bytes = reinterpret_cast<char*>(&masking_key);
+  if (masking_key != 0) {
+    memcpy(header + header_size, mask_bytes, kMaskingKeyWidthInBytes);
+    header_size += kMaskingKeyWidthInBytes;
+  }
+  DCHECK_LE(header_size, kMaxFrameHeaderSize);
 
-  const char* data = const_cast<char*>(message.data());
+  output->reserve(output->size() + header_size + data_length);
+  output->append(header, header_size);
+  size_t payload_offset = output->size();
+  output->append(payload.data(), data_length);
   if (masking_key != 0) {
-    const char* mask_bytes = reinterpret_cast<char*>(&masking_key);
-    frame.insert(frame.end(), mask_bytes, mask_bytes + 4);
+    char* data = &(*output)[payload_offset];
     for (size_t i = 0; i < data_length; ++i)  // Mask the payload.
-      frame.push_back(data[i] ^ mask_bytes[i % kMaskingKeyWidthInBytes]);
-  } else {
-    frame.insert(frame.end(), data, data + data_length);
+      data[i] ^= mask_bytes[i % kMaskingKeyWidthInBytes];
   }
-  *output = std::string(frame.data(), frame.size());
 }
 
 }  // anonymous namespace
@@ -304,11 +315,43 @@ WebSocket::ParseResult WebSocketEncoder::DecodeFrame(
 void WebSocketEncoder::EncodeFrame(base::StringPiece frame,
                                    int masking_key,
                                    std::string* output) {
-  std::string compressed;
-  if (Deflate(frame, &compressed))
-    EncodeFrameHybi17(compressed, masking_key, true, output);
-  else
-    EncodeFrameHybi17(frame, masking_key, false, output);
+  DCHECK(!in_fragmented_message_);
+  output->clear();
+  if (Deflate(frame, true /* final */)) {
+    EncodeFrameHybi17(deflate_buffer_, kOpCodeText, true /* final */,
+                      true /* compressed */, masking_key, output);
+  } else {
+    EncodeFrameHybi17(frame, kOpCodeText, true /* final */,
+                      false /* compressed */, masking_key, output);
+  }
+}
+
+bool WebSocketEncoder::EncodeFragment(base::StringPiece fragment,
+                                      bool final,
+                                      int masking_key,
+                                      std::string* output) {
+  output->clear();
+  OpCode op_code = kOpCodeContinuation;
+  if (!in_fragmented_message_) {
+    op_code = kOpCodeText;
+    fragmented_message_compressed_ = deflate_enabled();
+  }
+  in_fragmented_message_ = !final;
+
+  if (!fragmented_message_compressed_) {
+    EncodeFrameHybi17(fragment, op_code, final, false /* compressed */,
+                      masking_key, output);
+    return true;
+  }
+  // Once the first fragment has been sent compressed, the rest of the message
+  // can't be sent any other way.
+  if (!Deflate(fragment, final))
+    return false;
+  // Only the first frame of a message carries the compression bit.
+  EncodeFrameHybi17(deflate_buffer_, op_code, final,
+                    op_code == kOpCodeText /* compressed */, masking_key,
+                    output);
+  return true;
 }
 
 bool WebSocketEncoder::Inflate(std::string* message) {
@@ -333,20 +376,19 @@ bool WebSocketEncoder::Inflate(std::string* message) {
   return true;
 }
 
-bool WebSocketEncoder::Deflate(base::StringPiece message, std::string* output) {
+bool WebSocketEncoder::Deflate(base::StringPiece message, bool final) {
   if (!deflater_)
     return false;
-  if (!deflater_->AddBytes(message.data(), message.length())) {
-    deflater_->Finish();
+  deflate_buffer_.clear();
+  bool ok = deflater_->AddBytes(message.data(), message.length());
+  if (!ok || final)
+    ok = deflater_->Finish() && ok;
+  if (!ok) {
+    // Drop whatever was produced, so that it doesn't leak into later messages.
+    deflater_->GetOutput(deflater_->CurrentOutputSize());
     return false;
   }
-  if (!deflater_->Finish())
-    return false;
-  scoped_refptr<IOBufferWithSize> buffer =
-      deflater_->GetOutput(deflater_->CurrentOutputSize());
-  if (!buffer.get())
-    return false;
-  *output = std::string(buffer->data(), buffer->size());
+  deflater_->AppendOutput(&deflate_buffer_);
   return true;
 }
 
@@ -38,9 +38,23 @@ class WebSocketEncoder final {
   WebSocket::ParseResult DecodeFrame(const base::StringPiece& frame,
                                      int* bytes_consumed,
                                      std::string* output);
+  // Replaces |output| with a frame carrying the text message |frame|,
+  // compressed if deflate was negotiated. Reusing |output| across calls
+  // avoids reallocating it for every message.
   void EncodeFrame(base::StringPiece frame,
                    int masking_key,
                    std::string* output);
+  // Like EncodeFrame(), but encodes |fragment| as one frame of a text message
+  // that is sent in several frames, the last of which has |final| set. A
+  // compressed message is compressed as it is streamed, so its fragments
+  // needn't be held in memory at once. Fragments of different messages must
+  // not be interleaved, nor may EncodeFrame() be called in the middle of a
+  // message. Returns false if the fragment can't be compressed, in which case
+  // the connection must be failed.
+  bool EncodeFragment(base::StringPiece fragment,
+                      bool final,
+                      int masking_key,
+                      std::string* output);
 
   bool deflate_enabled() const { return !!deflater_; }
 
@@ -55,12 +69,20 @@ class WebSocketEncoder final {
                    std::unique_ptr<WebSocketInflater> inflater);
 
   bool Inflate(std::string* message);
-  bool Deflate(base::StringPiece message, std::string* output);
+  // Compresses |message| into |deflate_buffer_|, finishing the compressed
+  // message if |final| is set.
+  bool Deflate(base::StringPiece message, bool final);
 
   Type type_;
   std::unique_ptr<WebSocketDeflater> deflater_;
   std::unique_ptr<WebSocketInflater> inflater_;
 
+  // Reused for the compressed payload of every outgoing frame.
+  std::string deflate_buffer_;
+
+  bool in_fragmented_message_ = false;
+  bool fragmented_message_compressed_ = false;
+
   DISALLOW_COPY_AND_ASSIGN(WebSocketEncoder);
 };
 
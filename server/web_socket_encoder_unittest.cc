@@ -4,12 +4,34 @@
 
 #include "net/server/web_socket_encoder.h"
 
+#include "base/stl_util.h"
+#include "net/base/io_buffer.h"
 #include "net/websockets/websocket_deflate_parameters.h"
 #include "net/websockets/websocket_extension.h"
+#include "net/websockets/websocket_inflater.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
 
+namespace {
+
+// Returns the payload of |frame|, an unmasked frame whose payload is shorter
+// than 64KB.
+std::string GetUnmaskedPayload(const std::string& frame) {
+  EXPECT_GE(frame.size(), 2u);
+  size_t length = frame[1] & 0x7F;
+  size_t header_size = 2;
+  if (length == 126) {
+    length = (static_cast<unsigned char>(frame[2]) << 8) |
+             static_cast<unsigned char>(frame[3]);
+    header_size += 2;
+  }
+  EXPECT_EQ(header_size + length, frame.size());
+  return frame.substr(header_size);
+}
+
+}  // namespace
+
 TEST(WebSocketEncoderHandshakeTest, EmptyRequestShouldBeRejected) {
   WebSocketDeflateParameters params;
   std::unique_ptr<WebSocketEncoder> server =
@@ -174,6 +196,42 @@ TEST_F(WebSocketEncoderTest, ServerToClient) {
       client_->DecodeFrame(std::string("abcde"), &bytes_consumed, &decoded));
 }
 
+TEST_F(WebSocketEncoderTest, ReuseOutput) {
+  std::string encoded;
+  std::string expected;
+  server_->EncodeFrame("a longer first message", 0, &encoded);
+  server_->EncodeFrame("second", 0, &encoded);
+  server_->EncodeFrame("second", 0, &expected);
+  EXPECT_EQ(expected, encoded);
+}
+
+TEST_F(WebSocketEncoderTest, FragmentedMessage) {
+  std::string first;
+  std::string middle;
+  std::string last;
+
+  EXPECT_TRUE(server_->EncodeFragment("Fragmented", false, 0, &first));
+  EXPECT_TRUE(server_->EncodeFragment(" text", false, 0, &middle));
+  EXPECT_TRUE(server_->EncodeFragment(" message", true, 0, &last));
+
+  // A text frame without FIN, then continuation frames, the last with FIN.
+  EXPECT_EQ(0x01, first[0]);
+  EXPECT_EQ(0x00, middle[0]);
+  EXPECT_EQ(static_cast<char>(0x80), last[0]);
+  EXPECT_EQ("Fragmented", GetUnmaskedPayload(first));
+  EXPECT_EQ(" text", GetUnmaskedPayload(middle));
+  EXPECT_EQ(" message", GetUnmaskedPayload(last));
+
+  // Whole messages can be sent again once the fragmented one is done.
+  std::string encoded;
+  int bytes_consumed;
+  std::string decoded;
+  server_->EncodeFrame("Whole", 0, &encoded);
+  EXPECT_EQ(WebSocket::FRAME_OK,
+            client_->DecodeFrame(encoded, &bytes_consumed, &decoded));
+  EXPECT_EQ("Whole", decoded);
+}
+
 TEST_F(WebSocketEncoderCompressionTest, ClientToServer) {
   std::string frame("CompressionCompressionCompressionCompression");
   int mask = 654321;
@@ -204,6 +262,60 @@ TEST_F(WebSocketEncoderCompressionTest, ServerToClient) {
   EXPECT_EQ((int)encoded.length(), bytes_consumed);
 }
 
+TEST_F(WebSocketEncoderCompressionTest, ContextTakeover) {
+  std::string frame("CompressionCompressionCompressionCompression");
+  std::string first;
+  std::string second;
+  int bytes_consumed;
+  std::string decoded;
+
+  // The second message refers back to the first one.
+  server_->EncodeFrame(frame, 0, &first);
+  server_->EncodeFrame(frame, 0, &second);
+  EXPECT_LT(second.length(), first.length());
+
+  EXPECT_EQ(WebSocket::FRAME_OK,
+            client_->DecodeFrame(first, &bytes_consumed, &decoded));
+  EXPECT_EQ(frame, decoded);
+  EXPECT_EQ(WebSocket::FRAME_OK,
+            client_->DecodeFrame(second, &bytes_consumed, &decoded));
+  EXPECT_EQ(frame, decoded);
+}
+
+TEST_F(WebSocketEncoderCompressionTest, FragmentedMessage) {
+  const char* const kFragments[] = {"{\"event\": \"Compression\", ",
+                                    "\"params\": \"CompressionCompression\", ",
+                                    "\"more\": \"Compression\"}"};
+  std::string message;
+  std::string compressed;
+  for (size_t i = 0; i < base::size(kFragments); ++i) {
+    bool final = i + 1 == base::size(kFragments);
+    std::string encoded;
+    ASSERT_TRUE(server_->EncodeFragment(kFragments[i], final, 0, &encoded));
+    // Only the first frame has RSV1 set.
+    char expected_first_byte =
+        static_cast<char>((final ? 0x80 : 0x00) | (i == 0 ? 0x41 : 0x00));
+    EXPECT_EQ(expected_first_byte, encoded[0]);
+    message += kFragments[i];
+    compressed += GetUnmaskedPayload(encoded);
+  }
+  EXPECT_LT(compressed.length(), message.length());
+
+  WebSocketInflater inflater;
+  ASSERT_TRUE(inflater.Initialize(15));
+  ASSERT_TRUE(inflater.AddBytes(compressed.data(), compressed.size()));
+  ASSERT_TRUE(inflater.Finish());
+  scoped_refptr<IOBufferWithSize> output =
+      inflater.GetOutput(inflater.CurrentOutputSize());
+  ASSERT_TRUE(output);
+  EXPECT_EQ(message, std::string(output->data(), output->size()));
+
+  // Whole messages can be sent again once the fragmented one is done.
+  std::string encoded;
+  server_->EncodeFrame("Compression", 0, &encoded);
+  EXPECT_EQ(static_cast<char>(0xC1), encoded[0]);
+}
+
 TEST_F(WebSocketEncoderCompressionTest, LongFrame) {
   int length = 1000000;
   std::string temp;
@@ -18,4 +18,9 @@ int Socket::CancelReadIfReady() {
   return ERR_READ_IF_READY_NOT_IMPLEMENTED;
 }
 
+int Socket::ReadBuffer(scoped_refptr<IOBuffer>* buf,
+                       CompletionOnceCallback callback) {
+  return ERR_READ_IF_READY_NOT_IMPLEMENTED;
+}
+
 }  // namespace net
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include "base/memory/scoped_refptr.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_export.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
@@ -53,6 +54,15 @@ class NET_EXPORT Socket {
   // is returned if ReadIfReady() is not supported.
   virtual int CancelReadIfReady();
 
+  // Like ReadIfReady(), but instead of copying into a caller-provided buffer,
+  // hands over a buffer of already received data in |*buf| and returns its
+  // size. The buffer may be shared with the socket, and must not be written
+  // to. Default implementation returns ERR_READ_IF_READY_NOT_IMPLEMENTED, in
+  // which case the caller should fall back to ReadIfReady() or Read(). A
+  // pending ReadBuffer() is canceled with CancelReadIfReady().
+  virtual int ReadBuffer(scoped_refptr<IOBuffer>* buf,
+                         CompletionOnceCallback callback);
+
   // Writes data, up to |buf_len| bytes, to the socket.  Note: data may be
   // written partially.  The number of bytes written is returned, or an error
   // is returned upon failure.  ERR_SOCKET_NOT_CONNECTED should be returned if
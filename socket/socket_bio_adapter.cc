@@ -114,23 +114,32 @@ int SocketBIOAdapter::BIORead(char* out, int len) {
   }
 
   if (read_result_ == 0) {
-    // Instantiate the read buffer and read from the socket. Although only |len|
-    // bytes were requested, intentionally read to the full buffer size. The SSL
-    // layer reads the record header and body in separate reads to avoid
-    // overreading, but issuing one is more efficient. SSL sockets are not
-    // reused after shutdown for non-SSL traffic, so overreading is fine.
     DCHECK(!read_buffer_);
     DCHECK_EQ(0, read_offset_);
-    read_buffer_ = base::MakeRefCounted<IOBuffer>(read_buffer_capacity_);
-    int result = socket_->ReadIfReady(
-        read_buffer_.get(), read_buffer_capacity_,
+    // If the socket already holds the data in a buffer of its own, as a proxy
+    // tunnel does, drain that buffer rather than a copy of it.
+    int result = socket_->ReadBuffer(
+        &read_buffer_,
         base::BindOnce(&SocketBIOAdapter::OnSocketReadIfReadyComplete,
                        weak_factory_.GetWeakPtr()));
-    if (result == ERR_IO_PENDING)
-      read_buffer_ = nullptr;
     if (result == ERR_READ_IF_READY_NOT_IMPLEMENTED) {
-      result = socket_->Read(read_buffer_.get(), read_buffer_capacity_,
-                             read_callback_);
+      // Instantiate the read buffer and read from the socket. Although only
+      // |len| bytes were requested, intentionally read to the full buffer
+      // size. The SSL layer reads the record header and body in separate
+      // reads to avoid overreading, but issuing one is more efficient. SSL
+      // sockets are not reused after shutdown for non-SSL traffic, so
+      // overreading is fine.
+      read_buffer_ = base::MakeRefCounted<IOBuffer>(read_buffer_capacity_);
+      result = socket_->ReadIfReady(
+          read_buffer_.get(), read_buffer_capacity_,
+          base::BindOnce(&SocketBIOAdapter::OnSocketReadIfReadyComplete,
+                         weak_factory_.GetWeakPtr()));
+      if (result == ERR_IO_PENDING)
+        read_buffer_ = nullptr;
+      if (result == ERR_READ_IF_READY_NOT_IMPLEMENTED) {
+        result = socket_->Read(read_buffer_.get(), read_buffer_capacity_,
+                               read_callback_);
+      }
     }
     if (result == ERR_IO_PENDING) {
       read_result_ = ERR_IO_PENDING;
@@ -26,7 +26,8 @@ class StreamSocket;
 //
 // For reading, SocketBIOAdapter maintains a buffer to pass to
 // StreamSocket::Read. Once that Read completes, BIO_read synchronously drains
-// the buffer and signals BIO_should_read once empty.
+// the buffer and signals BIO_should_read once empty. Sockets that implement
+// StreamSocket::ReadBuffer hand over their own buffer instead.
 //
 // For writing, SocketBIOAdapter maintains a ring buffer of data to be written
 // to the StreamSocket. BIO_write synchronously copies data into the buffer or
@@ -24,6 +24,10 @@
 #include "net/base/trace_constants.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include <sys/sendfile.h>
+#endif
+
 #if defined(OS_FUCHSIA)
 #include <poll.h>
 #include <sys/ioctl.h>
@@ -73,6 +77,8 @@ SocketPosix::SocketPosix()
       read_buf_len_(0),
       write_socket_watcher_(FROM_HERE),
       write_buf_len_(0),
+      send_file_(base::kInvalidPlatformFile),
+      send_file_offset_(0),
       waiting_connect_(false) {}
 
 SocketPosix::~SocketPosix() {
@@ -362,6 +368,37 @@ int SocketPosix::WaitForWrite(IOBuffer* buf,
   return ERR_IO_PENDING;
 }
 
+int SocketPosix::SendFile(base::PlatformFile file,
+                          int64_t offset,
+                          int len,
+                          CompletionOnceCallback callback) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!waiting_connect_);
+  CHECK(write_callback_.is_null());
+  // Synchronous operation not supported
+  DCHECK(!callback.is_null());
+  DCHECK_LT(0, len);
+  DCHECK_LE(0, offset);
+
+  int rv = DoSendFile(file, offset, len);
+  if (rv != ERR_IO_PENDING)
+    return rv;
+
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          socket_fd_, true, base::MessagePumpForIO::WATCH_WRITE,
+          &write_socket_watcher_, this)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on write";
+    return MapSystemError(errno);
+  }
+
+  send_file_ = file;
+  send_file_offset_ = offset;
+  write_buf_len_ = len;
+  write_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
 int SocketPosix::GetLocalAddress(SockaddrStorage* address) const {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(address);
@@ -529,8 +566,35 @@ int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
   return rv >= 0 ? rv : MapSystemError(errno);
 }
 
+int SocketPosix::DoSendFile(base::PlatformFile file,
+                            int64_t offset,
+                            int len) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  // |socket_fd_| is non-blocking, so sendfile() fails with EAGAIN, mapped to
+  // ERR_IO_PENDING, once the socket's send buffer is full. That only covers
+  // the socket side: sendfile() still reads |file| synchronously, so this
+  // thread blocks on disk I/O whenever the range isn't in the page cache.
+  // Unlike DoWrite(), there's no way to suppress SIGPIPE for a single call,
+  // so this relies on the embedder ignoring it, as Chromium does.
+  off_t file_offset = offset;
+  ssize_t rv = HANDLE_EINTR(sendfile(socket_fd_, file, &file_offset, len));
+  if (rv >= 0)
+    return static_cast<int>(rv);
+  // sendfile() doesn't support all kinds of files, and may not be supported
+  // by the kernel at all. Nothing has been sent in either case, so let the
+  // caller fall back to Write().
+  if (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)
+    return ERR_NOT_IMPLEMENTED;
+  return MapSystemError(errno);
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
 void SocketPosix::WriteCompleted() {
-  int rv = DoWrite(write_buf_.get(), write_buf_len_);
+  int rv = send_file_ != base::kInvalidPlatformFile
+               ? DoSendFile(send_file_, send_file_offset_, write_buf_len_)
+               : DoWrite(write_buf_.get(), write_buf_len_);
   if (rv == ERR_IO_PENDING)
     return;
 
@@ -538,6 +602,8 @@ void SocketPosix::WriteCompleted() {
   DCHECK(ok);
   write_buf_.reset();
   write_buf_len_ = 0;
+  send_file_ = base::kInvalidPlatformFile;
+  send_file_offset_ = 0;
   std::move(write_callback_).Run(rv);
 }
 
@@ -575,6 +641,8 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
   if (!write_callback_.is_null()) {
     write_buf_.reset();
     write_buf_len_ = 0;
+    send_file_ = base::kInvalidPlatformFile;
+    send_file_offset_ = 0;
     write_callback_.Reset();
   }
 
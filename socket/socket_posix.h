@@ -5,9 +5,12 @@
 #ifndef NET_SOCKET_SOCKET_POSIX_H_
 #define NET_SOCKET_SOCKET_POSIX_H_
 
+#include <stdint.h>
+
 #include <memory>
 
 #include "base/compiler_specific.h"
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_pump_for_io.h"
@@ -87,6 +90,16 @@ class NET_EXPORT_PRIVATE SocketPosix
   // It must not be called after Write() because Write() calls it internally.
   int WaitForWrite(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
 
+  // Sends up to |len| bytes of |file|, starting at |offset|, with sendfile(2).
+  // Returns ERR_NOT_IMPLEMENTED on platforms without sendfile(2) for sockets,
+  // and when |file| or the kernel doesn't support it. Otherwise behaves like
+  // Write(), and likewise can't be pending at the same time as one, except
+  // that reading |file| may block the calling thread on disk I/O.
+  int SendFile(base::PlatformFile file,
+               int64_t offset,
+               int len,
+               CompletionOnceCallback callback);
+
   int GetLocalAddress(SockaddrStorage* address) const;
   int GetPeerAddress(SockaddrStorage* address) const;
   void SetPeerAddress(const SockaddrStorage& address);
@@ -118,6 +131,7 @@ class NET_EXPORT_PRIVATE SocketPosix
   void ReadCompleted();
 
   int DoWrite(IOBuffer* buf, int buf_len);
+  int DoSendFile(base::PlatformFile file, int64_t offset, int len);
   void WriteCompleted();
 
   // |close_socket| indicates whether the socket should also be closed.
@@ -142,6 +156,10 @@ class NET_EXPORT_PRIVATE SocketPosix
   base::MessagePumpForIO::FdWatchController write_socket_watcher_;
   scoped_refptr<IOBuffer> write_buf_;
   int write_buf_len_;
+  // The file being sent by a pending SendFile(), in which case |write_buf_| is
+  // null and |write_buf_len_| is the number of bytes to send.
+  base::PlatformFile send_file_;
+  int64_t send_file_offset_;
   // External callback; called when write or connect is complete.
   CompletionOnceCallback write_callback_;
 
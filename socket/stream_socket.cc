@@ -5,6 +5,7 @@
 #include "net/socket/stream_socket.h"
 
 #include "base/notreached.h"
+#include "net/base/net_errors.h"
 
 namespace net {
 
@@ -27,4 +28,13 @@ int StreamSocket::ConfirmHandshake(CompletionOnceCallback callback) {
   return OK;
 }
 
+int StreamSocket::SendFile(
+    base::PlatformFile file,
+    int64_t offset,
+    int len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
 }  // namespace net
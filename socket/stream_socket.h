@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include "base/bind.h"
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_export.h"
@@ -24,6 +25,10 @@ class SSLCertRequestInfo;
 class SSLInfo;
 class SocketTag;
 
+// The most bytes callers should ask StreamSocket::SendFile() to send in one
+// call, to bound the time spent in each one.
+constexpr int kMaxSendFileSize = 1 << 20;  // 1MB
+
 class NET_EXPORT StreamSocket : public Socket {
  public:
   using BeforeConnectCallback = base::RepeatingCallback<int()>;
@@ -93,6 +98,21 @@ class NET_EXPORT StreamSocket : public Socket {
   // progress at a time.
   virtual int ConfirmHandshake(CompletionOnceCallback callback);
 
+  // Sends up to |len| bytes of |file|, starting at |offset|, directly from the
+  // file to the socket, without copying them through an IOBuffer. |file| must
+  // stay open until the operation completes. Otherwise behaves like Write(),
+  // except that the file is read synchronously: parts of it that are not in
+  // the page cache block the calling thread on disk I/O.
+  //
+  // Sockets that cannot do this, including all sockets that transform the
+  // data they send, return ERR_NOT_IMPLEMENTED synchronously without side
+  // effects, in which case the caller should fall back to Write().
+  virtual int SendFile(base::PlatformFile file,
+                       int64_t offset,
+                       int len,
+                       CompletionOnceCallback callback,
+                       const NetworkTrafficAnnotationTag& traffic_annotation);
+
   // Called to disconnect a socket.  Does nothing if the socket is already
   // disconnected.  After calling Disconnect it is possible to call Connect
   // again to establish a new connection.
@@ -192,6 +192,29 @@ int TCPClientSocket::ReadCommon(IOBuffer* buf,
   return result;
 }
 
+int TCPClientSocket::WriteCommon(
+    base::OnceCallback<int(CompletionOnceCallback)> start_write,
+    CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+  DCHECK(write_callback_.is_null());
+
+  if (was_disconnected_on_suspend_)
+    return ERR_NETWORK_IO_SUSPENDED;
+
+  // |socket_| is owned by this class and the callback won't be run once
+  // |socket_| is gone. Therefore, it is safe to use base::Unretained() here.
+  CompletionOnceCallback complete_write_callback = base::BindOnce(
+      &TCPClientSocket::DidCompleteWrite, base::Unretained(this));
+  int result = std::move(start_write).Run(std::move(complete_write_callback));
+  if (result == ERR_IO_PENDING) {
+    write_callback_ = std::move(callback);
+  } else if (result > 0) {
+    was_ever_used_ = true;
+  }
+
+  return result;
+}
+
 int TCPClientSocket::DoConnectLoop(int result) {
   DCHECK_NE(next_connect_state_, CONNECT_STATE_NONE);
 
@@ -420,25 +443,45 @@ int TCPClientSocket::Write(
     int buf_len,
     CompletionOnceCallback callback,
     const NetworkTrafficAnnotationTag& traffic_annotation) {
-  DCHECK(!callback.is_null());
-  DCHECK(write_callback_.is_null());
-
-  if (was_disconnected_on_suspend_)
-    return ERR_NETWORK_IO_SUSPENDED;
-
-  // |socket_| is owned by this class and the callback won't be run once
-  // |socket_| is gone. Therefore, it is safe to use base::Unretained() here.
-  CompletionOnceCallback complete_write_callback = base::BindOnce(
-      &TCPClientSocket::DidCompleteWrite, base::Unretained(this));
-  int result = socket_->Write(buf, buf_len, std::move(complete_write_callback),
-                              traffic_annotation);
-  if (result == ERR_IO_PENDING) {
-    write_callback_ = std::move(callback);
-  } else if (result > 0) {
-    was_ever_used_ = true;
-  }
-
-  return result;
+  // |socket_| is owned by this class, and |start_write| is run synchronously
+  // by WriteCommon(). Therefore, it is safe to use base::Unretained() here.
+  return WriteCommon(
+      base::BindOnce(
+          [](TCPSocket* socket, IOBuffer* buf, int buf_len,
+             const NetworkTrafficAnnotationTag& traffic_annotation,
+             CompletionOnceCallback complete_write_callback) {
+            return socket->Write(buf, buf_len,
+                                 std::move(complete_write_callback),
+                                 traffic_annotation);
+          },
+          base::Unretained(socket_.get()), base::Unretained(buf), buf_len,
+          traffic_annotation),
+      std::move(callback));
+}
+
+int TCPClientSocket::SendFile(
+    base::PlatformFile file,
+    int64_t offset,
+    int len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+#if defined(OS_WIN)
+  return ERR_NOT_IMPLEMENTED;
+#else
+  // See Write() for why base::Unretained() is safe here.
+  return WriteCommon(
+      base::BindOnce(
+          [](TCPSocket* socket, base::PlatformFile file, int64_t offset,
+             int len, const NetworkTrafficAnnotationTag& traffic_annotation,
+             CompletionOnceCallback complete_write_callback) {
+            return socket->SendFile(file, offset, len,
+                                    std::move(complete_write_callback),
+                                    traffic_annotation);
+          },
+          base::Unretained(socket_.get()), file, offset, len,
+          traffic_annotation),
+      std::move(callback));
+#endif  // defined(OS_WIN)
 }
 
 int TCPClientSocket::SetReceiveBufferSize(int32_t size) {
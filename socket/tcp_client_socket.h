@@ -114,6 +114,11 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int SendFile(base::PlatformFile file,
+               int64_t offset,
+               int len,
+               CompletionOnceCallback callback,
+               const NetworkTrafficAnnotationTag& traffic_annotation) override;
   int SetReceiveBufferSize(int32_t size) override;
   int SetSendBufferSize(int32_t size) override;
 
@@ -149,6 +154,12 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
                  const CompletionOnceCallback callback,
                  bool read_if_ready);
 
+  // A helper method shared by Write() and SendFile(). |start_write| starts the
+  // write on |socket_| and is passed the callback to complete it with.
+  int WriteCommon(
+      base::OnceCallback<int(CompletionOnceCallback)> start_write,
+      CompletionOnceCallback callback);
+
   // State machine used by Connect().
   int DoConnectLoop(int result);
   int DoConnect();
@@ -322,6 +322,25 @@ int TCPSocketPosix::Write(
   return rv;
 }
 
+int TCPSocketPosix::SendFile(
+    base::PlatformFile file,
+    int64_t offset,
+    int len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+
+  CompletionOnceCallback write_callback =
+      base::BindOnce(&TCPSocketPosix::WriteCompleted, base::Unretained(this),
+                     scoped_refptr<IOBuffer>(), std::move(callback));
+  int rv = socket_->SendFile(file, offset, len, std::move(write_callback));
+
+  if (rv != ERR_IO_PENDING && rv != ERR_NOT_IMPLEMENTED)
+    rv = HandleWriteCompleted(nullptr, rv);
+  return rv;
+}
+
 int TCPSocketPosix::GetLocalAddress(IPEndPoint* address) const {
   DCHECK(address);
 
@@ -620,8 +639,14 @@ int TCPSocketPosix::HandleWriteCompleted(IOBuffer* buf, int rv) {
   if (rv > 0)
     NotifySocketPerformanceWatcher();
 
-  net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_SENT, rv,
-                                buf->data());
+  if (buf) {
+    net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_SENT, rv,
+                                  buf->data());
+  } else {
+    // Data sent directly from a file was never in memory.
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKET_BYTES_SENT,
+                                   "byte_count", rv);
+  }
   NetworkActivityMonitor::GetInstance()->IncrementBytesSent(rv);
   return rv;
 }
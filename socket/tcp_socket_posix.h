@@ -11,6 +11,7 @@
 
 #include "base/callback.h"
 #include "base/compiler_specific.h"
+#include "base/files/platform_file.h"
 #include "base/macros.h"
 #include "net/base/address_family.h"
 #include "net/base/completion_once_callback.h"
@@ -98,6 +99,14 @@ class NET_EXPORT TCPSocketPosix {
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
 
+  // Sends up to |len| bytes of |file| starting at |offset| directly to the
+  // socket. See StreamSocket::SendFile().
+  int SendFile(base::PlatformFile file,
+               int64_t offset,
+               int len,
+               CompletionOnceCallback callback,
+               const NetworkTrafficAnnotationTag& traffic_annotation);
+
   // Copies the local tcp address into |address| and returns a net error code.
   int GetLocalAddress(IPEndPoint* address) const;
 
@@ -191,6 +200,7 @@ class NET_EXPORT TCPSocketPosix {
   void WriteCompleted(const scoped_refptr<IOBuffer>& buf,
                       CompletionOnceCallback callback,
                       int rv);
+  // |buf| is null for SendFile().
   int HandleWriteCompleted(IOBuffer* buf, int rv);
 
   // Notifies |socket_performance_watcher_| of the latest RTT estimate available
@@ -12,6 +12,10 @@
 #include <vector>
 
 #include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/memory/ref_counted.h"
 #include "base/test/bind_test_util.h"
 #include "base/time/time.h"
@@ -670,6 +674,101 @@ TEST_F(TCPSocketTest, IsConnected) {
   EXPECT_FALSE(connecting_socket.IsConnectedAndIdle());
 }
 
+// Tests that TCPClientSocket::SendFile() sends the requested range of the file
+// where sendfile(2) is available, and otherwise reports it isn't supported.
+TEST_F(TCPSocketTest, SendFile) {
+  const std::string kFileContents("skip this, then: test message");
+  const size_t kOffset = kFileContents.find("test");
+  const std::string kMessage = kFileContents.substr(kOffset);
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath file_path = temp_dir.GetPath().AppendASCII("upload");
+  ASSERT_EQ(static_cast<int>(kFileContents.size()),
+            base::WriteFile(file_path, kFileContents.data(),
+                            kFileContents.size()));
+  base::File file(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+
+  ASSERT_NO_FATAL_FAILURE(SetUpListenIPv4());
+
+  TestCompletionCallback accept_callback;
+  std::unique_ptr<TCPSocket> accepted_socket;
+  IPEndPoint accepted_address;
+  EXPECT_THAT(socket_.Accept(&accepted_socket, &accepted_address,
+                             accept_callback.callback()),
+              IsError(ERR_IO_PENDING));
+
+  TestCompletionCallback connect_callback;
+  TCPClientSocket connecting_socket(local_address_list(), nullptr, nullptr,
+                                    nullptr, NetLogSource());
+  int connect_result = connecting_socket.Connect(connect_callback.callback());
+  EXPECT_THAT(accept_callback.WaitForResult(), IsOk());
+  EXPECT_THAT(connect_callback.GetResult(connect_result), IsOk());
+
+  TestCompletionCallback send_callback;
+  int send_result = connecting_socket.SendFile(
+      file.GetPlatformFile(), kOffset, kMessage.size(),
+      send_callback.callback(), TRAFFIC_ANNOTATION_FOR_TESTS);
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  send_result = send_callback.GetResult(send_result);
+  ASSERT_GT(send_result, 0);
+  ASSERT_LE(static_cast<size_t>(send_result), kMessage.size());
+  EXPECT_TRUE(connecting_socket.WasEverUsed());
+
+  std::string received;
+  while (received.size() < static_cast<size_t>(send_result)) {
+    scoped_refptr<IOBufferWithSize> read_buffer =
+        base::MakeRefCounted<IOBufferWithSize>(send_result - received.size());
+    TestCompletionCallback read_callback;
+    int read_result = read_callback.GetResult(accepted_socket->Read(
+        read_buffer.get(), read_buffer->size(), read_callback.callback()));
+    ASSERT_GT(read_result, 0);
+    received.append(read_buffer->data(), read_result);
+  }
+  EXPECT_EQ(kMessage.substr(0, send_result), received);
+#else
+  EXPECT_THAT(send_result, IsError(ERR_NOT_IMPLEMENTED));
+  EXPECT_FALSE(connecting_socket.WasEverUsed());
+#endif
+}
+
+#if defined(OS_POSIX)
+// Tests that SendFile() fails with ERR_NOT_IMPLEMENTED, so callers fall back to
+// Write(), when the file can't be sent with sendfile(2).
+TEST_F(TCPSocketTest, SendFileUnsupportedFile) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  // sendfile(2) can't read from directories.
+  base::File file(temp_dir.GetPath(),
+                  base::File::FLAG_OPEN | base::File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+
+  ASSERT_NO_FATAL_FAILURE(SetUpListenIPv4());
+
+  TestCompletionCallback accept_callback;
+  std::unique_ptr<TCPSocket> accepted_socket;
+  IPEndPoint accepted_address;
+  EXPECT_THAT(socket_.Accept(&accepted_socket, &accepted_address,
+                             accept_callback.callback()),
+              IsError(ERR_IO_PENDING));
+
+  TestCompletionCallback connect_callback;
+  TCPClientSocket connecting_socket(local_address_list(), nullptr, nullptr,
+                                    nullptr, NetLogSource());
+  int connect_result = connecting_socket.Connect(connect_callback.callback());
+  EXPECT_THAT(accept_callback.WaitForResult(), IsOk());
+  EXPECT_THAT(connect_callback.GetResult(connect_result), IsOk());
+
+  TestCompletionCallback send_callback;
+  EXPECT_THAT(connecting_socket.SendFile(file.GetPlatformFile(), 0, 1,
+                                         send_callback.callback(),
+                                         TRAFFIC_ANNOTATION_FOR_TESTS),
+              IsError(ERR_NOT_IMPLEMENTED));
+  EXPECT_FALSE(connecting_socket.WasEverUsed());
+}
+#endif  // defined(OS_POSIX)
+
 // Tests that setting a socket option in the BeforeConnectCallback works. With
 // real sockets, socket options often have to be set before the connect() call,
 // and the BeforeConnectCallback is the only way to do that, with a
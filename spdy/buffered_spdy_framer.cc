@@ -327,6 +327,15 @@ uint32_t BufferedSpdyFramer::header_encoder_table_size() const {
   return spdy_framer_.header_encoder_table_size();
 }
 
+void BufferedSpdyFramer::EnableHeaderIndexingPolicy() {
+  // |header_indexing_policy_| outlives the encoder.
+  spdy_framer_.GetHpackEncoder()->SetIndexingPolicy(
+      [this](absl::string_view name, absl::string_view value) {
+        return header_indexing_policy_.ShouldIndex(
+            name, value, spdy_framer_.header_encoder_table_size());
+      });
+}
+
 size_t BufferedSpdyFramer::EstimateMemoryUsage() const {
   return base::trace_event::EstimateMemoryUsage(spdy_framer_) +
          base::trace_event::EstimateMemoryUsage(deframer_) +
@@ -335,6 +344,12 @@ size_t BufferedSpdyFramer::EstimateMemoryUsage() const {
          base::trace_event::EstimateMemoryUsage(goaway_fields_);
 }
 
+size_t BufferedSpdyFramer::EstimateHeaderCompressionMemoryUsage() const {
+  return base::trace_event::EstimateMemoryUsage(spdy_framer_) +
+         base::trace_event::EstimateMemoryUsage(deframer_) +
+         base::trace_event::EstimateMemoryUsage(coalescer_);
+}
+
 BufferedSpdyFramer::ControlFrameFields::ControlFrameFields() = default;
 
 size_t BufferedSpdyFramer::GoAwayFields::EstimateMemoryUsage() const {
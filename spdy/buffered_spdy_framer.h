@@ -17,6 +17,7 @@
 #include "net/base/net_export.h"
 #include "net/log/net_log_source.h"
 #include "net/spdy/header_coalescer.h"
+#include "net/spdy/header_indexing_policy.h"
 #include "net/third_party/quiche/src/spdy/core/http2_frame_decoder_adapter.h"
 #include "net/third_party/quiche/src/spdy/core/spdy_alt_svc_wire_format.h"
 #include "net/third_party/quiche/src/spdy/core/spdy_framer.h"
@@ -237,10 +238,20 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer
   // Returns the maximum size of the header encoder compression table.
   uint32_t header_encoder_table_size() const;
 
+  // Makes the header encoder only add fields to its compression table once
+  // they repeat, see HeaderIndexingPolicy.
+  void EnableHeaderIndexingPolicy();
+
   // Returns the estimate of dynamically allocated memory in bytes.
   size_t EstimateMemoryUsage() const;
 
+  // Returns the part of EstimateMemoryUsage() taken up by header compression
+  // and decompression state, that is the HPACK tables and decoder buffers.
+  size_t EstimateHeaderCompressionMemoryUsage() const;
+
  private:
+  // Declared before |spdy_framer_|, whose encoder refers to it.
+  HeaderIndexingPolicy header_indexing_policy_;
   spdy::SpdyFramer spdy_framer_;
   http2::Http2DecoderAdapter deframer_;
   BufferedSpdyFramerVisitorInterface* visitor_;
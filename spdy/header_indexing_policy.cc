@@ -0,0 +1,64 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/header_indexing_policy.h"
+
+#include <algorithm>
+
+#include "base/hash/hash.h"
+
+namespace net {
+
+namespace {
+
+// The per-entry overhead that HPACK adds to the size of each field in the
+// dynamic table, see RFC 7541 Section 4.1.
+const size_t kEntryOverhead = 32;
+
+// Fields larger than this fraction of the table are never indexed.
+const size_t kMaxEntryFractionOfTable = 4;
+
+}  // namespace
+
+HeaderIndexingPolicy::HeaderIndexingPolicy() = default;
+
+HeaderIndexingPolicy::~HeaderIndexingPolicy() = default;
+
+bool HeaderIndexingPolicy::ShouldIndex(absl::string_view name,
+                                       absl::string_view value,
+                                       size_t table_size) {
+  // As the HPACK encoder does by default, leave out pseudo-headers other
+  // than :authority. A session can carry requests for several authorities,
+  // with IP pooling, so :authority is indexed like any other field once it
+  // repeats.
+  if (name.empty())
+    return false;
+  if (name[0] == ':' && name != ":authority")
+    return false;
+
+  if (name.size() + value.size() + kEntryOverhead >
+      table_size / kMaxEntryFractionOfTable) {
+    return false;
+  }
+
+  uint32_t hash = static_cast<uint32_t>(
+      base::HashInts32(base::PersistentHash(name.data(), name.size()),
+                       base::PersistentHash(value.data(), value.size())));
+  // Keep zero free to mark unused slots.
+  if (hash == 0)
+    hash = 1;
+
+  auto it = std::find(recent_fields_.begin(), recent_fields_.end(), hash);
+  if (it != recent_fields_.end()) {
+    // Sent before, so likely to be sent again. Once indexed, the encoder
+    // no longer asks about it, so the slot can be reused.
+    *it = 0;
+    return true;
+  }
+  recent_fields_[next_recent_field_] = hash;
+  next_recent_field_ = (next_recent_field_ + 1) % kRecentFieldCount;
+  return false;
+}
+
+}  // namespace net
@@ -0,0 +1,49 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SPDY_HEADER_INDEXING_POLICY_H_
+#define NET_SPDY_HEADER_INDEXING_POLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+
+#include "base/macros.h"
+#include "net/base/net_export.h"
+#include "third_party/abseil-cpp/absl/strings/string_view.h"
+
+namespace net {
+
+// Decides which header fields the HPACK encoder of a session adds to its
+// dynamic table. A field is only indexed once it has been sent before, so
+// that values that never repeat, such as request ids, don't evict the fields
+// that would be reused from the table. Fields that would take up too much of
+// the table to share it with others are never indexed.
+class NET_EXPORT_PRIVATE HeaderIndexingPolicy {
+ public:
+  HeaderIndexingPolicy();
+  ~HeaderIndexingPolicy();
+
+  // Returns whether the field |name|: |value|, which is not in the dynamic
+  // table, should be added to it, given a table of |table_size| bytes.
+  bool ShouldIndex(absl::string_view name,
+                   absl::string_view value,
+                   size_t table_size);
+
+ private:
+  // The number of recently sent fields that are remembered.
+  static constexpr size_t kRecentFieldCount = 64;
+
+  // Hashes of recently sent fields that were not indexed, used as a ring
+  // buffer. Zero marks an unused slot.
+  std::array<uint32_t, kRecentFieldCount> recent_fields_ = {};
+  size_t next_recent_field_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(HeaderIndexingPolicy);
+};
+
+}  // namespace net
+
+#endif  // NET_SPDY_HEADER_INDEXING_POLICY_H_
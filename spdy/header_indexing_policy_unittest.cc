@@ -0,0 +1,59 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/header_indexing_policy.h"
+
+#include <string>
+
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const size_t kTableSize = 4096;
+
+TEST(HeaderIndexingPolicyTest, IndexesRepeatedFields) {
+  HeaderIndexingPolicy policy;
+  EXPECT_FALSE(policy.ShouldIndex("accept", "*/*", kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex("x-request-id", "1", kTableSize));
+  EXPECT_TRUE(policy.ShouldIndex("accept", "*/*", kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex("x-request-id", "2", kTableSize));
+}
+
+TEST(HeaderIndexingPolicyTest, PseudoHeaders) {
+  HeaderIndexingPolicy policy;
+  EXPECT_FALSE(policy.ShouldIndex(":authority", "www.example.org", kTableSize));
+  EXPECT_FALSE(
+      policy.ShouldIndex(":authority", "mail.example.org", kTableSize));
+  EXPECT_TRUE(policy.ShouldIndex(":authority", "www.example.org", kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex(":path", "/", kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex(":path", "/", kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex("", "value", kTableSize));
+}
+
+TEST(HeaderIndexingPolicyTest, LargeFieldsAreNotIndexed) {
+  HeaderIndexingPolicy policy;
+  const std::string large_value(kTableSize / 2, 'a');
+  EXPECT_FALSE(policy.ShouldIndex("cookie", large_value, kTableSize));
+  EXPECT_FALSE(policy.ShouldIndex("cookie", large_value, kTableSize));
+  // The same field fits in a larger table.
+  EXPECT_FALSE(policy.ShouldIndex("cookie", large_value, 4 * kTableSize));
+  EXPECT_TRUE(policy.ShouldIndex("cookie", large_value, 4 * kTableSize));
+}
+
+TEST(HeaderIndexingPolicyTest, ForgetsOldFields) {
+  HeaderIndexingPolicy policy;
+  EXPECT_FALSE(policy.ShouldIndex("accept", "*/*", kTableSize));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(policy.ShouldIndex("x-request-id", base::NumberToString(i),
+                                    kTableSize));
+  }
+  EXPECT_FALSE(policy.ShouldIndex("accept", "*/*", kTableSize));
+}
+
+}  // namespace
+
+}  // namespace net
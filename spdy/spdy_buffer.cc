@@ -39,14 +39,16 @@ std::unique_ptr<spdy::SpdySerializedFrame> MakeSpdySerializedFrame(
 }  // namespace
 
 // This class is an IOBuffer implementation that simply holds a
-// reference to a SharedFrame object and a fixed offset. Used by
-// SpdyBuffer::GetIOBufferForRemainingData().
+// reference to a SharedFrame object, the buffer it points into if any,
+// and a fixed offset. Used by SpdyBuffer::GetIOBufferForRemainingData().
 class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
  public:
   SharedFrameIOBuffer(const scoped_refptr<SharedFrame>& shared_frame,
+                      const scoped_refptr<IOBuffer>& backing_buffer,
                       size_t offset)
       : IOBuffer(shared_frame->data->data() + offset),
-        shared_frame_(shared_frame) {}
+        shared_frame_(shared_frame),
+        backing_buffer_(backing_buffer) {}
 
  private:
   ~SharedFrameIOBuffer() override {
@@ -55,6 +57,7 @@ class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
   }
 
   const scoped_refptr<SharedFrame> shared_frame_;
+  const scoped_refptr<IOBuffer> backing_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(SharedFrameIOBuffer);
 };
@@ -72,6 +75,20 @@ SpdyBuffer::SpdyBuffer(const char* data, size_t size) :
   shared_frame_->data = MakeSpdySerializedFrame(data, size);
 }
 
+SpdyBuffer::SpdyBuffer(scoped_refptr<IOBuffer> backing_buffer,
+                       const char* data,
+                       size_t size)
+    : shared_frame_(new SharedFrame()),
+      backing_buffer_(std::move(backing_buffer)),
+      offset_(0) {
+  DCHECK(backing_buffer_);
+  DCHECK(data);
+  CHECK_GT(size, 0u);
+  CHECK_LE(size, kMaxSpdyFrameSize);
+  shared_frame_->data = std::make_unique<spdy::SpdySerializedFrame>(
+      const_cast<char*>(data), size, false /* owns_buffer */);
+}
+
 SpdyBuffer::~SpdyBuffer() {
   if (GetRemainingSize() > 0)
     ConsumeHelper(GetRemainingSize(), DISCARD);
@@ -94,7 +111,8 @@ void SpdyBuffer::Consume(size_t consume_size) {
 }
 
 scoped_refptr<IOBuffer> SpdyBuffer::GetIOBufferForRemainingData() {
-  return base::MakeRefCounted<SharedFrameIOBuffer>(shared_frame_, offset_);
+  return base::MakeRefCounted<SharedFrameIOBuffer>(shared_frame_,
+                                                 backing_buffer_, offset_);
 }
 
 size_t SpdyBuffer::EstimateMemoryUsage() const {
@@ -56,6 +56,14 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   // non-NULL and |size| must be non-zero.
   SpdyBuffer(const char* data, size_t size);
 
+  // Construct without copying from |size| bytes at |data|, which must lie
+  // within |backing_buffer|. |backing_buffer| is kept alive for as long as
+  // this object or any IOBuffer returned by GetIOBufferForRemainingData()
+  // is, and must not be written to in the meantime.
+  SpdyBuffer(scoped_refptr<IOBuffer> backing_buffer,
+             const char* data,
+             size_t size);
+
   // If there are bytes remaining in the buffer, triggers a call to
   // any consume callbacks with a DISCARD source.
   ~SpdyBuffer();
@@ -100,6 +108,8 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   class SharedFrameIOBuffer;
 
   const scoped_refptr<SharedFrame> shared_frame_;
+  // The buffer that |shared_frame_| points into, if it doesn't own its data.
+  const scoped_refptr<IOBuffer> backing_buffer_;
   std::vector<ConsumeCallback> consume_callbacks_;
   size_t offset_;
 
@@ -54,6 +54,19 @@ TEST_F(SpdyBufferTest, DataConstructor) {
   EXPECT_EQ(std::string(kData, kDataSize), BufferToString(buffer));
 }
 
+// Construct a SpdyBuffer from a slice of an IOBuffer and make sure it
+// points into the IOBuffer rather than making a copy.
+TEST_F(SpdyBufferTest, BackingBufferConstructor) {
+  auto backing_buffer = base::MakeRefCounted<IOBuffer>(2 * kDataSize);
+  char* data = backing_buffer->data() + kDataSize;
+  std::memcpy(data, kData, kDataSize);
+  SpdyBuffer buffer(backing_buffer, data, kDataSize);
+
+  EXPECT_EQ(data, buffer.GetRemainingData());
+  EXPECT_EQ(kDataSize, buffer.GetRemainingSize());
+  EXPECT_FALSE(backing_buffer->HasOneRef());
+}
+
 void IncrementBy(size_t* x,
                  SpdyBuffer::ConsumeSource expected_consume_source,
                  size_t delta,
@@ -130,6 +143,24 @@ TEST_F(SpdyBufferTest, IOBufferForRemainingDataOutlivesBuffer) {
   std::memcpy(io_buffer->data(), kData, kDataSize);
 }
 
+// Make sure the IOBuffer returned by GetIOBufferForRemainingData() keeps
+// the backing buffer of a SpdyBuffer that doesn't own its data alive.
+TEST_F(SpdyBufferTest, IOBufferForRemainingDataKeepsBackingBufferAlive) {
+  auto backing_buffer = base::MakeRefCounted<IOBuffer>(kDataSize);
+  std::memcpy(backing_buffer->data(), kData, kDataSize);
+  auto buffer = std::make_unique<SpdyBuffer>(
+      backing_buffer, backing_buffer->data(), kDataSize);
+  buffer->Consume(5);
+  scoped_refptr<IOBuffer> io_buffer = buffer->GetIOBufferForRemainingData();
+  buffer.reset();
+  backing_buffer = nullptr;
+
+  // This will cause a use-after-free error if |io_buffer| doesn't keep the
+  // backing buffer alive.
+  EXPECT_EQ(std::string(kData + 5, kDataSize - 5),
+            std::string(io_buffer->data(), kDataSize - 5));
+}
+
 }  // namespace
 
 }  // namespace net
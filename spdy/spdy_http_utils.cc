@@ -25,6 +25,10 @@ namespace net {
 
 namespace {
 
+// The RFC 9218 urgency that need not be sent, and the least urgent one.
+const uint8_t kDefaultUrgency = 3;
+const uint8_t kMaxUrgency = 7;
+
 void AddSpdyHeader(const std::string& name,
                    const std::string& value,
                    spdy::SpdyHeaderBlock* headers) {
@@ -158,6 +162,41 @@ ConvertSpdyPriorityToRequestPriority(spdy::SpdyPriority priority) {
                    MAXIMUM_PRIORITY - (priority - spdy::kV3HighestPriority));
 }
 
+const char kHttpPriorityHeader[] = "priority";
+
+uint8_t ConvertRequestPriorityToUrgency(RequestPriority priority) {
+  // Urgencies run in the same direction as SPDY priorities, from 0 (the
+  // most urgent) upwards, and there are more of them.
+  static_assert(MAXIMUM_PRIORITY - MINIMUM_PRIORITY <= kMaxUrgency,
+                "request priority incompatible with urgency");
+  return ConvertRequestPriorityToSpdyPriority(priority) -
+         spdy::kV3HighestPriority;
+}
+
+std::string SerializePriorityFieldValue(uint8_t urgency, bool incremental) {
+  DCHECK_LE(urgency, kMaxUrgency);
+  std::string value;
+  if (urgency != kDefaultUrgency)
+    value = "u=" + base::NumberToString(urgency);
+  if (incremental) {
+    if (!value.empty())
+      value += ", ";
+    value += "i";
+  }
+  return value;
+}
+
+void AddPriorityHeader(RequestPriority priority,
+                       bool incremental,
+                       spdy::SpdyHeaderBlock* headers) {
+  if (headers->find(kHttpPriorityHeader) != headers->end())
+    return;
+  std::string value = SerializePriorityFieldValue(
+      ConvertRequestPriorityToUrgency(priority), incremental);
+  if (!value.empty())
+    (*headers)[kHttpPriorityHeader] = value;
+}
+
 NET_EXPORT_PRIVATE void ConvertHeaderBlockToHttpRequestHeaders(
     const spdy::SpdyHeaderBlock& spdy_headers,
     HttpRequestHeaders* http_headers) {
@@ -5,6 +5,10 @@
 #ifndef NET_SPDY_SPDY_HTTP_UTILS_H_
 #define NET_SPDY_SPDY_HTTP_UTILS_H_
 
+#include <stdint.h>
+
+#include <string>
+
 #include "net/base/net_export.h"
 #include "net/base/request_priority.h"
 #include "net/third_party/quiche/src/spdy/core/spdy_framer.h"
@@ -50,6 +54,26 @@ NET_EXPORT spdy::SpdyPriority ConvertRequestPriorityToSpdyPriority(
 NET_EXPORT RequestPriority
 ConvertSpdyPriorityToRequestPriority(spdy::SpdyPriority priority);
 
+// The name of the RFC 9218 Priority request header.
+NET_EXPORT_PRIVATE extern const char kHttpPriorityHeader[];
+
+// Returns the RFC 9218 urgency, 0 being the most urgent and 7 the least, that
+// |priority| maps to.
+NET_EXPORT_PRIVATE uint8_t
+ConvertRequestPriorityToUrgency(RequestPriority priority);
+
+// Returns the RFC 9218 priority field value, as sent in the Priority header
+// and in PRIORITY_UPDATE frames, for |urgency| and |incremental|. Parameters
+// at their default values are omitted, so the result may be empty.
+NET_EXPORT_PRIVATE std::string SerializePriorityFieldValue(uint8_t urgency,
+                                                           bool incremental);
+
+// Adds a Priority header for |priority| and |incremental| to |headers|,
+// unless the value would be empty or |headers| already has one.
+NET_EXPORT_PRIVATE void AddPriorityHeader(RequestPriority priority,
+                                          bool incremental,
+                                          spdy::SpdyHeaderBlock* headers);
+
 }  // namespace net
 
 #endif  // NET_SPDY_SPDY_HTTP_UTILS_H_
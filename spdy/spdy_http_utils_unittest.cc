@@ -38,6 +38,37 @@ TEST(SpdyHttpUtilsTest, ConvertSpdy3PriorityToRequestPriority) {
   }
 }
 
+TEST(SpdyHttpUtilsTest, ConvertRequestPriorityToUrgency) {
+  EXPECT_EQ(0, ConvertRequestPriorityToUrgency(HIGHEST));
+  EXPECT_EQ(1, ConvertRequestPriorityToUrgency(MEDIUM));
+  EXPECT_EQ(2, ConvertRequestPriorityToUrgency(LOW));
+  EXPECT_EQ(3, ConvertRequestPriorityToUrgency(LOWEST));
+  EXPECT_EQ(4, ConvertRequestPriorityToUrgency(IDLE));
+  EXPECT_EQ(5, ConvertRequestPriorityToUrgency(THROTTLED));
+}
+
+TEST(SpdyHttpUtilsTest, SerializePriorityFieldValue) {
+  EXPECT_EQ("u=0", SerializePriorityFieldValue(0, false));
+  EXPECT_EQ("u=0, i", SerializePriorityFieldValue(0, true));
+  EXPECT_EQ("", SerializePriorityFieldValue(3, false));
+  EXPECT_EQ("i", SerializePriorityFieldValue(3, true));
+  EXPECT_EQ("u=7", SerializePriorityFieldValue(7, false));
+}
+
+TEST(SpdyHttpUtilsTest, AddPriorityHeader) {
+  spdy::SpdyHeaderBlock headers;
+  AddPriorityHeader(LOWEST, false, &headers);
+  EXPECT_TRUE(headers.end() == headers.find("priority"));
+
+  AddPriorityHeader(HIGHEST, true, &headers);
+  EXPECT_EQ("u=0, i", headers["priority"]);
+
+  // A Priority header set by the caller is kept.
+  headers["priority"] = "u=5";
+  AddPriorityHeader(HIGHEST, false, &headers);
+  EXPECT_EQ("u=5", headers["priority"]);
+}
+
 TEST(SpdyHttpUtilsTest, CreateSpdyHeadersFromHttpRequestHTTP2) {
   GURL url("https://www.google.com/index.html");
   HttpRequestInfo request;
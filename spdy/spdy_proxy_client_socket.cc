@@ -11,6 +11,7 @@
 #include "base/bind_helpers.h"
 #include "base/callback_helpers.h"
 #include "base/check_op.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/notreached.h"
 #include "base/single_thread_task_runner.h"
@@ -18,6 +19,7 @@
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/values.h"
 #include "net/base/auth.h"
+#include "net/base/features.h"
 #include "net/base/io_buffer.h"
 #include "net/base/proxy_delegate.h"
 #include "net/http/http_auth_cache.h"
@@ -51,6 +53,8 @@ SpdyProxyClientSocket::SpdyProxyClientSocket(
       user_buffer_len_(0),
       write_buffer_len_(0),
       was_ever_used_(false),
+      relay_buffers_(
+          base::FeatureList::IsEnabled(features::kHttp2ProxyTunnelRelay)),
       net_log_(NetLogWithSource::Make(spdy_stream->net_log().net_log(),
                                       NetLogSourceType::PROXY_CLIENT_SOCKET)),
       source_dependency_(source_net_log.source()) {
@@ -64,6 +68,13 @@ SpdyProxyClientSocket::SpdyProxyClientSocket(
 
   spdy_stream_->SetDelegate(this);
   was_ever_used_ = spdy_stream_->WasEverUsed();
+
+  // The tunneled TLS connection writes a record at a time, so send up to the
+  // largest frame every peer accepts rather than splitting records up.
+  if (relay_buffers_) {
+    spdy_stream_->SetMaxDataFrameSize(
+        static_cast<int>(spdy::kHttp2DefaultFramePayloadLimit));
+  }
 }
 
 SpdyProxyClientSocket::~SpdyProxyClientSocket() {
@@ -239,6 +250,34 @@ int SpdyProxyClientSocket::CancelReadIfReady() {
   return OK;
 }
 
+int SpdyProxyClientSocket::ReadBuffer(scoped_refptr<IOBuffer>* buf,
+                                      CompletionOnceCallback callback) {
+  if (!relay_buffers_)
+    return ERR_READ_IF_READY_NOT_IMPLEMENTED;
+
+  DCHECK(!read_callback_);
+  DCHECK(!user_buffer_);
+  DCHECK(buf);
+
+  if (next_state_ == STATE_DISCONNECTED)
+    return ERR_SOCKET_NOT_CONNECTED;
+
+  DCHECK(next_state_ == STATE_OPEN || next_state_ == STATE_CLOSED);
+  if (read_buffer_queue_.IsEmpty()) {
+    if (next_state_ == STATE_CLOSED)
+      return 0;
+    // OnDataReceived() runs |callback| with OK, as for ReadIfReady().
+    read_callback_ = std::move(callback);
+    return ERR_IO_PENDING;
+  }
+
+  // Releasing the payload credits the receive window, just as copying it out
+  // does.
+  std::unique_ptr<SpdyBuffer> buffer = read_buffer_queue_.DequeueBuffer();
+  *buf = buffer->GetIOBufferForRemainingData();
+  return static_cast<int>(buffer->GetRemainingSize());
+}
+
 size_t SpdyProxyClientSocket::PopulateUserReadBuffer(char* data, size_t len) {
   return read_buffer_queue_.Dequeue(data, len);
 }
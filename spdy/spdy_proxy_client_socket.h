@@ -89,6 +89,10 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
                   int buf_len,
                   CompletionOnceCallback callback) override;
   int CancelReadIfReady() override;
+  // Hands over received DATA payloads without copying them, if
+  // features::kHttp2ProxyTunnelRelay is enabled.
+  int ReadBuffer(scoped_refptr<IOBuffer>* buf,
+                 CompletionOnceCallback callback) override;
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
@@ -179,6 +183,10 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
   // True if the transport socket has ever sent data.
   bool was_ever_used_;
 
+  // Whether ReadBuffer() is supported and DATA frames are sized to hold a
+  // whole TLS record of the tunneled connection.
+  const bool relay_buffers_;
+
   const NetLogWithSource net_log_;
   const NetLogSource source_dependency_;
 
@@ -12,7 +12,9 @@
 #include "base/run_loop.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/test/scoped_feature_list.h"
 #include "net/base/address_list.h"
+#include "net/base/features.h"
 #include "net/base/load_timing_info.h"
 #include "net/base/proxy_server.h"
 #include "net/base/test_completion_callback.h"
@@ -723,8 +725,93 @@ TEST_P(SpdyProxyClientSocketTest, WriteSplitsLargeDataIntoMultipleFrames) {
   EXPECT_EQ(buf->size(), write_callback_.WaitForResult());
 }
 
+TEST_P(SpdyProxyClientSocketTest, RelayWritesRecordSizedFrames) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kHttp2ProxyTunnelRelay);
+
+  std::string record(spdy::kHttp2DefaultFramePayloadLimit, 'x');
+  spdy::SpdySerializedFrame conn(ConstructConnectRequestFrame());
+  spdy::SpdySerializedFrame chunk(
+      ConstructBodyFrame(record.data(), record.length()));
+  MockWrite writes[] = {CreateMockWrite(conn, 0, SYNCHRONOUS),
+                        CreateMockWrite(chunk, 3, SYNCHRONOUS)};
+
+  spdy::SpdySerializedFrame resp(ConstructConnectReplyFrame());
+  MockRead reads[] = {
+      CreateMockRead(resp, 1, ASYNC), MockRead(SYNCHRONOUS, ERR_IO_PENDING, 2),
+  };
+
+  Initialize(reads, writes);
+
+  AssertConnectSucceeds();
+
+  scoped_refptr<IOBufferWithSize> buf(
+      CreateBuffer(record.data(), record.length()));
+  EXPECT_EQ(ERR_IO_PENDING,
+            sock_->Write(buf.get(), buf->size(), write_callback_.callback(),
+                         TRAFFIC_ANNOTATION_FOR_TESTS));
+  EXPECT_EQ(buf->size(), write_callback_.WaitForResult());
+}
+
 // ----------- Read
 
+TEST_P(SpdyProxyClientSocketTest, ReadBufferNotSupportedByDefault) {
+  spdy::SpdySerializedFrame conn(ConstructConnectRequestFrame());
+  MockWrite writes[] = {CreateMockWrite(conn, 0, SYNCHRONOUS)};
+
+  spdy::SpdySerializedFrame resp(ConstructConnectReplyFrame());
+  MockRead reads[] = {
+      CreateMockRead(resp, 1, ASYNC), MockRead(SYNCHRONOUS, ERR_IO_PENDING, 2),
+  };
+
+  Initialize(reads, writes);
+
+  AssertConnectSucceeds();
+
+  scoped_refptr<IOBuffer> buf;
+  EXPECT_THAT(sock_->ReadBuffer(&buf, read_callback_.callback()),
+              IsError(ERR_READ_IF_READY_NOT_IMPLEMENTED));
+}
+
+TEST_P(SpdyProxyClientSocketTest, ReadBufferHandsOverDataFrames) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kHttp2ProxyTunnelRelay);
+
+  spdy::SpdySerializedFrame conn(ConstructConnectRequestFrame());
+  MockWrite writes[] = {CreateMockWrite(conn, 0, SYNCHRONOUS)};
+
+  spdy::SpdySerializedFrame resp(ConstructConnectReplyFrame());
+  spdy::SpdySerializedFrame msg1(ConstructBodyFrame(kMsg1, kLen1));
+  spdy::SpdySerializedFrame msg3(ConstructBodyFrame(kMsg3, kLen3));
+  MockRead reads[] = {
+      CreateMockRead(resp, 1, ASYNC), MockRead(ASYNC, ERR_IO_PENDING, 2),
+      CreateMockRead(msg1, 3, ASYNC), CreateMockRead(msg3, 4, ASYNC),
+      MockRead(ASYNC, ERR_IO_PENDING, 5), MockRead(ASYNC, 0, 6),  // EOF
+  };
+
+  Initialize(reads, writes);
+
+  AssertConnectSucceeds();
+
+  // Nothing has arrived yet.
+  scoped_refptr<IOBuffer> buf;
+  ASSERT_EQ(ERR_IO_PENDING, sock_->ReadBuffer(&buf, read_callback_.callback()));
+  ResumeAndRun();
+  EXPECT_THAT(read_callback_.WaitForResult(), IsOk());
+
+  // Each DATA frame's payload is handed over as is.
+  ASSERT_EQ(kLen1, sock_->ReadBuffer(&buf, read_callback_.callback()));
+  EXPECT_EQ(std::string(kMsg1, kLen1), std::string(buf->data(), kLen1));
+  ASSERT_EQ(kLen3, sock_->ReadBuffer(&buf, read_callback_.callback()));
+  EXPECT_EQ(std::string(kMsg3, kLen3), std::string(buf->data(), kLen3));
+
+  // The pending read completes when the connection closes.
+  ASSERT_EQ(ERR_IO_PENDING, sock_->ReadBuffer(&buf, read_callback_.callback()));
+  ResumeAndRun();
+  EXPECT_THAT(read_callback_.WaitForResult(), IsOk());
+  EXPECT_EQ(0, sock_->ReadBuffer(&buf, read_callback_.callback()));
+}
+
 TEST_P(SpdyProxyClientSocketTest, ReadReadsDataInDataFrame) {
   spdy::SpdySerializedFrame conn(ConstructConnectRequestFrame());
   MockWrite writes[] = {
@@ -36,6 +36,10 @@ class NET_EXPORT_PRIVATE SpdyReadQueue {
   // |out|. Returns the number of bytes dequeued.
   size_t Dequeue(char* out, size_t len);
 
+  // Dequeues the first buffer in the queue, which must not be empty, without
+  // copying its bytes.
+  std::unique_ptr<SpdyBuffer> DequeueBuffer();
+
   // Removes all bytes from the queue.
   void Clear();
 
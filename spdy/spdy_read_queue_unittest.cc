@@ -135,5 +135,27 @@ TEST_F(SpdyReadQueueTest, Clear) {
   EXPECT_TRUE(read_queue.IsEmpty());
 }
 
+TEST_F(SpdyReadQueueTest, DequeueBuffer) {
+  std::string data(kData, kDataSize);
+  SpdyReadQueue read_queue;
+  EnqueueString(data, 10, &read_queue);
+  // Partially consume the first buffer, so that DequeueBuffer() has to
+  // account for what's left of it.
+  char out[3];
+  ASSERT_EQ(3u, read_queue.Dequeue(out, 3));
+
+  std::string dequeued_data(out, 3);
+  while (!read_queue.IsEmpty()) {
+    size_t old_total_size = read_queue.GetTotalSize();
+    std::unique_ptr<SpdyBuffer> buffer = read_queue.DequeueBuffer();
+    ASSERT_GT(buffer->GetRemainingSize(), 0u);
+    dequeued_data.append(buffer->GetRemainingData(),
+                         buffer->GetRemainingSize());
+    EXPECT_EQ(old_total_size - buffer->GetRemainingSize(),
+              read_queue.GetTotalSize());
+  }
+  EXPECT_EQ(data, dequeued_data);
+}
+
 }  // namespace test
 }  // namespace net
@@ -4,13 +4,17 @@
 
 #include "net/spdy/spdy_session.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <limits>
 #include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/metrics/histogram_functions.h"
@@ -88,9 +92,29 @@ constexpr net::NetworkTrafficAnnotationTag
         }
     )");
 
-const int kReadBufferSize = 8 * 1024;
+// The read buffer starts at the minimum size. It doubles after each read
+// that fills it, since that suggests more data is waiting in the socket, and
+// halves after several reads in a row that used no more than a quarter of
+// it. The maximum is the yield threshold, so that a yield still comes after
+// at most two full reads.
+const int kMinReadBufferSize = 8 * 1024;
+const int kMaxReadBufferSize = kYieldAfterBytesRead;
+const int kSmallReadsBeforeShrinking = 4;
+// With receive window auto-tuning, a PING is sent along with a session
+// WINDOW_UPDATE to measure the round trip time if none has been sent for this
+// long.
+const int kRecvWindowAutoTuningPingIntervalSeconds = 30;
+// DATA payloads at least this fraction of the read buffer are handed to
+// streams as slices of it rather than copied. Smaller ones are copied, so
+// that a slice never holds on to more than twice its size.
+const int kMinReadBufferSliceFraction = 2;
 const int kDefaultConnectionAtRiskOfLossSeconds = 10;
 const int kHungIntervalSeconds = 10;
+// A PING that has gone unanswered, with nothing else read, for this many
+// times the last measured round trip time is considered overdue, but never
+// before kMinPingOverdueMilliseconds.
+const int kPingOverdueRttMultiplier = 4;
+const int kMinPingOverdueMilliseconds = 1000;
 
 // Lifetime of unclaimed pushed stream, in seconds: after this period, a pushed
 // stream is cancelled if still not claimed.
@@ -102,6 +126,11 @@ const uint32_t kDefaultInitialEnablePush = 1;
 const uint32_t kDefaultInitialInitialWindowSize = 65535;
 const uint32_t kDefaultInitialMaxFrameSize = 16384;
 
+// RFC 9218 SETTINGS_NO_RFC7540_PRIORITIES, with which a server announces that
+// it ignores RFC 7540 priority signals, and the PRIORITY_UPDATE frame type.
+const uint32_t kSettingsNoRfc7540Priorities = 0x9;
+const uint8_t kPriorityUpdateFrameType = 0x10;
+
 // Values of Vary response header on pushed streams.  This is logged to
 // Net.PushedStreamVaryResponseHeader, entries must not be changed.
 enum PushedStreamVaryResponseHeaderValues {
@@ -207,6 +236,8 @@ bool IsSpdySettingAtDefaultInitialValue(spdy::SpdySettingsId setting_id,
       return false;
     case spdy::SETTINGS_ENABLE_CONNECT_PROTOCOL:
       return value == 0;
+    case kSettingsNoRfc7540Priorities:
+      return value == 0;
     default:
       // Undefined parameters have no initial value.
       return false;
@@ -444,6 +475,14 @@ base::Value NetLogSpdyGreasedFrameParams(spdy::SpdyStreamId stream_id,
   return dict;
 }
 
+base::Value NetLogSpdyPriorityUpdateParams(spdy::SpdyStreamId stream_id,
+                                           const std::string& priority_field) {
+  base::Value dict(base::Value::Type::DICTIONARY);
+  dict.SetIntKey("stream_id", stream_id);
+  dict.SetStringKey("priority_field", priority_field);
+  return dict;
+}
+
 // Helper function to return the total size of an array of objects
 // with .size() member functions.
 template <typename T, size_t N>
@@ -499,6 +538,60 @@ class SpdyServerPushHelper : public ServerPushDelegate::ServerPushHelper {
   const GURL request_url_;
 };
 
+// Returns whether |new_hostname|, which the certificate in |ssl_info| is known
+// to cover, can be pooled into an existing connection to |old_hostname|. See
+// SpdySession::CanPool().
+bool CanPoolCoveredHostname(TransportSecurityState* transport_security_state,
+                            const SSLInfo& ssl_info,
+                            const SSLConfigService& ssl_config_service,
+                            const std::string& old_hostname,
+                            const std::string& new_hostname,
+                            const NetworkIsolationKey& network_isolation_key) {
+  if (IsCertStatusError(ssl_info.cert_status))
+    return false;
+
+  if (ssl_info.client_cert_sent &&
+      !(ssl_config_service.CanShareConnectionWithClientCerts(old_hostname) &&
+        ssl_config_service.CanShareConnectionWithClientCerts(new_hostname))) {
+    return false;
+  }
+
+  std::string pinning_failure_log;
+  // DISABLE_PIN_REPORTS is set here because this check can fail in
+  // normal operation without being indicative of a misconfiguration or
+  // attack. Port is left at 0 as it is never used.
+  if (transport_security_state->CheckPublicKeyPins(
+          HostPortPair(new_hostname, 0), ssl_info.is_issued_by_known_root,
+          ssl_info.public_key_hashes, ssl_info.unverified_cert.get(),
+          ssl_info.cert.get(), TransportSecurityState::DISABLE_PIN_REPORTS,
+          &pinning_failure_log) ==
+      TransportSecurityState::PKPStatus::VIOLATED) {
+    return false;
+  }
+
+  // As with CheckPublicKeyPins above, disable Expect-CT reports.
+  switch (transport_security_state->CheckCTRequirements(
+      HostPortPair(new_hostname, 0), ssl_info.is_issued_by_known_root,
+      ssl_info.public_key_hashes, ssl_info.cert.get(),
+      ssl_info.unverified_cert.get(), ssl_info.signed_certificate_timestamps,
+      TransportSecurityState::DISABLE_EXPECT_CT_REPORTS,
+      ssl_info.ct_policy_compliance, network_isolation_key)) {
+    case TransportSecurityState::CT_REQUIREMENTS_NOT_MET:
+      return false;
+    case TransportSecurityState::CT_REQUIREMENTS_MET:
+    case TransportSecurityState::CT_NOT_REQUIRED:
+      // Intentional fallthrough; this case is just here to make sure that all
+      // possible values of CheckCTRequirements() are handled.
+      break;
+  }
+
+  return true;
+}
+
+// The number of hostnames whose coverage by its certificate a session
+// remembers.
+const size_t kMaxCertCoverageCacheSize = 128;
+
 }  // namespace
 
 SpdyProtocolErrorDetails MapFramerErrorToProtocolError(
@@ -862,48 +955,12 @@ bool SpdySession::CanPool(
   // Pooling is prohibited if the server cert is not valid for the new domain,
   // and for connections on which client certs were sent. It is also prohibited
   // when channel ID was sent if the hosts are from different eTLDs+1.
-  if (IsCertStatusError(ssl_info.cert_status))
-    return false;
-
-  if (ssl_info.client_cert_sent &&
-      !(ssl_config_service.CanShareConnectionWithClientCerts(old_hostname) &&
-        ssl_config_service.CanShareConnectionWithClientCerts(new_hostname))) {
-    return false;
-  }
-
   if (!ssl_info.cert->VerifyNameMatch(new_hostname))
     return false;
 
-  std::string pinning_failure_log;
-  // DISABLE_PIN_REPORTS is set here because this check can fail in
-  // normal operation without being indicative of a misconfiguration or
-  // attack. Port is left at 0 as it is never used.
-  if (transport_security_state->CheckPublicKeyPins(
-          HostPortPair(new_hostname, 0), ssl_info.is_issued_by_known_root,
-          ssl_info.public_key_hashes, ssl_info.unverified_cert.get(),
-          ssl_info.cert.get(), TransportSecurityState::DISABLE_PIN_REPORTS,
-          &pinning_failure_log) ==
-      TransportSecurityState::PKPStatus::VIOLATED) {
-    return false;
-  }
-
-  // As with CheckPublicKeyPins above, disable Expect-CT reports.
-  switch (transport_security_state->CheckCTRequirements(
-      HostPortPair(new_hostname, 0), ssl_info.is_issued_by_known_root,
-      ssl_info.public_key_hashes, ssl_info.cert.get(),
-      ssl_info.unverified_cert.get(), ssl_info.signed_certificate_timestamps,
-      TransportSecurityState::DISABLE_EXPECT_CT_REPORTS,
-      ssl_info.ct_policy_compliance, network_isolation_key)) {
-    case TransportSecurityState::CT_REQUIREMENTS_NOT_MET:
-      return false;
-    case TransportSecurityState::CT_REQUIREMENTS_MET:
-    case TransportSecurityState::CT_NOT_REQUIRED:
-      // Intentional fallthrough; this case is just here to make sure that all
-      // possible values of CheckCTRequirements() are handled.
-      break;
-  }
-
-  return true;
+  return CanPoolCoveredHostname(transport_security_state, ssl_info,
+                                ssl_config_service, old_hostname,
+                                new_hostname, network_isolation_key);
 }
 
 SpdySession::SpdySession(
@@ -934,6 +991,8 @@ SpdySession::SpdySession(
       transport_security_state_(transport_security_state),
       ssl_config_service_(ssl_config_service),
       socket_(nullptr),
+      read_buffer_size_(kMinReadBufferSize),
+      consecutive_small_reads_(0),
       stream_hi_water_mark_(kFirstStreamId),
       last_accepted_push_stream_id_(0),
       push_delegate_(push_delegate),
@@ -941,8 +1000,11 @@ SpdySession::SpdySession(
       num_active_pushed_streams_(0u),
       bytes_pushed_count_(0u),
       bytes_pushed_and_unclaimed_count_(0u),
-      in_flight_write_frame_type_(spdy::SpdyFrameType::DATA),
-      in_flight_write_frame_size_(0),
+      in_flight_write_frame_bytes_written_(0),
+      max_write_coalescing_bytes_(
+          base::FeatureList::IsEnabled(features::kHttp2WriteCoalescing)
+              ? std::max(features::kHttp2WriteCoalescingMaxBytes.Get(), 0)
+              : 0),
       availability_state_(STATE_AVAILABLE),
       read_state_(READ_STATE_DO_READ),
       write_state_(WRITE_STATE_IDLE),
@@ -973,6 +1035,23 @@ SpdySession::SpdySession(
           initial_settings.at(spdy::SETTINGS_HEADER_TABLE_SIZE)),
       stream_max_recv_window_size_(
           initial_settings.at(spdy::SETTINGS_INITIAL_WINDOW_SIZE)),
+      enable_recv_window_auto_tuning_(
+          base::FeatureList::IsEnabled(features::kHttp2ReceiveWindowAutoTuning)),
+      max_auto_tuned_recv_window_size_(std::max(
+          features::kHttp2ReceiveWindowAutoTuningMaxWindowSize.Get(),
+          std::max<int>(session_max_recv_window_size,
+                        initial_settings.at(
+                            spdy::SETTINGS_INITIAL_WINDOW_SIZE)))),
+      initial_session_max_recv_window_size_(session_max_recv_window_size),
+      enable_priority_update_(
+          base::FeatureList::IsEnabled(features::kPriorityHeader)),
+      periodic_ping_interval_(
+          base::FeatureList::IsEnabled(features::kHttp2PeriodicPing)
+              ? features::kHttp2PeriodicPingInterval.Get()
+              : base::TimeDelta()),
+      periodic_ping_idle_sessions_(
+          features::kHttp2PeriodicPingIdleSessions.Get()),
+      periodic_ping_planned_(false),
       net_log_(
           NetLogWithSource::Make(net_log, NetLogSourceType::HTTP2_SESSION)),
       quic_supported_versions_(quic_supported_versions),
@@ -984,6 +1063,7 @@ SpdySession::SpdySession(
       is_trusted_proxy_(is_trusted_proxy),
       enable_push_(IsPushEnabled(initial_settings)),
       support_websocket_(false),
+      deprecate_http2_priorities_(false),
       connection_at_risk_of_loss_time_(
           base::TimeDelta::FromSeconds(kDefaultConnectionAtRiskOfLossSeconds)),
       hung_interval_(base::TimeDelta::FromSeconds(kHungIntervalSeconds)),
@@ -1117,9 +1197,25 @@ bool SpdySession::VerifyDomainAuthentication(const std::string& domain) const {
   if (!GetSSLInfo(&ssl_info))
     return true;  // This is not a secure session, so all domains are okay.
 
-  return CanPool(transport_security_state_, ssl_info, *ssl_config_service_,
-                 host_port_pair().host(), domain,
-                 spdy_session_key_.network_isolation_key());
+  // Whether the certificate covers |domain| can't change over the life of the
+  // session, and with many sessions to the same IP, checking it is most of
+  // the cost of looking for one to pool with. The remaining checks depend on
+  // state that may change.
+  auto it = cert_coverage_cache_.find(domain);
+  if (it == cert_coverage_cache_.end()) {
+    if (cert_coverage_cache_.size() >= kMaxCertCoverageCacheSize)
+      cert_coverage_cache_.clear();
+    it = cert_coverage_cache_
+             .emplace(domain, ssl_info.cert->VerifyNameMatch(domain))
+             .first;
+  }
+  if (!it->second)
+    return false;
+
+  return CanPoolCoveredHostname(transport_security_state_, ssl_info,
+                                *ssl_config_service_, host_port_pair().host(),
+                                domain,
+                                spdy_session_key_.network_isolation_key());
 }
 
 void SpdySession::EnqueueStreamWrite(
@@ -1185,7 +1281,9 @@ std::unique_ptr<spdy::SpdySerializedFrame> SpdySession::CreateHeaders(
   spdy::SpdyPriority spdy_priority =
       ConvertRequestPriorityToSpdyPriority(priority);
 
-  bool has_priority = true;
+  // The dependency tree is kept up to date regardless, as streams leave it
+  // when they close.
+  bool has_priority = !deprecate_http2_priorities_;
   int weight = 0;
   spdy::SpdyStreamId parent_stream_id = 0;
   bool exclusive = false;
@@ -1235,7 +1333,7 @@ std::unique_ptr<SpdyBuffer> SpdySession::CreateDataBuffer(
     return std::unique_ptr<SpdyBuffer>();
   }
 
-  *effective_len = std::min(len, kMaxSpdyFrameChunkSize);
+  *effective_len = std::min(len, stream->max_data_frame_size());
 
   bool send_stalled_by_stream = (stream->send_window_size() <= 0);
   bool send_stalled_by_session = IsSendStalled();
@@ -1339,8 +1437,15 @@ void SpdySession::UpdateStreamPriority(SpdyStream* stream,
 
   DCHECK(IsStreamActive(stream_id));
 
-  if (base::FeatureList::IsEnabled(features::kAvoidH2Reprioritization))
+  if (enable_priority_update_) {
+    EnqueuePriorityUpdateFrame(stream_id, new_priority,
+                               stream->priority_incremental());
+  }
+
+  if (deprecate_http2_priorities_ ||
+      base::FeatureList::IsEnabled(features::kAvoidH2Reprioritization)) {
     return;
+  }
 
   auto updates = priority_dependency_state_.OnStreamUpdate(
       stream_id, ConvertRequestPriorityToSpdyPriority(new_priority));
@@ -1534,6 +1639,17 @@ base::Value SpdySession::GetInfoAsValue() const {
   return dict;
 }
 
+bool SpdySession::IsPingOverdue() const {
+  if (!ping_in_flight_ || last_ping_rtt_.is_zero() ||
+      last_read_time_ >= last_ping_sent_time_) {
+    return false;
+  }
+  const base::TimeDelta overdue_after =
+      std::max(base::TimeDelta::FromMilliseconds(kMinPingOverdueMilliseconds),
+               kPingOverdueRttMultiplier * last_ping_rtt_);
+  return time_func_() - last_ping_sent_time_ > overdue_after;
+}
+
 bool SpdySession::IsReused() const {
   if (buffered_spdy_framer_->frames_received() > 0)
     return true;
@@ -1676,10 +1792,15 @@ size_t SpdySession::DumpMemoryStats(StreamSocket::SocketMemoryStats* stats,
   *is_session_active = is_active();
   socket_->DumpMemoryStats(stats);
 
-  // |connection_| is estimated in stats->total_size. |read_buffer_| is
-  // estimated in |read_buffer_size|. TODO(xunjieli): Make them use EMU().
-  size_t read_buffer_size = read_buffer_ ? kReadBufferSize : 0;
-  return stats->total_size + read_buffer_size +
+  // |connection_| is estimated in stats->total_size.
+  return stats->total_size + EstimateMemoryUsage();
+}
+
+size_t SpdySession::EstimateMemoryUsage() const {
+  // |read_buffer_| is estimated in |read_buffer_size|. TODO(xunjieli): Make it
+  // use EMU().
+  size_t read_buffer_size = read_buffer_ ? read_buffer_->size() : 0;
+  return read_buffer_size +
          base::trace_event::EstimateMemoryUsage(spdy_session_key_) +
          base::trace_event::EstimateMemoryUsage(pooled_aliases_) +
          base::trace_event::EstimateMemoryUsage(active_streams_) +
@@ -1692,6 +1813,12 @@ size_t SpdySession::DumpMemoryStats(StreamSocket::SocketMemoryStats* stats,
          base::trace_event::EstimateMemoryUsage(priority_dependency_state_);
 }
 
+size_t SpdySession::EstimateHeaderCompressionMemoryUsage() const {
+  return buffered_spdy_framer_
+             ? buffered_spdy_framer_->EstimateHeaderCompressionMemoryUsage()
+             : 0;
+}
+
 bool SpdySession::ChangeSocketTag(const SocketTag& new_tag) {
   if (!IsAvailable() || !socket_)
     return false;
@@ -1734,6 +1861,8 @@ void SpdySession::InitializeInternal(SpdySessionPool* pool) {
   buffered_spdy_framer_->set_visitor(this);
   buffered_spdy_framer_->set_debug_visitor(this);
   buffered_spdy_framer_->UpdateHeaderDecoderTableSize(max_header_table_size_);
+  if (base::FeatureList::IsEnabled(features::kHttp2SelectiveHeaderIndexing))
+    buffered_spdy_framer_->EnableHeaderIndexingPolicy();
 
   net_log_.AddEvent(NetLogEventType::HTTP2_SESSION_INITIALIZED, [&] {
     return NetLogSpdyInitializedParams(socket_->NetLog().source());
@@ -1749,6 +1878,9 @@ void SpdySession::InitializeInternal(SpdySessionPool* pool) {
       FROM_HERE,
       base::BindOnce(&SpdySession::PumpReadLoop, weak_factory_.GetWeakPtr(),
                      READ_STATE_DO_READ, OK));
+
+  if (!periodic_ping_interval_.is_zero() && periodic_ping_idle_sessions_)
+    PlanToSendPeriodicPing();
 }
 
 // {,Try}CreateStream() can be called with |in_io_loop_| set if a stream is
@@ -2092,7 +2224,8 @@ void SpdySession::TryCreatePushStream(spdy::SpdyStreamId stream_id,
   bool exclusive = false;
   priority_dependency_state_.OnStreamCreation(
       stream_id, spdy_priority, &dependency_id, &weight, &exclusive);
-  EnqueuePriorityFrame(stream_id, dependency_id, weight, exclusive);
+  if (!deprecate_http2_priorities_)
+    EnqueuePriorityFrame(stream_id, dependency_id, weight, exclusive);
 
   // PUSH_PROMISE arrives on associated stream.
   associated_it->second->AddRawReceivedBytes(last_compressed_frame_len_);
@@ -2233,6 +2366,39 @@ void SpdySession::EnqueuePriorityFrame(spdy::SpdyStreamId stream_id,
                kSpdySessionCommandsTrafficAnnotation);
 }
 
+void SpdySession::EnqueuePriorityUpdateFrame(spdy::SpdyStreamId stream_id,
+                                             RequestPriority priority,
+                                             bool incremental) {
+  const std::string priority_field = SerializePriorityFieldValue(
+      ConvertRequestPriorityToUrgency(priority), incremental);
+  net_log_.AddEvent(NetLogEventType::HTTP2_STREAM_SEND_PRIORITY_UPDATE, [&] {
+    return NetLogSpdyPriorityUpdateParams(stream_id, priority_field);
+  });
+
+  // The payload is the prioritized stream id followed by the field value.
+  std::string payload;
+  payload.push_back(static_cast<char>((stream_id >> 24) & 0x7f));
+  payload.push_back(static_cast<char>((stream_id >> 16) & 0xff));
+  payload.push_back(static_cast<char>((stream_id >> 8) & 0xff));
+  payload.push_back(static_cast<char>(stream_id & 0xff));
+  payload.append(priority_field);
+
+  DCHECK(buffered_spdy_framer_.get());
+  spdy::SpdyUnknownIR frame(/* stream_id = */ 0, kPriorityUpdateFrameType,
+                            /* flags = */ 0, std::move(payload));
+  auto serialized_frame = std::make_unique<spdy::SpdySerializedFrame>(
+      buffered_spdy_framer_->SerializeFrame(frame));
+
+  // Like PRIORITY frames, PRIORITY_UPDATE frames for a stream must arrive in
+  // the order they were sent, so they are all queued at HIGHEST priority.
+  EnqueueWrite(HIGHEST,
+               static_cast<spdy::SpdyFrameType>(kPriorityUpdateFrameType),
+               std::make_unique<SimpleBufferProducer>(
+                   std::make_unique<SpdyBuffer>(std::move(serialized_frame))),
+               base::WeakPtr<SpdyStream>(),
+               kSpdySessionCommandsTrafficAnnotation);
+}
+
 void SpdySession::PumpReadLoop(ReadState expected_read_state, int result) {
   CHECK(!in_io_loop_);
   if (availability_state_ == STATE_DRAINING) {
@@ -2295,14 +2461,18 @@ int SpdySession::DoReadLoop(ReadState expected_read_state, int result) {
 }
 
 int SpdySession::DoRead() {
-  DCHECK(!read_buffer_);
   CHECK(in_io_loop_);
 
   CHECK(socket_);
   read_state_ = READ_STATE_DO_READ_COMPLETE;
-  read_buffer_ = base::MakeRefCounted<IOBuffer>(kReadBufferSize);
+  // Reuse the previous read's buffer, unless it has been resized or streams
+  // still hold slices of it.
+  if (!read_buffer_ || !read_buffer_->HasOneRef() ||
+      read_buffer_->size() != read_buffer_size_) {
+    read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(read_buffer_size_);
+  }
   int rv = socket_->ReadIfReady(
-      read_buffer_.get(), kReadBufferSize,
+      read_buffer_.get(), read_buffer_->size(),
       base::BindOnce(&SpdySession::PumpReadLoop, weak_factory_.GetWeakPtr(),
                      READ_STATE_DO_READ));
   if (rv == ERR_IO_PENDING) {
@@ -2313,7 +2483,7 @@ int SpdySession::DoRead() {
   if (rv == ERR_READ_IF_READY_NOT_IMPLEMENTED) {
     // Fallback to regular Read().
     return socket_->Read(
-        read_buffer_.get(), kReadBufferSize,
+        read_buffer_.get(), read_buffer_->size(),
         base::BindOnce(&SpdySession::PumpReadLoop, weak_factory_.GetWeakPtr(),
                        READ_STATE_DO_READ_COMPLETE));
   }
@@ -2325,7 +2495,7 @@ int SpdySession::DoReadComplete(int result) {
   CHECK(in_io_loop_);
 
   // Parse a frame.  For now this code requires that the frame fit into our
-  // buffer (kReadBufferSize).
+  // buffer (|read_buffer_size_|).
   // TODO(mbelshe): support arbitrarily large frames!
 
   if (result == 0) {
@@ -2339,9 +2509,10 @@ int SpdySession::DoReadComplete(int result) {
         base::StringPrintf("Error %d reading from socket.", -result));
     return result;
   }
-  CHECK_LE(result, kReadBufferSize);
+  CHECK_LE(result, read_buffer_->size());
 
   last_read_time_ = time_func_();
+  UpdateReadBufferSize(result);
 
   DCHECK(buffered_spdy_framer_.get());
   char* data = read_buffer_->data();
@@ -2359,11 +2530,29 @@ int SpdySession::DoReadComplete(int result) {
               http2::Http2DecoderAdapter::SPDY_NO_ERROR);
   }
 
-  read_buffer_ = nullptr;
+  // |read_buffer_| is kept for the next read, which may reuse it.
   read_state_ = READ_STATE_DO_READ;
   return OK;
 }
 
+void SpdySession::UpdateReadBufferSize(int bytes_read) {
+  if (bytes_read == read_buffer_->size()) {
+    consecutive_small_reads_ = 0;
+    read_buffer_size_ = std::min(2 * read_buffer_size_, kMaxReadBufferSize);
+    return;
+  }
+
+  if (bytes_read > read_buffer_->size() / 4) {
+    consecutive_small_reads_ = 0;
+    return;
+  }
+
+  if (++consecutive_small_reads_ >= kSmallReadsBeforeShrinking) {
+    consecutive_small_reads_ = 0;
+    read_buffer_size_ = std::max(read_buffer_size_ / 2, kMinReadBufferSize);
+  }
+}
+
 void SpdySession::PumpWriteLoop(WriteState expected_write_state, int result) {
   CHECK(!in_io_loop_);
   DCHECK_EQ(write_state_, expected_write_state);
@@ -2434,45 +2623,16 @@ int SpdySession::DoWrite() {
     DCHECK_GT(in_flight_write_->GetRemainingSize(), 0u);
   } else {
     // Grab the next frame to send.
-    spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::DATA;
-    std::unique_ptr<SpdyBufferProducer> producer;
-    base::WeakPtr<SpdyStream> stream;
-    if (!write_queue_.Dequeue(&frame_type, &producer, &stream,
-                              &in_flight_write_traffic_annotation)) {
+    int rv =
+        DequeueWrite(&in_flight_write_traffic_annotation, &in_flight_write_);
+    if (rv == ERR_IO_PENDING) {
       write_state_ = WRITE_STATE_IDLE;
       return ERR_IO_PENDING;
     }
-
-    if (stream.get())
-      CHECK(!stream->IsClosed());
-
-    // Activate the stream only when sending the HEADERS frame to
-    // guarantee monotonically-increasing stream IDs.
-    if (frame_type == spdy::SpdyFrameType::HEADERS) {
-      CHECK(stream.get());
-      CHECK_EQ(stream->stream_id(), 0u);
-      std::unique_ptr<SpdyStream> owned_stream =
-          ActivateCreatedStream(stream.get());
-      InsertActivatedStream(std::move(owned_stream));
-
-      if (stream_hi_water_mark_ > kLastStreamId) {
-        CHECK_EQ(stream->stream_id(), kLastStreamId);
-        // We've exhausted the stream ID space, and no new streams may be
-        // created after this one.
-        MakeUnavailable();
-        StartGoingAway(kLastStreamId, ERR_HTTP2_PROTOCOL_ERROR);
-      }
-    }
-
-    in_flight_write_ = producer->ProduceBuffer();
-    if (!in_flight_write_) {
-      NOTREACHED();
-      return ERR_UNEXPECTED;
-    }
-    in_flight_write_frame_type_ = frame_type;
-    in_flight_write_frame_size_ = in_flight_write_->GetRemainingSize();
-    DCHECK_GE(in_flight_write_frame_size_, spdy::kFrameMinimumSize);
-    in_flight_write_stream_ = stream;
+    if (rv != OK)
+      return rv;
+    if (max_write_coalescing_bytes_ > 0)
+      CoalesceQueuedWrites();
   }
 
   write_state_ = WRITE_STATE_DO_WRITE_COMPLETE;
@@ -2494,9 +2654,8 @@ int SpdySession::DoWriteComplete(int result) {
   if (result < 0) {
     DCHECK_NE(result, ERR_IO_PENDING);
     in_flight_write_.reset();
-    in_flight_write_frame_type_ = spdy::SpdyFrameType::DATA;
-    in_flight_write_frame_size_ = 0;
-    in_flight_write_stream_.reset();
+    in_flight_write_frames_.clear();
+    in_flight_write_frame_bytes_written_ = 0;
     in_flight_write_traffic_annotation.reset();
     write_state_ = WRITE_STATE_DO_WRITE;
     DoDrainSession(static_cast<Error>(result), "Write error");
@@ -2509,24 +2668,39 @@ int SpdySession::DoWriteComplete(int result) {
 
   if (result > 0) {
     in_flight_write_->Consume(static_cast<size_t>(result));
-    if (in_flight_write_stream_.get())
-      in_flight_write_stream_->AddRawSentBytes(static_cast<size_t>(result));
 
-    // We only notify the stream when we've fully written the pending frame.
-    if (in_flight_write_->GetRemainingSize() == 0) {
+    // Attribute the written bytes to the frames they belong to.
+    size_t bytes_to_attribute = static_cast<size_t>(result);
+    while (bytes_to_attribute > 0) {
+      DCHECK(!in_flight_write_frames_.empty());
+      InFlightFrame& frame = in_flight_write_frames_.front();
+      size_t frame_bytes =
+          std::min(bytes_to_attribute,
+                   frame.size - in_flight_write_frame_bytes_written_);
+      if (frame.stream.get())
+        frame.stream->AddRawSentBytes(frame_bytes);
+      in_flight_write_frame_bytes_written_ += frame_bytes;
+      bytes_to_attribute -= frame_bytes;
+
+      // We only notify the stream when we've fully written the pending frame.
+      if (in_flight_write_frame_bytes_written_ < frame.size)
+        break;
+      InFlightFrame written_frame = std::move(frame);
+      in_flight_write_frames_.pop_front();
+      in_flight_write_frame_bytes_written_ = 0;
       // It is possible that the stream was cancelled while we were
       // writing to the socket.
-      if (in_flight_write_stream_.get()) {
-        DCHECK_GT(in_flight_write_frame_size_, 0u);
-        in_flight_write_stream_->OnFrameWriteComplete(
-            in_flight_write_frame_type_, in_flight_write_frame_size_);
+      if (written_frame.stream.get()) {
+        DCHECK_GT(written_frame.size, 0u);
+        written_frame.stream->OnFrameWriteComplete(written_frame.type,
+                                                   written_frame.size);
       }
+    }
 
+    if (in_flight_write_->GetRemainingSize() == 0) {
+      DCHECK(in_flight_write_frames_.empty());
       // Cleanup the write which just completed.
       in_flight_write_.reset();
-      in_flight_write_frame_type_ = spdy::SpdyFrameType::DATA;
-      in_flight_write_frame_size_ = 0;
-      in_flight_write_stream_.reset();
     }
   }
 
@@ -2534,6 +2708,89 @@ int SpdySession::DoWriteComplete(int result) {
   return OK;
 }
 
+int SpdySession::DequeueWrite(
+    MutableNetworkTrafficAnnotationTag* traffic_annotation,
+    std::unique_ptr<SpdyBuffer>* buffer) {
+  spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::DATA;
+  std::unique_ptr<SpdyBufferProducer> producer;
+  base::WeakPtr<SpdyStream> stream;
+  if (!write_queue_.Dequeue(&frame_type, &producer, &stream,
+                            traffic_annotation)) {
+    return ERR_IO_PENDING;
+  }
+
+  if (stream.get())
+    CHECK(!stream->IsClosed());
+
+  // Activate the stream only when sending the HEADERS frame to
+  // guarantee monotonically-increasing stream IDs.
+  if (frame_type == spdy::SpdyFrameType::HEADERS) {
+    CHECK(stream.get());
+    CHECK_EQ(stream->stream_id(), 0u);
+    std::unique_ptr<SpdyStream> owned_stream =
+        ActivateCreatedStream(stream.get());
+    InsertActivatedStream(std::move(owned_stream));
+
+    if (stream_hi_water_mark_ > kLastStreamId) {
+      CHECK_EQ(stream->stream_id(), kLastStreamId);
+      // We've exhausted the stream ID space, and no new streams may be
+      // created after this one.
+      MakeUnavailable();
+      StartGoingAway(kLastStreamId, ERR_HTTP2_PROTOCOL_ERROR);
+    }
+  }
+
+  *buffer = producer->ProduceBuffer();
+  if (!*buffer) {
+    NOTREACHED();
+    return ERR_UNEXPECTED;
+  }
+  size_t frame_size = (*buffer)->GetRemainingSize();
+  DCHECK_GE(frame_size, spdy::kFrameMinimumSize);
+  in_flight_write_frames_.push_back(InFlightFrame{frame_type, frame_size,
+                                                  stream});
+  return OK;
+}
+
+void SpdySession::CoalesceQueuedWrites() {
+  DCHECK(in_flight_write_);
+  DCHECK_EQ(1u, in_flight_write_frames_.size());
+
+  size_t total_size = in_flight_write_->GetRemainingSize();
+  std::vector<std::unique_ptr<SpdyBuffer>> buffers;
+  // Frames are dequeued in priority order, as they would be for writes of
+  // their own. A frame with a different traffic annotation ends the write,
+  // as a socket write only carries one.
+  while (total_size < max_write_coalescing_bytes_ &&
+         availability_state_ != STATE_DRAINING &&
+         write_queue_.IsNextWriteAnnotatedWith(
+             in_flight_write_traffic_annotation)) {
+    MutableNetworkTrafficAnnotationTag traffic_annotation;
+    std::unique_ptr<SpdyBuffer> buffer;
+    if (DequeueWrite(&traffic_annotation, &buffer) != OK)
+      break;
+    total_size += buffer->GetRemainingSize();
+    buffers.push_back(std::move(buffer));
+  }
+  if (buffers.empty())
+    return;
+
+  buffers.insert(buffers.begin(), std::move(in_flight_write_));
+  auto data = std::make_unique<char[]>(total_size);
+  size_t offset = 0;
+  for (const auto& buffer : buffers) {
+    size_t size = buffer->GetRemainingSize();
+    memcpy(data.get() + offset, buffer->GetRemainingData(), size);
+    offset += size;
+    // The frame is written from the coalesced buffer from now on.
+    buffer->Consume(size);
+  }
+  DCHECK_EQ(total_size, offset);
+  in_flight_write_ =
+      std::make_unique<SpdyBuffer>(std::make_unique<spdy::SpdySerializedFrame>(
+          data.release(), total_size, true /* owns_buffer */));
+}
+
 void SpdySession::NotifyRequestsOfConfirmation(int rv) {
   for (auto& callback : waiting_for_confirmation_callbacks_) {
     base::ThreadTaskRunnerHandle::Get()->PostTask(
@@ -2660,6 +2917,14 @@ void SpdySession::HandleSetting(uint32_t id, uint32_t value) {
         support_websocket_ = true;
       }
       break;
+    case kSettingsNoRfc7540Priorities:
+      if (value != 0 && value != 1) {
+        DoDrainSession(ERR_HTTP2_PROTOCOL_ERROR,
+                       "Invalid value for SETTINGS_NO_RFC7540_PRIORITIES.");
+        return;
+      }
+      deprecate_http2_priorities_ = value == 1;
+      break;
   }
 }
 
@@ -2701,6 +2966,37 @@ void SpdySession::MaybeSendPrefacePing() {
     WritePingFrame(next_ping_id_, false);
 }
 
+void SpdySession::PlanToSendPeriodicPing() {
+  DCHECK(!periodic_ping_interval_.is_zero());
+  DCHECK(!periodic_ping_planned_);
+  periodic_ping_planned_ = true;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SpdySession::SendPeriodicPing,
+                     weak_factory_.GetWeakPtr()),
+      periodic_ping_interval_);
+}
+
+void SpdySession::SendPeriodicPing() {
+  DCHECK(periodic_ping_planned_);
+  periodic_ping_planned_ = false;
+  if (availability_state_ == STATE_DRAINING)
+    return;
+
+  // Idle sessions are left alone; InsertActivatedStream() plans the next PING
+  // once there is a stream again.
+  if (!is_active() && !periodic_ping_idle_sessions_)
+    return;
+
+  // Unlike a preface PING, this is sent even if data has just been read, so
+  // that busy sessions get their round trip time sampled too.
+  if (!ping_in_flight_ && !check_ping_status_pending_ &&
+      enable_ping_based_connection_checking_) {
+    WritePingFrame(next_ping_id_, false);
+  }
+  PlanToSendPeriodicPing();
+}
+
 void SpdySession::SendWindowUpdateFrame(spdy::SpdyStreamId stream_id,
                                         uint32_t delta_window_size,
                                         RequestPriority priority) {
@@ -2870,15 +3166,20 @@ void SpdySession::InsertActivatedStream(std::unique_ptr<SpdyStream> stream) {
       active_streams_.insert(std::make_pair(stream_id, stream.get()));
   CHECK(result.second);
   ignore_result(stream.release());
+
+  if (!periodic_ping_interval_.is_zero() && !periodic_ping_planned_)
+    PlanToSendPeriodicPing();
 }
 
 void SpdySession::DeleteStream(std::unique_ptr<SpdyStream> stream, int status) {
-  if (in_flight_write_stream_.get() == stream.get()) {
-    // If we're deleting the stream for the in-flight write, we still
-    // need to let the write complete, so we clear
-    // |in_flight_write_stream_| and let the write finish on its own
-    // without notifying |in_flight_write_stream_|.
-    in_flight_write_stream_.reset();
+  for (InFlightFrame& frame : in_flight_write_frames_) {
+    if (frame.stream.get() == stream.get()) {
+      // If we're deleting the stream for an in-flight write, we still
+      // need to let the write complete, so we clear the frame's stream
+      // and let the write finish on its own without notifying the
+      // stream.
+      frame.stream.reset();
+    }
   }
 
   write_queue_.RemovePendingWritesForStream(stream.get());
@@ -3106,6 +3407,7 @@ void SpdySession::OnPing(spdy::SpdyPingId unique_id, bool is_ack) {
 
   // Record RTT in histogram when there are no more pings in flight.
   base::TimeDelta ping_duration = time_func_() - last_ping_sent_time_;
+  last_ping_rtt_ = ping_duration;
   if (network_quality_estimator_) {
     network_quality_estimator_->RecordSpdyPingLatency(host_port_pair(),
                                                       ping_duration);
@@ -3221,8 +3523,18 @@ void SpdySession::OnStreamFrameData(spdy::SpdyStreamId stream_id,
   std::unique_ptr<SpdyBuffer> buffer;
   if (data) {
     DCHECK_GT(len, 0u);
-    CHECK_LE(len, static_cast<size_t>(kReadBufferSize));
-    buffer = std::make_unique<SpdyBuffer>(data, len);
+    CHECK_LE(len, static_cast<size_t>(kMaxReadBufferSize));
+    // |read_buffer_| is not reused while slices of it are held, so a payload
+    // that lies within it can be handed to the stream without copying it.
+    if (read_buffer_ &&
+        len >= static_cast<size_t>(read_buffer_->size() /
+                                   kMinReadBufferSliceFraction) &&
+        data >= read_buffer_->data() &&
+        data + len <= read_buffer_->data() + read_buffer_->size()) {
+      buffer = std::make_unique<SpdyBuffer>(read_buffer_, data, len);
+    } else {
+      buffer = std::make_unique<SpdyBuffer>(data, len);
+    }
 
     DecreaseRecvWindowSize(static_cast<int32_t>(len));
     buffer->AddConsumeCallback(base::BindRepeating(
@@ -3549,7 +3861,8 @@ void SpdySession::DecreaseSendWindowSize(int32_t delta_window_size) {
   // We only call this method when sending a frame. Therefore,
   // |delta_window_size| should be within the valid frame size range.
   DCHECK_GE(delta_window_size, 1);
-  DCHECK_LE(delta_window_size, kMaxSpdyFrameChunkSize);
+  DCHECK_LE(delta_window_size,
+            static_cast<int32_t>(spdy::kHttp2DefaultFramePayloadLimit));
 
   // |send_window_size_| should have been at least |delta_window_size| for
   // this call to happen.
@@ -3590,13 +3903,105 @@ void SpdySession::IncreaseRecvWindowSize(int32_t delta_window_size) {
   });
 
   session_unacked_recv_window_bytes_ += delta_window_size;
+
+  // Once ShrinkRecvWindows() has reduced the maximum, hold back credit until
+  // the window fits within it again.
+  if (enable_recv_window_auto_tuning_ &&
+      session_recv_window_size_ > session_max_recv_window_size_) {
+    const int32_t excess =
+        std::min(session_unacked_recv_window_bytes_,
+                 session_recv_window_size_ - session_max_recv_window_size_);
+    session_recv_window_size_ -= excess;
+    session_unacked_recv_window_bytes_ -= excess;
+  }
+
   if (session_unacked_recv_window_bytes_ > session_max_recv_window_size_ / 2) {
+    if (enable_recv_window_auto_tuning_) {
+      const int32_t max_recv_window_size = AutoTuneRecvWindowSize(
+          session_max_recv_window_size_, &last_session_window_update_time_);
+      if (max_recv_window_size > session_max_recv_window_size_)
+        GrowRecvWindowSize(max_recv_window_size);
+      // Keep the round trip time measurement auto-tuning relies on fresh.
+      if (!ping_in_flight_ &&
+          (last_ping_rtt_.is_zero() ||
+           time_func_() - last_ping_sent_time_ >
+               base::TimeDelta::FromSeconds(
+                   kRecvWindowAutoTuningPingIntervalSeconds))) {
+        WritePingFrame(next_ping_id_, false);
+      }
+    }
     SendWindowUpdateFrame(spdy::kSessionFlowControlStreamId,
                           session_unacked_recv_window_bytes_, HIGHEST);
     session_unacked_recv_window_bytes_ = 0;
   }
 }
 
+int32_t SpdySession::AutoTuneStreamRecvWindowSize(
+    int32_t max_recv_window_size,
+    base::TimeTicks* last_window_update_time) {
+  if (!enable_recv_window_auto_tuning_)
+    return max_recv_window_size;
+
+  const int32_t new_max_recv_window_size =
+      AutoTuneRecvWindowSize(max_recv_window_size, last_window_update_time);
+  if (new_max_recv_window_size > max_recv_window_size) {
+    // Keep the session window ahead of the stream's, so that a single
+    // stream isn't limited by the session window instead.
+    const int32_t session_max_recv_window_size = static_cast<int32_t>(
+        std::min<int64_t>(max_auto_tuned_recv_window_size_,
+                          int64_t{new_max_recv_window_size} * 3 / 2));
+    if (session_max_recv_window_size > session_max_recv_window_size_) {
+      GrowRecvWindowSize(session_max_recv_window_size);
+      if (session_unacked_recv_window_bytes_ >
+          session_max_recv_window_size_ / 2) {
+        SendWindowUpdateFrame(spdy::kSessionFlowControlStreamId,
+                              session_unacked_recv_window_bytes_, HIGHEST);
+        session_unacked_recv_window_bytes_ = 0;
+      }
+    }
+  }
+  return new_max_recv_window_size;
+}
+
+void SpdySession::ShrinkRecvWindows() {
+  if (!enable_recv_window_auto_tuning_)
+    return;
+
+  session_max_recv_window_size_ = initial_session_max_recv_window_size_;
+  for (const auto& it : active_streams_)
+    it.second->ShrinkMaxRecvWindowSize(stream_max_recv_window_size_);
+}
+
+int32_t SpdySession::AutoTuneRecvWindowSize(
+    int32_t max_recv_window_size,
+    base::TimeTicks* last_window_update_time) {
+  const base::TimeTicks now = time_func_();
+  const base::TimeTicks previous_window_update_time = *last_window_update_time;
+  *last_window_update_time = now;
+
+  if (previous_window_update_time.is_null() || last_ping_rtt_.is_zero() ||
+      now - previous_window_update_time >= 2 * last_ping_rtt_) {
+    return max_recv_window_size;
+  }
+  return static_cast<int32_t>(
+      std::max<int64_t>(max_recv_window_size,
+                        std::min<int64_t>(max_auto_tuned_recv_window_size_,
+                                          int64_t{max_recv_window_size} * 2)));
+}
+
+void SpdySession::GrowRecvWindowSize(int32_t max_recv_window_size) {
+  DCHECK_GT(max_recv_window_size, session_max_recv_window_size_);
+  const int32_t delta_window_size =
+      max_recv_window_size - session_max_recv_window_size_;
+  session_max_recv_window_size_ = max_recv_window_size;
+  session_recv_window_size_ += delta_window_size;
+  net_log_.AddEvent(NetLogEventType::HTTP2_SESSION_UPDATE_RECV_WINDOW, [&] {
+    return NetLogSpdySessionWindowUpdateParams(delta_window_size,
+                                               session_recv_window_size_);
+  });
+  session_unacked_recv_window_bytes_ += delta_window_size;
+}
+
 void SpdySession::DecreaseRecvWindowSize(int32_t delta_window_size) {
   CHECK(in_io_loop_);
   DCHECK_GE(delta_window_size, 1);
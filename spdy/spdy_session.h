@@ -467,7 +467,8 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
                                                int* effective_len,
                                                bool* end_stream);
 
-  // Send PRIORITY frames according to the new priority of an existing stream.
+  // Send PRIORITY or PRIORITY_UPDATE frames according to the new priority of
+  // an existing stream.
   void UpdateStreamPriority(SpdyStream* stream,
                             RequestPriority old_priority,
                             RequestPriority new_priority);
@@ -511,6 +512,23 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   void SendStreamWindowUpdate(spdy::SpdyStreamId stream_id,
                               uint32_t delta_window_size);
 
+  // Called by a stream that is about to send a WINDOW_UPDATE frame, with its
+  // maximum receive window size and the time its previous WINDOW_UPDATE was
+  // sent, which is updated to now. Returns the maximum receive window size
+  // the stream should use from now on, which is larger than
+  // |max_recv_window_size| if receive window auto-tuning finds the window
+  // limiting throughput. Also grows the session's receive window to keep up
+  // with the stream's.
+  int32_t AutoTuneStreamRecvWindowSize(
+      int32_t max_recv_window_size,
+      base::TimeTicks* last_window_update_time);
+
+  // Restores the maximum receive window size of the session and its streams
+  // to their configured values, if auto-tuning has grown them, so that no
+  // more data than that is buffered once the peer has used up the windows
+  // it's been given. Called under memory pressure.
+  void ShrinkRecvWindows();
+
   // Accessors for the session's availability state.
   bool IsAvailable() const { return availability_state_ == STATE_AVAILABLE; }
   bool IsGoingAway() const { return availability_state_ == STATE_GOING_AWAY; }
@@ -568,6 +586,14 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   bool GetLoadTimingInfo(spdy::SpdyStreamId stream_id,
                          LoadTimingInfo* load_timing_info) const;
 
+  // Returns true if a PING has gone unanswered, with nothing else read since
+  // it was sent, for several times the round trip time measured by the
+  // previous PING. The connection has then probably died, but
+  // CheckPingStatus() will not close the session until |hung_interval_| has
+  // passed. Always false until a round trip time has been measured, and false
+  // again as soon as the ACK or anything else is read.
+  bool IsPingOverdue() const;
+
   // Returns true if session is currently active.
   bool is_active() const {
     return !active_streams_.empty() || !created_streams_.empty();
@@ -622,6 +648,14 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   size_t DumpMemoryStats(StreamSocket::SocketMemoryStats* stats,
                          bool* is_session_active) const;
 
+  // Returns the estimate of dynamically allocated memory in bytes, not
+  // counting the underlying socket.
+  size_t EstimateMemoryUsage() const;
+
+  // Returns the part of EstimateMemoryUsage() taken up by HPACK state, which
+  // grows with the header table sizes of the session.
+  size_t EstimateHeaderCompressionMemoryUsage() const;
+
   // Change this session's socket tag to |new_tag|. Returns true on success.
   bool ChangeSocketTag(const SocketTag& new_tag);
 
@@ -740,6 +774,12 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
                             int weight,
                             bool exclusive);
 
+  // Send an RFC 9218 PRIORITY_UPDATE frame giving the stream |stream_id|
+  // |priority| and |incremental|.
+  void EnqueuePriorityUpdateFrame(spdy::SpdyStreamId stream_id,
+                                  RequestPriority priority,
+                                  bool incremental);
+
   // Calls DoReadLoop. Use this function instead of DoReadLoop when
   // posting a task to pump the read loop.
   void PumpReadLoop(ReadState expected_read_state, int result);
@@ -753,6 +793,10 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   int DoRead();
   int DoReadComplete(int result);
 
+  // Adjusts |read_buffer_size_| after a read of |bytes_read| bytes into
+  // |read_buffer_|.
+  void UpdateReadBufferSize(int bytes_read);
+
   // Calls DoWriteLoop. If |availability_state_| is STATE_DRAINING and no
   // writes remain, the session is removed from the session pool and
   // destroyed.
@@ -774,6 +818,18 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   int DoWrite();
   int DoWriteComplete(int result);
 
+  // Dequeues the next frame from |write_queue_| into |buffer|, activating
+  // its stream if it is a HEADERS frame, and appends it to
+  // |in_flight_write_frames_|. Returns ERR_IO_PENDING if there is nothing
+  // to write.
+  int DequeueWrite(MutableNetworkTrafficAnnotationTag* traffic_annotation,
+                   std::unique_ptr<SpdyBuffer>* buffer);
+
+  // Gathers the frames queued behind |in_flight_write_| into it, so that
+  // they are written to the socket together, until the write reaches
+  // |max_write_coalescing_bytes_|.
+  void CoalesceQueuedWrites();
+
   void NotifyRequestsOfConfirmation(int rv);
 
   // TODO(akalin): Rename the Send* and Write* functions below to
@@ -812,6 +868,15 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // haven't received any data in |kHungInterval| time period.
   void CheckPingStatus(base::TimeTicks last_check_time);
 
+  // Post a SendPeriodicPing call after |periodic_ping_interval_|.
+  void PlanToSendPeriodicPing();
+
+  // Send a PING frame unless one is in flight or CheckPingStatus() is pending,
+  // whether or not there has been read activity, then plan the next one.
+  // Stops once the session is draining, or while it has no streams unless
+  // |periodic_ping_idle_sessions_| is set.
+  void SendPeriodicPing();
+
   // Get a new stream id.
   spdy::SpdyStreamId GetNewStreamId();
 
@@ -957,8 +1022,8 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // If session flow control is turned on, called by CreateDataFrame()
   // (which is in turn called by a stream) to decrease this session's
   // send window size by |delta_window_size|, which must be at least 1
-  // and at most kMaxSpdyFrameChunkSize.  |delta_window_size| must not
-  // cause this session's send window size to go negative.
+  // and at most spdy::kHttp2DefaultFramePayloadLimit.  |delta_window_size|
+  // must not cause this session's send window size to go negative.
   //
   // If session flow control is turned off, this must not be called.
   void DecreaseSendWindowSize(int32_t delta_window_size);
@@ -988,6 +1053,20 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // If session flow control is turned off, this must not be called.
   void DecreaseRecvWindowSize(int32_t delta_window_size);
 
+  // With receive window auto-tuning, returns |max_recv_window_size| doubled,
+  // up to |max_auto_tuned_recv_window_size_|, if the WINDOW_UPDATE frame about
+  // to be sent for it follows the one sent at |*last_window_update_time| by
+  // less than two round trips. That means the peer uses up the window faster
+  // than once per round trip, i.e. the window is below the bandwidth-delay
+  // product. Otherwise returns |max_recv_window_size|. Updates
+  // |*last_window_update_time| to now either way.
+  int32_t AutoTuneRecvWindowSize(int32_t max_recv_window_size,
+                                 base::TimeTicks* last_window_update_time);
+
+  // Grows the session's maximum receive window size to
+  // |max_recv_window_size|, crediting the peer with the difference.
+  void GrowRecvWindowSize(int32_t max_recv_window_size);
+
   // Queue a send-stalled stream for possibly resuming once we're not
   // send-stalled anymore.
   void QueueSendStalledStream(const SpdyStream& stream);
@@ -1031,9 +1110,18 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // The socket for this session.
   StreamSocket* socket_;
 
-  // The read buffer used to read data from the socket.
-  // Non-null if there is a Read() pending.
-  scoped_refptr<IOBuffer> read_buffer_;
+  // The read buffer used to read data from the socket. Non-null if there is
+  // a Read() pending, and kept between reads in the same read loop so that it
+  // can be reused.
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+
+  // The size of the next read buffer, which grows while reads fill it and
+  // shrinks while they leave most of it unused.
+  int read_buffer_size_;
+
+  // The number of reads in a row that used no more than a quarter of the
+  // read buffer.
+  int consecutive_small_reads_;
 
   spdy::SpdyStreamId stream_hi_water_mark_;  // The next stream id to use.
 
@@ -1085,17 +1173,29 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // The write queue.
   SpdyWriteQueue write_queue_;
 
-  // Data for the frame we are currently sending.
+  // Data for the frames we are currently sending.
+
+  // A frame in |in_flight_write_|.
+  struct InFlightFrame {
+    spdy::SpdyFrameType type;
+    size_t size;
+    // The stream to notify when the frame has been written to the socket
+    // completely.
+    base::WeakPtr<SpdyStream> stream;
+  };
 
-  // The buffer we're currently writing.
+  // The buffer we're currently writing. Holds a single frame, unless
+  // frames are coalesced into one write.
   std::unique_ptr<SpdyBuffer> in_flight_write_;
-  // The type of the frame in |in_flight_write_|.
-  spdy::SpdyFrameType in_flight_write_frame_type_;
-  // The size of the frame in |in_flight_write_|.
-  size_t in_flight_write_frame_size_;
-  // The stream to notify when |in_flight_write_| has been written to
-  // the socket completely.
-  base::WeakPtr<SpdyStream> in_flight_write_stream_;
+  // The frames in |in_flight_write_|, in the order they are written.
+  base::circular_deque<InFlightFrame> in_flight_write_frames_;
+  // The number of bytes of the first of |in_flight_write_frames_| that
+  // have already been written.
+  size_t in_flight_write_frame_bytes_written_;
+
+  // Once a write holds this many bytes, no more queued frames are
+  // coalesced into it. Zero if frames are always written one by one.
+  const size_t max_write_coalescing_bytes_;
 
   // Traffic annotation for the write in progress.
   MutableNetworkTrafficAnnotationTag in_flight_write_traffic_annotation;
@@ -1208,6 +1308,37 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // window size.
   int32_t stream_max_recv_window_size_;
 
+  // Whether receive windows grow with the measured bandwidth-delay product,
+  // and the size they may grow to.
+  const bool enable_recv_window_auto_tuning_;
+  const int32_t max_auto_tuned_recv_window_size_;
+
+  // The configured maximum receive window size of the session, which
+  // ShrinkRecvWindows() restores.
+  const int32_t initial_session_max_recv_window_size_;
+
+  // Whether reprioritization is signalled with RFC 9218 PRIORITY_UPDATE
+  // frames.
+  const bool enable_priority_update_;
+
+  // The interval at which PINGs are sent to sample the round trip time, or
+  // zero if they are only sent as preface PINGs and for auto-tuning.
+  const base::TimeDelta periodic_ping_interval_;
+
+  // Whether periodic PINGs are also sent while there are no streams.
+  const bool periodic_ping_idle_sessions_;
+
+  // Whether a SendPeriodicPing() task is posted.
+  bool periodic_ping_planned_;
+
+  // The time the last session WINDOW_UPDATE frame was sent. Only tracked
+  // with receive window auto-tuning.
+  base::TimeTicks last_session_window_update_time_;
+
+  // The round trip time measured by the last PING, or zero if none has been
+  // acknowledged yet.
+  base::TimeDelta last_ping_rtt_;
+
   // A queue of stream IDs that have been send-stalled at some point
   // in the past.
   base::circular_deque<spdy::SpdyStreamId>
@@ -1238,6 +1369,15 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // https://tools.ietf.org/html/draft-ietf-httpbis-h2-websockets-00.
   bool support_websocket_;
 
+  // Whether the server certificate covers each hostname that
+  // VerifyDomainAuthentication() has been asked about. Bounded by clearing it
+  // when it grows too large.
+  mutable std::map<std::string, bool> cert_coverage_cache_;
+
+  // True if the server has announced with SETTINGS_NO_RFC7540_PRIORITIES
+  // that it ignores RFC 7540 priorities, in which case none are sent.
+  bool deprecate_http2_priorities_;
+
   // |connection_at_risk_of_loss_time_| is an optimization to avoid sending
   // wasteful preface pings (when we just got some data).
   //
@@ -0,0 +1,256 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_session.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/check_op.h"
+#include "base/run_loop.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_server.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_network_session.h"
+#include "net/log/net_log_source.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/spdy/spdy_buffer.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/spdy/spdy_stream.h"
+#include "net/spdy/spdy_test_util_common.h"
+#include "net/test/test_with_task_environment.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+const char kUrl[] = "https://www.example.org/";
+const size_t kBodySize = 32 * 1024 * 1024;
+const int32_t kSessionMaxRecvWindowSize = 15 * 1024 * 1024;
+const int32_t kStreamMaxRecvWindowSize = 6 * 1024 * 1024;
+
+static constexpr char kMetricPrefixSpdySession[] = "SpdySession.";
+static constexpr char kMetricThroughput[] = "throughput";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixSpdySession, story);
+  reporter.RegisterImportantMetric(kMetricThroughput, "MBytes/s");
+  return reporter;
+}
+
+// Accepts a single connection and, once told to, writes |response| to it as
+// fast as the connection allows, discarding whatever the client sends.
+class LoopbackServer {
+ public:
+  explicit LoopbackServer(const std::string& response)
+      : server_socket_(nullptr, NetLogSource()),
+        response_(base::MakeRefCounted<DrainableIOBuffer>(
+            base::MakeRefCounted<StringIOBuffer>(response),
+            response.size())),
+        read_buffer_(base::MakeRefCounted<IOBufferWithSize>(4096)) {}
+
+  int Listen(IPEndPoint* address) {
+    int rv =
+        server_socket_.Listen(IPEndPoint(IPAddress::IPv4Localhost(), 0), 1);
+    if (rv != OK)
+      return rv;
+    rv = server_socket_.GetLocalAddress(address);
+    if (rv != OK)
+      return rv;
+    rv = server_socket_.Accept(
+        &socket_,
+        base::BindOnce(&LoopbackServer::OnAccepted, base::Unretained(this)));
+    return rv == ERR_IO_PENDING ? OK : rv;
+  }
+
+  void StartSending() {
+    CHECK(socket_);
+    DoWrite();
+  }
+
+ private:
+  void OnAccepted(int rv) {
+    CHECK_EQ(OK, rv);
+    DoRead();
+  }
+
+  void DoRead() {
+    int rv = socket_->Read(
+        read_buffer_.get(), read_buffer_->size(),
+        base::BindOnce(&LoopbackServer::OnRead, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnRead(rv);
+  }
+
+  void OnRead(int rv) {
+    if (rv > 0)
+      DoRead();
+  }
+
+  void DoWrite() {
+    int rv = socket_->Write(
+        response_.get(), response_->BytesRemaining(),
+        base::BindOnce(&LoopbackServer::OnWritten, base::Unretained(this)),
+        TRAFFIC_ANNOTATION_FOR_TESTS);
+    if (rv != ERR_IO_PENDING)
+      OnWritten(rv);
+  }
+
+  void OnWritten(int rv) {
+    CHECK_GT(rv, 0);
+    response_->DidConsume(rv);
+    if (response_->BytesRemaining() > 0)
+      DoWrite();
+  }
+
+  TCPServerSocket server_socket_;
+  std::unique_ptr<StreamSocket> socket_;
+  scoped_refptr<DrainableIOBuffer> response_;
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+};
+
+// Counts and drops the response body, so that the receive window is
+// replenished as soon as data is delivered.
+class DiscardingDelegate : public SpdyStream::Delegate {
+ public:
+  DiscardingDelegate(base::OnceClosure headers_sent_closure,
+                     base::OnceClosure close_closure)
+      : headers_sent_closure_(std::move(headers_sent_closure)),
+        close_closure_(std::move(close_closure)) {}
+
+  size_t bytes_received() const { return bytes_received_; }
+  int status() const { return status_; }
+
+  void OnHeadersSent() override { std::move(headers_sent_closure_).Run(); }
+  void OnHeadersReceived(
+      const spdy::SpdyHeaderBlock& response_headers,
+      const spdy::SpdyHeaderBlock* pushed_request_headers) override {}
+  void OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) override {
+    if (buffer)
+      bytes_received_ += buffer->GetRemainingSize();
+  }
+  void OnDataSent() override {}
+  void OnTrailers(const spdy::SpdyHeaderBlock& trailers) override {}
+  void OnClose(int status) override {
+    status_ = status;
+    std::move(close_closure_).Run();
+  }
+  bool CanGreaseFrameType() const override { return false; }
+  NetLogSource source_dependency() const override { return NetLogSource(); }
+
+ private:
+  base::OnceClosure headers_sent_closure_;
+  base::OnceClosure close_closure_;
+  size_t bytes_received_ = 0;
+  int status_ = ERR_IO_PENDING;
+};
+
+class SpdySessionPerfTest : public TestWithTaskEnvironment {
+ protected:
+  // Downloads a |kBodySize| byte response, sent in DATA frames of
+  // |frame_size| bytes, over a loopback TCP connection, and reports the
+  // throughput.
+  void RunDownload(const std::string& story, size_t frame_size) {
+    SpdyTestUtil spdy_util;
+    std::string response;
+    spdy::SpdySerializedFrame reply(
+        spdy_util.ConstructSpdyGetReply(nullptr, 0, 1));
+    response.append(reply.data(), reply.size());
+    const std::string payload(frame_size, 'a');
+    for (size_t sent = 0; sent < kBodySize; sent += frame_size) {
+      spdy::SpdySerializedFrame data(spdy_util.ConstructSpdyDataFrame(
+          1, payload, sent + frame_size >= kBodySize));
+      response.append(data.data(), data.size());
+    }
+
+    LoopbackServer server(response);
+    IPEndPoint address;
+    ASSERT_EQ(OK, server.Listen(&address));
+
+    auto socket = std::make_unique<TCPClientSocket>(
+        AddressList(address), nullptr, nullptr, nullptr, NetLogSource());
+    TestCompletionCallback connect_callback;
+    ASSERT_EQ(OK, connect_callback.GetResult(
+                      socket->Connect(connect_callback.callback())));
+
+    SpdySessionDependencies session_deps;
+    session_deps.session_max_recv_window_size = kSessionMaxRecvWindowSize;
+    session_deps.http2_settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] =
+        kStreamMaxRecvWindowSize;
+    std::unique_ptr<HttpNetworkSession> http_session =
+        SpdySessionDependencies::SpdyCreateSession(&session_deps);
+    // Announce the receive windows to the server.
+    SpdySessionPoolPeer(http_session->spdy_session_pool())
+        .SetEnableSendingInitialData(true);
+    const SpdySessionKey key(HostPortPair::FromURL(GURL(kUrl)),
+                             ProxyServer::Direct(), PRIVACY_MODE_DISABLED,
+                             SpdySessionKey::IsProxySession::kFalse,
+                             SocketTag(), NetworkIsolationKey(),
+                             false /* disable_secure_dns */);
+    auto handle = std::make_unique<ClientSocketHandle>();
+    handle->SetSocket(std::move(socket));
+    base::WeakPtr<SpdySession> session =
+        http_session->spdy_session_pool()
+            ->CreateAvailableSessionFromSocketHandle(
+                key, false /* is_trusted_proxy */, std::move(handle),
+                NetLogWithSource());
+    ASSERT_TRUE(session);
+
+    base::WeakPtr<SpdyStream> stream =
+        CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session,
+                                  GURL(kUrl), LOWEST, NetLogWithSource());
+    ASSERT_TRUE(stream);
+    base::RunLoop headers_sent_loop;
+    base::RunLoop close_loop;
+    DiscardingDelegate delegate(headers_sent_loop.QuitClosure(),
+                                close_loop.QuitClosure());
+    stream->SetDelegate(&delegate);
+    stream->SendRequestHeaders(spdy_util.ConstructGetHeaderBlock(kUrl),
+                               NO_MORE_DATA_TO_SEND);
+    // Wait for the request to go out, so that the stream exists by the time
+    // the response arrives.
+    headers_sent_loop.Run();
+
+    base::ElapsedTimer timer;
+    server.StartSending();
+    close_loop.Run();
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    EXPECT_EQ(OK, delegate.status());
+    EXPECT_EQ(kBodySize, delegate.bytes_received());
+
+    auto reporter = SetUpReporter(story);
+    reporter.AddResult(kMetricThroughput,
+                       kBodySize / elapsed.InSecondsF() / (1024 * 1024));
+  }
+};
+
+TEST_F(SpdySessionPerfTest, LoopbackDownload) {
+  RunDownload("16KB_frames", 16 * 1024);
+  RunDownload("1KB_frames", 1024);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -4,6 +4,8 @@
 
 #include "net/spdy/spdy_session_pool.h"
 
+#include <inttypes.h>
+
 #include <algorithm>
 #include <utility>
 
@@ -88,6 +90,7 @@ SpdySessionPool::SpdySessionPool(
     size_t session_max_recv_window_size,
     int session_max_queued_capped_frames,
     const spdy::SettingsMap& initial_settings,
+    const HeaderTableSizeMap& origin_header_table_sizes,
     const base::Optional<GreasedHttp2Frame>& greased_http2_frame,
     bool http2_end_stream_with_data_frame,
     SpdySessionPool::TimeFunc time_func,
@@ -105,6 +108,7 @@ SpdySessionPool::SpdySessionPool(
       session_max_recv_window_size_(session_max_recv_window_size),
       session_max_queued_capped_frames_(session_max_queued_capped_frames),
       initial_settings_(initial_settings),
+      origin_header_table_sizes_(origin_header_table_sizes),
       greased_http2_frame_(greased_http2_frame),
       http2_end_stream_with_data_frame_(http2_end_stream_with_data_frame),
       time_func_(time_func),
@@ -185,6 +189,17 @@ base::WeakPtr<SpdySession> SpdySessionPool::FindAvailableSession(
     return base::WeakPtr<SpdySession>();
   }
 
+  // A session whose PING is overdue has probably lost its connection, e.g. to
+  // a network change. Rather than have the request wait for CheckPingStatus()
+  // to close it, make a new connection for it. The session stays available,
+  // in case the PING is merely late, until InsertSession() replaces it.
+  if (it->second->IsPingOverdue()) {
+    net_log.AddEventReferencingSource(
+        NetLogEventType::HTTP2_SESSION_POOL_SKIPPED_SESSION_WITH_OVERDUE_PING,
+        it->second->net_log().source());
+    return base::WeakPtr<SpdySession>();
+  }
+
   if (key == it->second->spdy_session_key()) {
     UMA_HISTOGRAM_ENUMERATION("Net.SpdySessionGet", FOUND_EXISTING,
                               SPDY_SESSION_GET_MAX);
@@ -267,7 +282,8 @@ OnHostResolutionCallbackResult SpdySessionPool::OnHostResolutionComplete(
   }
 
   for (const auto& address : addresses) {
-    auto range = aliases_.equal_range(address);
+    auto range =
+        aliases_.equal_range(AliasAddress(address, key.privacy_mode()));
     for (auto alias_it = range.first; alias_it != range.second; ++alias_it) {
       // We found a potential alias.
       const SpdySessionKey& alias_key = alias_it->second;
@@ -331,8 +347,10 @@ OnHostResolutionCallbackResult SpdySessionPool::OnHostResolutionComplete(
 
         // Remap alias. From this point on |alias_it| is invalid, so no more
         // iterations of the loop should be allowed.
-        aliases_.insert(AliasMap::value_type(alias_it->first, new_key));
-        aliases_.erase(alias_it);
+        const IPEndPoint alias_address = alias_it->first.first;
+        const SpdySessionKey old_alias_key = alias_it->second;
+        RemoveAliases(old_alias_key);
+        AddAlias(alias_address, new_key);
 
         // Remap pooled session keys.
         const auto& aliases = available_session->pooled_aliases();
@@ -433,6 +451,11 @@ void SpdySessionPool::CloseAllSessions() {
   }
 }
 
+void SpdySessionPool::ShrinkRecvWindows() {
+  for (SpdySession* session : sessions_)
+    session->ShrinkRecvWindows();
+}
+
 std::unique_ptr<base::Value> SpdySessionPool::SpdySessionPoolInfoToValue()
     const {
   auto list = std::make_unique<base::ListValue>();
@@ -521,20 +544,47 @@ void SpdySessionPool::DumpMemoryStats(
     const std::string& parent_dump_absolute_name) const {
   if (sessions_.empty())
     return;
+  const bool dump_sessions =
+      pmd->dump_args().level_of_detail ==
+      base::trace_event::MemoryDumpLevelOfDetail::DETAILED;
   size_t total_size = 0;
   size_t buffer_size = 0;
   size_t cert_count = 0;
   size_t cert_size = 0;
+  size_t header_compression_size = 0;
   size_t num_active_sessions = 0;
   for (auto* session : sessions_) {
     StreamSocket::SocketMemoryStats stats;
     bool is_session_active = false;
-    total_size += session->DumpMemoryStats(&stats, &is_session_active);
+    size_t session_size = session->DumpMemoryStats(&stats, &is_session_active);
+    size_t session_header_compression_size =
+        session->EstimateHeaderCompressionMemoryUsage();
+    total_size += session_size;
     buffer_size += stats.buffer_size;
     cert_count += stats.cert_count;
     cert_size += stats.cert_size;
+    header_compression_size += session_header_compression_size;
     if (is_session_active)
       num_active_sessions++;
+
+    // With thousands of sessions, only detailed dumps list them one by one.
+    if (dump_sessions) {
+      base::trace_event::MemoryAllocatorDump* session_dump =
+          pmd->CreateAllocatorDump(base::StringPrintf(
+              "%s/spdy_session_pool/session_0x%" PRIxPTR,
+              parent_dump_absolute_name.c_str(),
+              reinterpret_cast<uintptr_t>(session)));
+      session_dump->AddScalar(
+          base::trace_event::MemoryAllocatorDump::kNameSize,
+          base::trace_event::MemoryAllocatorDump::kUnitsBytes, session_size);
+      session_dump->AddScalar(
+          "header_compression_size",
+          base::trace_event::MemoryAllocatorDump::kUnitsBytes,
+          session_header_compression_size);
+      session_dump->AddScalar(
+          "active", base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+          is_session_active ? 1 : 0);
+    }
   }
   total_size +=
       base::trace_event::EstimateMemoryUsage(spdy::ObtainHpackHuffmanTable()) +
@@ -561,6 +611,9 @@ void SpdySessionPool::DumpMemoryStats(
   dump->AddScalar("cert_size",
                   base::trace_event::MemoryAllocatorDump::kUnitsBytes,
                   cert_size);
+  dump->AddScalar("header_compression_size",
+                  base::trace_event::MemoryAllocatorDump::kUnitsBytes,
+                  header_compression_size);
 }
 
 SpdySessionPool::RequestInfoForKey::RequestInfoForKey() = default;
@@ -597,18 +650,19 @@ void SpdySessionPool::UnmapKey(const SpdySessionKey& key) {
   available_sessions_.erase(it);
 }
 
+void SpdySessionPool::AddAlias(const IPEndPoint& address,
+                               const SpdySessionKey& key) {
+  RemoveAliases(key);
+  alias_entries_[key] = aliases_.insert(
+      AliasMap::value_type(AliasAddress(address, key.privacy_mode()), key));
+}
+
 void SpdySessionPool::RemoveAliases(const SpdySessionKey& key) {
-  // Walk the aliases map, find references to this pair.
-  // TODO(mbelshe):  Figure out if this is too expensive.
-  for (auto it = aliases_.begin(); it != aliases_.end();) {
-    if (it->second == key) {
-      auto old_it = it;
-      ++it;
-      aliases_.erase(old_it);
-    } else {
-      ++it;
-    }
-  }
+  auto it = alias_entries_.find(key);
+  if (it == alias_entries_.end())
+    return;
+  aliases_.erase(it->second);
+  alias_entries_.erase(it);
 }
 
 SpdySessionPool::WeakSessionList SpdySessionPool::GetCurrentSessions() const {
@@ -667,15 +721,31 @@ std::unique_ptr<SpdySession> SpdySessionPool::CreateSession(
       quic_supported_versions_, enable_sending_initial_data_,
       enable_ping_based_connection_checking_, is_http2_enabled_,
       is_quic_enabled_, is_trusted_proxy, session_max_recv_window_size_,
-      session_max_queued_capped_frames_, initial_settings_,
+      session_max_queued_capped_frames_, GetInitialSettings(key),
       greased_http2_frame_, http2_end_stream_with_data_frame_, time_func_,
       push_delegate_, network_quality_estimator_, net_log);
 }
 
+spdy::SettingsMap SpdySessionPool::GetInitialSettings(
+    const SpdySessionKey& key) const {
+  auto it = origin_header_table_sizes_.find(key.host_port_pair());
+  if (it == origin_header_table_sizes_.end())
+    return initial_settings_;
+  spdy::SettingsMap settings = initial_settings_;
+  settings[spdy::SETTINGS_HEADER_TABLE_SIZE] = it->second;
+  return settings;
+}
+
 base::WeakPtr<SpdySession> SpdySessionPool::InsertSession(
     const SpdySessionKey& key,
     std::unique_ptr<SpdySession> new_session,
     const NetLogWithSource& source_net_log) {
+  // A session still available for |key| was skipped by FindAvailableSession()
+  // because its PING was overdue. Retire it now that there is a new one.
+  auto existing_session_it = LookupAvailableSessionByKey(key);
+  if (existing_session_it != available_sessions_.end())
+    existing_session_it->second->MakeUnavailable();
+
   base::WeakPtr<SpdySession> available_session = new_session->GetWeakPtr();
   sessions_.insert(new_session.release());
   MapKeyToAvailableSession(key, available_session);
@@ -696,7 +766,7 @@ base::WeakPtr<SpdySession> SpdySessionPool::InsertSession(
   if (key.proxy_server().is_direct()) {
     IPEndPoint address;
     if (available_session->GetPeerAddress(&address) == OK)
-      aliases_.insert(AliasMap::value_type(address, key));
+      AddAlias(address, key);
   }
 
   return available_session;
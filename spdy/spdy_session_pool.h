@@ -60,6 +60,9 @@ class NET_EXPORT SpdySessionPool
  public:
   typedef base::TimeTicks (*TimeFunc)(void);
 
+  // HPACK dynamic table sizes, by origin.
+  typedef std::map<HostPortPair, uint32_t> HeaderTableSizeMap;
+
   // Struct to hold randomly generated frame parameters to be used for sending
   // frames on the wire to "grease" frame type.  Frame type has to be one of
   // the reserved values defined in
@@ -143,6 +146,7 @@ class NET_EXPORT SpdySessionPool
                   size_t session_max_recv_window_size,
                   int session_max_queued_capped_frames,
                   const spdy::SettingsMap& initial_settings,
+                  const HeaderTableSizeMap& origin_header_table_sizes,
                   const base::Optional<GreasedHttp2Frame>& greased_http2_frame,
                   bool http2_end_stream_with_data_frame,
                   SpdySessionPool::TimeFunc time_func,
@@ -271,6 +275,11 @@ class NET_EXPORT SpdySessionPool
   // the process of closing those new ones, etc.) are unavailable.
   void CloseAllSessions();
 
+  // Restores the receive windows of all SpdySessions to their configured
+  // sizes, where auto-tuning has grown them. See
+  // SpdySession::ShrinkRecvWindows().
+  void ShrinkRecvWindows();
+
   // Creates a Value summary of the state of the spdy session pool.
   std::unique_ptr<base::Value> SpdySessionPoolInfoToValue() const;
 
@@ -316,7 +325,10 @@ class NET_EXPORT SpdySessionPool
   typedef std::vector<base::WeakPtr<SpdySession> > WeakSessionList;
   typedef std::map<SpdySessionKey, base::WeakPtr<SpdySession>>
       AvailableSessionMap;
-  typedef std::multimap<IPEndPoint, SpdySessionKey> AliasMap;
+  // Sessions may only be pooled with keys of the same privacy mode, so
+  // aliases are indexed by it as well as by address.
+  typedef std::pair<IPEndPoint, PrivacyMode> AliasAddress;
+  typedef std::multimap<AliasAddress, SpdySessionKey> AliasMap;
 
   typedef std::set<SpdySessionRequest*> RequestSet;
   struct RequestInfoForKey {
@@ -354,6 +366,10 @@ class NET_EXPORT SpdySessionPool
   // Remove the mapping of the given key, which must exist.
   void UnmapKey(const SpdySessionKey& key);
 
+  // Add |key|, of a session connected to |address|, to the aliases table,
+  // replacing any alias it already has.
+  void AddAlias(const IPEndPoint& address, const SpdySessionKey& key);
+
   // Remove all aliases for |key| from the aliases table.
   void RemoveAliases(const SpdySessionKey& key);
 
@@ -373,6 +389,8 @@ class NET_EXPORT SpdySessionPool
   std::unique_ptr<SpdySession> CreateSession(const SpdySessionKey& key,
                                              bool is_trusted_proxy,
                                              NetLog* net_log);
+  // Returns the settings to send on a new session for |key|.
+  spdy::SettingsMap GetInitialSettings(const SpdySessionKey& key) const;
   // Adds a new session previously created with CreateSession to the pool.
   // |source_net_log| is the NetLog for the object that created the session.
   base::WeakPtr<SpdySession> InsertSession(
@@ -412,6 +430,10 @@ class NET_EXPORT SpdySessionPool
   // A map of IPEndPoint aliases for sessions.
   AliasMap aliases_;
 
+  // The entry in |aliases_| of each key that has one, so that aliases can be
+  // removed without walking the whole table.
+  std::map<SpdySessionKey, AliasMap::iterator> alias_entries_;
+
   // The index of all unclaimed pushed streams of all SpdySessions in this pool.
   Http2PushPromiseIndex push_promise_index_;
 
@@ -439,6 +461,10 @@ class NET_EXPORT SpdySessionPool
   // and maximum HPACK dynamic table size.
   const spdy::SettingsMap initial_settings_;
 
+  // HPACK dynamic table sizes for sessions to particular origins, overriding
+  // spdy::SETTINGS_HEADER_TABLE_SIZE in |initial_settings_|.
+  const HeaderTableSizeMap origin_header_table_sizes_;
+
   // If set, an HTTP/2 frame with a reserved frame type will be sent after
   // every HTTP/2 SETTINGS frame and before every HTTP/2 DATA frame. See
   // https://tools.ietf.org/html/draft-bishop-httpbis-grease-00.
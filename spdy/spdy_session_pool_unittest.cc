@@ -5,12 +5,15 @@
 #include "net/spdy/spdy_session_pool.h"
 
 #include <cstddef>
+#include <map>
+#include <string>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/memory/ref_counted.h"
 #include "base/run_loop.h"
 #include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
 #include "base/test/bind_test_util.h"
 #include "base/test/metrics/histogram_tester.h"
 #include "base/trace_event/memory_allocator_dump.h"
@@ -77,6 +80,11 @@ class SpdySessionPoolTest : public TestWithTaskEnvironment {
     return session->active_streams_.size();
   }
 
+  std::map<std::string, bool>& cert_coverage_cache(
+      base::WeakPtr<SpdySession> session) {
+    return session->cert_coverage_cache_;
+  }
+
   SpdySessionDependencies session_deps_;
   std::unique_ptr<HttpNetworkSession> http_session_;
   SpdySessionPool* spdy_session_pool_;
@@ -804,6 +812,115 @@ TEST_F(SpdySessionPoolTest, IPPoolingDisabled) {
   EXPECT_NE(session0.get(), session1.get());
 }
 
+#if defined(OS_ANDROID)
+
+// Pooling a request whose socket tag differs from a session's retags the
+// session, which moves its alias to the session's new key rather than adding
+// a second one.
+TEST_F(SpdySessionPoolTest, IPPoolingSocketTagChangeRemapsAlias) {
+  const int kTestPort = 443;
+  const SocketTag kSocketTag(SocketTag::UNSET_UID, 1);
+  session_deps_.host_resolver->set_synchronous_mode(true);
+  session_deps_.host_resolver->rules()->AddIPLiteralRule(
+      "www.example.org", "192.168.0.1", std::string());
+  session_deps_.host_resolver->rules()->AddIPLiteralRule(
+      "mail.example.org", "192.168.0.1", std::string());
+
+  MockRead reads[] = {MockRead(SYNCHRONOUS, ERR_IO_PENDING)};
+  StaticSocketDataProvider data(reads, base::span<MockWrite>());
+  data.set_connect_data(MockConnect(SYNCHRONOUS, OK));
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  SpdySessionPoolPeer pool_peer(spdy_session_pool_);
+
+  SpdySessionKey key0(HostPortPair("www.example.org", kTestPort),
+                      ProxyServer::Direct(), PRIVACY_MODE_DISABLED,
+                      SpdySessionKey::IsProxySession::kFalse, SocketTag(),
+                      NetworkIsolationKey(), false /* disable_secure_dns */);
+  base::WeakPtr<SpdySession> session =
+      CreateSpdySession(http_session_.get(), key0, NetLogWithSource());
+  ASSERT_TRUE(session);
+  EXPECT_EQ(1u, pool_peer.GetAliasCount());
+  EXPECT_TRUE(pool_peer.HasAlias(key0));
+
+  SpdySessionKey tagged_key1(
+      HostPortPair("mail.example.org", kTestPort), ProxyServer::Direct(),
+      PRIVACY_MODE_DISABLED, SpdySessionKey::IsProxySession::kFalse,
+      kSocketTag, NetworkIsolationKey(), false /* disable_secure_dns */);
+  EXPECT_TRUE(TryCreateAliasedSpdySession(spdy_session_pool_, tagged_key1,
+                                          "192.168.0.1"));
+
+  SpdySessionKey tagged_key0(
+      HostPortPair("www.example.org", kTestPort), ProxyServer::Direct(),
+      PRIVACY_MODE_DISABLED, SpdySessionKey::IsProxySession::kFalse,
+      kSocketTag, NetworkIsolationKey(), false /* disable_secure_dns */);
+  EXPECT_EQ(tagged_key0, session->spdy_session_key());
+  EXPECT_EQ(1u, pool_peer.GetAliasCount());
+  EXPECT_TRUE(pool_peer.HasAlias(tagged_key0));
+  EXPECT_FALSE(pool_peer.HasAlias(key0));
+  EXPECT_FALSE(pool_peer.HasAlias(tagged_key1));
+
+  // Once the session goes away, so does its alias.
+  spdy_session_pool_->CloseAllSessions();
+  EXPECT_EQ(0u, pool_peer.GetAliasCount());
+}
+
+#endif  // defined(OS_ANDROID)
+
+// A session remembers which hostnames its certificate covers, and forgets
+// them all once it has been asked about too many.
+TEST_F(SpdySessionPoolTest, CertCoverageCache) {
+  const int kTestPort = 443;
+  session_deps_.host_resolver->set_synchronous_mode(true);
+
+  MockRead reads[] = {MockRead(SYNCHRONOUS, ERR_IO_PENDING)};
+  StaticSocketDataProvider data(reads, base::span<MockWrite>());
+  data.set_connect_data(MockConnect(SYNCHRONOUS, OK));
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+
+  SpdySessionKey key(HostPortPair("www.example.org", kTestPort),
+                     ProxyServer::Direct(), PRIVACY_MODE_DISABLED,
+                     SpdySessionKey::IsProxySession::kFalse, SocketTag(),
+                     NetworkIsolationKey(), false /* disable_secure_dns */);
+  base::WeakPtr<SpdySession> session =
+      CreateSpdySession(http_session_.get(), key, NetLogWithSource());
+  ASSERT_TRUE(session);
+  std::map<std::string, bool>& cache = cert_coverage_cache(session);
+  EXPECT_TRUE(cache.empty());
+
+  // Misses check the certificate and cache the result.
+  EXPECT_TRUE(session->VerifyDomainAuthentication("mail.example.org"));
+  EXPECT_FALSE(session->VerifyDomainAuthentication("mail.example.net"));
+  ASSERT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache["mail.example.org"]);
+  EXPECT_FALSE(cache["mail.example.net"]);
+
+  // Hits use the cached result without checking the certificate again.
+  cache["mail.example.org"] = false;
+  EXPECT_FALSE(session->VerifyDomainAuthentication("mail.example.org"));
+  cache["mail.example.org"] = true;
+  EXPECT_TRUE(session->VerifyDomainAuthentication("mail.example.org"));
+  EXPECT_EQ(2u, cache.size());
+
+  // Fill the cache up to its limit of 128 entries.
+  for (int i = 0; cache.size() < 128u; ++i) {
+    EXPECT_FALSE(session->VerifyDomainAuthentication(
+        base::StringPrintf("host%d.example.net", i)));
+  }
+  EXPECT_TRUE(session->VerifyDomainAuthentication("mail.example.org"));
+  EXPECT_EQ(128u, cache.size());
+
+  // The next miss clears it before caching its own result.
+  EXPECT_TRUE(session->VerifyDomainAuthentication("mail.example.com"));
+  ASSERT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache["mail.example.com"]);
+}
+
 // Verifies that an SSL connection with client authentication disables SPDY IP
 // pooling.
 TEST_F(SpdySessionPoolTest, IPPoolingClientCert) {
@@ -1102,18 +1219,29 @@ TEST_P(SpdySessionMemoryDumpTest, DumpMemoryStats) {
 
   // Whether SpdySession::DumpMemoryStats() is invoked.
   bool did_dump = false;
+  // Whether the session got a dump of its own.
+  bool did_dump_session = false;
   const base::trace_event::ProcessMemoryDump::AllocatorDumpsMap&
       allocator_dumps = process_memory_dump->allocator_dumps();
   for (const auto& pair : allocator_dumps) {
     const std::string& dump_name = pair.first;
     if (dump_name.find("spdy_session_pool") == std::string::npos)
       continue;
+    if (dump_name.find("/session_0x") != std::string::npos) {
+      MemoryAllocatorDump::Entry expected("active",
+                                          MemoryAllocatorDump::kUnitsObjects, 0);
+      ASSERT_THAT(pair.second->entries(), Contains(Eq(ByRef(expected))));
+      did_dump_session = true;
+      continue;
+    }
     MemoryAllocatorDump::Entry expected("active_session_count",
                                         MemoryAllocatorDump::kUnitsObjects, 0);
     ASSERT_THAT(pair.second->entries(), Contains(Eq(ByRef(expected))));
     did_dump = true;
   }
   EXPECT_TRUE(did_dump);
+  EXPECT_EQ(GetParam() == base::trace_event::MemoryDumpLevelOfDetail::DETAILED,
+            did_dump_session);
   spdy_session_pool_->CloseCurrentSessions(ERR_ABORTED);
 }
 
@@ -334,6 +334,14 @@ class SpdySessionTest : public PlatformTest, public WithTaskEnvironment {
     return session_->session_unacked_recv_window_bytes_;
   }
 
+  int32_t session_max_recv_window_size() {
+    return session_->session_max_recv_window_size_;
+  }
+
+  void set_last_ping_rtt(base::TimeDelta rtt) {
+    session_->last_ping_rtt_ = rtt;
+  }
+
   int32_t stream_initial_send_window_size() {
     return session_->stream_initial_send_window_size_;
   }
@@ -368,6 +376,8 @@ class SpdySessionTest : public PlatformTest, public WithTaskEnvironment {
     return session_->buffered_spdy_framer_->header_encoder_table_size();
   }
 
+  int read_buffer_size() { return session_->read_buffer_size_; }
+
   RecordingBoundTestNetLog log_;
 
   // Original socket limits.  Some tests set these.  Safest to always restore
@@ -1981,6 +1991,221 @@ TEST_F(SpdySessionTestWithMockTime, NoPingSentWhenCheckPingPending) {
   EXPECT_TRUE(data.AllReadDataConsumed());
 }
 
+// With periodic PINGs enabled for idle sessions, a PING is sent once the
+// interval has passed even though the session has just been set up, and its
+// round trip time is reported to the network quality estimator.
+TEST_F(SpdySessionTestWithMockTime, PeriodicPing) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttp2PeriodicPing, {{"Http2PeriodicPingInterval", "5s"},
+                                     {"Http2PeriodicPingIdleSessions", "true"}});
+  session_deps_.enable_ping = true;
+
+  spdy::SpdySerializedFrame read_ping(spdy_util_.ConstructSpdyPing(1, true));
+  MockRead reads[] = {CreateMockRead(read_ping, 1),
+                      MockRead(ASYNC, ERR_IO_PENDING, 2),
+                      MockRead(ASYNC, 0, 3)};  // EOF
+  spdy::SpdySerializedFrame write_ping(spdy_util_.ConstructSpdyPing(1, false));
+  MockWrite writes[] = {CreateMockWrite(write_ping, 0)};
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  TestNetworkQualityEstimator estimator;
+  spdy_session_pool_->set_network_quality_estimator(&estimator);
+  CreateSpdySession();
+
+  FastForwardBy(base::TimeDelta::FromSeconds(4));
+  EXPECT_FALSE(ping_in_flight());
+  EXPECT_EQ(1u, next_ping_id());
+
+  // Send the PING and read its ACK.
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  EXPECT_FALSE(ping_in_flight());
+  EXPECT_EQ(2u, next_ping_id());
+  EXPECT_EQ(1u, estimator.ping_rtt_received_count());
+
+  // Read EOF before the next PING is due.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(HasSpdySession(spdy_session_pool_, key_));
+  EXPECT_FALSE(session_);
+
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
+// By default, periodic PINGs are only sent while the session has streams.
+TEST_F(SpdySessionTestWithMockTime, PeriodicPingSkipsIdleSessions) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttp2PeriodicPing, {{"Http2PeriodicPingInterval", "5s"}});
+  session_deps_.enable_ping = true;
+
+  spdy::SpdySerializedFrame read_ping(spdy_util_.ConstructSpdyPing(1, true));
+  MockRead reads[] = {CreateMockRead(read_ping, 2),
+                      MockRead(ASYNC, ERR_IO_PENDING, 3),
+                      MockRead(ASYNC, 0, 4)};  // EOF
+  spdy::SpdySerializedFrame req(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, MEDIUM));
+  spdy::SpdySerializedFrame write_ping(spdy_util_.ConstructSpdyPing(1, false));
+  MockWrite writes[] = {CreateMockWrite(req, 0),
+                        CreateMockWrite(write_ping, 1)};
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+  // Keep preface PINGs out of the way.
+  set_connection_at_risk_of_loss_time(base::TimeDelta::FromSeconds(60));
+
+  // No PING is sent, or planned, while the session is idle.
+  FastForwardBy(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(1u, next_ping_id());
+  EXPECT_TRUE(MainThreadIsIdle());
+
+  base::WeakPtr<SpdyStream> spdy_stream =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, MEDIUM, NetLogWithSource());
+  test::StreamDelegateDoNothing delegate(spdy_stream);
+  spdy_stream->SetDelegate(&delegate);
+  spdy::SpdyHeaderBlock headers(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl));
+  spdy_stream->SendRequestHeaders(std::move(headers), NO_MORE_DATA_TO_SEND);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, spdy_stream->stream_id());
+
+  // Once the stream is active, a PING is sent after the interval.
+  FastForwardBy(base::TimeDelta::FromSeconds(4));
+  EXPECT_EQ(1u, next_ping_id());
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  EXPECT_FALSE(ping_in_flight());
+  EXPECT_EQ(2u, next_ping_id());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(session_);
+
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
+// Once a PING has gone unanswered for several round trip times, the pool
+// makes new connections rather than hand out the session. The session is only
+// made unavailable when a new one replaces it, and CheckPingStatus() later
+// closes it.
+TEST_F(SpdySessionTestWithMockTime, OverduePingSkipsSession) {
+  session_deps_.enable_ping = true;
+
+  MockRead reads[] = {MockRead(SYNCHRONOUS, ERR_IO_PENDING)};  // Stall forever.
+  spdy::SpdySerializedFrame write_ping(spdy_util_.ConstructSpdyPing(1, false));
+  spdy::SpdySerializedFrame goaway(spdy_util_.ConstructSpdyGoAway(
+      0, spdy::ERROR_CODE_PROTOCOL_ERROR, "Failed ping."));
+  MockWrite writes[] = {CreateMockWrite(write_ping), CreateMockWrite(goaway)};
+  StaticSocketDataProvider data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  MockRead new_reads[] = {MockRead(SYNCHRONOUS, ERR_IO_PENDING)};
+  StaticSocketDataProvider new_data(new_reads, base::span<MockWrite>());
+  session_deps_.socket_factory->AddSocketDataProvider(&new_data);
+
+  AddSSLSocketData();
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+  set_last_ping_rtt(base::TimeDelta::FromMilliseconds(100));
+
+  // Send a PING some time after the last read.
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  set_connection_at_risk_of_loss_time(base::TimeDelta::FromSeconds(-1));
+  MaybeSendPrefacePing();
+  EXPECT_TRUE(ping_in_flight());
+  EXPECT_FALSE(session_->IsPingOverdue());
+
+  // Four round trip times have passed, but not the minimum of a second.
+  FastForwardBy(base::TimeDelta::FromMilliseconds(500));
+  EXPECT_FALSE(session_->IsPingOverdue());
+  EXPECT_TRUE(HasSpdySession(spdy_session_pool_, key_));
+
+  FastForwardBy(base::TimeDelta::FromMilliseconds(600));
+  EXPECT_TRUE(session_->IsPingOverdue());
+  EXPECT_FALSE(HasSpdySession(spdy_session_pool_, key_));
+  EXPECT_TRUE(session_->IsAvailable());
+
+  // A new session for the same key replaces the old one.
+  base::WeakPtr<SpdySession> new_session =
+      ::net::CreateSpdySession(http_session_.get(), key_, NetLogWithSource());
+  ASSERT_TRUE(new_session);
+  EXPECT_FALSE(session_->IsAvailable());
+  EXPECT_EQ(new_session.get(),
+            spdy_session_pool_
+                ->FindAvailableSession(
+                    key_, /* enable_ip_based_pooling = */ true,
+                    /* is_websocket = */ false, NetLogWithSource())
+                .get());
+  ASSERT_TRUE(session_);
+
+  // Run CheckPingStatus(), which closes the old session.
+  FastForwardUntilNoTasksRemain();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(session_);
+  EXPECT_TRUE(new_session);
+
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
+// A PING that is overdue but then acknowledged leaves the session usable.
+TEST_F(SpdySessionTestWithMockTime, LatePingAckKeepsSessionAvailable) {
+  session_deps_.enable_ping = true;
+
+  spdy::SpdySerializedFrame read_ping(spdy_util_.ConstructSpdyPing(1, true));
+  MockRead reads[] = {MockRead(ASYNC, ERR_IO_PENDING, 1),
+                      CreateMockRead(read_ping, 2),
+                      MockRead(ASYNC, ERR_IO_PENDING, 3),
+                      MockRead(ASYNC, 0, 4)};  // EOF
+  spdy::SpdySerializedFrame write_ping(spdy_util_.ConstructSpdyPing(1, false));
+  MockWrite writes[] = {CreateMockWrite(write_ping, 0)};
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+  set_last_ping_rtt(base::TimeDelta::FromMilliseconds(100));
+
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  set_connection_at_risk_of_loss_time(base::TimeDelta::FromSeconds(-1));
+  MaybeSendPrefacePing();
+  EXPECT_TRUE(ping_in_flight());
+
+  FastForwardBy(base::TimeDelta::FromMilliseconds(1100));
+  EXPECT_TRUE(session_->IsPingOverdue());
+  EXPECT_FALSE(HasSpdySession(spdy_session_pool_, key_));
+  EXPECT_TRUE(session_->IsAvailable());
+
+  // Read the ACK.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(ping_in_flight());
+  EXPECT_FALSE(session_->IsPingOverdue());
+  EXPECT_TRUE(HasSpdySession(spdy_session_pool_, key_));
+
+  // Read EOF.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(session_);
+
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
 // Request kInitialMaxConcurrentStreams + 1 streams.  Receive a
 // settings frame increasing the max concurrent streams by 1.  Make
 // sure nothing blows up. This is a regression test for
@@ -2461,6 +2686,180 @@ TEST_F(SpdySessionTest, CancelStream) {
   EXPECT_FALSE(spdy_stream2);
 }
 
+// With write coalescing, frames queued together go out in a single socket
+// write, in priority order, and each stream is still told about its own frame.
+TEST_F(SpdySessionTest, CoalesceQueuedWrites) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kHttp2WriteCoalescing);
+
+  spdy::SpdySerializedFrame req1(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, HIGHEST));
+  spdy::SpdySerializedFrame req2(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 3, LOWEST));
+  spdy::SpdySerializedFrame coalesced = CombineFrames({&req1, &req2});
+  MockWrite writes[] = {
+      CreateMockWrite(coalesced, 0),
+  };
+  MockRead reads[] = {
+      MockRead(ASYNC, ERR_IO_PENDING, 1), MockRead(ASYNC, 0, 2)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream2 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, LOWEST, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream2);
+  test::StreamDelegateDoNothing delegate2(spdy_stream2);
+  spdy_stream2->SetDelegate(&delegate2);
+
+  base::WeakPtr<SpdyStream> spdy_stream1 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, HIGHEST, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream1);
+  test::StreamDelegateDoNothing delegate1(spdy_stream1);
+  spdy_stream1->SetDelegate(&delegate1);
+
+  spdy_stream2->SendRequestHeaders(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl), NO_MORE_DATA_TO_SEND);
+  spdy_stream1->SendRequestHeaders(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl), NO_MORE_DATA_TO_SEND);
+
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(1u, delegate1.stream_id());
+  EXPECT_EQ(3u, delegate2.stream_id());
+  ASSERT_TRUE(spdy_stream1);
+  ASSERT_TRUE(spdy_stream2);
+  EXPECT_EQ(static_cast<int64_t>(req1.size()),
+            spdy_stream1->raw_sent_bytes());
+  EXPECT_EQ(static_cast<int64_t>(req2.size()),
+            spdy_stream2->raw_sent_bytes());
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+
+  spdy_stream1->Cancel(ERR_ABORTED);
+  spdy_stream2->Cancel(ERR_ABORTED);
+}
+
+// A write that has reached the coalescing limit takes no more frames.
+TEST_F(SpdySessionTest, CoalesceQueuedWritesLimit) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttp2WriteCoalescing,
+      {{"Http2WriteCoalescingMaxBytes", "1"}});
+
+  spdy::SpdySerializedFrame req1(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, HIGHEST));
+  spdy::SpdySerializedFrame req2(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 3, LOWEST));
+  MockWrite writes[] = {
+      CreateMockWrite(req1, 0), CreateMockWrite(req2, 1),
+  };
+  MockRead reads[] = {
+      MockRead(ASYNC, ERR_IO_PENDING, 2), MockRead(ASYNC, 0, 3)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream1 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, HIGHEST, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream1);
+  test::StreamDelegateDoNothing delegate1(spdy_stream1);
+  spdy_stream1->SetDelegate(&delegate1);
+
+  base::WeakPtr<SpdyStream> spdy_stream2 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, LOWEST, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream2);
+  test::StreamDelegateDoNothing delegate2(spdy_stream2);
+  spdy_stream2->SetDelegate(&delegate2);
+
+  spdy_stream1->SendRequestHeaders(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl), NO_MORE_DATA_TO_SEND);
+  spdy_stream2->SendRequestHeaders(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl), NO_MORE_DATA_TO_SEND);
+
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(1u, delegate1.stream_id());
+  EXPECT_EQ(3u, delegate2.stream_id());
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+
+  spdy_stream1->Cancel(ERR_ABORTED);
+  spdy_stream2->Cancel(ERR_ABORTED);
+}
+
+// With RFC 9218 priorities, reprioritizing an open stream sends a
+// PRIORITY_UPDATE frame carrying its new urgency.
+TEST_F(SpdySessionTest, PriorityUpdateOnReprioritization) {
+  base::test::ScopedFeatureList feature_list;
+  // Leave out RFC 7540 PRIORITY frames, so that only PRIORITY_UPDATE is sent.
+  feature_list.InitWithFeatures(
+      {features::kPriorityHeader, features::kAvoidH2Reprioritization}, {});
+
+  spdy::SpdySerializedFrame req(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, LOWEST));
+  // PRIORITY_UPDATE on stream 0 for stream 1, with urgency 0.
+  const char kPriorityUpdate[] = {
+      0x00, 0x00, 0x07,        // Length
+      0x10,                    // Type
+      0x00,                    // Flags
+      0x00, 0x00, 0x00, 0x00,  // Stream id
+      0x00, 0x00, 0x00, 0x01,  // Prioritized stream id
+      'u',  '=',  '0'};
+  MockWrite writes[] = {
+      CreateMockWrite(req, 0),
+      MockWrite(ASYNC, kPriorityUpdate, base::size(kPriorityUpdate), 2),
+  };
+  MockRead reads[] = {
+      MockRead(ASYNC, ERR_IO_PENDING, 1), MockRead(ASYNC, ERR_IO_PENDING, 3),
+      MockRead(ASYNC, 0, 4)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, LOWEST, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream);
+  test::StreamDelegateDoNothing delegate(spdy_stream);
+  spdy_stream->SetDelegate(&delegate);
+  spdy_stream->SendRequestHeaders(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl), NO_MORE_DATA_TO_SEND);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, delegate.stream_id());
+
+  spdy_stream->SetPriority(HIGHEST);
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+
+  // Read EOF.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(data.AllReadDataConsumed());
+  EXPECT_FALSE(session_);
+}
+
 // Create two streams that are set to re-close themselves on close,
 // and then close the session. Nothing should blow up. Also a
 // regression test for http://crbug.com/139518 .
@@ -3524,6 +3923,229 @@ TEST_F(SpdySessionTest, TestYieldingDuringAsyncReadData) {
   EXPECT_TRUE(data.AllReadDataConsumed());
 }
 
+// The read buffer doubles after each read that fills it, up to
+// kYieldAfterBytesRead.
+TEST_F(SpdySessionTest, ReadBufferGrowsAfterFullReads) {
+  const int kInitialReadBufferSize = 8 * 1024;
+  ASSERT_EQ(4 * kInitialReadBufferSize, kYieldAfterBytesRead);
+
+  spdy::SpdySerializedFrame req1(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, MEDIUM));
+  MockWrite writes[] = {
+      CreateMockWrite(req1, 0),
+  };
+
+  // Each DATA frame takes up exactly the initial read buffer.
+  const std::string payload(kInitialReadBufferSize - spdy::kFrameHeaderSize,
+                            'a');
+  spdy::SpdySerializedFrame data_frame(
+      spdy_util_.ConstructSpdyDataFrame(1, payload, /*fin=*/false));
+  spdy::SpdySerializedFrame two_data_frames(
+      CombineFrames({&data_frame, &data_frame}));
+  spdy::SpdySerializedFrame four_data_frames(
+      CombineFrames({&data_frame, &data_frame, &data_frame, &data_frame}));
+  spdy::SpdySerializedFrame resp1(
+      spdy_util_.ConstructSpdyGetReply(nullptr, 0, 1));
+
+  MockRead reads[] = {
+      CreateMockRead(resp1, 1),
+      MockRead(ASYNC, ERR_IO_PENDING, 2),
+      CreateMockRead(data_frame, 3),
+      MockRead(ASYNC, ERR_IO_PENDING, 4),
+      CreateMockRead(two_data_frames, 5),
+      MockRead(ASYNC, ERR_IO_PENDING, 6),
+      CreateMockRead(four_data_frames, 7),
+      MockRead(ASYNC, ERR_IO_PENDING, 8),
+      MockRead(ASYNC, 0, 9)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream1 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, MEDIUM, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream1);
+  test::StreamDelegateDoNothing delegate1(spdy_stream1);
+  spdy_stream1->SetDelegate(&delegate1);
+
+  spdy::SpdyHeaderBlock headers1(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl));
+  spdy_stream1->SendRequestHeaders(std::move(headers1), NO_MORE_DATA_TO_SEND);
+
+  // The response headers leave most of the buffer unused.
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, delegate1.stream_id());
+  EXPECT_EQ(kInitialReadBufferSize, read_buffer_size());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(2 * kInitialReadBufferSize, read_buffer_size());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(4 * kInitialReadBufferSize, read_buffer_size());
+
+  // A full read at the maximum size does not grow the buffer further.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(kYieldAfterBytesRead, read_buffer_size());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(spdy_stream1);
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
+// The read buffer halves after four reads in a row that use no more than a
+// quarter of it.
+TEST_F(SpdySessionTest, ReadBufferShrinksAfterSmallReads) {
+  const int kInitialReadBufferSize = 8 * 1024;
+
+  spdy::SpdySerializedFrame req1(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, MEDIUM));
+  MockWrite writes[] = {
+      CreateMockWrite(req1, 0),
+  };
+
+  const std::string large_payload(
+      kInitialReadBufferSize - spdy::kFrameHeaderSize, 'a');
+  spdy::SpdySerializedFrame large_data_frame(
+      spdy_util_.ConstructSpdyDataFrame(1, large_payload, /*fin=*/false));
+  const std::string small_payload(100, 'b');
+  spdy::SpdySerializedFrame small_data_frame(
+      spdy_util_.ConstructSpdyDataFrame(1, small_payload, /*fin=*/false));
+  spdy::SpdySerializedFrame resp1(
+      spdy_util_.ConstructSpdyGetReply(nullptr, 0, 1));
+
+  MockRead reads[] = {
+      CreateMockRead(resp1, 1),
+      MockRead(ASYNC, ERR_IO_PENDING, 2),
+      CreateMockRead(large_data_frame, 3),
+      CreateMockRead(small_data_frame, 4, SYNCHRONOUS),
+      CreateMockRead(small_data_frame, 5, SYNCHRONOUS),
+      CreateMockRead(small_data_frame, 6, SYNCHRONOUS),
+      MockRead(ASYNC, ERR_IO_PENDING, 7),
+      CreateMockRead(small_data_frame, 8),
+      MockRead(ASYNC, ERR_IO_PENDING, 9),
+      MockRead(ASYNC, 0, 10)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream1 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, MEDIUM, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream1);
+  test::StreamDelegateDoNothing delegate1(spdy_stream1);
+  spdy_stream1->SetDelegate(&delegate1);
+
+  spdy::SpdyHeaderBlock headers1(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl));
+  spdy_stream1->SendRequestHeaders(std::move(headers1), NO_MORE_DATA_TO_SEND);
+
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, delegate1.stream_id());
+
+  // The large DATA frame fills the buffer, which then takes three small
+  // reads without shrinking.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(2 * kInitialReadBufferSize, read_buffer_size());
+
+  // The fourth small read in a row halves it.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(kInitialReadBufferSize, read_buffer_size());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(spdy_stream1);
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
+// A DATA frame that takes up a large part of the read buffer is handed to the
+// stream as a slice of it. The next read must not reuse the buffer while that
+// slice is held, or it would overwrite the data.
+TEST_F(SpdySessionTest, ReadBufferNotReusedWhileDataHeld) {
+  const int kInitialReadBufferSize = 8 * 1024;
+
+  spdy::SpdySerializedFrame req1(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, MEDIUM));
+  MockWrite writes[] = {
+      CreateMockWrite(req1, 0),
+  };
+
+  // Both payloads are more than half the read buffer, so neither is copied,
+  // and neither read fills the buffer, so its size does not change.
+  const int kPayloadSize = kInitialReadBufferSize / 2 + 100;
+  const std::string payload1(kPayloadSize, 'a');
+  const std::string payload2(kPayloadSize, 'b');
+  spdy::SpdySerializedFrame data_frame1(
+      spdy_util_.ConstructSpdyDataFrame(1, payload1, /*fin=*/false));
+  spdy::SpdySerializedFrame data_frame2(
+      spdy_util_.ConstructSpdyDataFrame(1, payload2, /*fin=*/false));
+  spdy::SpdySerializedFrame resp1(
+      spdy_util_.ConstructSpdyGetReply(nullptr, 0, 1));
+
+  MockRead reads[] = {
+      CreateMockRead(resp1, 1),
+      MockRead(ASYNC, ERR_IO_PENDING, 2),
+      CreateMockRead(data_frame1, 3),
+      CreateMockRead(data_frame2, 4, SYNCHRONOUS),
+      MockRead(ASYNC, ERR_IO_PENDING, 5),
+      MockRead(ASYNC, 0, 6)  // EOF
+  };
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream1 =
+      CreateStreamSynchronously(SPDY_REQUEST_RESPONSE_STREAM, session_,
+                                test_url_, MEDIUM, NetLogWithSource());
+  ASSERT_TRUE(spdy_stream1);
+  test::StreamDelegateDoNothing delegate1(spdy_stream1);
+  spdy_stream1->SetDelegate(&delegate1);
+
+  spdy::SpdyHeaderBlock headers1(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultUrl));
+  spdy_stream1->SendRequestHeaders(std::move(headers1), NO_MORE_DATA_TO_SEND);
+
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, delegate1.stream_id());
+
+  // Both frames are read in the same read loop while the delegate holds on
+  // to the first one.
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(kInitialReadBufferSize, read_buffer_size());
+  EXPECT_EQ(payload1 + payload2, delegate1.TakeReceivedData());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(spdy_stream1);
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
 // Send a GoAway frame when SpdySession is in DoReadLoop. Make sure
 // nothing blows up.
 TEST_F(SpdySessionTest, GoAwayWhileInDoReadLoop) {
@@ -4061,6 +4683,95 @@ TEST_F(SpdySessionTest, AdjustRecvWindowSize) {
   EXPECT_FALSE(session_);
 }
 
+// With receive window auto-tuning, the session receive window should double
+// when WINDOW_UPDATE frames are sent less than two round trips apart, and
+// shrink back to its configured size under memory pressure.
+TEST_F(SpdySessionTest, RecvWindowAutoTuning) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kHttp2ReceiveWindowAutoTuning);
+  session_deps_.time_func = TheNearFuture;
+
+  const int32_t initial_window_size = kDefaultInitialWindowSize;
+  const int32_t half_window_size = initial_window_size / 2 + 1;
+
+  MockRead reads[] = {
+      MockRead(ASYNC, ERR_IO_PENDING, 5), MockRead(ASYNC, 0, 6)  // EOF
+  };
+  spdy::SpdySerializedFrame ping(spdy_util_.ConstructSpdyPing(1, false));
+  spdy::SpdySerializedFrame window_update1(
+      spdy_util_.ConstructSpdyWindowUpdate(spdy::kSessionFlowControlStreamId,
+                                           half_window_size));
+  spdy::SpdySerializedFrame window_update2(
+      spdy_util_.ConstructSpdyWindowUpdate(
+          spdy::kSessionFlowControlStreamId,
+          half_window_size + initial_window_size));
+  spdy::SpdySerializedFrame window_update3(
+      spdy_util_.ConstructSpdyWindowUpdate(spdy::kSessionFlowControlStreamId,
+                                           initial_window_size + 1));
+  spdy::SpdySerializedFrame window_update4(
+      spdy_util_.ConstructSpdyWindowUpdate(spdy::kSessionFlowControlStreamId,
+                                           initial_window_size));
+  MockWrite writes[] = {
+      CreateMockWrite(ping, 0), CreateMockWrite(window_update1, 1),
+      CreateMockWrite(window_update2, 2), CreateMockWrite(window_update3, 3),
+      CreateMockWrite(window_update4, 4),
+  };
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+  set_last_ping_rtt(base::TimeDelta::FromMilliseconds(100));
+
+  // The first WINDOW_UPDATE has nothing to be compared with. A PING is sent
+  // along with it to measure the round trip time.
+  set_in_io_loop(true);
+  DecreaseRecvWindowSize(initial_window_size);
+  set_in_io_loop(false);
+  IncreaseRecvWindowSize(half_window_size);
+  EXPECT_EQ(initial_window_size, session_max_recv_window_size());
+  EXPECT_TRUE(ping_in_flight());
+  base::RunLoop().RunUntilIdle();
+
+  // The second follows right away, so the window doubles.
+  set_in_io_loop(true);
+  DecreaseRecvWindowSize(half_window_size);
+  set_in_io_loop(false);
+  IncreaseRecvWindowSize(half_window_size);
+  EXPECT_EQ(2 * initial_window_size, session_max_recv_window_size());
+  EXPECT_EQ(half_window_size + initial_window_size, session_recv_window_size());
+  EXPECT_EQ(0, session_unacked_recv_window_bytes());
+  base::RunLoop().RunUntilIdle();
+
+  // The third follows after more than two round trips, so the window stays.
+  g_time_delta += base::TimeDelta::FromSeconds(1);
+  set_in_io_loop(true);
+  DecreaseRecvWindowSize(half_window_size + initial_window_size);
+  set_in_io_loop(false);
+  IncreaseRecvWindowSize(initial_window_size + 1);
+  EXPECT_EQ(2 * initial_window_size, session_max_recv_window_size());
+  base::RunLoop().RunUntilIdle();
+
+  // Once shrunk, no more credit than the configured window is given.
+  session_->ShrinkRecvWindows();
+  EXPECT_EQ(initial_window_size, session_max_recv_window_size());
+  g_time_delta += base::TimeDelta::FromSeconds(1);
+  set_in_io_loop(true);
+  DecreaseRecvWindowSize(initial_window_size + 1);
+  set_in_io_loop(false);
+  IncreaseRecvWindowSize(initial_window_size + 1);
+  EXPECT_EQ(initial_window_size, session_recv_window_size());
+  EXPECT_EQ(0, session_unacked_recv_window_bytes());
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_TRUE(session_);
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(session_);
+}
+
 // SpdySession::{Increase,Decrease}SendWindowSize should properly
 // adjust the session send window size when the "enable_spdy_31" flag
 // is set.
@@ -7245,4 +7956,40 @@ TEST_F(SpdySessionTest, UpdateHeaderTableSize) {
   EXPECT_TRUE(data.AllReadDataConsumed());
 }
 
+// A header table size configured for the origin is announced for our decoder,
+// and doesn't limit the table the server allows the encoder.
+TEST_F(SpdySessionTest, OriginHeaderTableSizeDoesNotBoundEncoderTable) {
+  session_deps_.http2_header_table_sizes[HostPortPair::FromURL(test_url_)] =
+      1024;
+
+  spdy::SettingsMap settings;
+  settings[spdy::SETTINGS_HEADER_TABLE_SIZE] = 65536;
+  spdy::SpdySerializedFrame settings_frame(
+      spdy_util_.ConstructSpdySettings(settings));
+  MockRead reads[] = {CreateMockRead(settings_frame, 0),
+                      MockRead(ASYNC, ERR_IO_PENDING, 2),
+                      MockRead(ASYNC, 0, 3)};
+
+  spdy::SpdySerializedFrame settings_ack(spdy_util_.ConstructSpdySettingsAck());
+  MockWrite writes[] = {CreateMockWrite(settings_ack, 1)};
+
+  SequencedSocketData data(reads, writes);
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  AddSSLSocketData();
+
+  CreateNetworkSession();
+  CreateSpdySession();
+
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(65536u, header_encoder_table_size());
+  EXPECT_GE(session_->EstimateMemoryUsage(),
+            session_->EstimateHeaderCompressionMemoryUsage());
+
+  data.Resume();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
 }  // namespace net
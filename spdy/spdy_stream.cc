@@ -102,6 +102,8 @@ SpdyStream::SpdyStream(SpdyStreamType type,
       stream_id_(0),
       url_(url),
       priority_(priority),
+      priority_incremental_(false),
+      max_data_frame_size_(kMaxSpdyFrameChunkSize),
       send_stalled_by_flow_control_(false),
       send_window_size_(initial_send_window_size),
       max_recv_window_size_(max_recv_window_size),
@@ -224,6 +226,13 @@ void SpdyStream::SetPriority(RequestPriority priority) {
   priority_ = priority;
 }
 
+void SpdyStream::SetMaxDataFrameSize(int max_data_frame_size) {
+  DCHECK_GT(max_data_frame_size, 0);
+  DCHECK_LE(max_data_frame_size,
+            static_cast<int>(spdy::kHttp2DefaultFramePayloadLimit));
+  max_data_frame_size_ = max_data_frame_size;
+}
+
 bool SpdyStream::AdjustSendWindowSize(int32_t delta_window_size) {
   if (IsClosed())
     return true;
@@ -290,7 +299,7 @@ void SpdyStream::DecreaseSendWindowSize(int32_t delta_window_size) {
   // We only call this method when sending a frame. Therefore,
   // |delta_window_size| should be within the valid frame size range.
   DCHECK_GE(delta_window_size, 1);
-  DCHECK_LE(delta_window_size, kMaxSpdyFrameChunkSize);
+  DCHECK_LE(delta_window_size, max_data_frame_size_);
 
   // |send_window_size_| should have been at least |delta_window_size| for
   // this call to happen.
@@ -333,13 +342,39 @@ void SpdyStream::IncreaseRecvWindowSize(int32_t delta_window_size) {
   });
 
   unacked_recv_window_bytes_ += delta_window_size;
+
+  // Once ShrinkMaxRecvWindowSize() has reduced the maximum, hold back credit
+  // until the window fits within it again.
+  if (recv_window_size_ > max_recv_window_size_) {
+    const int32_t excess = std::min(unacked_recv_window_bytes_,
+                                    recv_window_size_ - max_recv_window_size_);
+    recv_window_size_ -= excess;
+    unacked_recv_window_bytes_ -= excess;
+  }
+
   if (unacked_recv_window_bytes_ > max_recv_window_size_ / 2) {
+    const int32_t max_recv_window_size = session_->AutoTuneStreamRecvWindowSize(
+        max_recv_window_size_, &last_window_update_time_);
+    if (max_recv_window_size > max_recv_window_size_) {
+      const int32_t growth = max_recv_window_size - max_recv_window_size_;
+      max_recv_window_size_ = max_recv_window_size;
+      recv_window_size_ += growth;
+      net_log_.AddEvent(NetLogEventType::HTTP2_STREAM_UPDATE_RECV_WINDOW, [&] {
+        return NetLogSpdyStreamWindowUpdateParams(stream_id_, growth,
+                                                  recv_window_size_);
+      });
+      unacked_recv_window_bytes_ += growth;
+    }
     session_->SendStreamWindowUpdate(
         stream_id_, static_cast<uint32_t>(unacked_recv_window_bytes_));
     unacked_recv_window_bytes_ = 0;
   }
 }
 
+void SpdyStream::ShrinkMaxRecvWindowSize(int32_t max_recv_window_size) {
+  max_recv_window_size_ = std::min(max_recv_window_size_, max_recv_window_size);
+}
+
 void SpdyStream::DecreaseRecvWindowSize(int32_t delta_window_size) {
   DCHECK(session_->IsStreamActive(stream_id_));
   DCHECK_GE(delta_window_size, 1);
@@ -158,6 +158,20 @@ class NET_EXPORT_PRIVATE SpdyStream {
   // Update priority and send PRIORITY frames on the wire if necessary.
   void SetPriority(RequestPriority priority);
 
+  // Whether the stream's data may be interleaved with that of other streams
+  // of the same priority, per the RFC 9218 incremental parameter. Must be set
+  // before the request headers are sent.
+  bool priority_incremental() const { return priority_incremental_; }
+  void set_priority_incremental(bool priority_incremental) {
+    priority_incremental_ = priority_incremental;
+  }
+
+  // The largest DATA frame payload this stream sends. Defaults to
+  // kMaxSpdyFrameChunkSize; may be raised up to
+  // spdy::kHttp2DefaultFramePayloadLimit, which every peer accepts.
+  int max_data_frame_size() const { return max_data_frame_size_; }
+  void SetMaxDataFrameSize(int max_data_frame_size);
+
   int32_t send_window_size() const { return send_window_size_; }
 
   int32_t recv_window_size() const { return recv_window_size_; }
@@ -206,7 +220,7 @@ class NET_EXPORT_PRIVATE SpdyStream {
 
   // If stream flow control is turned on, called by the session to
   // decrease this stream's send window size by |delta_window_size|,
-  // which must be at least 0 and at most kMaxSpdyFrameChunkSize.
+  // which must be at least 0 and at most max_data_frame_size().
   // |delta_window_size| must not cause this stream's send window size
   // to go negative. Does nothing if the stream is already closed.
   //
@@ -230,6 +244,11 @@ class NET_EXPORT_PRIVATE SpdyStream {
   // If stream flow control is turned off, this must not be called.
   void IncreaseRecvWindowSize(int32_t delta_window_size);
 
+  // Lowers this stream's maximum receive window size to
+  // |max_recv_window_size|, if it is larger. The receive window shrinks to
+  // match as the peer uses it up.
+  void ShrinkMaxRecvWindowSize(int32_t max_recv_window_size);
+
   // Called by OnDataReceived or OnPaddingConsumed (which are in turn called by
   // the session) to decrease this stream's receive window size by
   // |delta_window_size|, which must be at least 1.  May close the stream on
@@ -459,6 +478,8 @@ class NET_EXPORT_PRIVATE SpdyStream {
   spdy::SpdyStreamId stream_id_;
   const GURL url_;
   RequestPriority priority_;
+  bool priority_incremental_;
+  int max_data_frame_size_;
 
   bool send_stalled_by_flow_control_;
 
@@ -480,6 +501,10 @@ class NET_EXPORT_PRIVATE SpdyStream {
   // are sent.
   int32_t unacked_recv_window_bytes_;
 
+  // The time the last WINDOW_UPDATE frame for this stream was sent, for
+  // receive window auto-tuning.
+  base::TimeTicks last_window_update_time_;
+
   const base::WeakPtr<SpdySession> session_;
 
   // The transaction should own the delegate.
@@ -395,6 +395,7 @@ HttpNetworkSession::Params SpdySessionDependencies::CreateSessionParams(
   params.spdy_session_max_queued_capped_frames =
       session_deps->session_max_queued_capped_frames;
   params.http2_settings = session_deps->http2_settings;
+  params.http2_header_table_sizes = session_deps->http2_header_table_sizes;
   params.time_func = session_deps->time_func;
   params.enable_http2_alternative_service =
       session_deps->enable_http2_alternative_service;
@@ -663,6 +664,19 @@ void SpdySessionPoolPeer::SetEnableSendingInitialData(bool enabled) {
   pool_->enable_sending_initial_data_ = enabled;
 }
 
+size_t SpdySessionPoolPeer::GetAliasCount() const {
+  DCHECK_EQ(pool_->aliases_.size(), pool_->alias_entries_.size());
+  return pool_->aliases_.size();
+}
+
+bool SpdySessionPoolPeer::HasAlias(const SpdySessionKey& key) const {
+  auto it = pool_->alias_entries_.find(key);
+  if (it == pool_->alias_entries_.end())
+    return false;
+  DCHECK(it->second->second == key);
+  return true;
+}
+
 SpdyTestUtil::SpdyTestUtil()
     : headerless_spdy_framer_(spdy::SpdyFramer::ENABLE_COMPRESSION),
       request_spdy_framer_(spdy::SpdyFramer::ENABLE_COMPRESSION),
@@ -231,6 +231,7 @@ struct SpdySessionDependencies {
   size_t session_max_recv_window_size;
   int session_max_queued_capped_frames;
   spdy::SettingsMap http2_settings;
+  SpdySessionPool::HeaderTableSizeMap http2_header_table_sizes;
   SpdySession::TimeFunc time_func;
   bool enable_http2_alternative_service;
   bool enable_websocket_over_http2;
@@ -302,6 +303,11 @@ class SpdySessionPoolPeer {
   void RemoveAliases(const SpdySessionKey& key);
   void SetEnableSendingInitialData(bool enabled);
 
+  // Returns the number of entries in the pool's aliases table.
+  size_t GetAliasCount() const;
+  // Returns whether |key| has an entry in the pool's aliases table.
+  bool HasAlias(const SpdySessionKey& key) const;
+
  private:
   SpdySessionPool* const pool_;
 
@@ -4,19 +4,59 @@
 
 #include "net/spdy/spdy_write_queue.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <utility>
 #include <vector>
 
 #include "base/check_op.h"
 #include "base/containers/circular_deque.h"
+#include "base/feature_list.h"
 #include "base/trace_event/memory_usage_estimator.h"
+#include "net/base/features.h"
 #include "net/spdy/spdy_buffer.h"
 #include "net/spdy/spdy_buffer_producer.h"
 #include "net/spdy/spdy_stream.h"
 
 namespace net {
 
+namespace {
+
+// Returns the id of |stream| if its writes are to be sent one stream at a
+// time, or 0 if they are sent in the order they were queued: because the
+// stream is incremental, absent, or has not sent its HEADERS frame yet.
+spdy::SpdyStreamId GetSequentialStreamId(
+    const base::WeakPtr<SpdyStream>& stream) {
+  if (!stream || stream->priority_incremental())
+    return 0;
+  return stream->stream_id();
+}
+
+// Removes the writes in |queue| that |predicate| matches, moving their frame
+// producers to |erased_buffer_producers|. Returns the number of capped frames
+// removed.
+template <typename PendingWriteQueue, typename Predicate>
+int EraseWritesIf(
+    PendingWriteQueue* queue,
+    Predicate predicate,
+    std::vector<std::unique_ptr<SpdyBufferProducer>>* erased_buffer_producers) {
+  int num_capped_frames = 0;
+  for (auto it = queue->begin(); it != queue->end();) {
+    if (predicate(*it)) {
+      if (IsSpdyFrameTypeWriteCapped(it->frame_type))
+        num_capped_frames++;
+      erased_buffer_producers->push_back(std::move(it->frame_producer));
+      it = queue->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return num_capped_frames;
+}
+
+}  // namespace
+
 bool IsSpdyFrameTypeWriteCapped(spdy::SpdyFrameType frame_type) {
   return frame_type == spdy::SpdyFrameType::RST_STREAM ||
          frame_type == spdy::SpdyFrameType::SETTINGS ||
@@ -48,7 +88,10 @@ size_t SpdyWriteQueue::PendingWrite::EstimateMemoryUsage() const {
   return base::trace_event::EstimateMemoryUsage(frame_producer);
 }
 
-SpdyWriteQueue::SpdyWriteQueue() : removing_writes_(false) {}
+SpdyWriteQueue::SpdyWriteQueue()
+    : sequence_non_incremental_streams_(
+          base::FeatureList::IsEnabled(features::kPriorityHeader)),
+      removing_writes_(false) {}
 
 SpdyWriteQueue::~SpdyWriteQueue() {
   DCHECK_GE(num_queued_capped_frames_, 0);
@@ -57,7 +100,7 @@ SpdyWriteQueue::~SpdyWriteQueue() {
 
 bool SpdyWriteQueue::IsEmpty() const {
   for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; i++) {
-    if (!queue_[i].empty())
+    if (!queue_[i].empty() || !sequenced_queues_[i].empty())
       return false;
   }
   return true;
@@ -74,9 +117,11 @@ void SpdyWriteQueue::Enqueue(
   CHECK_LE(priority, MAXIMUM_PRIORITY);
   if (stream.get())
     DCHECK_EQ(stream->priority(), priority);
-  queue_[priority].push_back(
-      {frame_type, std::move(frame_producer), stream,
-       MutableNetworkTrafficAnnotationTag(traffic_annotation)});
+  PushWrite(priority,
+            sequence_non_incremental_streams_ ? GetSequentialStreamId(stream)
+                                              : 0,
+            {frame_type, std::move(frame_producer), stream,
+             MutableNetworkTrafficAnnotationTag(traffic_annotation)});
   if (IsSpdyFrameTypeWriteCapped(frame_type)) {
     DCHECK_GE(num_queued_capped_frames_, 0);
     num_queued_capped_frames_++;
@@ -90,9 +135,12 @@ bool SpdyWriteQueue::Dequeue(
     MutableNetworkTrafficAnnotationTag* traffic_annotation) {
   CHECK(!removing_writes_);
   for (int i = MAXIMUM_PRIORITY; i >= MINIMUM_PRIORITY; --i) {
-    if (!queue_[i].empty()) {
-      PendingWrite pending_write = std::move(queue_[i].front());
-      queue_[i].pop_front();
+    PendingWriteQueue* queue = GetNextWriteQueue(i);
+    if (queue) {
+      PendingWrite pending_write = std::move(queue->front());
+      queue->pop_front();
+      if (queue->empty() && queue != &queue_[i])
+        sequenced_queues_[i].erase(sequenced_queues_[i].begin());
       *frame_type = pending_write.frame_type;
       *frame_producer = std::move(pending_write.frame_producer);
       *stream = pending_write.stream;
@@ -109,6 +157,16 @@ bool SpdyWriteQueue::Dequeue(
   return false;
 }
 
+bool SpdyWriteQueue::IsNextWriteAnnotatedWith(
+    const MutableNetworkTrafficAnnotationTag& traffic_annotation) const {
+  for (int i = MAXIMUM_PRIORITY; i >= MINIMUM_PRIORITY; --i) {
+    const PendingWriteQueue* queue = GetNextWriteQueue(i);
+    if (queue)
+      return queue->front().traffic_annotation == traffic_annotation;
+  }
+  return false;
+}
+
 void SpdyWriteQueue::RemovePendingWritesForStream(SpdyStream* stream) {
   CHECK(!removing_writes_);
   removing_writes_ = true;
@@ -124,25 +182,28 @@ void SpdyWriteQueue::RemovePendingWritesForStream(SpdyStream* stream) {
       continue;
     for (auto it = queue_[i].begin(); it != queue_[i].end(); ++it)
       DCHECK_NE(it->stream.get(), stream);
+    for (const auto& id_and_queue : sequenced_queues_[i]) {
+      for (const PendingWrite& pending_write : id_and_queue.second)
+        DCHECK_NE(pending_write.stream.get(), stream);
+    }
   }
 #endif
 
   // Defer deletion until queue iteration is complete, as
   // SpdyBuffer::~SpdyBuffer() can result in callbacks into SpdyWriteQueue.
   std::vector<std::unique_ptr<SpdyBufferProducer>> erased_buffer_producers;
-  base::circular_deque<PendingWrite>& queue = queue_[priority];
-  for (auto it = queue.begin(); it != queue.end();) {
-    if (it->stream.get() == stream) {
-      if (IsSpdyFrameTypeWriteCapped(it->frame_type)) {
-        num_queued_capped_frames_--;
-        DCHECK_GE(num_queued_capped_frames_, 0);
-      }
-      erased_buffer_producers.push_back(std::move(it->frame_producer));
-      it = queue.erase(it);
-    } else {
-      ++it;
-    }
+  auto is_write_of_stream = [stream](const PendingWrite& pending_write) {
+    return pending_write.stream.get() == stream;
+  };
+  num_queued_capped_frames_ -= EraseWritesIf(
+      &queue_[priority], is_write_of_stream, &erased_buffer_producers);
+  auto& sequenced_queues = sequenced_queues_[priority];
+  for (auto it = sequenced_queues.begin(); it != sequenced_queues.end();) {
+    num_queued_capped_frames_ -= EraseWritesIf(
+        &it->second, is_write_of_stream, &erased_buffer_producers);
+    it = it->second.empty() ? sequenced_queues.erase(it) : std::next(it);
   }
+  DCHECK_GE(num_queued_capped_frames_, 0);
   removing_writes_ = false;
 
   // Iteration on |queue| is completed.  Now |erased_buffer_producers| goes out
@@ -157,22 +218,23 @@ void SpdyWriteQueue::RemovePendingWritesForStreamsAfter(
   // Defer deletion until queue iteration is complete, as
   // SpdyBuffer::~SpdyBuffer() can result in callbacks into SpdyWriteQueue.
   std::vector<std::unique_ptr<SpdyBufferProducer>> erased_buffer_producers;
+  auto is_write_of_later_stream =
+      [last_good_stream_id](const PendingWrite& pending_write) {
+        return pending_write.stream.get() &&
+               (pending_write.stream->stream_id() > last_good_stream_id ||
+                pending_write.stream->stream_id() == 0);
+      };
   for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
-    base::circular_deque<PendingWrite>& queue = queue_[i];
-    for (auto it = queue.begin(); it != queue.end();) {
-      if (it->stream.get() && (it->stream->stream_id() > last_good_stream_id ||
-                               it->stream->stream_id() == 0)) {
-        if (IsSpdyFrameTypeWriteCapped(it->frame_type)) {
-          num_queued_capped_frames_--;
-          DCHECK_GE(num_queued_capped_frames_, 0);
-        }
-        erased_buffer_producers.push_back(std::move(it->frame_producer));
-        it = queue.erase(it);
-      } else {
-        ++it;
-      }
+    num_queued_capped_frames_ -= EraseWritesIf(
+        &queue_[i], is_write_of_later_stream, &erased_buffer_producers);
+    auto& sequenced_queues = sequenced_queues_[i];
+    for (auto it = sequenced_queues.begin(); it != sequenced_queues.end();) {
+      num_queued_capped_frames_ -= EraseWritesIf(
+          &it->second, is_write_of_later_stream, &erased_buffer_producers);
+      it = it->second.empty() ? sequenced_queues.erase(it) : std::next(it);
     }
   }
+  DCHECK_GE(num_queued_capped_frames_, 0);
   removing_writes_ = false;
 
   // Iteration on each |queue| is completed.  Now |erased_buffer_producers| goes
@@ -194,19 +256,47 @@ void SpdyWriteQueue::ChangePriorityOfWritesForStream(
       continue;
     for (auto it = queue_[i].begin(); it != queue_[i].end(); ++it)
       DCHECK_NE(it->stream.get(), stream);
+    for (const auto& id_and_queue : sequenced_queues_[i]) {
+      for (const PendingWrite& pending_write : id_and_queue.second)
+        DCHECK_NE(pending_write.stream.get(), stream);
+    }
   }
 #endif
 
-  base::circular_deque<PendingWrite>& old_queue = queue_[old_priority];
-  base::circular_deque<PendingWrite>& new_queue = queue_[new_priority];
+  // Take the stream's writes out of both kinds of queue, along with the
+  // stream id they are sequenced by, and requeue them in their original
+  // order.
+  std::vector<std::pair<spdy::SpdyStreamId, PendingWrite>> moved_writes;
+  PendingWriteQueue& old_queue = queue_[old_priority];
   for (auto it = old_queue.begin(); it != old_queue.end();) {
     if (it->stream.get() == stream) {
-      new_queue.push_back(std::move(*it));
+      moved_writes.emplace_back(0, std::move(*it));
       it = old_queue.erase(it);
     } else {
       ++it;
     }
   }
+  auto& old_sequenced_queues = sequenced_queues_[old_priority];
+  for (auto it = old_sequenced_queues.begin();
+       it != old_sequenced_queues.end();) {
+    for (auto write_it = it->second.begin(); write_it != it->second.end();) {
+      if (write_it->stream.get() == stream) {
+        moved_writes.emplace_back(it->first, std::move(*write_it));
+        write_it = it->second.erase(write_it);
+      } else {
+        ++write_it;
+      }
+    }
+    it = it->second.empty() ? old_sequenced_queues.erase(it) : std::next(it);
+  }
+
+  std::sort(moved_writes.begin(), moved_writes.end(),
+            [](const std::pair<spdy::SpdyStreamId, PendingWrite>& a,
+               const std::pair<spdy::SpdyStreamId, PendingWrite>& b) {
+              return a.second.sequence_number < b.second.sequence_number;
+            });
+  for (auto& moved_write : moved_writes)
+    PushWrite(new_priority, moved_write.first, std::move(moved_write.second));
 }
 
 void SpdyWriteQueue::Clear() {
@@ -219,13 +309,57 @@ void SpdyWriteQueue::Clear() {
       erased_buffer_producers.push_back(std::move(it->frame_producer));
     }
     queue_[i].clear();
+    for (auto& id_and_queue : sequenced_queues_[i]) {
+      for (PendingWrite& pending_write : id_and_queue.second) {
+        erased_buffer_producers.push_back(
+            std::move(pending_write.frame_producer));
+      }
+    }
+    sequenced_queues_[i].clear();
   }
   removing_writes_ = false;
   num_queued_capped_frames_ = 0;
 }
 
+void SpdyWriteQueue::PushWrite(int priority,
+                               spdy::SpdyStreamId sequential_stream_id,
+                               PendingWrite pending_write) {
+  pending_write.sequence_number = next_sequence_number_++;
+  if (sequential_stream_id == 0) {
+    queue_[priority].push_back(std::move(pending_write));
+  } else {
+    sequenced_queues_[priority][sequential_stream_id].push_back(
+        std::move(pending_write));
+  }
+}
+
+SpdyWriteQueue::PendingWriteQueue* SpdyWriteQueue::GetNextWriteQueue(
+    int priority) {
+  return const_cast<PendingWriteQueue*>(
+      static_cast<const SpdyWriteQueue*>(this)->GetNextWriteQueue(priority));
+}
+
+const SpdyWriteQueue::PendingWriteQueue* SpdyWriteQueue::GetNextWriteQueue(
+    int priority) const {
+  const PendingWriteQueue& queue = queue_[priority];
+  const auto& sequenced_queues = sequenced_queues_[priority];
+  if (sequenced_queues.empty())
+    return queue.empty() ? nullptr : &queue;
+
+  // Only the stream with the lowest id is being sent. Its writes and those
+  // sent in queued order go out in the order they were queued.
+  const PendingWriteQueue& sequenced_queue = sequenced_queues.begin()->second;
+  DCHECK(!sequenced_queue.empty());
+  if (!queue.empty() && queue.front().sequence_number <
+                            sequenced_queue.front().sequence_number) {
+    return &queue;
+  }
+  return &sequenced_queue;
+}
+
 size_t SpdyWriteQueue::EstimateMemoryUsage() const {
-  return base::trace_event::EstimateMemoryUsage(queue_);
+  return base::trace_event::EstimateMemoryUsage(queue_) +
+         base::trace_event::EstimateMemoryUsage(sequenced_queues_);
 }
 
 }  // namespace net
@@ -5,6 +5,9 @@
 #ifndef NET_SPDY_SPDY_WRITE_QUEUE_H_
 #define NET_SPDY_SPDY_WRITE_QUEUE_H_
 
+#include <stdint.h>
+
+#include <map>
 #include <memory>
 
 #include "base/containers/circular_deque.h"
@@ -26,7 +29,11 @@ class SpdyBufferProducer;
 class SpdyStream;
 
 // A queue of SpdyBufferProducers to produce frames to write. Ordered
-// by priority, and then FIFO.
+// by priority, and then FIFO. With features::kPriorityHeader, frames of
+// streams that are not incremental are instead written one stream at a time
+// within a priority, lowest stream id first, as RFC 9218 asks of the
+// server for responses. Other frames, such as those of incremental streams,
+// are interleaved with them in the order they were queued.
 class NET_EXPORT_PRIVATE SpdyWriteQueue {
  public:
   SpdyWriteQueue();
@@ -47,8 +54,8 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
                const base::WeakPtr<SpdyStream>& stream,
                const NetworkTrafficAnnotationTag& traffic_annotation);
 
-  // Dequeues the frame producer with the highest priority that was
-  // enqueued the earliest and its associated stream. Returns true and
+  // Dequeues the frame producer with the highest priority that is next
+  // in line, as described above, and its associated stream. Returns true and
   // fills in |frame_type|, |frame_producer|, and |stream| if
   // successful -- otherwise, just returns false.
   bool Dequeue(spdy::SpdyFrameType* frame_type,
@@ -56,6 +63,12 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
                base::WeakPtr<SpdyStream>* stream,
                MutableNetworkTrafficAnnotationTag* traffic_annotation);
 
+  // Returns whether the frame producer that the next call to Dequeue
+  // would return was enqueued with |traffic_annotation|. Returns false
+  // if the queue is empty.
+  bool IsNextWriteAnnotatedWith(
+      const MutableNetworkTrafficAnnotationTag& traffic_annotation) const;
+
   // Removes all pending writes for the given stream, which must be
   // non-NULL.
   void RemovePendingWritesForStream(SpdyStream* stream);
@@ -90,6 +103,8 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
     MutableNetworkTrafficAnnotationTag traffic_annotation;
     // Whether |stream| was non-NULL when enqueued.
     bool has_stream;
+    // Orders writes by when they were enqueued, across all queues.
+    uint64_t sequence_number = 0;
 
     PendingWrite();
     PendingWrite(spdy::SpdyFrameType frame_type,
@@ -106,13 +121,37 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
     DISALLOW_COPY_AND_ASSIGN(PendingWrite);
   };
 
+  using PendingWriteQueue = base::circular_deque<PendingWrite>;
+
+  // Appends |pending_write| to the queue at |priority| for
+  // |sequential_stream_id|, which is 0 for writes sent in queued order.
+  void PushWrite(int priority,
+                 spdy::SpdyStreamId sequential_stream_id,
+                 PendingWrite pending_write);
+
+  // Returns the queue at |priority| whose first write is to be dequeued next,
+  // or nullptr if there are no writes at |priority|.
+  PendingWriteQueue* GetNextWriteQueue(int priority);
+  const PendingWriteQueue* GetNextWriteQueue(int priority) const;
+
+  // Whether writes of non-incremental streams are sequenced by stream id.
+  const bool sequence_non_incremental_streams_;
+
   bool removing_writes_;
 
   // Number of currently queued capped frames including all priorities.
   int num_queued_capped_frames_ = 0;
 
-  // The actual write queue, binned by priority.
-  base::circular_deque<PendingWrite> queue_[NUM_PRIORITIES];
+  // Writes sent in the order they were queued, binned by priority.
+  PendingWriteQueue queue_[NUM_PRIORITIES];
+
+  // Writes of streams that are sent one at a time, binned by priority and
+  // then by stream id. Queues are removed once empty, so the first one is
+  // that of the stream to send next.
+  std::map<spdy::SpdyStreamId, PendingWriteQueue>
+      sequenced_queues_[NUM_PRIORITIES];
+
+  uint64_t next_sequence_number_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(SpdyWriteQueue);
 };
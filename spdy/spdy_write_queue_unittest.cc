@@ -14,6 +14,8 @@
 #include "base/notreached.h"
 #include "base/stl_util.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/test/scoped_feature_list.h"
+#include "net/base/features.h"
 #include "net/base/request_priority.h"
 #include "net/log/net_log_with_source.h"
 #include "net/spdy/spdy_buffer_producer.h"
@@ -466,6 +468,120 @@ TEST_F(SpdyWriteQueueTest, ChangePriority) {
                                    &traffic_annotation));
 }
 
+TEST_F(SpdyWriteQueueTest, IsNextWriteAnnotatedWith) {
+  SpdyWriteQueue write_queue;
+  MutableNetworkTrafficAnnotationTag traffic_annotation(
+      TRAFFIC_ANNOTATION_FOR_TESTS);
+
+  EXPECT_FALSE(write_queue.IsNextWriteAnnotatedWith(traffic_annotation));
+
+  write_queue.Enqueue(LOW, spdy::SpdyFrameType::HEADERS, IntToProducer(1),
+                      base::WeakPtr<SpdyStream>(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+  EXPECT_TRUE(write_queue.IsNextWriteAnnotatedWith(traffic_annotation));
+  EXPECT_FALSE(write_queue.IsNextWriteAnnotatedWith(
+      MutableNetworkTrafficAnnotationTag()));
+
+  // Peeking doesn't dequeue anything.
+  spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::DATA;
+  std::unique_ptr<SpdyBufferProducer> frame_producer;
+  base::WeakPtr<SpdyStream> stream;
+  MutableNetworkTrafficAnnotationTag dequeued_traffic_annotation;
+  ASSERT_TRUE(write_queue.Dequeue(&frame_type, &frame_producer, &stream,
+                                  &dequeued_traffic_annotation));
+  EXPECT_EQ(1, ProducerToInt(std::move(frame_producer)));
+  EXPECT_FALSE(write_queue.IsNextWriteAnnotatedWith(traffic_annotation));
+}
+
+// With RFC 9218 priorities, writes of non-incremental streams of the same
+// priority go out one stream at a time, lowest stream id first. Writes of
+// incremental streams and session frames are interleaved with them in queued
+// order.
+TEST_F(SpdyWriteQueueTest, SequencesNonIncrementalStreams) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kPriorityHeader);
+  SpdyWriteQueue write_queue;
+
+  std::unique_ptr<SpdyStream> stream1 = MakeTestStream(DEFAULT_PRIORITY);
+  stream1->set_stream_id(1);
+  std::unique_ptr<SpdyStream> stream3 = MakeTestStream(DEFAULT_PRIORITY);
+  stream3->set_stream_id(3);
+  std::unique_ptr<SpdyStream> stream5 = MakeTestStream(DEFAULT_PRIORITY);
+  stream5->set_stream_id(5);
+  stream5->set_priority_incremental(true);
+
+  write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                      IntToProducer(1), stream3->GetWeakPtr(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+  write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                      IntToProducer(2), stream5->GetWeakPtr(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+  write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                      IntToProducer(3), stream1->GetWeakPtr(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+  write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                      IntToProducer(4), stream3->GetWeakPtr(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+  write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                      IntToProducer(5), stream1->GetWeakPtr(),
+                      TRAFFIC_ANNOTATION_FOR_TESTS);
+
+  // The incremental stream 5's write was queued before any of stream 1's, and
+  // stream 1 goes before stream 3, which was queued first.
+  const int kExpectedOrder[] = {2, 3, 5, 1, 4};
+  for (int expected : kExpectedOrder) {
+    spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::HEADERS;
+    std::unique_ptr<SpdyBufferProducer> frame_producer;
+    base::WeakPtr<SpdyStream> stream;
+    MutableNetworkTrafficAnnotationTag traffic_annotation;
+    ASSERT_TRUE(write_queue.Dequeue(&frame_type, &frame_producer, &stream,
+                                    &traffic_annotation));
+    EXPECT_EQ(expected, ProducerToInt(std::move(frame_producer)));
+  }
+  EXPECT_TRUE(write_queue.IsEmpty());
+}
+
+// Writes of sequenced streams can be removed and reprioritized like any other.
+TEST_F(SpdyWriteQueueTest, RemovesAndReprioritizesSequencedWrites) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kPriorityHeader);
+  SpdyWriteQueue write_queue;
+
+  std::unique_ptr<SpdyStream> stream1 = MakeTestStream(DEFAULT_PRIORITY);
+  stream1->set_stream_id(1);
+  std::unique_ptr<SpdyStream> stream3 = MakeTestStream(DEFAULT_PRIORITY);
+  stream3->set_stream_id(3);
+  std::unique_ptr<SpdyStream> stream5 = MakeTestStream(DEFAULT_PRIORITY);
+  stream5->set_stream_id(5);
+
+  for (int i = 0; i < 3; ++i) {
+    write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                        IntToProducer(10 + i), stream1->GetWeakPtr(),
+                        TRAFFIC_ANNOTATION_FOR_TESTS);
+    write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                        IntToProducer(30 + i), stream3->GetWeakPtr(),
+                        TRAFFIC_ANNOTATION_FOR_TESTS);
+    write_queue.Enqueue(DEFAULT_PRIORITY, spdy::SpdyFrameType::DATA,
+                        IntToProducer(50 + i), stream5->GetWeakPtr(),
+                        TRAFFIC_ANNOTATION_FOR_TESTS);
+  }
+  write_queue.RemovePendingWritesForStream(stream1.get());
+  write_queue.ChangePriorityOfWritesForStream(stream5.get(), DEFAULT_PRIORITY,
+                                              HIGHEST);
+
+  const int kExpectedOrder[] = {50, 51, 52, 30, 31, 32};
+  for (int expected : kExpectedOrder) {
+    spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::HEADERS;
+    std::unique_ptr<SpdyBufferProducer> frame_producer;
+    base::WeakPtr<SpdyStream> stream;
+    MutableNetworkTrafficAnnotationTag traffic_annotation;
+    ASSERT_TRUE(write_queue.Dequeue(&frame_type, &frame_producer, &stream,
+                                    &traffic_annotation));
+    EXPECT_EQ(expected, ProducerToInt(std::move(frame_producer)));
+  }
+  EXPECT_TRUE(write_queue.IsEmpty());
+}
+
 }  // namespace
 
 }  // namespace net
@@ -456,6 +456,11 @@ void URLRequest::set_method(const std::string& method) {
   method_ = method;
 }
 
+void URLRequest::set_priority_incremental(bool priority_incremental) {
+  DCHECK(!is_pending_);
+  priority_incremental_ = priority_incremental;
+}
+
 #if BUILDFLAG(ENABLE_REPORTING)
 void URLRequest::set_reporting_upload_depth(int reporting_upload_depth) {
   DCHECK(!is_pending_);
@@ -554,6 +559,7 @@ URLRequest::URLRequest(const GURL& url,
       is_redirecting_(false),
       redirect_limit_(kMaxRedirects),
       priority_(priority),
+      priority_incremental_(false),
       delegate_event_type_(NetLogEventType::FAILED),
       calling_delegate_(false),
       use_blocked_by_as_load_param_(false),
@@ -636,6 +636,13 @@ class NET_EXPORT URLRequest : public base::SupportsUserData {
   // MAXIMUM_PRIORITY if the IGNORE_LIMITS load flag is set.
   void SetPriority(RequestPriority priority);
 
+  // Whether the response may be processed as it arrives, rather than only as
+  // a whole, and so can share bandwidth with other responses of the same
+  // priority. Sent as the RFC 9218 incremental parameter with
+  // features::kPriorityHeader. Must be set before the request is started.
+  bool priority_incremental() const { return priority_incremental_; }
+  void set_priority_incremental(bool priority_incremental);
+
   void set_received_response_content_length(int64_t received_content_length) {
     received_response_content_length_ = received_content_length;
   }
@@ -904,6 +911,8 @@ class NET_EXPORT URLRequest : public base::SupportsUserData {
   // allocate sockets to first.
   RequestPriority priority_;
 
+  bool priority_incremental_;
+
   // If |calling_delegate_| is true, the event type of the delegate being
   // called.
   NetLogEventType delegate_event_type_;
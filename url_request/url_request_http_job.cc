@@ -295,6 +295,7 @@ void URLRequestHttpJob::Start() {
   request_info_.possibly_top_frame_origin =
       request_->isolation_info().top_frame_origin();
   request_info_.load_flags = request_->load_flags();
+  request_info_.priority_incremental = request_->priority_incremental();
   request_info_.disable_secure_dns = request_->disable_secure_dns();
   request_info_.traffic_annotation =
       net::MutableNetworkTrafficAnnotationTag(request_->traffic_annotation());
@@ -1336,6 +1336,19 @@ TEST_F(URLRequestHttpJobTest, SetTransactionPriorityOnStart) {
   EXPECT_EQ(LOW, network_layer_.last_transaction()->priority());
 }
 
+// Make sure that URLRequestHttpJob passes on whether the request's priority is
+// incremental to its transaction.
+TEST_F(URLRequestHttpJobTest, SetTransactionPriorityIncremental) {
+  TestScopedURLInterceptor interceptor(
+      req_->url(), std::make_unique<TestURLRequestHttpJob>(req_.get()));
+  req_->set_priority_incremental(true);
+  req_->Start();
+
+  ASSERT_TRUE(network_layer_.last_transaction());
+  EXPECT_TRUE(
+      network_layer_.last_transaction()->request()->priority_incremental);
+}
+
 // Make sure that URLRequestHttpJob passes on its priority updates to
 // its transaction.
 TEST_F(URLRequestHttpJobTest, SetTransactionPriority) {
@@ -129,6 +129,11 @@ scoped_refptr<IOBufferWithSize> WebSocketDeflater::GetOutput(size_t size) {
   return result;
 }
 
+void WebSocketDeflater::AppendOutput(std::string* output) {
+  output->append(buffer_.begin(), buffer_.end());
+  buffer_.clear();
+}
+
 void WebSocketDeflater::ResetContext() {
   if (mode_ == DO_NOT_TAKE_OVER_CONTEXT)
     deflateReset(stream_.get());
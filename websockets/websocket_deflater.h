@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "base/containers/circular_deque.h"
@@ -56,6 +57,10 @@ class NET_EXPORT_PRIVATE WebSocketDeflater {
   // returned thereafter.
   scoped_refptr<IOBufferWithSize> GetOutput(size_t size);
 
+  // Appends the whole current deflated output to |output|, and drops it from
+  // the current output, without copying it to an intermediate buffer.
+  void AppendOutput(std::string* output);
+
   // Returns the size of the current deflated output.
   size_t CurrentOutputSize() const { return buffer_.size(); }
 
@@ -77,6 +77,18 @@ TEST(WebSocketDeflaterTest, MultipleAddBytesCalls) {
   EXPECT_EQ(std::string("\x4a\x4c\xc4\x0f\x00\x00", 6), ToString(actual.get()));
 }
 
+TEST(WebSocketDeflaterTest, AppendOutput) {
+  WebSocketDeflater deflater(WebSocketDeflater::TAKE_OVER_CONTEXT);
+  deflater.Initialize(15);
+  std::string output = "prefix";
+
+  ASSERT_TRUE(deflater.AddBytes("Hello", 5));
+  ASSERT_TRUE(deflater.Finish());
+  deflater.AppendOutput(&output);
+  EXPECT_EQ(std::string("prefix\xf2\x48\xcd\xc9\xc9\x07\x00", 13), output);
+  EXPECT_EQ(0u, deflater.CurrentOutputSize());
+}
+
 TEST(WebSocketDeflaterTest, GetMultipleDeflatedOutput) {
   WebSocketDeflater deflater(WebSocketDeflater::TAKE_OVER_CONTEXT);
   deflater.Initialize(15);